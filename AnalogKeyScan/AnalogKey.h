@@ -0,0 +1,79 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "AnalogKeyScan_config.h"
+#include "Set.h"
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // アナログ(磁気)スイッチ1個に対応するクラス
+  // 位置は全て0.01mm単位
+  // 状態はAnalogKeyTrackerが持つので、ここではIDと設定だけを持つ
+  class AnalogKey
+  {
+  public:
+    // キーが無いチャンネル
+    constexpr AnalogKey()
+        : _id(0), _is_valid(false), _actuation_point(0), _press_sensitivity(0), _release_sensitivity(0)
+    {
+    }
+
+    // 論理的なIDをセットする
+    // rapid_trigger_sensitivityを0にするとラピッドトリガーを使わない
+    constexpr AnalogKey(key_id_t id,
+                        uint16_t actuation_point = ANALOG_KEY_SCAN_ACTUATION_POINT,
+                        uint16_t rapid_trigger_sensitivity = ANALOG_KEY_SCAN_RAPID_TRIGGER_SENSITIVITY)
+        : AnalogKey(id, actuation_point, rapid_trigger_sensitivity, rapid_trigger_sensitivity)
+    {
+    }
+
+    // ラピッドトリガーの押下と解放で別々の感度を使う
+    constexpr AnalogKey(key_id_t id, uint16_t actuation_point, uint16_t press_sensitivity, uint16_t release_sensitivity)
+        : _id(id), _is_valid(true), _actuation_point(actuation_point), _press_sensitivity(press_sensitivity), _release_sensitivity(release_sensitivity)
+    {
+    }
+
+    constexpr key_id_t getId() const { return _id; }
+    constexpr uint16_t getActuationPoint() const { return _actuation_point; }
+    constexpr uint16_t getPressSensitivity() const { return _press_sensitivity; }
+    constexpr uint16_t getReleaseSensitivity() const { return _release_sensitivity; }
+    constexpr bool isRapidTrigger() const { return _press_sensitivity > 0 && _release_sensitivity > 0; }
+    constexpr bool isValid() const { return _is_valid; }
+
+  private:
+    key_id_t _id;
+    bool _is_valid;
+    uint16_t _actuation_point;
+    uint16_t _press_sensitivity;
+    uint16_t _release_sensitivity;
+  };
+
+  // キーが無いチャンネル
+  constexpr AnalogKey NO_KEY = AnalogKey();
+
+} // namespace hidpg
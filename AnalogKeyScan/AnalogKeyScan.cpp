@@ -0,0 +1,154 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "AnalogKeyScan.h"
+
+namespace hidpg
+{
+  namespace Internal
+  {
+
+    AnalogKeyScanClass::callback_t AnalogKeyScanClass::_callback = nullptr;
+    const AnalogKey *AnalogKeyScanClass::_keys = nullptr;
+    uint8_t AnalogKeyScanClass::_keys_len = 0;
+    AnalogKeyTracker *AnalogKeyScanClass::_trackers = nullptr;
+    uint16_t *AnalogKeyScanClass::_values = nullptr;
+    AnalogSource *AnalogKeyScanClass::_source = nullptr;
+
+    TaskHandle_t AnalogKeyScanClass::_task_handle = nullptr;
+    StackType_t AnalogKeyScanClass::_task_stack[ANALOG_KEY_SCAN_TASK_STACK_SIZE];
+    StaticTask_t AnalogKeyScanClass::_task_tcb;
+    volatile bool AnalogKeyScanClass::_calibration_requested = false;
+    SemaphoreHandle_t AnalogKeyScanClass::_calibrated_sem = nullptr;
+    StaticSemaphore_t AnalogKeyScanClass::_calibrated_sem_buf;
+
+    void AnalogKeyScanClass::setCallback(callback_t callback)
+    {
+      _callback = callback;
+    }
+
+    void AnalogKeyScanClass::start()
+    {
+      _source->begin();
+      runCalibration();
+      _calibrated_sem = xSemaphoreCreateBinaryStatic(&_calibrated_sem_buf);
+      _task_handle = xTaskCreateStatic(task, "AnalogKeyScan", ANALOG_KEY_SCAN_TASK_STACK_SIZE, nullptr, ANALOG_KEY_SCAN_TASK_PRIO, _task_stack, &_task_tcb);
+    }
+
+    void AnalogKeyScanClass::calibrate()
+    {
+      if (_task_handle == nullptr)
+      {
+        runCalibration();
+        return;
+      }
+
+      // タスクを外から止めるとADCの読み取り途中で止まることがあるので、タスク自身にやってもらう
+      _calibration_requested = true;
+      xSemaphoreTake(_calibrated_sem, portMAX_DELAY);
+    }
+
+    // 離した状態の値を平均してキー毎の基準にする
+    void AnalogKeyScanClass::runCalibration()
+    {
+      for (int i = 0; i < _keys_len; i++)
+      {
+        _trackers[i].beginCalibration();
+      }
+      for (int n = 0; n < ANALOG_KEY_SCAN_CALIBRATION_SAMPLES; n++)
+      {
+        _source->read(_values, _keys_len);
+        for (int i = 0; i < _keys_len; i++)
+        {
+          _trackers[i].addCalibrationSample(_values[i]);
+        }
+        delay(ANALOG_KEY_SCAN_POLLING_INTERVAL_MS);
+      }
+      for (int i = 0; i < _keys_len; i++)
+      {
+        _trackers[i].endCalibration(ANALOG_KEY_SCAN_CALIBRATION_SAMPLES);
+      }
+    }
+
+    void AnalogKeyScanClass::task(void *pvParameters)
+    {
+      Set ids, prev_ids;
+      TickType_t polling_interval_ticks = max(pdMS_TO_TICKS(ANALOG_KEY_SCAN_POLLING_INTERVAL_MS), (TickType_t)1);
+      TickType_t last_wake_time = xTaskGetTickCount();
+
+      while (true)
+      {
+        if (_calibration_requested)
+        {
+          // キャリブレーションで全てのキーが解放状態に戻るので、押されていたキーの解放を先に知らせる
+          ids.clear();
+          if (ids != prev_ids)
+          {
+            if (_callback != nullptr)
+            {
+              _callback(ids);
+            }
+            prev_ids = ids;
+          }
+
+          runCalibration();
+          _calibration_requested = false;
+          xSemaphoreGive(_calibrated_sem);
+
+          // キャリブレーション中の遅れを取り戻そうと連続でスキャンしないようにする
+          last_wake_time = xTaskGetTickCount();
+        }
+
+        _source->read(_values, _keys_len);
+
+        for (int i = 0; i < _keys_len; i++)
+        {
+          const AnalogKey &key = _keys[i];
+          if (key.isValid() == false)
+          {
+            continue;
+          }
+          _trackers[i].update(_values[i], key);
+          ids.update(key.getId(), _trackers[i].isPressed());
+        }
+
+        // 更新してたらコールバック関数を発火
+        if (ids != prev_ids)
+        {
+          if (_callback != nullptr)
+          {
+            _callback(ids);
+          }
+          prev_ids = ids;
+        }
+
+        vTaskDelayUntil(&last_wake_time, polling_interval_ticks);
+      }
+    }
+
+  } // namespace Internal
+
+  Internal::AnalogKeyScanClass AnalogKeyScan;
+
+} // namespace hidpg
@@ -0,0 +1,101 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "AnalogKey.h"
+#include "AnalogKeyScan_config.h"
+#include "AnalogKeyTracker.h"
+#include "AnalogSource.h"
+#include "Arduino.h"
+#include "FreeRTOS.h"
+#include "Set.h"
+#include "semphr.h"
+#include "task.h"
+
+namespace hidpg
+{
+  namespace Internal
+  {
+
+    // アナログ(磁気)スイッチを一定間隔でスキャンし、押されているキーのIDのSetをコールバックで渡す
+    // MatrixScanと同じくコールバックにはHidEngine.applyToKeymapをそのまま渡せる
+    //
+    // 使用例
+    //   constexpr AnalogKey keys[] = {AnalogKey(0), AnalogKey(1, 150, 20), NO_KEY, AnalogKey(2)};
+    //   MuxAnalogSource source(select_pins, adc_pins);
+    //   AnalogKeyScan.setKeys(keys, source);
+    //   AnalogKeyScan.setCallback(HidEngine.applyToKeymap);
+    //   AnalogKeyScan.start();
+    class AnalogKeyScanClass
+    {
+    public:
+      using callback_t = void (*)(const Set &key_ids);
+
+      // keysのインデックスがsourceのチャンネル番号に対応する
+      template <uint8_t keys_len>
+      static void setKeys(const AnalogKey (&keys)[keys_len], AnalogSource &source)
+      {
+        static AnalogKeyTracker trackers[keys_len];
+        static uint16_t values[keys_len];
+
+        _keys = keys;
+        _keys_len = keys_len;
+        _trackers = trackers;
+        _values = values;
+        _source = &source;
+      }
+
+      static void start();
+      static void setCallback(callback_t callback);
+
+      // キーを離した状態で呼ぶ
+      // スキャン中はタスクがスキャンの合間にキャリブレーションし、終わるまで待つ
+      // 押されていたキーは解放としてコールバックされる、スキャンタスク(コールバック)からは呼ばないこと
+      static void calibrate();
+
+    private:
+      static void runCalibration();
+      static void task(void *pvParameters);
+
+      static callback_t _callback;
+      static const AnalogKey *_keys;
+      static uint8_t _keys_len;
+      static AnalogKeyTracker *_trackers;
+      static uint16_t *_values;
+      static AnalogSource *_source;
+
+      static TaskHandle_t _task_handle;
+      static StackType_t _task_stack[];
+      static StaticTask_t _task_tcb;
+      static volatile bool _calibration_requested;
+      static SemaphoreHandle_t _calibrated_sem;
+      static StaticSemaphore_t _calibrated_sem_buf;
+    };
+
+  } // namespace Internal
+
+  extern Internal::AnalogKeyScanClass AnalogKeyScan;
+
+} // namespace hidpg
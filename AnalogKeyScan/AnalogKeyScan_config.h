@@ -0,0 +1,90 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+// キーストロークの長さ、移動量は全て0.01mm単位の固定小数点で扱う
+#ifndef ANALOG_KEY_SCAN_TOTAL_TRAVEL
+#define ANALOG_KEY_SCAN_TOTAL_TRAVEL 400 // 4.00mm
+#endif
+
+// AnalogKeyで指定しなかった場合のアクチュエーションポイント
+#ifndef ANALOG_KEY_SCAN_ACTUATION_POINT
+#define ANALOG_KEY_SCAN_ACTUATION_POINT 200 // 2.00mm
+#endif
+
+// AnalogKeyで指定しなかった場合のラピッドトリガーの感度
+// アクチュエーションポイントより深い位置で、この量だけ戻ったら解放、この量だけ押し込んだら押下になる
+// 0にするとラピッドトリガーを使わない
+#ifndef ANALOG_KEY_SCAN_RAPID_TRIGGER_SENSITIVITY
+#define ANALOG_KEY_SCAN_RAPID_TRIGGER_SENSITIVITY 30 // 0.30mm
+#endif
+
+// アクチュエーションポイントのヒステリシス
+// 押下後はアクチュエーションポイントからこの量だけ戻るまで解放しない
+#ifndef ANALOG_KEY_SCAN_HYSTERESIS
+#define ANALOG_KEY_SCAN_HYSTERESIS 10 // 0.10mm
+#endif
+
+// 底打ちまでのADCの値の変化量の初期値、センサーの向きで値が減る場合は負の値にする
+// 実際の変化量がこれより大きければ底打ちした時に自動的に広げるので、小さめの値にしておく
+#ifndef ANALOG_KEY_SCAN_DEFAULT_RANGE
+#define ANALOG_KEY_SCAN_DEFAULT_RANGE 300
+#endif
+
+// キャリブレーションの際に離した状態の値を平均するサンプル数
+#ifndef ANALOG_KEY_SCAN_CALIBRATION_SAMPLES
+#define ANALOG_KEY_SCAN_CALIBRATION_SAMPLES 16
+#endif
+
+// ADCの値に掛けるローパスフィルタの強さ、新しいサンプルの重みは1/2^n
+// 0にするとフィルタを使わない
+#ifndef ANALOG_KEY_SCAN_FILTER_SHIFT
+#define ANALOG_KEY_SCAN_FILTER_SHIFT 1
+#endif
+
+// ADCの分解能(bit)
+#ifndef ANALOG_KEY_SCAN_ADC_RESOLUTION
+#define ANALOG_KEY_SCAN_ADC_RESOLUTION 12
+#endif
+
+// マルチプレクサのチャンネルを切り替えてからADCで読むまでの待ち時間
+#ifndef ANALOG_KEY_SCAN_MUX_SETTLE_US
+#define ANALOG_KEY_SCAN_MUX_SETTLE_US 5
+#endif
+
+// スキャンの間隔
+#ifndef ANALOG_KEY_SCAN_POLLING_INTERVAL_MS
+#define ANALOG_KEY_SCAN_POLLING_INTERVAL_MS 1
+#endif
+
+// AnalogKeyScanタスクのスタックサイズ
+#ifndef ANALOG_KEY_SCAN_TASK_STACK_SIZE
+#define ANALOG_KEY_SCAN_TASK_STACK_SIZE 128
+#endif
+
+// AnalogKeyScanタスクのプライオリティ
+#ifndef ANALOG_KEY_SCAN_TASK_PRIO
+#define ANALOG_KEY_SCAN_TASK_PRIO 1
+#endif
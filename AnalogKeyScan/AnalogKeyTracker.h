@@ -0,0 +1,162 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "AnalogKey.h"
+#include "AnalogKeyScan_config.h"
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // アナログスイッチ1個分のADCの値からストロークを求め、押下/解放を判定する
+  // 計算は全て整数で行う
+  //
+  // - 離した状態の値(rest)と底打ちまでの変化量(range)でADCの値を0 ~ ANALOG_KEY_SCAN_TOTAL_TRAVELに変換する
+  // - 底打ちで変化量がrangeを超えたらrangeを広げ、離した状態で値がrestより戻ったらrestを更新する
+  // - アクチュエーションポイントより浅い位置では常に解放(ヒステリシス付き)
+  // - ラピッドトリガーが有効なら、アクチュエーションポイントより深い位置で
+  //   押下中は最も深い位置から解放の感度だけ戻ったら解放、
+  //   解放中は最も浅い位置から押下の感度だけ押し込んだら押下にする
+  class AnalogKeyTracker
+  {
+  public:
+    AnalogKeyTracker() : _filtered(0), _rest(0), _range(ANALOG_KEY_SCAN_DEFAULT_RANGE), _travel(0), _extreme(0), _is_pressed(false) {}
+
+    // キャリブレーション、離した状態の値をサンプル数だけ加えてから終了する
+    void beginCalibration()
+    {
+      _filtered = 0;
+    }
+
+    void addCalibrationSample(uint16_t raw)
+    {
+      _filtered += raw;
+    }
+
+    void endCalibration(uint16_t samples, int16_t range = ANALOG_KEY_SCAN_DEFAULT_RANGE)
+    {
+      _rest = (samples > 0) ? _filtered / samples : 0;
+      _range = (range != 0) ? range : 1;
+      _filtered = static_cast<int32_t>(_rest) << ANALOG_KEY_SCAN_FILTER_SHIFT;
+      _travel = 0;
+      _extreme = 0;
+      _is_pressed = false;
+    }
+
+    // rawはADCの値
+    // 戻り値は押下状態が変化したか
+    bool update(uint16_t raw, const AnalogKey &key)
+    {
+      // 1次のIIRフィルタ、_filteredは下位ANALOG_KEY_SCAN_FILTER_SHIFTビットが小数部
+      _filtered += static_cast<int32_t>(raw) - (_filtered >> ANALOG_KEY_SCAN_FILTER_SHIFT);
+      _travel = toTravel(_filtered >> ANALOG_KEY_SCAN_FILTER_SHIFT);
+
+      uint16_t actuation_point = key.getActuationPoint();
+      bool was_pressed = _is_pressed;
+
+      if (_is_pressed)
+      {
+        if (_travel + ANALOG_KEY_SCAN_HYSTERESIS < actuation_point)
+        {
+          _is_pressed = false;
+        }
+        else if (key.isRapidTrigger())
+        {
+          if (_travel > _extreme)
+          {
+            _extreme = _travel;
+          }
+          if (_travel + key.getReleaseSensitivity() <= _extreme)
+          {
+            _is_pressed = false;
+          }
+        }
+      }
+      else
+      {
+        if (_travel < _extreme)
+        {
+          _extreme = _travel;
+        }
+        // アクチュエーションポイントを浅い側から超えたか、ラピッドトリガーで押し込んだか
+        if (_travel >= actuation_point &&
+            (_extreme < actuation_point || (key.isRapidTrigger() && _travel >= _extreme + key.getPressSensitivity())))
+        {
+          _is_pressed = true;
+        }
+      }
+
+      if (_is_pressed != was_pressed)
+      {
+        _extreme = _travel;
+        return true;
+      }
+      return false;
+    }
+
+    bool isPressed() const { return _is_pressed; }
+
+    // 現在のストローク(0.01mm単位)
+    uint16_t getTravel() const { return _travel; }
+
+  private:
+    uint16_t toTravel(int32_t value)
+    {
+      int32_t delta = value - _rest;
+      int32_t range = _range;
+      if (range < 0)
+      {
+        delta = -delta;
+        range = -range;
+      }
+
+      if (delta <= 0)
+      {
+        // 離した状態でrestより戻っていたらrestを追従させる
+        if (_is_pressed == false)
+        {
+          _rest = value;
+        }
+        return 0;
+      }
+      if (delta >= range)
+      {
+        // 底打ちで想定より大きく変化したらrangeを広げる
+        _range = (_range < 0) ? -delta : delta;
+        return ANALOG_KEY_SCAN_TOTAL_TRAVEL;
+      }
+      return static_cast<uint16_t>(delta * ANALOG_KEY_SCAN_TOTAL_TRAVEL / range);
+    }
+
+    int32_t _filtered;
+    uint16_t _rest;
+    int16_t _range;
+    uint16_t _travel;
+    uint16_t _extreme;
+    bool _is_pressed;
+  };
+
+} // namespace hidpg
@@ -1,7 +1,7 @@
 /*
   The MIT License (MIT)
 
-  Copyright (c) 2019 ogatatsu.
+  Copyright (c) 2022 ogatatsu.
 
   Permission is hereby granted, free of charge, to any person obtaining a copy
   of this software and associated documentation files (the "Software"), to deal
@@ -22,34 +22,21 @@
   THE SOFTWARE.
 */
 
-#include "Switch.h"
+#pragma once
+
+#include <stdint.h>
 
 namespace hidpg
 {
 
-  Switch::Switch(uint8_t id, uint16_t debounce_delay_ms) : Bounce(), _id(id)
-  {
-    this->interval(debounce_delay_ms);
-  }
-
-  void Switch::updateState(Set &switch_ids)
-  {
-    if (this->update())
-    {
-      if (this->read() == MATRIX_SCAN_ACTIVE_STATE)
-      {
-        switch_ids.add(_id);
-      }
-      else
-      {
-        switch_ids.remove(_id);
-      }
-    }
-  }
-
-  uint16_t Switch::getDebounceDelay() const
+  // AnalogKeyScanがキーのADCの値を読むためのインターフェース
+  // ADCやマルチプレクサの構成毎に実装する、ホストでは合成した値を返す実装に差し替えられる
+  class AnalogSource
   {
-    return this->interval_millis;
-  }
+  public:
+    virtual void begin() = 0;
+    // チャンネル0からlen-1までの値をvaluesに読む
+    virtual void read(uint16_t values[], uint8_t len) = 0;
+  };
 
 } // namespace hidpg
@@ -0,0 +1,73 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "MuxAnalogSource.h"
+#include "AnalogKeyScan_config.h"
+
+namespace hidpg
+{
+
+  void MuxAnalogSource::begin()
+  {
+    for (int i = 0; i < _select_pins_len; i++)
+    {
+      pinMode(_select_pins[i], OUTPUT);
+      digitalWrite(_select_pins[i], LOW);
+    }
+#ifdef ARDUINO_ARCH_NRF52
+    analogReadResolution(ANALOG_KEY_SCAN_ADC_RESOLUTION);
+#endif
+  }
+
+  void MuxAnalogSource::select(uint8_t mux_channel)
+  {
+    for (int i = 0; i < _select_pins_len; i++)
+    {
+      digitalWrite(_select_pins[i], bitRead(mux_channel, i));
+    }
+#if (ANALOG_KEY_SCAN_MUX_SETTLE_US > 0)
+    delayMicroseconds(ANALOG_KEY_SCAN_MUX_SETTLE_US);
+#endif
+  }
+
+  void MuxAnalogSource::read(uint16_t values[], uint8_t len)
+  {
+    uint16_t mux_channels_len = 1 << _select_pins_len;
+
+    for (int ch = 0; ch < mux_channels_len; ch++)
+    {
+      uint16_t base = ch * _adc_pins_len;
+      if (base >= len)
+      {
+        break;
+      }
+      select(ch);
+      for (int i = 0; i < _adc_pins_len && base + i < len; i++)
+      {
+        values[base + i] = analogRead(_adc_pins[i]);
+      }
+    }
+  }
+
+} // namespace hidpg
@@ -0,0 +1,57 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "AnalogSource.h"
+#include "Arduino.h"
+
+namespace hidpg
+{
+
+  // 74HC4067などのアナログマルチプレクサをselect_pinsで切り替えて、adc_pinsのADCで読む
+  // チャンネル番号は (マルチプレクサのチャンネル * adc_pinsの数 + adc_pinsのインデックス)
+  // マルチプレクサの切り替え1回で全てのADCのピンを読む
+  class MuxAnalogSource : public AnalogSource
+  {
+  public:
+    template <uint8_t select_pins_len, uint8_t adc_pins_len>
+    MuxAnalogSource(const uint8_t (&select_pins)[select_pins_len], const uint8_t (&adc_pins)[adc_pins_len])
+        : _select_pins(select_pins), _adc_pins(adc_pins), _select_pins_len(select_pins_len), _adc_pins_len(adc_pins_len)
+    {
+    }
+
+    void begin() override;
+    void read(uint16_t values[], uint8_t len) override;
+
+  private:
+    void select(uint8_t mux_channel);
+
+    const uint8_t *_select_pins;
+    const uint8_t *_adc_pins;
+    uint8_t _select_pins_len;
+    uint8_t _adc_pins_len;
+  };
+
+} // namespace hidpg
@@ -29,6 +29,17 @@
 namespace hidpg
 {
 
+  // Link parameters requested by the central after the connection is secured.
+  struct BLELinkPreference
+  {
+    uint16_t connection_interval; // in unit of 1.25 ms, 0 = keep the peer's choice
+    uint16_t slave_latency;
+    uint16_t supervision_timeout; // in unit of 10 ms
+    uint8_t phy;                  // BLE_GAP_PHY_xxx, BLE_GAP_PHY_AUTO = no request
+    uint8_t event_length;         // in unit of 1.25 ms, 0 = Bluefruit default (applied in setProfile())
+    uint16_t data_length;         // max LL payload (27..251), 0 = no request
+  };
+
   class BLECentralProfile
   {
   public:
@@ -39,6 +50,19 @@ namespace hidpg
     virtual bool discover(uint16_t conn_handle) = 0;
     virtual bool discovered() = 0;
     virtual bool enable() = 0;
+
+    void setLinkPreference(const BLELinkPreference &link_preference) { _link_preference = link_preference; }
+    const BLELinkPreference &getLinkPreference() const { return _link_preference; }
+
+  private:
+    BLELinkPreference _link_preference = {
+        .connection_interval = 0,
+        .slave_latency = BLE_GAP_CONN_SLAVE_LATENCY,
+        .supervision_timeout = BLE_GAP_CONN_SUP_TIMEOUT,
+        .phy = BLE_GAP_PHY_2MBPS,
+        .event_length = 0,
+        .data_length = 0,
+    };
   };
 
 } // namespace hidpg
@@ -33,18 +33,55 @@ namespace hidpg::Internal
   uint8_t Bluefruit_ConnectionControllerCentral::_unconnected_count = 0;
   bool Bluefruit_ConnectionControllerCentral::_is_running = false;
   Bluefruit_ConnectionControllerCentral::disconnectCallbackCallback_t Bluefruit_ConnectionControllerCentral::_disconnect_callback = nullptr;
+  Bluefruit_ConnectionControllerCentral::eventCallback_t Bluefruit_ConnectionControllerCentral::_event_callback = nullptr;
 
   void Bluefruit_ConnectionControllerCentral::begin()
   {
     Bluefruit.Central.setConnectCallback(connect_callback);
     Bluefruit.Central.setDisconnectCallback(disconnect_callback);
     Bluefruit.Security.setSecuredCallback(connection_secured_callback);
+    Bluefruit.setEventCallback(ble_event_callback);
+
+    // 送るデータがある間は接続イベントをevent_lengthを超えて延長させる
+    ble_opt_t opt;
+    varclr(&opt);
+    opt.common_opt.conn_evt_ext.enable = 1;
+    sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &opt);
 
     Bluefruit.Scanner.setRxCallback(scan_callback);
     Bluefruit.Scanner.restartOnDisconnect(false);
     Bluefruit.Scanner.setInterval(8, 4); // in unit of 0.625 ms
   }
 
+  void Bluefruit_ConnectionControllerCentral::configCentralConn()
+  {
+    // SoftDeviceの接続設定はBluefruit.begin()で確定するので、それ以降は反映されない
+    uint8_t sd_enabled = 0;
+    sd_softdevice_is_enabled(&sd_enabled);
+    if (sd_enabled)
+    {
+      LOG_LV1("CENTRAL", "setProfile() must be called before Bluefruit.begin(), event_length and data_length are not applied");
+      return;
+    }
+
+    uint16_t mtu_max = BLE_GATT_ATT_MTU_DEFAULT;
+    uint8_t event_length = BLE_GAP_EVENT_LENGTH_DEFAULT;
+
+    for (size_t i = 0; i < _profile_list_len; i++)
+    {
+      const BLELinkPreference &pref = _profile_list[i]->getLinkPreference();
+
+      event_length = max(pref.event_length, event_length);
+      if (pref.data_length > BLE_GAP_DATA_LENGTH_DEFAULT)
+      {
+        // LL payload = ATT MTU + L2CAP header(4 bytes)
+        mtu_max = max(static_cast<uint16_t>(pref.data_length - 4), mtu_max);
+      }
+    }
+
+    Bluefruit.configCentralConn(mtu_max, event_length, BLE_GATTS_HVN_TX_QUEUE_SIZE_DEFAULT, BLE_GATTC_WRITE_CMD_TX_QUEUE_SIZE_DEFAULT);
+  }
+
   void Bluefruit_ConnectionControllerCentral::setScanLed(BlinkLed *scan_led)
   {
     _scan_led = scan_led;
@@ -129,6 +166,11 @@ namespace hidpg::Internal
     _disconnect_callback = callback;
   }
 
+  void Bluefruit_ConnectionControllerCentral::setEventCallback(eventCallback_t callback)
+  {
+    _event_callback = callback;
+  }
+
   void Bluefruit_ConnectionControllerCentral::scan_callback(ble_gap_evt_adv_report_t *report)
   {
     for (size_t i = 0; i < _profile_list_len; i++)
@@ -180,7 +222,8 @@ namespace hidpg::Internal
         if (_profile_list[i]->connHandle() == conn_handle)
         {
           _profile_list[i]->enable();
-          conn->requestPHY();
+          // PHY -> Data Length -> Connection Parameterの順に1つずつ要求する（SoftDeviceは同時に1つの手続きしか受け付けない）
+          requestPHY(conn, _profile_list[i]->getLinkPreference());
 
           if (_unconnected_count == 0)
           {
@@ -210,4 +253,129 @@ namespace hidpg::Internal
     }
   }
 
+  void Bluefruit_ConnectionControllerCentral::ble_event_callback(ble_evt_t *evt)
+  {
+    processLinkUpdate(evt);
+
+    if (_event_callback != nullptr)
+    {
+      _event_callback(evt);
+    }
+  }
+
+  void Bluefruit_ConnectionControllerCentral::processLinkUpdate(ble_evt_t *evt)
+  {
+    uint16_t conn_handle = evt->evt.gap_evt.conn_handle;
+
+    switch (evt->header.evt_id)
+    {
+    case BLE_GAP_EVT_PHY_UPDATE:
+    {
+      BLECentralProfile *profile = findProfile(conn_handle);
+      if (profile == nullptr)
+      {
+        return;
+      }
+
+      const ble_gap_evt_phy_update_t &phy = evt->evt.gap_evt.params.phy_update;
+      LOG_LV1("CENTRAL", "conn %d PHY: status = %d, tx = %d, rx = %d", conn_handle, phy.status, phy.tx_phy, phy.rx_phy);
+
+      requestDataLength(Bluefruit.Connection(conn_handle), profile->getLinkPreference());
+    }
+    break;
+
+    case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
+    {
+      BLECentralProfile *profile = findProfile(conn_handle);
+      if (profile == nullptr)
+      {
+        return;
+      }
+
+      const ble_gap_data_length_params_t &dl = evt->evt.gap_evt.params.data_length_update.effective_params;
+      LOG_LV1("CENTRAL", "conn %d Data Length: tx = %d bytes / %d us, rx = %d bytes / %d us", conn_handle, dl.max_tx_octets, dl.max_tx_time_us, dl.max_rx_octets, dl.max_rx_time_us);
+
+      requestConnectionParameter(Bluefruit.Connection(conn_handle), profile->getLinkPreference());
+    }
+    break;
+
+    case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+    {
+      if (findProfile(conn_handle) == nullptr)
+      {
+        return;
+      }
+
+      const ble_gap_conn_params_t &param = evt->evt.gap_evt.params.conn_param_update.conn_params;
+      LOG_LV1("CENTRAL", "conn %d Connection Parameter: interval = %d, latency = %d, timeout = %d", conn_handle, param.max_conn_interval, param.slave_latency, param.conn_sup_timeout);
+    }
+    break;
+
+    default:
+      break;
+    }
+  }
+
+  BLECentralProfile *Bluefruit_ConnectionControllerCentral::findProfile(uint16_t conn_handle)
+  {
+    for (size_t i = 0; i < _profile_list_len; i++)
+    {
+      if (_profile_list[i]->connHandle() == conn_handle)
+      {
+        return _profile_list[i];
+      }
+    }
+    return nullptr;
+  }
+
+  void Bluefruit_ConnectionControllerCentral::requestPHY(BLEConnection *conn, const BLELinkPreference &pref)
+  {
+    // 要求が通ればBLE_GAP_EVT_PHY_UPDATEで次に進む
+    if (pref.phy != BLE_GAP_PHY_AUTO && conn->requestPHY(pref.phy))
+    {
+      return;
+    }
+    requestDataLength(conn, pref);
+  }
+
+  void Bluefruit_ConnectionControllerCentral::requestDataLength(BLEConnection *conn, const BLELinkPreference &pref)
+  {
+    if (conn == nullptr)
+    {
+      return;
+    }
+
+    if (pref.data_length > BLE_GAP_DATA_LENGTH_DEFAULT)
+    {
+      ble_gap_data_length_params_t params = {
+          .max_tx_octets = pref.data_length,
+          .max_rx_octets = pref.data_length,
+          .max_tx_time_us = BLE_GAP_DATA_LENGTH_AUTO,
+          .max_rx_time_us = BLE_GAP_DATA_LENGTH_AUTO,
+      };
+
+      // 要求が通ればBLE_GAP_EVT_DATA_LENGTH_UPDATEで次に進む
+      if (conn->requestDataLengthUpdate(&params))
+      {
+        return;
+      }
+    }
+    requestConnectionParameter(conn, pref);
+  }
+
+  void Bluefruit_ConnectionControllerCentral::requestConnectionParameter(BLEConnection *conn, const BLELinkPreference &pref)
+  {
+    if (conn == nullptr || pref.connection_interval == 0)
+    {
+      return;
+    }
+
+    if (conn->getConnectionInterval() == pref.connection_interval && conn->getSlaveLatency() == pref.slave_latency)
+    {
+      return;
+    }
+
+    conn->requestConnectionParameter(pref.connection_interval, pref.slave_latency, pref.supervision_timeout);
+  }
+
 } // namespace hidpg::Internal
@@ -42,13 +42,18 @@ namespace hidpg::Internal
 
   public:
     using disconnectCallbackCallback_t = void (*)(uint16_t conn_handle, uint8_t reason);
+    using eventCallback_t = void (*)(ble_evt_t *evt);
 
+    // Bluefruit.begin()より前に呼ぶ
+    // プロファイルのevent_length, data_lengthの最大値でSoftDeviceの接続設定もここで行う
     static void setProfile(BLECentralProfile *profile_list[], uint8_t profile_list_len)
     {
       _profile_list = profile_list;
       _profile_list_len = profile_list_len;
       _unconnected_count = _profile_list_len;
 
+      configCentralConn();
+
       for (size_t i = 0; i < profile_list_len; i++)
       {
         if (profile_list[i]->needsActiveScan())
@@ -82,9 +87,13 @@ namespace hidpg::Internal
     static void stop();
     static bool isRunning();
     static void setDisconnectCallback(disconnectCallbackCallback_t callback);
+    // Bluefruit.setEventCallback()はコントローラが使うので、アプリのイベントコールバックはこちらで設定する
+    // コントローラの処理の後に全てのイベントが渡される
+    static void setEventCallback(eventCallback_t callback);
 
   private:
     static void begin();
+    static void configCentralConn();
     static void _start();
     static void _stop();
     static bool startScan();
@@ -92,12 +101,19 @@ namespace hidpg::Internal
     static void connect_callback(uint16_t conn_handle);
     static void connection_secured_callback(uint16_t conn_handle);
     static void disconnect_callback(uint16_t conn_handle, uint8_t reason);
+    static void ble_event_callback(ble_evt_t *evt);
+    static void processLinkUpdate(ble_evt_t *evt);
+    static BLECentralProfile *findProfile(uint16_t conn_handle);
+    static void requestPHY(BLEConnection *conn, const BLELinkPreference &pref);
+    static void requestDataLength(BLEConnection *conn, const BLELinkPreference &pref);
+    static void requestConnectionParameter(BLEConnection *conn, const BLELinkPreference &pref);
 
     static BLECentralProfile **_profile_list;
     static uint8_t _profile_list_len;
     static uint8_t _unconnected_count;
     static bool _is_running;
     static disconnectCallbackCallback_t _disconnect_callback;
+    static eventCallback_t _event_callback;
 
     static BlinkLed *_scan_led;
   };
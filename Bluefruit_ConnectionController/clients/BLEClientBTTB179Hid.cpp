@@ -31,6 +31,7 @@ namespace hidpg
   BLEClientBTTB179Hid::BLEClientBTTB179Hid(void)
       : BLEClientService(UUID16_SVC_HUMAN_INTERFACE_DEVICE),
         _trackball_cb(nullptr),
+        _trackball_relay(nullptr),
         _trackball_input(UUID16_CHR_REPORT)
   {
   }
@@ -53,6 +54,11 @@ namespace hidpg
     _trackball_cb = fp;
   }
 
+  void BLEClientBTTB179Hid::setTrackballReportRelay(BLEMouseRelay *relay)
+  {
+    _trackball_relay = relay;
+  }
+
   bool BLEClientBTTB179Hid::discover(uint16_t conn_handle)
   {
     // Call Base class discover
@@ -83,9 +89,20 @@ namespace hidpg
 
   void BLEClientBTTB179Hid::_handle_trackball_input(uint8_t *data, uint16_t len)
   {
-    if (_trackball_cb && (len == sizeof(trackball_report_t)))
+    if (len != sizeof(trackball_report_t))
+    {
+      return;
+    }
+
+    trackball_report_t *report = (trackball_report_t *)data;
+
+    if (_trackball_relay != nullptr)
+    {
+      _trackball_relay->relay(report->buttons, report->x, report->y, report->wheel, report->pan);
+    }
+
+    if (_trackball_cb != nullptr)
     {
-      trackball_report_t *report = (trackball_report_t *)data;
       _trackball_cb(report->buttons, report->x, report->y, report->wheel, report->pan);
     }
   }
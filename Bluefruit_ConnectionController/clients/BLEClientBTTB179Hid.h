@@ -26,6 +26,7 @@
 
 #include "BLEClientCharacteristic.h"
 #include "BLEClientService.h"
+#include "BLEMouseRelay.h"
 
 namespace hidpg
 {
@@ -47,9 +48,11 @@ namespace hidpg
 
     // Report callback
     void setTrackballReportCallback(trackball_callback_t fp);
+    void setTrackballReportRelay(BLEMouseRelay *relay);
 
   private:
     trackball_callback_t _trackball_cb;
+    BLEMouseRelay *_trackball_relay;
     BLEClientCharacteristic _trackball_input;
 
     void _handle_trackball_input(uint8_t *data, uint16_t len);
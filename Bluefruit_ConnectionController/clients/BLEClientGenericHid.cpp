@@ -0,0 +1,400 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "BLEClientGenericHid.h"
+#include "bluefruit.h"
+
+namespace hidpg
+{
+  constexpr uint16_t Usage_Page_Generic_Desktop = 0x01;
+  constexpr uint16_t Usage_Page_Keyboard = 0x07;
+  constexpr uint16_t Usage_Page_Button = 0x09;
+  constexpr uint16_t Usage_Page_Consumer = 0x0C;
+
+  constexpr uint16_t Usage_X = 0x30;
+  constexpr uint16_t Usage_Y = 0x31;
+  constexpr uint16_t Usage_Wheel = 0x38;
+  constexpr uint16_t Usage_AC_Pan = 0x0238;
+  constexpr uint16_t Usage_Left_Control = 0xE0;
+
+  constexpr uint8_t Report_Id_Unresolved = 0xFF;
+
+  // Report Referenceディスクリプタのレポートタイプ
+  constexpr uint8_t Report_Type_Input = 1;
+
+  uint8_t BLEClientGenericHid::_report_map_buffer[REPORT_MAP_BUFFER_SIZE];
+
+  BLEClientGenericHid::BLEClientGenericHid(void)
+      : BLEClientService(UUID16_SVC_HUMAN_INTERFACE_DEVICE),
+        _mouse_cb(nullptr),
+        _mouse_relay(nullptr),
+        _keyboard_cb(nullptr),
+        _consumer_cb(nullptr),
+        _report_map(UUID16_CHR_REPORT_MAP),
+        _report_chr_count(0),
+        _report_reference(BLEUuid(BLE_UUID_REPORT_REF_DESCR)),
+        _mouse(),
+        _keyboard(),
+        _consumer()
+  {
+  }
+
+  bool BLEClientGenericHid::begin()
+  {
+    // Invoke base class begin()
+    BLEClientService::begin();
+
+    _report_map.begin(this);
+    _report_reference.begin(this);
+
+    for (BLEClientCharacteristic &chr : _report_chrs)
+    {
+      chr.uuid = BLEUuid(UUID16_CHR_REPORT);
+      chr.begin(this);
+      // set notify callback
+      chr.setNotifyCallback(report_client_notify_cb);
+    }
+
+    return true;
+  }
+
+  void BLEClientGenericHid::setMouseReportCallback(mouse_callback_t fp)
+  {
+    _mouse_cb = fp;
+  }
+
+  void BLEClientGenericHid::setMouseReportRelay(BLEMouseRelay *relay)
+  {
+    _mouse_relay = relay;
+  }
+
+  void BLEClientGenericHid::setKeyboardReportCallback(keyboard_callback_t fp)
+  {
+    _keyboard_cb = fp;
+  }
+
+  void BLEClientGenericHid::setConsumerReportCallback(consumer_callback_t fp)
+  {
+    _consumer_cb = fp;
+  }
+
+  bool BLEClientGenericHid::discover(uint16_t conn_handle)
+  {
+    // Call Base class discover
+    VERIFY(BLEClientService::discover(conn_handle));
+    _conn_hdl = BLE_CONN_HANDLE_INVALID; // make as invalid until we found all chars
+
+    // Discover all characteristics
+    Bluefruit.Discovery.discoverCharacteristic(conn_handle, _report_map);
+    VERIFY(_report_map.discovered());
+
+    BLEClientCharacteristic *chrs[MAX_REPORT_CHRS];
+    for (uint8_t i = 0; i < MAX_REPORT_CHRS; i++)
+    {
+      chrs[i] = &_report_chrs[i];
+    }
+    _report_chr_count = Bluefruit.Discovery.discoverCharacteristic(conn_handle, chrs, MAX_REPORT_CHRS);
+    VERIFY(_report_chr_count > 0);
+
+    // readはサービスのconn handleを使うので、読み込みの間だけ有効にする
+    _conn_hdl = conn_handle;
+
+    // Report Mapは長いのでlong readで読み込まれる
+    uint16_t len = _report_map.read(_report_map_buffer, sizeof(_report_map_buffer));
+    if (len == 0 || compile(_report_map_buffer, len) == false || readReportReferences(conn_handle) == false)
+    {
+      _conn_hdl = BLE_CONN_HANDLE_INVALID;
+      return false;
+    }
+
+    return true;
+  }
+
+  bool BLEClientGenericHid::readReportReferences(uint16_t conn_handle)
+  {
+    bool has_input = false;
+    for (uint8_t i = 0; i < _report_chr_count; i++)
+    {
+      uint8_t report_id;
+      uint8_t report_type;
+      _report_ids[i] = Report_Id_Unresolved;
+
+      if (readReportReference(conn_handle, _report_chrs[i], report_id, report_type))
+      {
+        if (report_type == Report_Type_Input && _parser.findReport(report_id) != nullptr)
+        {
+          _report_ids[i] = report_id;
+          has_input = true;
+        }
+      }
+      else if (_parser.reportCount() == 1)
+      {
+        // ディスクリプタが無い場合、Inputレポートが1つだけならそれとみなす
+        _report_ids[i] = _parser.report(0).report_id;
+        has_input = true;
+      }
+    }
+    return has_input;
+  }
+
+  bool BLEClientGenericHid::readReportReference(uint16_t conn_handle, BLEClientCharacteristic &chr, uint8_t &report_id, uint8_t &report_type)
+  {
+    // キャラクタリスティックの値の後ろから次の宣言までがそのキャラクタリスティックのディスクリプタ
+    constexpr uint8_t MAX_DESCRIPTORS = 4;
+    union
+    {
+      ble_gattc_evt_desc_disc_rsp_t rsp;
+      uint8_t raw[sizeof(ble_gattc_evt_desc_disc_rsp_t) + (MAX_DESCRIPTORS - 1) * sizeof(ble_gattc_desc_t)];
+    } disc;
+
+    uint16_t start_handle = chr.valueHandle() + 1;
+    uint16_t end_handle = Bluefruit.Discovery.getHandleRange().end_handle;
+    if (start_handle > end_handle)
+    {
+      return false;
+    }
+
+    uint16_t count = Bluefruit.Discovery._discoverDescriptor(conn_handle, &disc.rsp, sizeof(disc), start_handle, end_handle);
+    for (uint16_t i = 0; i < count; i++)
+    {
+      const ble_gattc_desc_t &desc = disc.rsp.descs[i];
+      if (desc.uuid.type != BLE_UUID_TYPE_BLE)
+      {
+        continue;
+      }
+      if (desc.uuid.uuid == BLE_UUID_CHARACTERISTIC || desc.uuid.uuid == BLE_UUID_SERVICE_PRIMARY || desc.uuid.uuid == BLE_UUID_SERVICE_SECONDARY)
+      {
+        break;
+      }
+      if (desc.uuid.uuid != BLE_UUID_REPORT_REF_DESCR)
+      {
+        continue;
+      }
+
+      // Bluefruitにはディスクリプタを読むAPIが無いので、ディスクリプタのハンドルを値に割り当てたキャラクタリスティックとして読む
+      ble_gattc_char_t ref = {};
+      ref.uuid = desc.uuid;
+      ref.handle_value = desc.handle;
+      ref.char_props.read = 1;
+      _report_reference._assign(&ref);
+
+      // [0]: Report ID, [1]: Report Type (1: Input, 2: Output, 3: Feature)
+      uint8_t value[2];
+      if (_report_reference.read(value, sizeof(value)) != sizeof(value))
+      {
+        return false;
+      }
+      report_id = value[0];
+      report_type = value[1];
+      return true;
+    }
+    return false;
+  }
+
+  const HidReportMapParser::Field *BLEClientGenericHid::findVariable(uint16_t usage_page, uint16_t usage, Field &storage)
+  {
+    uint16_t index;
+    const Field *field = _parser.findField(usage_page, usage, &index);
+    if (field == nullptr || field->is_array)
+    {
+      return nullptr;
+    }
+    storage = HidReportMapParser::element(*field, index);
+    return &storage;
+  }
+
+  const HidReportMapParser::Field *BLEClientGenericHid::mergeVariableFields(uint16_t usage_page, uint16_t usage_min, uint8_t max_count, Field &storage)
+  {
+    uint16_t index;
+    const Field *first = _parser.findField(usage_page, usage_min, &index);
+    if (first == nullptr || first->is_array || first->bit_size != 1)
+    {
+      return nullptr;
+    }
+
+    // 同じレポート内で隣接する1bitの値を連結する
+    storage = HidReportMapParser::element(*first, index);
+    storage.bit_size = std::min<uint16_t>(first->count - index, max_count);
+    for (uint8_t i = (first - &_parser.field(0)) + 1; i < _parser.fieldCount() && storage.bit_size < max_count; i++)
+    {
+      const Field &f = _parser.field(i);
+      if (f.is_array ||
+          f.report_id != first->report_id ||
+          f.usage_page != usage_page ||
+          f.bit_size != 1 ||
+          f.bit_offset != storage.bit_offset + storage.bit_size)
+      {
+        break;
+      }
+      storage.bit_size = std::min<uint16_t>(storage.bit_size + f.count, max_count);
+    }
+    storage.is_signed = false;
+    return &storage;
+  }
+
+  bool BLEClientGenericHid::compile(const uint8_t *report_map, uint16_t len)
+  {
+    VERIFY(_parser.parse(report_map, len));
+
+    _mouse.buttons = mergeVariableFields(Usage_Page_Button, 1, 8, _mouse.buttons_storage);
+    _mouse.x = findVariable(Usage_Page_Generic_Desktop, Usage_X, _mouse.x_storage);
+    _mouse.y = findVariable(Usage_Page_Generic_Desktop, Usage_Y, _mouse.y_storage);
+    _mouse.wheel = findVariable(Usage_Page_Generic_Desktop, Usage_Wheel, _mouse.wheel_storage);
+    _mouse.pan = findVariable(Usage_Page_Consumer, Usage_AC_Pan, _mouse.pan_storage);
+
+    _keyboard.modifiers = mergeVariableFields(Usage_Page_Keyboard, Usage_Left_Control, 8, _keyboard.modifiers_storage);
+    _keyboard.key_codes = nullptr;
+    _consumer.usage_code = nullptr;
+    for (uint8_t i = 0; i < _parser.fieldCount(); i++)
+    {
+      const Field &f = _parser.field(i);
+      if (f.is_array && f.usage_page == Usage_Page_Keyboard && _keyboard.key_codes == nullptr)
+      {
+        _keyboard.key_codes = &f;
+      }
+      else if (f.is_array && f.usage_page == Usage_Page_Consumer && _consumer.usage_code == nullptr)
+      {
+        _consumer.usage_code = &f;
+      }
+    }
+
+    return true;
+  }
+
+  //------------------------------------------------------------------+
+  // Input
+  //------------------------------------------------------------------+
+  bool BLEClientGenericHid::enableInput()
+  {
+    // Output, Featureレポートはnotifyできないので飛ばす
+    bool result = false;
+    for (uint8_t i = 0; i < _report_chr_count; i++)
+    {
+      if (_report_ids[i] != Report_Id_Unresolved)
+      {
+        result |= _report_chrs[i].enableNotify();
+      }
+    }
+    return result;
+  }
+
+  bool BLEClientGenericHid::disableInput()
+  {
+    bool result = false;
+    for (uint8_t i = 0; i < _report_chr_count; i++)
+    {
+      if (_report_ids[i] != Report_Id_Unresolved)
+      {
+        result |= _report_chrs[i].disableNotify();
+      }
+    }
+    return result;
+  }
+
+  void BLEClientGenericHid::_handle_input(uint8_t chr_index, uint8_t *data, uint16_t len)
+  {
+    uint8_t report_id = _report_ids[chr_index];
+    if (report_id == Report_Id_Unresolved)
+    {
+      return;
+    }
+
+    const HidReportMapParser::Report *report = _parser.findReport(report_id);
+    if (report == nullptr || report->byteLength() != len)
+    {
+      return;
+    }
+
+    _handle_mouse(report_id, data, len);
+    _handle_keyboard(report_id, data, len);
+    _handle_consumer(report_id, data, len);
+  }
+
+  void BLEClientGenericHid::_handle_mouse(uint8_t report_id, const uint8_t *data, uint16_t len)
+  {
+    if (hasMouse() == false || _mouse.x->report_id != report_id)
+    {
+      return;
+    }
+
+    uint8_t buttons = (_mouse.buttons != nullptr) ? HidReportMapParser::extract(data, len, *_mouse.buttons) : 0;
+    int16_t x = constrain(HidReportMapParser::extract(data, len, *_mouse.x), INT16_MIN, INT16_MAX);
+    int16_t y = constrain(HidReportMapParser::extract(data, len, *_mouse.y), INT16_MIN, INT16_MAX);
+    int8_t wheel = (_mouse.wheel != nullptr && _mouse.wheel->report_id == report_id)
+                       ? constrain(HidReportMapParser::extract(data, len, *_mouse.wheel), INT8_MIN, INT8_MAX)
+                       : 0;
+    int8_t pan = (_mouse.pan != nullptr && _mouse.pan->report_id == report_id)
+                     ? constrain(HidReportMapParser::extract(data, len, *_mouse.pan), INT8_MIN, INT8_MAX)
+                     : 0;
+
+    if (_mouse_relay != nullptr)
+    {
+      _mouse_relay->relay(buttons, x, y, wheel, pan);
+    }
+
+    if (_mouse_cb != nullptr)
+    {
+      _mouse_cb(buttons, x, y, wheel, pan);
+    }
+  }
+
+  void BLEClientGenericHid::_handle_keyboard(uint8_t report_id, const uint8_t *data, uint16_t len)
+  {
+    if (_keyboard_cb == nullptr || hasKeyboard() == false || _keyboard.key_codes->report_id != report_id)
+    {
+      return;
+    }
+
+    uint8_t modifiers = (_keyboard.modifiers != nullptr) ? HidReportMapParser::extract(data, len, *_keyboard.modifiers) : 0;
+    uint8_t key_codes[6] = {};
+    uint16_t count = min(_keyboard.key_codes->count, static_cast<uint16_t>(6));
+    for (uint16_t i = 0; i < count; i++)
+    {
+      key_codes[i] = HidReportMapParser::extractArrayUsage(data, len, *_keyboard.key_codes, i);
+    }
+
+    _keyboard_cb(modifiers, key_codes);
+  }
+
+  void BLEClientGenericHid::_handle_consumer(uint8_t report_id, const uint8_t *data, uint16_t len)
+  {
+    if (_consumer_cb == nullptr || hasConsumer() == false || _consumer.usage_code->report_id != report_id)
+    {
+      return;
+    }
+
+    _consumer_cb(HidReportMapParser::extractArrayUsage(data, len, *_consumer.usage_code));
+  }
+
+  void BLEClientGenericHid::report_client_notify_cb(BLEClientCharacteristic *chr, uint8_t *data, uint16_t len)
+  {
+    BLEClientGenericHid &svc = (BLEClientGenericHid &)chr->parentService();
+    uint8_t chr_index = chr - svc._report_chrs;
+    if (chr_index < svc._report_chr_count)
+    {
+      svc._handle_input(chr_index, data, len);
+    }
+  }
+
+} // namespace hidpg
@@ -0,0 +1,132 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "BLEClientCharacteristic.h"
+#include "BLEClientService.h"
+#include "BLEMouseRelay.h"
+#include "HidReportMapParser.h"
+
+namespace hidpg
+{
+
+  // Report Mapを読み込んでレポートの形式を決めるHIDクライアント
+  // デバイス毎にレポート構造体を書かなくてもマウス、キーボード、コンシューマのレポートを受け取れる
+  // Report Mapの解析はdiscover時に1回だけ行い、notify時は事前に求めたbit offsetから値を切り出すだけ
+  class BLEClientGenericHid : public BLEClientService
+  {
+  public:
+    static constexpr uint8_t MAX_REPORT_CHRS = 8;
+    static constexpr uint16_t REPORT_MAP_BUFFER_SIZE = 512;
+
+    // Callback Signatures
+    using mouse_callback_t = void (*)(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t pan);
+    using keyboard_callback_t = void (*)(uint8_t modifiers, uint8_t key_codes[6]);
+    using consumer_callback_t = void (*)(uint16_t usage_code);
+
+    BLEClientGenericHid();
+
+    bool begin() override;
+    bool discover(uint16_t conn_handle) override;
+
+    bool enableInput();
+    bool disableInput();
+
+    bool hasMouse() const { return _mouse.x != nullptr && _mouse.y != nullptr; }
+    bool hasKeyboard() const { return _keyboard.key_codes != nullptr; }
+    bool hasConsumer() const { return _consumer.usage_code != nullptr; }
+
+    // Report callback
+    void setMouseReportCallback(mouse_callback_t fp);
+    void setMouseReportRelay(BLEMouseRelay *relay);
+    void setKeyboardReportCallback(keyboard_callback_t fp);
+    void setConsumerReportCallback(consumer_callback_t fp);
+
+  private:
+    using Field = HidReportMapParser::Field;
+
+    // Variableのフィールドは複数の値をまとめていることがあるので、使う値だけのフィールドを_storageに取り出す
+    struct MouseFields
+    {
+      Field buttons_storage; // ボタンは連続したVariableの値を1つのフィールドにまとめる
+      Field x_storage;
+      Field y_storage;
+      Field wheel_storage;
+      Field pan_storage;
+      const Field *buttons;
+      const Field *x;
+      const Field *y;
+      const Field *wheel;
+      const Field *pan;
+    };
+
+    struct KeyboardFields
+    {
+      Field modifiers_storage;
+      const Field *modifiers;
+      const Field *key_codes;
+    };
+
+    struct ConsumerFields
+    {
+      const Field *usage_code;
+    };
+
+    mouse_callback_t _mouse_cb;
+    BLEMouseRelay *_mouse_relay;
+    keyboard_callback_t _keyboard_cb;
+    consumer_callback_t _consumer_cb;
+
+    BLEClientCharacteristic _report_map;
+    BLEClientCharacteristic _report_chrs[MAX_REPORT_CHRS];
+    uint8_t _report_chr_count;
+    // キャラクタリスティック毎のInputレポートのID、Output, Featureレポートは未解決のまま
+    uint8_t _report_ids[MAX_REPORT_CHRS];
+    // Report Referenceディスクリプタの読み込み用
+    BLEClientCharacteristic _report_reference;
+
+    HidReportMapParser _parser;
+    MouseFields _mouse;
+    KeyboardFields _keyboard;
+    ConsumerFields _consumer;
+
+    // Report Mapの読み込み用、discoverはBLEタスクから順に呼ばれるので全インスタンスで共有する
+    static uint8_t _report_map_buffer[REPORT_MAP_BUFFER_SIZE];
+
+    bool compile(const uint8_t *report_map, uint16_t len);
+    const Field *findVariable(uint16_t usage_page, uint16_t usage, Field &storage);
+    const Field *mergeVariableFields(uint16_t usage_page, uint16_t usage_min, uint8_t max_count, Field &storage);
+    bool readReportReferences(uint16_t conn_handle);
+    bool readReportReference(uint16_t conn_handle, BLEClientCharacteristic &chr, uint8_t &report_id, uint8_t &report_type);
+
+    void _handle_input(uint8_t chr_index, uint8_t *data, uint16_t len);
+    void _handle_mouse(uint8_t report_id, const uint8_t *data, uint16_t len);
+    void _handle_keyboard(uint8_t report_id, const uint8_t *data, uint16_t len);
+    void _handle_consumer(uint8_t report_id, const uint8_t *data, uint16_t len);
+
+    static void report_client_notify_cb(BLEClientCharacteristic *chr, uint8_t *data, uint16_t len);
+  };
+
+} // namespace hidpg
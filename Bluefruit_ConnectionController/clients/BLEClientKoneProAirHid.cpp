@@ -31,6 +31,7 @@ namespace hidpg
   BLEClientKoneProAirHid::BLEClientKoneProAirHid(void)
       : BLEClientService(UUID16_SVC_HUMAN_INTERFACE_DEVICE),
         _mouse_cb(nullptr),
+        _mouse_relay(nullptr),
         _mouse_input(UUID16_CHR_REPORT)
   {
   }
@@ -53,6 +54,11 @@ namespace hidpg
     _mouse_cb = fp;
   }
 
+  void BLEClientKoneProAirHid::setMouseReportRelay(BLEMouseRelay *relay)
+  {
+    _mouse_relay = relay;
+  }
+
   bool BLEClientKoneProAirHid::discover(uint16_t conn_handle)
   {
     // Call Base class discover
@@ -83,9 +89,20 @@ namespace hidpg
 
   void BLEClientKoneProAirHid::_handle_mouse_input(uint8_t *data, uint16_t len)
   {
-    if (_mouse_cb && (len == sizeof(mouse_report_t)))
+    if (len != sizeof(mouse_report_t))
+    {
+      return;
+    }
+
+    mouse_report_t *report = (mouse_report_t *)data;
+
+    if (_mouse_relay != nullptr)
+    {
+      _mouse_relay->relay(report->buttons, report->x, report->y, report->wheel, 0);
+    }
+
+    if (_mouse_cb != nullptr)
     {
-      mouse_report_t *report = (mouse_report_t *)data;
       _mouse_cb(report->buttons, report->x, report->y, report->wheel);
     }
   }
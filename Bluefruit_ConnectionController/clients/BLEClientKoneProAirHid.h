@@ -26,6 +26,7 @@
 
 #include "BLEClientCharacteristic.h"
 #include "BLEClientService.h"
+#include "BLEMouseRelay.h"
 
 namespace hidpg
 {
@@ -47,9 +48,11 @@ namespace hidpg
 
     // Report callback
     void setMouseReportCallback(mouse_callback_t fp);
+    void setMouseReportRelay(BLEMouseRelay *relay);
 
   private:
     mouse_callback_t _mouse_cb;
+    BLEMouseRelay *_mouse_relay;
     BLEClientCharacteristic _mouse_input;
 
     void _handle_mouse_input(uint8_t *data, uint16_t len);
@@ -31,6 +31,7 @@ namespace hidpg
   BLEClientRelaconHid::BLEClientRelaconHid(void)
       : BLEClientService(UUID16_SVC_HUMAN_INTERFACE_DEVICE),
         _trackball_cb(nullptr),
+        _trackball_relay(nullptr),
         _consumer_cb(nullptr),
         _trackball_input(UUID16_CHR_REPORT),
         _consumer_input(UUID16_CHR_REPORT)
@@ -57,6 +58,11 @@ namespace hidpg
     _trackball_cb = fp;
   }
 
+  void BLEClientRelaconHid::setTrackballReportRelay(BLEMouseRelay *relay)
+  {
+    _trackball_relay = relay;
+  }
+
   void BLEClientRelaconHid::setConsumerReportCallback(consumer_callback_t fp)
   {
     _consumer_cb = fp;
@@ -92,9 +98,20 @@ namespace hidpg
 
   void BLEClientRelaconHid::_handle_trackball_input(uint8_t *data, uint16_t len)
   {
-    if (_trackball_cb && (len == sizeof(trackball_report_t)))
+    if (len != sizeof(trackball_report_t))
+    {
+      return;
+    }
+
+    trackball_report_t *report = (trackball_report_t *)data;
+
+    if (_trackball_relay != nullptr)
+    {
+      _trackball_relay->relay(report->buttons, report->x, report->y, report->wheel, 0);
+    }
+
+    if (_trackball_cb != nullptr)
     {
-      trackball_report_t *report = (trackball_report_t *)data;
       _trackball_cb(report->buttons, report->x, report->y, report->wheel);
     }
   }
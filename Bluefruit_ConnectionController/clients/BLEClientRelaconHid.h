@@ -26,6 +26,7 @@
 
 #include "BLEClientCharacteristic.h"
 #include "BLEClientService.h"
+#include "BLEMouseRelay.h"
 
 namespace hidpg
 {
@@ -52,10 +53,12 @@ namespace hidpg
 
     // Report callback
     void setTrackballReportCallback(trackball_callback_t fp);
+    void setTrackballReportRelay(BLEMouseRelay *relay);
     void setConsumerReportCallback(consumer_callback_t fp);
 
   private:
     trackball_callback_t _trackball_cb;
+    BLEMouseRelay *_trackball_relay;
     consumer_callback_t _consumer_cb;
 
     BLEClientCharacteristic _trackball_input;
@@ -32,6 +32,7 @@ namespace hidpg
       : BLEClientService(UUID16_SVC_HUMAN_INTERFACE_DEVICE),
         _keyboard_cb(nullptr),
         _trackpoint_cb(nullptr),
+        _trackpoint_relay(nullptr),
         _consumer_cb(nullptr),
         _vendor_cb(nullptr),
         _keyboard_input(UUID16_CHR_REPORT),
@@ -78,6 +79,11 @@ namespace hidpg
     _trackpoint_cb = fp;
   }
 
+  void BLEClientTrackPointKeyboard2Hid::setTrackpointReportRelay(BLEMouseRelay *relay)
+  {
+    _trackpoint_relay = relay;
+  }
+
   void BLEClientTrackPointKeyboard2Hid::setConsumerReportCallback(consumer_callback_t fp)
   {
     _consumer_cb = fp;
@@ -161,9 +167,20 @@ namespace hidpg
 
   void BLEClientTrackPointKeyboard2Hid::_handle_trackpoint_input(uint8_t *data, uint16_t len)
   {
-    if (_trackpoint_cb && (len == sizeof(trackpoint_report_t)))
+    if (len != sizeof(trackpoint_report_t))
+    {
+      return;
+    }
+
+    trackpoint_report_t *report = (trackpoint_report_t *)data;
+
+    if (_trackpoint_relay != nullptr)
+    {
+      _trackpoint_relay->relay(report->buttons, report->x, report->y, report->wheel, 0);
+    }
+
+    if (_trackpoint_cb != nullptr)
     {
-      trackpoint_report_t *report = (trackpoint_report_t *)data;
       _trackpoint_cb(report->buttons, report->x, report->y, report->wheel);
     }
   }
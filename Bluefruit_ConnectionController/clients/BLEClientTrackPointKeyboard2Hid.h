@@ -26,6 +26,7 @@
 
 #include "BLEClientCharacteristic.h"
 #include "BLEClientService.h"
+#include "BLEMouseRelay.h"
 
 namespace hidpg
 {
@@ -61,12 +62,14 @@ namespace hidpg
     // Report callback
     void setKeyboardReportCallback(keyboard_callback_t fp);
     void setTrackpointReportCallback(trackpoint_callback_t fp);
+    void setTrackpointReportRelay(BLEMouseRelay *relay);
     void setConsumerReportCallback(consumer_callback_t fp);
     void setVendorReportCallback(vendor_callback_t fp);
 
   private:
     keyboard_callback_t _keyboard_cb;
     trackpoint_callback_t _trackpoint_cb;
+    BLEMouseRelay *_trackpoint_relay;
     consumer_callback_t _consumer_cb;
     vendor_callback_t _vendor_cb;
 
@@ -0,0 +1,153 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "BLEMouseRelay.h"
+#include "Arduino.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+namespace hidpg
+{
+
+  BLEMouseRelay::BLEMouseRelay()
+      : _motion_cb(nullptr),
+        _buttons_cb(nullptr),
+        _delta_x(0),
+        _delta_y(0),
+        _wheel(0),
+        _pan(0),
+        _needs_motion_call(true),
+        _buttons_queue(),
+        _buttons_head(0),
+        _buttons_count(0),
+        _last_buttons(0),
+        _needs_buttons_call(true)
+  {
+  }
+
+  void BLEMouseRelay::setMotionCallback(callback_t cb)
+  {
+    _motion_cb = cb;
+  }
+
+  void BLEMouseRelay::setButtonsCallback(callback_t cb)
+  {
+    _buttons_cb = cb;
+  }
+
+  void BLEMouseRelay::relay(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t pan)
+  {
+    bool call_motion = false;
+    bool call_buttons = false;
+
+    taskENTER_CRITICAL();
+    if (x != 0 || y != 0 || wheel != 0 || pan != 0)
+    {
+      // 読み出されるまで合算しておく
+      _delta_x += x;
+      _delta_y += y;
+      _wheel = constrain(_wheel + wheel, INT8_MIN, INT8_MAX);
+      _pan = constrain(_pan + pan, INT8_MIN, INT8_MAX);
+      call_motion = _needs_motion_call;
+      _needs_motion_call = false;
+    }
+
+    if (buttons != _last_buttons)
+    {
+      _last_buttons = buttons;
+      if (_buttons_count < BUTTONS_QUEUE_SIZE)
+      {
+        _buttons_queue[(_buttons_head + _buttons_count) % BUTTONS_QUEUE_SIZE] = buttons;
+        _buttons_count++;
+      }
+      else
+      {
+        // 満杯なら最後の状態だけ上書きする、最終的なボタンの状態は失わない
+        _buttons_queue[(_buttons_head + BUTTONS_QUEUE_SIZE - 1) % BUTTONS_QUEUE_SIZE] = buttons;
+      }
+      call_buttons = _needs_buttons_call;
+      _needs_buttons_call = false;
+    }
+    taskEXIT_CRITICAL();
+
+    // ボタンを先に通知してクリック前後のモーションの順序が崩れにくいようにする
+    // 通知できなかったら次のレポートで再度通知する
+    if (call_buttons && _buttons_cb != nullptr && _buttons_cb() == false)
+    {
+      taskENTER_CRITICAL();
+      _needs_buttons_call = true;
+      taskEXIT_CRITICAL();
+    }
+    if (call_motion && _motion_cb != nullptr && _motion_cb() == false)
+    {
+      taskENTER_CRITICAL();
+      _needs_motion_call = true;
+      taskEXIT_CRITICAL();
+    }
+  }
+
+  void BLEMouseRelay::readDelta(int16_t &delta_x, int16_t &delta_y)
+  {
+    taskENTER_CRITICAL();
+    delta_x = constrain(_delta_x, INT16_MIN, INT16_MAX);
+    delta_y = constrain(_delta_y, INT16_MIN, INT16_MAX);
+    _delta_x = 0;
+    _delta_y = 0;
+    _needs_motion_call = true;
+    taskEXIT_CRITICAL();
+  }
+
+  void BLEMouseRelay::readScroll(int8_t &wheel, int8_t &pan)
+  {
+    taskENTER_CRITICAL();
+    wheel = _wheel;
+    pan = _pan;
+    _wheel = 0;
+    _pan = 0;
+    _needs_motion_call = true;
+    taskEXIT_CRITICAL();
+  }
+
+  bool BLEMouseRelay::readButtons(uint8_t &buttons)
+  {
+    bool result = false;
+
+    taskENTER_CRITICAL();
+    if (_buttons_count > 0)
+    {
+      buttons = _buttons_queue[_buttons_head];
+      _buttons_head = (_buttons_head + 1) % BUTTONS_QUEUE_SIZE;
+      _buttons_count--;
+      result = true;
+    }
+    if (_buttons_count == 0)
+    {
+      _needs_buttons_call = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return result;
+  }
+
+} // namespace hidpg
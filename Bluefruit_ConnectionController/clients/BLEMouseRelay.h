@@ -0,0 +1,81 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // BLEクライアントのnotifyコールバック(BLEスタックのコンテキスト)からHidEngineへマウスレポートを中継する
+  // - notifyコールバック側は事前確保したバッファにコピーするだけでブロックしない
+  // - 連続するモーションは読み出されるまで1つに合算される
+  // - コールバックは読み出されるまで再度呼ばれないので、HidEngineのイベントキューに積まれるのはrelay毎に最大1つ
+  // - コールバックもBLEスタックのコンテキストで呼ばれるのでブロックしてはいけない
+  //   キューに積めなかった時はfalseを返せば、次のレポートで再度呼ばれる
+  //
+  // 使用例
+  //   relay.setMotionCallback([] { return HidEngine.tryMovePointer(PointingDeviceId{0}); });
+  //   HidEngine.setReadPointerDeltaCallback([](PointingDeviceId, int16_t &x, int16_t &y) { relay.readDelta(x, y); });
+  //   Lift.Hid.setMouseReportRelay(&relay);
+  class BLEMouseRelay
+  {
+  public:
+    using callback_t = bool (*)(void);
+
+    BLEMouseRelay();
+
+    void setMotionCallback(callback_t cb);
+    void setButtonsCallback(callback_t cb);
+
+    // notifyコールバックから呼ぶ
+    void relay(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t pan);
+
+    // 読み出し側、合算された値を返してクリアする
+    void readDelta(int16_t &delta_x, int16_t &delta_y);
+    void readScroll(int8_t &wheel, int8_t &pan);
+    // ボタンの状態変化は合算せずに順番に読み出す、空ならfalse
+    bool readButtons(uint8_t &buttons);
+
+  private:
+    static constexpr uint8_t BUTTONS_QUEUE_SIZE = 8;
+
+    callback_t _motion_cb;
+    callback_t _buttons_cb;
+
+    int32_t _delta_x;
+    int32_t _delta_y;
+    int16_t _wheel;
+    int16_t _pan;
+    bool _needs_motion_call;
+
+    uint8_t _buttons_queue[BUTTONS_QUEUE_SIZE];
+    uint8_t _buttons_head;
+    uint8_t _buttons_count;
+    uint8_t _last_buttons;
+    bool _needs_buttons_call;
+  };
+
+} // namespace hidpg
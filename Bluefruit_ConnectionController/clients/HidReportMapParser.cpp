@@ -0,0 +1,439 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "HidReportMapParser.h"
+
+namespace hidpg
+{
+  // item tags (HID 1.11 6.2.2)
+  constexpr uint8_t Item_Input = 0x80;
+  constexpr uint8_t Item_Collection = 0xA0;
+  constexpr uint8_t Item_End_Collection = 0xC0;
+  constexpr uint8_t Item_Usage_Page = 0x04;
+  constexpr uint8_t Item_Logical_Minimum = 0x14;
+  constexpr uint8_t Item_Logical_Maximum = 0x24;
+  constexpr uint8_t Item_Report_Size = 0x74;
+  constexpr uint8_t Item_Report_ID = 0x84;
+  constexpr uint8_t Item_Report_Count = 0x94;
+  constexpr uint8_t Item_Push = 0xA4;
+  constexpr uint8_t Item_Pop = 0xB4;
+  constexpr uint8_t Item_Usage = 0x08;
+  constexpr uint8_t Item_Usage_Minimum = 0x18;
+  constexpr uint8_t Item_Usage_Maximum = 0x28;
+  constexpr uint8_t Item_Long = 0xFE;
+
+  // main item data bits
+  constexpr uint32_t Main_Constant = 0b001;
+  constexpr uint32_t Main_Variable = 0b010;
+  constexpr uint32_t Main_Relative = 0b100;
+
+  constexpr uint8_t MAX_USAGES = 16;
+  constexpr uint8_t MAX_GLOBAL_STACK = 4;
+
+  struct GlobalState
+  {
+    uint16_t usage_page;
+    int32_t logical_minimum;
+    int32_t logical_maximum;
+    uint32_t logical_maximum_unsigned;
+    uint32_t report_size;
+    uint8_t report_id;
+    uint32_t report_count;
+  };
+
+  HidReportMapParser::HidReportMapParser() : _fields(), _field_count(0), _reports(), _report_count(0)
+  {
+  }
+
+  void HidReportMapParser::clear()
+  {
+    _field_count = 0;
+    _report_count = 0;
+  }
+
+  HidReportMapParser::Report *HidReportMapParser::getReport(uint8_t report_id)
+  {
+    for (uint8_t i = 0; i < _report_count; i++)
+    {
+      if (_reports[i].report_id == report_id)
+      {
+        return &_reports[i];
+      }
+    }
+
+    if (_report_count >= MAX_REPORTS)
+    {
+      return nullptr;
+    }
+
+    Report &report = _reports[_report_count++];
+    report.report_id = report_id;
+    report.bit_length = 0;
+    return &report;
+  }
+
+  bool HidReportMapParser::addField(const Field &field)
+  {
+    if (_field_count >= MAX_FIELDS)
+    {
+      return false;
+    }
+    _fields[_field_count++] = field;
+    return true;
+  }
+
+  bool HidReportMapParser::parse(const uint8_t *desc, size_t len)
+  {
+    clear();
+
+    GlobalState global = {};
+    GlobalState global_stack[MAX_GLOBAL_STACK];
+    uint8_t global_stack_len = 0;
+
+    // local items, Main itemの度にクリアされる
+    uint32_t usages[MAX_USAGES];
+    uint8_t usages_len = 0;
+    uint32_t usage_minimum = 0;
+    uint32_t usage_maximum = 0;
+    bool has_usage_range = false;
+
+    size_t i = 0;
+    while (i < len)
+    {
+      uint8_t prefix = desc[i++];
+
+      if (prefix == Item_Long)
+      {
+        if (i >= len)
+        {
+          return false;
+        }
+        i += 2 + desc[i];
+        continue;
+      }
+
+      uint8_t size = prefix & 0b11;
+      size = (size == 3) ? 4 : size;
+      uint8_t tag = prefix & 0b11111100;
+
+      if (i + size > len)
+      {
+        return false;
+      }
+
+      uint32_t data = 0;
+      for (uint8_t b = 0; b < size; b++)
+      {
+        data |= static_cast<uint32_t>(desc[i + b]) << (8 * b);
+      }
+      // 符号付きの値(Logical Minimum, Logical Maximum)用
+      int32_t sdata = data;
+      if (size > 0 && size < 4 && (data & (1UL << (size * 8 - 1))))
+      {
+        sdata = static_cast<int32_t>(data | (UINT32_MAX << (size * 8)));
+      }
+      i += size;
+
+      switch (tag)
+      {
+      case Item_Usage_Page:
+        global.usage_page = data;
+        break;
+      case Item_Logical_Minimum:
+        global.logical_minimum = sdata;
+        break;
+      case Item_Logical_Maximum:
+        global.logical_maximum = sdata;
+        global.logical_maximum_unsigned = data;
+        break;
+      case Item_Report_Size:
+        global.report_size = data;
+        break;
+      case Item_Report_ID:
+        global.report_id = data;
+        break;
+      case Item_Report_Count:
+        global.report_count = data;
+        break;
+      case Item_Push:
+        if (global_stack_len < MAX_GLOBAL_STACK)
+        {
+          global_stack[global_stack_len++] = global;
+        }
+        break;
+      case Item_Pop:
+        if (global_stack_len > 0)
+        {
+          global = global_stack[--global_stack_len];
+        }
+        break;
+
+      case Item_Usage:
+        // 4byteの場合は上位16bitがUsage Page
+        if (usages_len < MAX_USAGES)
+        {
+          usages[usages_len++] = (size == 4) ? data : ((static_cast<uint32_t>(global.usage_page) << 16) | data);
+        }
+        break;
+      case Item_Usage_Minimum:
+        usage_minimum = (size == 4) ? data : ((static_cast<uint32_t>(global.usage_page) << 16) | data);
+        has_usage_range = true;
+        break;
+      case Item_Usage_Maximum:
+        usage_maximum = (size == 4) ? data : ((static_cast<uint32_t>(global.usage_page) << 16) | data);
+        has_usage_range = true;
+        break;
+
+      case Item_Input:
+      {
+        Report *report = getReport(global.report_id);
+        if (report == nullptr)
+        {
+          return false;
+        }
+        // レポートの長さやフィールドの位置が16bitに収まらないものは扱わない
+        if (global.report_size > UINT8_MAX || global.report_count > UINT16_MAX)
+        {
+          return false;
+        }
+        uint32_t bit_length = report->bit_length + global.report_size * global.report_count;
+        if (bit_length > UINT16_MAX)
+        {
+          return false;
+        }
+
+        Field field = {};
+        field.report_id = global.report_id;
+        field.bit_size = global.report_size;
+        field.is_signed = global.logical_minimum < 0;
+        field.is_relative = data & Main_Relative;
+        field.logical_minimum = global.logical_minimum;
+        // Logical Minimumが0以上なのにLogical Maximumが負になる場合は符号無しで書かれている(0x25 0xFFで255など)
+        field.logical_maximum = (global.logical_minimum >= 0 && global.logical_maximum < global.logical_minimum)
+                                    ? static_cast<int32_t>(global.logical_maximum_unsigned)
+                                    : global.logical_maximum;
+
+        if (data & Main_Constant)
+        {
+          // padding
+        }
+        else if ((data & Main_Variable) == 0)
+        {
+          // Array: Report Count個のスロットにUsage(Minimum + index)が入る
+          uint32_t base = has_usage_range ? usage_minimum : (usages_len > 0 ? usages[0] : 0);
+          field.usage_page = base >> 16;
+          field.usage = base & 0xFFFF;
+          field.bit_offset = report->bit_length;
+          field.count = global.report_count;
+          field.is_array = true;
+          if (addField(field) == false)
+          {
+            return false;
+          }
+        }
+        else
+        {
+          // Variable: 1つのUsageに1つの値
+          // Usage Minimum ~ Maximumで続くUsageと、足りない分の繰り返しは前のフィールドに足す
+          field.count = 0;
+          field.is_array = false;
+          for (uint16_t n = 0; n < global.report_count; n++)
+          {
+            bool from_range = false;
+            uint32_t usage;
+            if (n < usages_len)
+            {
+              usage = usages[n];
+            }
+            else if (has_usage_range && usage_minimum + (n - usages_len) <= usage_maximum)
+            {
+              usage = usage_minimum + (n - usages_len);
+              from_range = true;
+            }
+            else if (usages_len > 0)
+            {
+              // 足りない場合は最後のUsageを繰り返す
+              usage = usages[usages_len - 1];
+            }
+            else
+            {
+              usage = usage_maximum;
+            }
+
+            if (field.count > 0 && (usage >> 16) == field.usage_page)
+            {
+              uint16_t last = field.usage_maximum;
+              bool ascending = (field.usage_maximum - field.usage + 1) == field.count;
+              if ((usage & 0xFFFF) == last)
+              {
+                field.count++;
+                continue;
+              }
+              if (from_range && ascending && (usage & 0xFFFF) == static_cast<uint32_t>(last) + 1)
+              {
+                field.usage_maximum++;
+                field.count++;
+                continue;
+              }
+            }
+
+            if (field.count > 0 && addField(field) == false)
+            {
+              return false;
+            }
+            field.usage_page = usage >> 16;
+            field.usage = usage & 0xFFFF;
+            field.usage_maximum = field.usage;
+            field.bit_offset = report->bit_length + n * global.report_size;
+            field.count = 1;
+          }
+          if (field.count > 0 && addField(field) == false)
+          {
+            return false;
+          }
+        }
+
+        report->bit_length = bit_length;
+      }
+        // fall through
+      case Item_Collection:
+      case Item_End_Collection:
+      case 0x90: // Output
+      case 0xB0: // Feature
+        usages_len = 0;
+        usage_minimum = 0;
+        usage_maximum = 0;
+        has_usage_range = false;
+        break;
+
+      default:
+        break;
+      }
+    }
+
+    return _report_count > 0;
+  }
+
+  const HidReportMapParser::Field *HidReportMapParser::findField(uint16_t usage_page, uint16_t usage, uint16_t *index) const
+  {
+    // Variableで一致するフィールドを優先し、無ければUsageの範囲に含むArrayを探す
+    const Field *array = nullptr;
+    for (uint8_t i = 0; i < _field_count; i++)
+    {
+      const Field &f = _fields[i];
+      if (f.usage_page != usage_page)
+      {
+        continue;
+      }
+      if (f.is_array == false)
+      {
+        if (f.usage <= usage && usage <= f.usage_maximum)
+        {
+          if (index != nullptr)
+          {
+            *index = usage - f.usage;
+          }
+          return &f;
+        }
+      }
+      else if (array == nullptr && f.usage <= usage && (usage - f.usage) <= (f.logical_maximum - f.logical_minimum))
+      {
+        array = &f;
+      }
+    }
+    if (array != nullptr && index != nullptr)
+    {
+      *index = 0;
+    }
+    return array;
+  }
+
+  const HidReportMapParser::Report *HidReportMapParser::findReport(uint8_t report_id) const
+  {
+    for (uint8_t i = 0; i < _report_count; i++)
+    {
+      if (_reports[i].report_id == report_id)
+      {
+        return &_reports[i];
+      }
+    }
+    return nullptr;
+  }
+
+  HidReportMapParser::Field HidReportMapParser::element(const Field &field, uint16_t index)
+  {
+    Field e = field;
+    e.usage = (index < field.usage_maximum - field.usage) ? field.usage + index : field.usage_maximum;
+    e.usage_maximum = e.usage;
+    e.bit_offset = field.bit_offset + index * field.bit_size;
+    e.count = 1;
+    return e;
+  }
+
+  int32_t HidReportMapParser::extract(const uint8_t *data, uint16_t len, const Field &field, uint16_t index)
+  {
+    // 32bitを超える分は読まない(下位32bitに切り詰める)
+    uint8_t bit_size = (field.bit_size > 32) ? 32 : field.bit_size;
+    uint32_t bit_offset = field.bit_offset + static_cast<uint32_t>(index) * field.bit_size;
+    uint32_t byte_offset = bit_offset / 8;
+    uint8_t shift = bit_offset % 8;
+    uint8_t n_bytes = (shift + bit_size + 7) / 8;
+
+    // 最大32bit + 7bitのシフトなので64bitで読む
+    uint64_t raw = 0;
+    for (uint8_t i = 0; i < n_bytes && (byte_offset + i) < len; i++)
+    {
+      raw |= static_cast<uint64_t>(data[byte_offset + i]) << (8 * i);
+    }
+    raw >>= shift;
+
+    // 定数やパディングなどサイズ0のフィールドは常に0
+    if (bit_size == 0)
+    {
+      return 0;
+    }
+    if (bit_size == 32)
+    {
+      return static_cast<int32_t>(raw);
+    }
+
+    uint32_t value = raw & ((1UL << bit_size) - 1);
+    if (field.is_signed && (value & (1UL << (bit_size - 1))))
+    {
+      value |= UINT32_MAX << bit_size;
+    }
+    return static_cast<int32_t>(value);
+  }
+
+  uint16_t HidReportMapParser::extractArrayUsage(const uint8_t *data, uint16_t len, const Field &field, uint16_t index)
+  {
+    int32_t value = extract(data, len, field, index);
+    if (value < field.logical_minimum || value > field.logical_maximum)
+    {
+      return 0;
+    }
+    return field.usage + (value - field.logical_minimum);
+  }
+
+} // namespace hidpg
@@ -0,0 +1,105 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // Report Mapを一度だけ解析してInputレポートのフィールド抽出表(bit offset, bit size)に変換する
+  // notify毎には表を引いてビットを切り出すだけなので解析コストはかからない
+  class HidReportMapParser
+  {
+  public:
+    static constexpr uint8_t MAX_FIELDS = 48;
+    static constexpr uint8_t MAX_REPORTS = 8;
+
+    // Variableは連続したUsageを1つのフィールドにまとめる(NKROのキーのビットマップ等)
+    // n番目の値のUsageはmin(usage + n, usage_maximum)、ビット位置はbit_offset + n * bit_size
+    struct Field
+    {
+      uint16_t usage_page;
+      uint16_t usage;         // Arrayの場合はUsage Minimum
+      uint16_t usage_maximum; // Variableの最後の値のUsage
+      uint16_t bit_offset;    // レポートIDを除いたペイロード先頭からのオフセット
+      int32_t logical_minimum;
+      int32_t logical_maximum;
+      uint8_t bit_size;
+      uint16_t count; // Variableなら値の数、ArrayならReport Count
+      uint8_t report_id;
+      bool is_signed;
+      bool is_relative;
+      bool is_array;
+    };
+
+    struct Report
+    {
+      uint8_t report_id;
+      uint16_t bit_length;
+
+      uint16_t byteLength() const { return (bit_length + 7) / 8; }
+    };
+
+    HidReportMapParser();
+
+    // 不正なReport Map、またはフィールド数やレポート数がMAX_FIELDS, MAX_REPORTSを超えた場合はfalse
+    // Report Sizeが255bit、レポートの長さが65535bitを超える場合もfalse
+    bool parse(const uint8_t *desc, size_t len);
+    void clear();
+
+    uint8_t fieldCount() const { return _field_count; }
+    const Field &field(uint8_t i) const { return _fields[i]; }
+    uint8_t reportCount() const { return _report_count; }
+    const Report &report(uint8_t i) const { return _reports[i]; }
+
+    // Variableは一致するUsage、ArrayはUsageの範囲に含むフィールドを返す
+    // Variableの場合はindexにフィールドの何番目の値かを入れる
+    const Field *findField(uint16_t usage_page, uint16_t usage, uint16_t *index = nullptr) const;
+    const Report *findReport(uint8_t report_id) const;
+
+    // Variableのindex番目の値だけの1つのフィールドを返す
+    static Field element(const Field &field, uint16_t index);
+
+    // dataはレポートIDを含まないペイロード
+    // 32bitより大きいフィールドは下位32bitを返す
+    static int32_t extract(const uint8_t *data, uint16_t len, const Field &field, uint16_t index = 0);
+
+    // Arrayのindex番目のスロットのUsageを返す
+    // Usage Minimum + (値 - Logical Minimum)、値がLogical Minimum ~ Logical Maximumの範囲外なら0(キー無し)
+    static uint16_t extractArrayUsage(const uint8_t *data, uint16_t len, const Field &field, uint16_t index = 0);
+
+  private:
+    Report *getReport(uint8_t report_id);
+    bool addField(const Field &field);
+
+    Field _fields[MAX_FIELDS];
+    uint8_t _field_count;
+    Report _reports[MAX_REPORTS];
+    uint8_t _report_count;
+  };
+
+} // namespace hidpg
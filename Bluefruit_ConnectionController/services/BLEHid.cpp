@@ -28,19 +28,32 @@
 namespace hidpg
 {
 
-  BLEHid::BLEHid() : BLEHidGeneric(5, 1, 0), _kbd_led_cb(nullptr), _kbd_led_hdl_cb(nullptr)
+  BLEHid::BLEHid() : BLEHidGeneric(REPORT_ID_COUNT, 1, 0), _kbd_led_cb(nullptr), _kbd_led_hdl_cb(nullptr), _wheel_remainder(0), _horiz_remainder(0)
   {
   }
 
   err_t BLEHid::begin()
   {
-    uint16_t input_len[] = {sizeof(hid_keyboard_report_t), sizeof(uint16_t), sizeof(hid_mouse_report_ex_t), sizeof(uint16_t), sizeof(uint8_t)};
+    // Report IDの順番
+    uint16_t input_len[] = {
+        sizeof(hid_keyboard_report_ex_t),
+#if HID_REPORTER_ENABLE_CONSUMER_CONTROL
+        sizeof(uint16_t),
+#endif
+        sizeof(hid_mouse_report_ex_t),
+#if HID_REPORTER_ENABLE_RADIAL_CONTROLLER
+        sizeof(hid_radial_controller_report_t),
+#endif
+#if HID_REPORTER_ENABLE_SYSTEM_CONTROL
+        sizeof(uint8_t),
+#endif
+    };
     uint16_t output_len[] = {1};
 
     setReportLen(input_len, output_len, NULL);
     enableKeyboard(true);
     enableMouse(true);
-    setReportMap(hid_report_descriptor, sizeof(hid_report_descriptor));
+    setReportMap(hid_report_descriptor, hid_report_descriptor_len);
 
     VERIFY_STATUS(BLEHidGeneric::begin());
 
@@ -83,27 +96,8 @@ namespace hidpg
 
   bool BLEHid::keyboardReport(uint16_t conn_hdl, uint8_t modifiers, uint8_t key_codes[6])
   {
-    hid_keyboard_report_t report = {
-        .modifier = modifiers,
-        .reserved = 0,
-        .keycode = {
-            key_codes[0],
-            key_codes[1],
-            key_codes[2],
-            key_codes[3],
-            key_codes[4],
-            key_codes[5],
-        },
-    };
-
-    if (isBootMode())
-    {
-      return bootKeyboardReport(conn_hdl, &report, sizeof(hid_keyboard_report_t));
-    }
-    else
-    {
-      return inputReport(conn_hdl, REPORT_ID_KEYBOARD, &report, sizeof(hid_keyboard_report_t));
-    }
+    Report report = makeKeyboardReport(modifiers, key_codes);
+    return submit(conn_hdl, {&report, 1});
   }
 
   bool BLEHid::keyboardReport(uint8_t modifiers, uint8_t key_codes[6])
@@ -113,7 +107,9 @@ namespace hidpg
 
   bool BLEHid::consumerReport(uint16_t conn_hdl, uint16_t usage_code)
   {
-    return inputReport(conn_hdl, REPORT_ID_CONSUMER_CONTROL, &usage_code, sizeof(usage_code));
+    Report report{.type = Report::Type::Consumer};
+    report.consumer.usage_code = usage_code;
+    return submit(conn_hdl, {&report, 1});
   }
 
   bool BLEHid::consumerReport(uint16_t usage_code)
@@ -123,30 +119,8 @@ namespace hidpg
 
   bool BLEHid::mouseReport(uint16_t conn_hdl, uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t horiz)
   {
-    if (isBootMode())
-    {
-      hid_mouse_report_t report = {
-          buttons = buttons,
-          .x = static_cast<int8_t>(constrain(x, -127, 127)),
-          .y = static_cast<int8_t>(constrain(y, -127, 127)),
-          .wheel = wheel,
-          .pan = horiz,
-      };
-
-      return bootMouseReport(conn_hdl, &report, sizeof(hid_mouse_report_t));
-    }
-    else
-    {
-      hid_mouse_report_ex_t report = {
-          buttons = buttons,
-          .x = x,
-          .y = y,
-          .wheel = wheel,
-          .pan = horiz,
-      };
-
-      return inputReport(conn_hdl, REPORT_ID_MOUSE, &report, sizeof(hid_mouse_report_ex_t));
-    }
+    Report report = makeMouseReport(buttons, x, y, wheel, horiz);
+    return submit(conn_hdl, {&report, 1});
   }
 
   bool BLEHid::mouseReport(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t horiz)
@@ -156,12 +130,10 @@ namespace hidpg
 
   bool BLEHid::radialControllerReport(uint16_t conn_hdl, bool button, int16_t dial)
   {
-    hid_radial_controller_report_t report = {
-        .button = button,
-        .dial = dial,
-    };
-
-    return inputReport(conn_hdl, REPORT_ID_RADIAL_CONTROLLER, &report, sizeof(hid_radial_controller_report_t));
+    Report report{.type = Report::Type::RadialController};
+    report.radial_controller.button = button;
+    report.radial_controller.dial = dial;
+    return submit(conn_hdl, {&report, 1});
   }
 
   bool BLEHid::radialControllerReport(bool button, int16_t dial)
@@ -171,7 +143,9 @@ namespace hidpg
 
   bool BLEHid::systemControlReport(uint16_t conn_hdl, uint8_t usage_code)
   {
-    return inputReport(conn_hdl, REPORT_ID_SYSTEM_CONTROL, &usage_code, sizeof(usage_code));
+    Report report{.type = Report::Type::SystemControl};
+    report.system_control.usage_code = usage_code;
+    return submit(conn_hdl, {&report, 1});
   }
 
   bool BLEHid::systemControlReport(uint8_t usage_code)
@@ -179,6 +153,122 @@ namespace hidpg
     return systemControlReport(BLE_CONN_HANDLE_INVALID, usage_code);
   }
 
+  bool BLEHid::submit(uint16_t conn_hdl, etl::span<Report> reports)
+  {
+    // Boot Modeのチェックはバッチ毎に1回だけ
+    // notifyはSoftDeviceのキューに積まれるだけなので、キューに空きがあれば同じコネクションイベントでまとめて送られる
+    bool boot_mode = isBootMode();
+    bool result = true;
+    for (Report &report : reports)
+    {
+      result &= sendReport(conn_hdl, boot_mode, report);
+    }
+    return result;
+  }
+
+  bool BLEHid::submit(etl::span<Report> reports)
+  {
+    return submit(BLE_CONN_HANDLE_INVALID, reports);
+  }
+
+  bool BLEHid::sendReport(uint16_t conn_hdl, bool boot_mode, const Report &report)
+  {
+    switch (report.type)
+    {
+    case Report::Type::Keyboard:
+      if (boot_mode)
+      {
+        // Boot Modeは常に6キーの配列
+        hid_keyboard_report_t buf = {
+            .modifier = report.keyboard.modifiers,
+            .reserved = 0,
+            .keycode = {
+                report.keyboard.key_codes[0],
+                report.keyboard.key_codes[1],
+                report.keyboard.key_codes[2],
+                report.keyboard.key_codes[3],
+                report.keyboard.key_codes[4],
+                report.keyboard.key_codes[5],
+            },
+        };
+        return bootKeyboardReport(conn_hdl, &buf, sizeof(hid_keyboard_report_t));
+      }
+      else
+      {
+        hid_keyboard_report_ex_t buf;
+        serializeKeyboardReport(buf, report);
+        return inputReport(conn_hdl, REPORT_ID_KEYBOARD, &buf, sizeof(hid_keyboard_report_ex_t));
+      }
+
+    case Report::Type::Consumer:
+      if (REPORT_ID_CONSUMER_CONTROL == 0)
+      {
+        return false;
+      }
+      return inputReport(conn_hdl, REPORT_ID_CONSUMER_CONTROL, &report.consumer.usage_code, sizeof(report.consumer.usage_code));
+
+    case Report::Type::Mouse:
+    {
+      // BLEHidGenericはFeatureレポートを持てず、Resolution Multiplierは常に無効なのでノッチ単位にする
+      int16_t wheel = scaleWheel(report.mouse.wheel, false, _wheel_remainder);
+      int16_t horiz = scaleWheel(report.mouse.horiz, false, _horiz_remainder);
+
+      if (boot_mode)
+      {
+        hid_mouse_report_t buf = {
+            .buttons = report.mouse.buttons,
+            .x = static_cast<int8_t>(constrain(report.mouse.x, -127, 127)),
+            .y = static_cast<int8_t>(constrain(report.mouse.y, -127, 127)),
+            .wheel = static_cast<int8_t>(constrain(wheel, -127, 127)),
+            .pan = static_cast<int8_t>(constrain(horiz, -127, 127)),
+        };
+
+        return bootMouseReport(conn_hdl, &buf, sizeof(hid_mouse_report_t));
+      }
+      else
+      {
+        int16_t x = report.mouse.x;
+        int16_t y = report.mouse.y;
+        hid_mouse_report_ex_t buf;
+
+        // レポートのビット数に収まらない移動量は分割して送る
+        bool result;
+        do
+        {
+          serializeMouseReport(buf, report.mouse.buttons, x, y, wheel, horiz);
+          result = inputReport(conn_hdl, REPORT_ID_MOUSE, &buf, sizeof(hid_mouse_report_ex_t));
+        } while (result && (x != 0 || y != 0 || wheel != 0 || horiz != 0));
+
+        return result;
+      }
+    }
+
+    case Report::Type::RadialController:
+    {
+      if (REPORT_ID_RADIAL_CONTROLLER == 0)
+      {
+        return false;
+      }
+
+      hid_radial_controller_report_t buf = {
+          .button = report.radial_controller.button,
+          .dial = report.radial_controller.dial,
+      };
+
+      return inputReport(conn_hdl, REPORT_ID_RADIAL_CONTROLLER, &buf, sizeof(hid_radial_controller_report_t));
+    }
+
+    case Report::Type::SystemControl:
+      if (REPORT_ID_SYSTEM_CONTROL == 0)
+      {
+        return false;
+      }
+      return inputReport(conn_hdl, REPORT_ID_SYSTEM_CONTROL, &report.system_control.usage_code, sizeof(report.system_control.usage_code));
+    }
+
+    return false;
+  }
+
   bool BLEHid::waitReady(uint16_t conn_hdl)
   {
     BLEConnection *conn = Bluefruit.Connection(conn_hdl);
@@ -45,6 +45,7 @@ namespace hidpg
     bool systemControlReport(uint16_t conn_hdl, uint8_t usage_code);
     bool waitReady(uint16_t conn_hdl);
     void setKeyboardLedCallback(kbd_led_cb_hdl_t cb);
+    bool submit(uint16_t conn_hdl, etl::span<Report> reports);
 
     bool keyboardReport(uint8_t modifiers, uint8_t key_codes[6]) override;
     bool consumerReport(uint16_t usage_code) override;
@@ -53,11 +54,16 @@ namespace hidpg
     bool systemControlReport(uint8_t usage_code) override;
     bool waitReady() override;
     void setKeyboardLedCallback(kbd_led_cb_t cb) override;
+    bool submit(etl::span<Report> reports) override;
 
   private:
     kbd_led_cb_t _kbd_led_cb;
     kbd_led_cb_hdl_t _kbd_led_hdl_cb;
+    // BLEでは高解像度ホイールを使えないので、ノッチに満たない端数を持ち越す
+    int16_t _wheel_remainder;
+    int16_t _horiz_remainder;
 
+    bool sendReport(uint16_t conn_hdl, bool boot_mode, const Report &report);
     static void keyboard_output_cb(uint16_t conn_hdl, BLECharacteristic *chr, uint8_t *data, uint16_t len);
   };
 
@@ -23,9 +23,13 @@
 */
 
 #include "DebounceIn.h"
-#include "Arduino.h"
+#include "EdgeCapture.h"
 #include "SenseInterrupt.h"
 
+#ifdef ARDUINO_ARCH_NRF52
+#include "nrf_gpio.h"
+#endif
+
 #define pdMS_TO_TICKS_DOUBLE(xTimeInMs) ((double)(((double)(xTimeInMs) * (double)configTICK_RATE_HZ) / (double)1000))
 
 namespace hidpg
@@ -33,13 +37,26 @@ namespace hidpg
   namespace Internal
   {
 
+    static_assert(DEBOUNCE_IN_MAX_PIN_COUNT <= 64, "DEBOUNCE_IN_MAX_PIN_COUNT must be 64 or less");
+    static_assert(!(DEBOUNCE_IN_USE_SENSE_INTERRUPT == true && DEBOUNCE_IN_USE_EDGE_CAPTURE == true), "Sense interrupt and edge capture cannot be used together");
+
     DebounceInClass::callback_t DebounceInClass::_callback = nullptr;
+    DebounceInClass::batch_callback_t DebounceInClass::_batch_callback = nullptr;
 
-    Bounce DebounceInClass::_bounce_list[DEBOUNCE_IN_MAX_PIN_COUNT];
-    uint8_t DebounceInClass::_bounce_list_len = 0;
+    uint8_t DebounceInClass::_pins[DEBOUNCE_IN_MAX_PIN_COUNT];
+    uint16_t DebounceInClass::_debounce_delays_ms[DEBOUNCE_IN_MAX_PIN_COUNT];
+    uint8_t DebounceInClass::_pins_len = 0;
+    DebounceInClass::PinGroup DebounceInClass::_groups[MAX_GROUP_COUNT];
+    uint8_t DebounceInClass::_groups_len = 0;
+    uint64_t DebounceInClass::_state = 0;
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE == true
+    DebounceInClass::timed_callback_t DebounceInClass::_timed_callback = nullptr;
+    EdgeRing<DebounceInClass::Edge, DEBOUNCE_IN_EDGE_CAPTURE_RING_SIZE> DebounceInClass::_edge_ring;
+    EdgeDebouncer DebounceInClass::_edge_debouncers[DEBOUNCE_IN_MAX_PIN_COUNT];
+#endif
 
     uint16_t DebounceInClass::_max_debounce_delay_ms = 0;
-    uint16_t DebounceInClass::_polling_interval_ms = UINT16_MAX;
+    TickType_t DebounceInClass::_polling_interval_ticks = 1;
     uint16_t DebounceInClass::_max_polling_count = 0;
 
     TaskHandle_t DebounceInClass::_task_handle = nullptr;
@@ -53,34 +70,142 @@ namespace hidpg
       attachSenseInterrupt(interrupt_callback);
 #endif
 
-      // _polling_interval_ms * _max_polling_countは最低でもdebounce_delayの最大値を超える値に設定
-      // delay関数で切り捨てられるtick回数も考慮して計算
-      _max_polling_count = ceil(pdMS_TO_TICKS_DOUBLE(_max_debounce_delay_ms) / pdMS_TO_TICKS(_polling_interval_ms)) + 3;
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE == true
+      beginEdgeCapture();
+
+      // start前のエッジは捨てて、現在のレベルを初期状態にする
+      Edge edge;
+      while (_edge_ring.pop(edge))
+      {
+      }
+      _edge_ring.takeOverflow();
+
+      _state = 0;
+      for (int i = 0; i < _pins_len; i++)
+      {
+        bool level = (digitalRead(_pins[i]) == HIGH);
+        _edge_debouncers[i].reset(level);
+        _state |= static_cast<uint64_t>(level) << i;
+      }
+#else
+      // デバウンスはポーリング毎のサンプルを数えて行うので、debounce_delayの最大値がサンプル数の上限に収まる間隔にする
+      _polling_interval_ticks = max(pdMS_TO_TICKS(DEBOUNCE_IN_POLLING_INTERVAL_MS), (TickType_t)1);
+      _polling_interval_ticks = max(_polling_interval_ticks, (TickType_t)ceil(pdMS_TO_TICKS_DOUBLE(_max_debounce_delay_ms) / VerticalCounter::MAX_THRESHOLD));
+
+      for (int gi = 0; gi < _groups_len; gi++)
+      {
+        PinGroup &group = _groups[gi];
+        uint32_t mask = group.mask;
+        while (mask != 0)
+        {
+          int bit = __builtin_ctz(mask);
+          mask &= mask - 1;
+          uint8_t samples = debounceDelayToSamples(_debounce_delays_ms[group.indexes[bit]]);
+          group.counter.configure(bit, samples, samples, false);
+        }
+      }
+
+      // 現在の入力を初期状態にする
+      _state = 0;
+      for (int gi = 0; gi < _groups_len; gi++)
+      {
+        PinGroup &group = _groups[gi];
+        uint32_t value = readGroup(group);
+        group.counter.reset(value);
+        while (value != 0)
+        {
+          int bit = __builtin_ctz(value);
+          value &= value - 1;
+          _state |= 1ULL << group.indexes[bit];
+        }
+      }
+
+      // _polling_interval_ticks * _max_polling_countは最低でもdebounce_delayの最大値を超える値に設定
+      _max_polling_count = ceil(pdMS_TO_TICKS_DOUBLE(_max_debounce_delay_ms) / _polling_interval_ticks) + 3;
+#endif
 
       _task_handle = xTaskCreateStatic(task, "DebounceIn", DEBOUNCE_IN_TASK_STACK_SIZE, nullptr, DEBOUNCE_IN_TASK_PRIO, _task_stack, &_task_tcb);
     }
 
     bool DebounceInClass::addPin(uint8_t pin, int mode, uint16_t debounce_delay_ms)
     {
-#if DEBOUNCE_IN_USE_SENSE_INTERRUPT == false
-      if (_bounce_list_len >= DEBOUNCE_IN_MAX_PIN_COUNT)
+      if (_pins_len >= DEBOUNCE_IN_MAX_PIN_COUNT)
+      {
+        return false;
+      }
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE == true
+      if (_pins_len >= EDGE_CAPTURE_MAX_PIN_COUNT)
       {
         return false;
       }
 #endif
 
-      _bounce_list[_bounce_list_len].attach(pin, mode);
-      _bounce_list[_bounce_list_len].interval(debounce_delay_ms);
-      _bounce_list_len++;
+      // ピンが属するグループとビット位置を求める
+#ifdef ARDUINO_ARCH_NRF52
+      uint32_t hw_pin = g_ADigitalPinMap[pin];
+      NRF_GPIO_Type *port = nrf_gpio_pin_port_decode(&hw_pin);
+      uint8_t bit = hw_pin;
 
-#if DEBOUNCE_IN_USE_SENSE_INTERRUPT == false
+      int gi = 0;
+      while (gi < _groups_len && _groups[gi].port != port)
+      {
+        gi++;
+      }
+      if (gi == _groups_len)
+      {
+        if (_groups_len >= MAX_GROUP_COUNT)
+        {
+          return false;
+        }
+        _groups[gi].port = port;
+        _groups[gi].mask = 0;
+        _groups_len++;
+      }
+#else
+      uint8_t bit = _pins_len % 32;
+      int gi = _pins_len / 32;
+      if (gi == _groups_len)
+      {
+        _groups[gi].mask = 0;
+        _groups_len++;
+      }
+#endif
+
+      pinMode(pin, mode);
+
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE == true
+      // ピン毎に別々の割り込みハンドラを使ってどのピンのエッジか区別する
+      static const voidFuncPtr edge_callbacks[] = {
+          edge_interrupt_callback<0>,
+          edge_interrupt_callback<1>,
+          edge_interrupt_callback<2>,
+          edge_interrupt_callback<3>,
+          edge_interrupt_callback<4>,
+          edge_interrupt_callback<5>,
+          edge_interrupt_callback<6>,
+          edge_interrupt_callback<7>,
+      };
+      static_assert(sizeof(edge_callbacks) / sizeof(edge_callbacks[0]) >= EDGE_CAPTURE_MAX_PIN_COUNT, "edge_callbacks is too short");
+
+      _pins[_pins_len] = pin;
+      attachInterrupt(digitalPinToInterrupt(pin), edge_callbacks[_pins_len], CHANGE);
+      if (attachEdgeCapture(pin, _pins_len) == false)
+      {
+        detachInterrupt(digitalPinToInterrupt(pin));
+        return false;
+      }
+#elif DEBOUNCE_IN_USE_SENSE_INTERRUPT == false
       attachInterrupt(digitalPinToInterrupt(pin), interrupt_callback, CHANGE);
 #endif
 
-      // 後でポーリング回数を決めるためにdebounce_delayの最大値を保存しておく
+      _groups[gi].mask |= 1UL << bit;
+      _groups[gi].indexes[bit] = _pins_len;
+      _pins[_pins_len] = pin;
+      _debounce_delays_ms[_pins_len] = debounce_delay_ms;
+      _pins_len++;
+
+      // 後でポーリング間隔と回数を決めるためにdebounce_delayの最大値を保存しておく
       _max_debounce_delay_ms = max(debounce_delay_ms, _max_debounce_delay_ms);
-      // debounce_delayの最小値の間隔でポーリングする
-      _polling_interval_ms = min(debounce_delay_ms, _polling_interval_ms);
 
       return true;
     }
@@ -94,7 +219,7 @@ namespace hidpg
 
 #if DEBOUNCE_IN_USE_SENSE_INTERRUPT == false
       // TODO
-      // for (int i = 0; i < _bounce_list_len; i++)
+      // for (int i = 0; i < _pins_len; i++)
       // {
       // }
 #endif
@@ -105,6 +230,18 @@ namespace hidpg
       _callback = callback;
     }
 
+    void DebounceInClass::setBatchCallback(batch_callback_t callback)
+    {
+      _batch_callback = callback;
+    }
+
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE == true
+    void DebounceInClass::setTimedCallback(timed_callback_t callback)
+    {
+      _timed_callback = callback;
+    }
+#endif
+
     void DebounceInClass::interrupt_callback()
     {
       if (_task_handle != nullptr)
@@ -125,40 +262,190 @@ namespace hidpg
       return false;
     }
 
-    void DebounceInClass::task(void *pvParameters)
+    // グループのピンを読んで、HIGHのピンのビットを1にして返す
+    uint32_t DebounceInClass::readGroup(const PinGroup &group)
     {
-      while (true)
+#ifdef ARDUINO_ARCH_NRF52
+      return group.port->IN & group.mask;
+#else
+      uint32_t value = 0;
+      uint32_t mask = group.mask;
+      while (mask != 0)
+      {
+        int bit = __builtin_ctz(mask);
+        mask &= mask - 1;
+        value |= static_cast<uint32_t>(digitalRead(_pins[group.indexes[bit]]) == HIGH) << bit;
+      }
+      return value;
+#endif
+    }
+
+    // debounce_delayをポーリングのサンプル数に変換する
+    uint8_t DebounceInClass::debounceDelayToSamples(uint16_t debounce_delay_ms)
+    {
+      uint32_t samples = ceil(pdMS_TO_TICKS_DOUBLE(debounce_delay_ms) / _polling_interval_ticks);
+      return constrain(samples, 1, VerticalCounter::MAX_THRESHOLD);
+    }
+
+    // 全グループを読んでデバウンスし、状態が確定したピンのコールバックを呼ぶ
+    // 戻り値はデバウンス中のピンがあるか
+    bool DebounceInClass::update()
+    {
+      bool is_busy = false;
+      uint64_t changed_pins = 0;
+
+      for (int gi = 0; gi < _groups_len; gi++)
       {
-        if (needsUpdate())
+        PinGroup &group = _groups[gi];
+
+        uint32_t changed = group.counter.update(readGroup(group));
+        is_busy |= (group.counter.pending() != 0);
+
+        while (changed != 0)
         {
-          // update
-          for (int i = 0; i < _bounce_list_len; i++)
+          int bit = __builtin_ctz(changed);
+          changed &= changed - 1;
+
+          uint8_t index = group.indexes[bit];
+          bool state = bitRead(group.counter.state(), bit);
+          changed_pins |= 1ULL << index;
+          _state ^= 1ULL << index;
+
+          if (_callback != nullptr)
           {
-            int pin = _bounce_list[i].getPin();
-            if (_bounce_list[i].update())
-            {
-              if (_callback != nullptr)
-              {
-                _callback(pin, _bounce_list[i].read());
-              }
-            }
+            _callback(_pins[index], state);
+          }
+        }
+
 #if DEBOUNCE_IN_USE_SENSE_INTERRUPT == true
-            if (readLatch(pin))
-            {
-              xTaskNotify(_task_handle, _max_polling_count, eSetValueWithOverwrite);
-              clearLatch(pin);
-            }
+        uint32_t latch = readLatch(group.port) & group.mask;
+        if (latch != 0)
+        {
+          xTaskNotify(_task_handle, _max_polling_count, eSetValueWithOverwrite);
+          clearLatch(group.port, latch);
+        }
 #endif
+      }
+
+      if (changed_pins != 0 && _batch_callback != nullptr)
+      {
+        _batch_callback(changed_pins, _state);
+      }
+
+      return is_busy;
+    }
+
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE == true
+    // エッジの時刻とその直後のレベルを記録してタスクを起こす
+    void DebounceInClass::onEdge(uint8_t index)
+    {
+      Edge edge;
+      edge.time = readEdgeTime(index);
+      edge.index = index;
+      edge.level = (digitalRead(_pins[index]) == HIGH);
+      _edge_ring.push(edge);
+
+      if (_task_handle != nullptr)
+      {
+        vTaskNotifyGiveFromISR(_task_handle, nullptr);
+      }
+    }
+
+    // 記録されたエッジでデバウンスし、状態が確定したピンのコールバックを呼ぶ
+    // 戻り値は次に状態が確定する可能性がある時刻までのtick数
+    TickType_t DebounceInClass::processEdges()
+    {
+      Edge edge;
+      while (_edge_ring.pop(edge))
+      {
+        _edge_debouncers[edge.index].onEdge(edge.level, edge.time);
+      }
+
+      // 全てのエッジより後の時刻
+      uint32_t now = readEdgeCaptureClock();
+
+      // 取りこぼしたエッジがあるので現在のレベルをエッジとして扱う
+      if (_edge_ring.takeOverflow())
+      {
+        for (int i = 0; i < _pins_len; i++)
+        {
+          _edge_debouncers[i].onEdge(digitalRead(_pins[i]) == HIGH, now);
+        }
+      }
+
+      uint32_t wait_us = UINT32_MAX;
+      uint64_t changed_pins = 0;
+
+      for (int i = 0; i < _pins_len; i++)
+      {
+        EdgeDebouncer &debouncer = _edge_debouncers[i];
+        uint32_t debounce_delay_us = _debounce_delays_ms[i] * 1000UL;
+
+        if (debouncer.poll(now, debounce_delay_us))
+        {
+          changed_pins |= 1ULL << i;
+          _state ^= 1ULL << i;
+
+          if (_callback != nullptr)
+          {
+            _callback(_pins[i], debouncer.state());
+          }
+          if (_timed_callback != nullptr)
+          {
+            _timed_callback(_pins[i], debouncer.state(), debouncer.changeTime());
           }
-          delay(_polling_interval_ms);
+        }
+        if (debouncer.isPending())
+        {
+          wait_us = min(wait_us, debouncer.remaining(now, debounce_delay_us));
+        }
+      }
+
+      if (changed_pins != 0 && _batch_callback != nullptr)
+      {
+        _batch_callback(changed_pins, _state);
+      }
+
+      if (wait_us == UINT32_MAX)
+      {
+        return portMAX_DELAY;
+      }
+      // 切り上げて、tickの境界の分も足す
+      return static_cast<TickType_t>((static_cast<uint64_t>(wait_us) * configTICK_RATE_HZ + 999999) / 1000000) + 1;
+    }
+
+    void DebounceInClass::task(void *pvParameters)
+    {
+      while (true)
+      {
+        // 新しいエッジか、次に状態が確定する時刻まで寝る
+        ulTaskNotifyTake(pdTRUE, processEdges());
+      }
+    }
+#else
+    void DebounceInClass::task(void *pvParameters)
+    {
+      TickType_t last_wake_time = xTaskGetTickCount();
+      bool is_busy = false;
+
+      while (true)
+      {
+        // デバウンス中のピンがある間は割り込みに関係なくポーリングを続ける
+        if (needsUpdate() || is_busy)
+        {
+          is_busy = update();
+          // 処理にかかった時間に関係なく一定間隔でサンプリングする
+          vTaskDelayUntil(&last_wake_time, _polling_interval_ticks);
         }
         else
         {
           // 割り込みが発生するまで寝る
           ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+          last_wake_time = xTaskGetTickCount();
         }
       }
     }
+#endif
 
   } // namespace Internal
 
@@ -24,8 +24,12 @@
 
 #pragma once
 
-#include "Bounce2.h"
+#include "Arduino.h"
+#include "DebounceIn_config.h"
+#include "EdgeDebouncer.h"
+#include "EdgeRing.h"
 #include "FreeRTOS.h"
+#include "VerticalCounter.h"
 #include "task.h"
 #include <stdint.h>
 
@@ -34,28 +38,88 @@ namespace hidpg
   namespace Internal
   {
 
+    // 入力ピンをGPIOのポート単位でまとめて読み、VerticalCounterでまとめてデバウンスする
+    // 割り込みが発生したら入力が安定するまでポーリングし、状態が確定したピンだけコールバックする
     class DebounceInClass
     {
     public:
       using callback_t = void (*)(uint8_t pin, bool state);
+      // 変化したピンをまとめて受け取る、ビットiはi番目にaddPinしたピン
+      // stateは全てのピンの現在の状態
+      using batch_callback_t = void (*)(uint64_t changed, uint64_t state);
+      // 確定した変化の最初のエッジの時刻(μs)と一緒に受け取る
+      using timed_callback_t = void (*)(uint8_t pin, bool state, uint32_t edge_time_us);
 
       static void start();
       static bool addPin(uint8_t pin, int mode, uint16_t debounce_delay_ms = 10);
       static void setCallback(callback_t callback);
+      static void setBatchCallback(batch_callback_t callback);
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE == true
+      static void setTimedCallback(timed_callback_t callback);
+#endif
       static void stop_and_setWakeUpInterrupt();
 
     private:
+      // 1回のレジスタアクセスで読めるピンのまとまり
+      // nRF52ではGPIOのポート毎、それ以外ではaddPinした順に32本毎
+      struct PinGroup
+      {
+#ifdef ARDUINO_ARCH_NRF52
+        NRF_GPIO_Type *port;
+#endif
+        uint32_t mask;
+        VerticalCounter counter;
+        // ビット位置からaddPinした順番への変換
+        uint8_t indexes[32];
+      };
+
+#ifdef ARDUINO_ARCH_NRF52
+      static constexpr uint8_t MAX_GROUP_COUNT = 2;
+#else
+      static constexpr uint8_t MAX_GROUP_COUNT = (DEBOUNCE_IN_MAX_PIN_COUNT + 31) / 32;
+#endif
+
       static void task(void *pvParameters);
       static bool needsUpdate();
       static void interrupt_callback();
+      static uint32_t readGroup(const PinGroup &group);
+      static uint8_t debounceDelayToSamples(uint16_t debounce_delay_ms);
+      static bool update();
+
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE == true
+      struct Edge
+      {
+        uint32_t time;
+        uint8_t index;
+        bool level;
+      };
+
+      template <uint8_t index>
+      static void edge_interrupt_callback()
+      {
+        onEdge(index);
+      }
+      static void onEdge(uint8_t index);
+      static TickType_t processEdges();
+#endif
 
       static callback_t _callback;
-
-      static Bounce _bounce_list[];
-      static uint8_t _bounce_list_len;
+      static batch_callback_t _batch_callback;
+
+      static uint8_t _pins[];
+      static uint16_t _debounce_delays_ms[];
+      static uint8_t _pins_len;
+      static PinGroup _groups[];
+      static uint8_t _groups_len;
+      static uint64_t _state;
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE == true
+      static timed_callback_t _timed_callback;
+      static EdgeRing<Edge, DEBOUNCE_IN_EDGE_CAPTURE_RING_SIZE> _edge_ring;
+      static EdgeDebouncer _edge_debouncers[];
+#endif
 
       static uint16_t _max_debounce_delay_ms;
-      static uint16_t _polling_interval_ms;
+      static TickType_t _polling_interval_ticks;
       static uint16_t _max_polling_count;
 
       static TaskHandle_t _task_handle;
@@ -24,17 +24,51 @@
 
 #pragma once
 
+// 最大64
+// Sense signalを使用しない場合はピン毎に割り込みを使うので、割り込みの数にも制限される
 #ifndef DEBOUNCE_IN_MAX_PIN_COUNT
 #define DEBOUNCE_IN_MAX_PIN_COUNT 8
 #endif
 
+// 割り込みが発生してから入力が安定するまでポーリングする間隔
+// デバウンスはこの間隔で取ったサンプルを数えて行う(最大15サンプル)
+// debounce_delayがこの15倍を超える場合は間隔を広げる
+#ifndef DEBOUNCE_IN_POLLING_INTERVAL_MS
+#define DEBOUNCE_IN_POLLING_INTERVAL_MS 1
+#endif
+
 // 割り込みにSense signalを使用するか
 // nRF52でのみ使用可能
-// Sense signalを使用する場合割り込み数に制限はないのでDEBOUNCE_IN_MAX_PIN_COUNTは無視する
 #ifndef DEBOUNCE_IN_USE_SENSE_INTERRUPT
 #define DEBOUNCE_IN_USE_SENSE_INTERRUPT false
 #endif
 
+// ピンの変化を割り込みでエッジ毎に時刻付きで記録し、その時刻からデバウンスするか
+// 押下時刻が割り込みを処理した時刻やポーリングの時刻ではなくエッジの時刻になり、
+// 次に状態が確定する時刻まで寝るので一定間隔のポーリングも無くなる
+// nRF52ではGPIOTEのイベントをPPIでタイマーのキャプチャに繋ぐので、割り込みの遅延に関係なく1μs単位の時刻になる
+// (その代わりタイマーが動いている間はHFCLKが止まらない)、ピン数は最大5
+// それ以外ではmicros()を割り込みハンドラで読む、ピン数は最大8
+// Sense signalとは同時に使えない
+#ifndef DEBOUNCE_IN_USE_EDGE_CAPTURE
+#define DEBOUNCE_IN_USE_EDGE_CAPTURE false
+#endif
+
+// エッジを記録するリングバッファのサイズ(2のべき乗)
+#ifndef DEBOUNCE_IN_EDGE_CAPTURE_RING_SIZE
+#define DEBOUNCE_IN_EDGE_CAPTURE_RING_SIZE 32
+#endif
+
+// エッジの時刻のキャプチャに使うタイマー、CCが6個あるTIMER3かTIMER4
+#ifndef DEBOUNCE_IN_EDGE_CAPTURE_TIMER
+#define DEBOUNCE_IN_EDGE_CAPTURE_TIMER NRF_TIMER3
+#endif
+
+// エッジの時刻のキャプチャに使うPPIのチャンネルの先頭、ここからピン数分使う
+#ifndef DEBOUNCE_IN_EDGE_CAPTURE_PPI_CHANNEL
+#define DEBOUNCE_IN_EDGE_CAPTURE_PPI_CHANNEL 8
+#endif
+
 // タスクのスタックサイズ
 #ifndef DEBOUNCE_IN_TASK_STACK_SIZE
 #define DEBOUNCE_IN_TASK_STACK_SIZE 128
@@ -0,0 +1,131 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "DebounceIn_config.h"
+
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE
+
+#include "EdgeCapture.h"
+
+#ifdef ARDUINO_ARCH_NRF52
+#include "nrf_gpio.h"
+#include "nrf_ppi.h"
+#endif
+
+namespace hidpg::Internal
+{
+
+#ifdef ARDUINO_ARCH_NRF52
+
+  static constexpr uint8_t CLOCK_CC_INDEX = EDGE_CAPTURE_MAX_PIN_COUNT;
+
+  // 1MHzで32bitのフリーランニングタイマー
+  void beginEdgeCapture()
+  {
+    NRF_TIMER_Type *timer = DEBOUNCE_IN_EDGE_CAPTURE_TIMER;
+
+    timer->TASKS_STOP = 1;
+    timer->MODE = TIMER_MODE_MODE_Timer;
+    timer->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+    timer->PRESCALER = 4; // 16MHz / 2^4 = 1MHz
+    timer->TASKS_CLEAR = 1;
+    timer->TASKS_START = 1;
+  }
+
+  // attachInterruptでピンに割り当てられたGPIOTEのチャンネルのイベントを、PPIでタイマーのキャプチャに繋ぐ
+  bool attachEdgeCapture(uint8_t pin, uint8_t index)
+  {
+    if (index >= EDGE_CAPTURE_MAX_PIN_COUNT)
+    {
+      return false;
+    }
+
+    uint32_t hw_pin = g_ADigitalPinMap[pin];
+
+    for (int ch = 0; ch < GPIOTE_CH_NUM; ch++)
+    {
+      uint32_t config = NRF_GPIOTE->CONFIG[ch];
+      if (((config & GPIOTE_CONFIG_MODE_Msk) >> GPIOTE_CONFIG_MODE_Pos) != GPIOTE_CONFIG_MODE_Event)
+      {
+        continue;
+      }
+      uint32_t psel = (config & GPIOTE_CONFIG_PSEL_Msk) >> GPIOTE_CONFIG_PSEL_Pos;
+#ifdef GPIOTE_CONFIG_PORT_Msk
+      psel |= ((config & GPIOTE_CONFIG_PORT_Msk) >> GPIOTE_CONFIG_PORT_Pos) << 5;
+#endif
+      if (psel != hw_pin)
+      {
+        continue;
+      }
+
+      nrf_ppi_channel_t ppi_channel = static_cast<nrf_ppi_channel_t>(DEBOUNCE_IN_EDGE_CAPTURE_PPI_CHANNEL + index);
+      nrf_ppi_channel_endpoint_setup(
+          NRF_PPI,
+          ppi_channel,
+          reinterpret_cast<uint32_t>(&NRF_GPIOTE->EVENTS_IN[ch]),
+          reinterpret_cast<uint32_t>(&DEBOUNCE_IN_EDGE_CAPTURE_TIMER->TASKS_CAPTURE[index]));
+      nrf_ppi_channel_enable(NRF_PPI, ppi_channel);
+      return true;
+    }
+    return false;
+  }
+
+  uint32_t readEdgeTime(uint8_t index)
+  {
+    return DEBOUNCE_IN_EDGE_CAPTURE_TIMER->CC[index];
+  }
+
+  uint32_t readEdgeCaptureClock()
+  {
+    DEBOUNCE_IN_EDGE_CAPTURE_TIMER->TASKS_CAPTURE[CLOCK_CC_INDEX] = 1;
+    return DEBOUNCE_IN_EDGE_CAPTURE_TIMER->CC[CLOCK_CC_INDEX];
+  }
+
+#else
+
+  // ハードウェアのキャプチャが無いので割り込みハンドラで時刻を読む
+  void beginEdgeCapture()
+  {
+  }
+
+  bool attachEdgeCapture(uint8_t pin, uint8_t index)
+  {
+    return index < EDGE_CAPTURE_MAX_PIN_COUNT;
+  }
+
+  uint32_t readEdgeTime(uint8_t index)
+  {
+    return micros();
+  }
+
+  uint32_t readEdgeCaptureClock()
+  {
+    return micros();
+  }
+
+#endif
+
+} // namespace hidpg::Internal
+
+#endif
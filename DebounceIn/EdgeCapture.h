@@ -0,0 +1,56 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "DebounceIn_config.h"
+
+#if DEBOUNCE_IN_USE_EDGE_CAPTURE
+
+#include "Arduino.h"
+
+namespace hidpg::Internal
+{
+
+#ifdef ARDUINO_ARCH_NRF52
+  // タイマーのCCの最後の1つは現在時刻の読み出しに使う
+  constexpr uint8_t EDGE_CAPTURE_MAX_PIN_COUNT = 5;
+#else
+  constexpr uint8_t EDGE_CAPTURE_MAX_PIN_COUNT = 8;
+#endif
+
+  void beginEdgeCapture();
+
+  // attachInterruptした後に呼ぶ、indexは0 ~ EDGE_CAPTURE_MAX_PIN_COUNT - 1
+  bool attachEdgeCapture(uint8_t pin, uint8_t index);
+
+  // 割り込みハンドラから呼ぶ、indexのピンの最後のエッジの時刻(μs)
+  uint32_t readEdgeTime(uint8_t index);
+
+  // 現在時刻(μs)
+  uint32_t readEdgeCaptureClock();
+
+} // namespace hidpg::Internal
+
+#endif
@@ -0,0 +1,100 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // エッジの時刻からピン1本をデバウンスする
+  // 最後のエッジからdebounce_delayの間変化が無ければ、その時のレベルを確定状態にする
+  // 確定した変化の時刻はバウンスの最初のエッジの時刻になるので、ポーリングの間隔に関係なく正確な押下時刻がわかる
+  // 時刻はオーバーフローしても差が正しく求まる符号無し32bitのμs
+  class EdgeDebouncer
+  {
+  public:
+    EdgeDebouncer() : _stable(false), _level(false), _is_pending(false), _first_edge_time(0), _last_edge_time(0), _change_time(0) {}
+
+    void reset(bool level)
+    {
+      _stable = level;
+      _level = level;
+      _is_pending = false;
+    }
+
+    // levelはエッジの直後のピンのレベル
+    void onEdge(bool level, uint32_t time)
+    {
+      if (_is_pending == false)
+      {
+        _first_edge_time = time;
+        _is_pending = true;
+      }
+      _last_edge_time = time;
+      _level = level;
+    }
+
+    // 戻り値は確定状態が変化したか
+    bool poll(uint32_t now, uint32_t debounce_delay)
+    {
+      if (_is_pending == false || now - _last_edge_time < debounce_delay)
+      {
+        return false;
+      }
+      _is_pending = false;
+      // バウンスして元のレベルに戻っていたら変化なし
+      if (_level == _stable)
+      {
+        return false;
+      }
+      _stable = _level;
+      _change_time = _first_edge_time;
+      return true;
+    }
+
+    // 確定するまでの残り時間
+    uint32_t remaining(uint32_t now, uint32_t debounce_delay) const
+    {
+      uint32_t elapsed = now - _last_edge_time;
+      return (elapsed >= debounce_delay) ? 0 : debounce_delay - elapsed;
+    }
+
+    bool isPending() const { return _is_pending; }
+    bool state() const { return _stable; }
+
+    // 最後に確定した変化の最初のエッジの時刻
+    uint32_t changeTime() const { return _change_time; }
+
+  private:
+    bool _stable;
+    bool _level;
+    bool _is_pending;
+    uint32_t _first_edge_time;
+    uint32_t _last_edge_time;
+    uint32_t _change_time;
+  };
+
+} // namespace hidpg
@@ -0,0 +1,94 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // 割り込みハンドラから書き込み、タスクから読み出すリングバッファ
+  // 書き込み側と読み出し側がそれぞれ1つだけならロック無しで使える
+  // 一杯の時に書き込まれた値は捨ててオーバーフローを記録する
+  template <typename T, uint8_t N>
+  class EdgeRing
+  {
+    static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "N must be a power of 2 and 128 or less");
+
+  public:
+    EdgeRing() : _head(0), _tail(0), _overflowed(false) {}
+
+    // 割り込みハンドラから呼ぶ
+    bool push(const T &value)
+    {
+      uint8_t head = _head;
+      if (static_cast<uint8_t>(head - _tail) == N)
+      {
+        _overflowed = true;
+        return false;
+      }
+      _buf[head & (N - 1)] = value;
+      // 値を書いてからheadを進める
+      std::atomic_signal_fence(std::memory_order_release);
+      _head = head + 1;
+      return true;
+    }
+
+    // タスクから呼ぶ
+    bool pop(T &value)
+    {
+      uint8_t tail = _tail;
+      if (tail == _head)
+      {
+        return false;
+      }
+      std::atomic_signal_fence(std::memory_order_acquire);
+      value = _buf[tail & (N - 1)];
+      // 値を読んでからtailを進める
+      std::atomic_signal_fence(std::memory_order_release);
+      _tail = tail + 1;
+      return true;
+    }
+
+    // 前回呼んでからオーバーフローしたか
+    bool takeOverflow()
+    {
+      if (_overflowed)
+      {
+        _overflowed = false;
+        return true;
+      }
+      return false;
+    }
+
+  private:
+    T _buf[N];
+    volatile uint8_t _head;
+    volatile uint8_t _tail;
+    volatile bool _overflowed;
+  };
+
+} // namespace hidpg
@@ -99,6 +99,17 @@ namespace hidpg::Internal
     return nrf_gpio_pin_latch_get(pin);
   }
 
+  void clearLatch(NRF_GPIO_Type *port, uint32_t mask)
+  {
+    // 1を書き込んだビットがクリアされる
+    port->LATCH = mask;
+  }
+
+  uint32_t readLatch(NRF_GPIO_Type *port)
+  {
+    return port->LATCH;
+  }
+
   extern "C"
   {
     void SWI3_EGU3_IRQHandler()
@@ -39,6 +39,10 @@ namespace hidpg::Internal
   void clearLatch(uint32_t pin);
   bool readLatch(uint32_t pin);
 
+  // ポート単位でまとめて読み書きする
+  void clearLatch(NRF_GPIO_Type *port, uint32_t mask);
+  uint32_t readLatch(NRF_GPIO_Type *port);
+
 } // namespace hidpg::Internal
 
 #endif
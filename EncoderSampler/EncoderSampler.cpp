@@ -0,0 +1,258 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "EncoderSampler.h"
+
+namespace hidpg
+{
+  namespace Internal
+  {
+#ifdef ARDUINO_ARCH_NRF52
+
+#define ENCODER_SAMPLER_CONCAT_(a, b, c) a##b##c
+#define ENCODER_SAMPLER_CONCAT(a, b, c) ENCODER_SAMPLER_CONCAT_(a, b, c)
+#define SAMPLER_TIMER ENCODER_SAMPLER_CONCAT(NRF_TIMER, ENCODER_SAMPLER_TIMER_NUMBER, )
+#define SAMPLER_TIMER_IRQn ENCODER_SAMPLER_CONCAT(TIMER, ENCODER_SAMPLER_TIMER_NUMBER, _IRQn)
+#define SAMPLER_TIMER_IRQHandler ENCODER_SAMPLER_CONCAT(TIMER, ENCODER_SAMPLER_TIMER_NUMBER, _IRQHandler)
+
+    extern "C"
+    {
+      void SAMPLER_TIMER_IRQHandler()
+      {
+        SAMPLER_TIMER->EVENTS_COMPARE[0] = 0;
+        // 書き込みがペリフェラルに届く前に割り込みから抜けると再度割り込みが入るので読み戻す
+        (void)SAMPLER_TIMER->EVENTS_COMPARE[0];
+
+        EncoderSamplerClass::sample();
+      }
+    }
+
+#endif
+
+    EncoderSamplerClass::Encoder EncoderSamplerClass::_encoders[ENCODER_SAMPLER_MAX_COUNT];
+    volatile int32_t EncoderSamplerClass::_steps[ENCODER_SAMPLER_MAX_COUNT] = {};
+    uint8_t EncoderSamplerClass::_encoders_len = 0;
+    uint32_t EncoderSamplerClass::_pending = 0;
+    EncoderSamplerClass::callback_t EncoderSamplerClass::_callback = nullptr;
+    TaskHandle_t EncoderSamplerClass::_task_handle = nullptr;
+    StackType_t EncoderSamplerClass::_task_stack[ENCODER_SAMPLER_TASK_STACK_SIZE];
+    StaticTask_t EncoderSamplerClass::_task_tcb;
+#ifndef ARDUINO_ARCH_NRF52
+    TimerHandle_t EncoderSamplerClass::_timer_handle = nullptr;
+    StaticTimer_t EncoderSamplerClass::_timer_buffer;
+#endif
+
+    int8_t EncoderSamplerClass::addEncoder(uint8_t pin_a, uint8_t pin_b, bool full_step)
+    {
+      static_assert(ENCODER_SAMPLER_MAX_COUNT <= 32, "ENCODER_SAMPLER_MAX_COUNT must be 32 or less.");
+
+      if (_encoders_len >= ENCODER_SAMPLER_MAX_COUNT)
+      {
+        return -1;
+      }
+
+      Encoder &encoder = _encoders[_encoders_len];
+      encoder.pin_a = pin_a;
+      encoder.pin_b = pin_b;
+      encoder.full_step = full_step;
+      encoder.state = 0;
+#ifdef ARDUINO_ARCH_NRF52
+      // ピン番号をポートとビットにしておいてポート毎に1回読んだINから取り出す
+      uint32_t nrf_pin_a = g_ADigitalPinMap[pin_a];
+      uint32_t nrf_pin_b = g_ADigitalPinMap[pin_b];
+      encoder.port_a = nrf_pin_a >> 5;
+      encoder.bit_a = nrf_pin_a & 0x1f;
+      encoder.port_b = nrf_pin_b >> 5;
+      encoder.bit_b = nrf_pin_b & 0x1f;
+#endif
+      return _encoders_len++;
+    }
+
+    void EncoderSamplerClass::setCallback(callback_t callback)
+    {
+      _callback = callback;
+    }
+
+    void EncoderSamplerClass::start()
+    {
+      for (uint8_t i = 0; i < _encoders_len; i++)
+      {
+        pinMode(_encoders[i].pin_a, INPUT_PULLUP);
+        pinMode(_encoders[i].pin_b, INPUT_PULLUP);
+      }
+
+      if (_task_handle == nullptr)
+      {
+        _task_handle = xTaskCreateStatic(task, "EncoderSampler", ENCODER_SAMPLER_TASK_STACK_SIZE, nullptr, ENCODER_SAMPLER_TASK_PRIO, _task_stack, &_task_tcb);
+      }
+
+#ifdef ARDUINO_ARCH_NRF52
+      SAMPLER_TIMER->TASKS_STOP = 1;
+      SAMPLER_TIMER->TASKS_CLEAR = 1;
+      SAMPLER_TIMER->MODE = TIMER_MODE_MODE_Timer;
+      SAMPLER_TIMER->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+      SAMPLER_TIMER->PRESCALER = 4; // 16MHz / 2^4 = 1MHz
+      SAMPLER_TIMER->CC[0] = ENCODER_SAMPLER_INTERVAL_US;
+      SAMPLER_TIMER->SHORTS = TIMER_SHORTS_COMPARE0_CLEAR_Msk;
+      SAMPLER_TIMER->INTENSET = TIMER_INTENSET_COMPARE0_Msk;
+
+      NVIC_DisableIRQ(SAMPLER_TIMER_IRQn);
+      NVIC_ClearPendingIRQ(SAMPLER_TIMER_IRQn);
+      NVIC_SetPriority(SAMPLER_TIMER_IRQn, 3);
+      NVIC_EnableIRQ(SAMPLER_TIMER_IRQn);
+
+      SAMPLER_TIMER->TASKS_START = 1;
+#else
+      if (_timer_handle == nullptr)
+      {
+        TickType_t period = pdMS_TO_TICKS((ENCODER_SAMPLER_INTERVAL_US + 999) / 1000);
+        _timer_handle = xTimerCreateStatic("EncoderSampler", (period > 0) ? period : 1, pdTRUE, nullptr, [](TimerHandle_t) { sample(); }, &_timer_buffer);
+      }
+      xTimerStart(_timer_handle, portMAX_DELAY);
+#endif
+    }
+
+    void EncoderSamplerClass::stop()
+    {
+#ifdef ARDUINO_ARCH_NRF52
+      SAMPLER_TIMER->TASKS_STOP = 1;
+      SAMPLER_TIMER->INTENCLR = TIMER_INTENCLR_COMPARE0_Msk;
+      NVIC_DisableIRQ(SAMPLER_TIMER_IRQn);
+#else
+      if (_timer_handle != nullptr)
+      {
+        xTimerStop(_timer_handle, portMAX_DELAY);
+      }
+#endif
+      for (uint8_t i = 0; i < _encoders_len; i++)
+      {
+        pinMode(_encoders[i].pin_a, INPUT);
+        pinMode(_encoders[i].pin_b, INPUT);
+      }
+    }
+
+    int16_t EncoderSamplerClass::readStep(uint8_t index)
+    {
+      if (index >= _encoders_len)
+      {
+        return 0;
+      }
+
+      taskENTER_CRITICAL();
+      int32_t result = constrain(_steps[index], INT16_MIN, INT16_MAX);
+      _steps[index] -= result;
+      bool has_carry = (_steps[index] != 0);
+      if (has_carry == false)
+      {
+        _pending &= ~(1UL << index);
+      }
+      taskEXIT_CRITICAL();
+
+      // pendingのままなのでsample()からは通知されない、残りはここから通知する
+      if (has_carry)
+      {
+        xTaskNotify(_task_handle, 1UL << index, eSetBits);
+      }
+
+      return result;
+    }
+
+    void EncoderSamplerClass::sample()
+    {
+#ifdef ARDUINO_ARCH_NRF52
+#ifdef NRF_P1
+      const uint32_t in[] = {NRF_P0->IN, NRF_P1->IN};
+#else
+      const uint32_t in[] = {NRF_P0->IN};
+#endif
+#endif
+
+      uint32_t notify = 0;
+      for (uint8_t i = 0; i < _encoders_len; i++)
+      {
+        Encoder &encoder = _encoders[i];
+#ifdef ARDUINO_ARCH_NRF52
+        uint8_t pins = (((in[encoder.port_b] >> encoder.bit_b) & 1) << 1) | ((in[encoder.port_a] >> encoder.bit_a) & 1);
+#else
+        uint8_t pins = (digitalRead(encoder.pin_b) << 1) | digitalRead(encoder.pin_a);
+#endif
+        encoder.state = QuadratureTable::next(encoder.state, pins, encoder.full_step);
+        int8_t step = QuadratureTable::step(encoder.state);
+        if (step != 0)
+        {
+          // readStep()と同時に読み書きしないように守る
+#ifdef ARDUINO_ARCH_NRF52
+          UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+#else
+          taskENTER_CRITICAL();
+#endif
+          _steps[i] += step;
+          if ((_pending & (1UL << i)) == 0)
+          {
+            _pending |= 1UL << i;
+            notify |= 1UL << i;
+          }
+#ifdef ARDUINO_ARCH_NRF52
+          taskEXIT_CRITICAL_FROM_ISR(saved);
+#else
+          taskEXIT_CRITICAL();
+#endif
+        }
+      }
+
+      if (notify != 0)
+      {
+#ifdef ARDUINO_ARCH_NRF52
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        xTaskNotifyFromISR(_task_handle, notify, eSetBits, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+#else
+        xTaskNotify(_task_handle, notify, eSetBits);
+#endif
+      }
+    }
+
+    void EncoderSamplerClass::task(void *pvParameters)
+    {
+      while (true)
+      {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        while (bits != 0)
+        {
+          uint8_t index = __builtin_ctz(bits);
+          bits &= bits - 1;
+          if (_callback != nullptr)
+          {
+            _callback(index);
+          }
+        }
+      }
+    }
+
+  } // namespace Internal
+
+  Internal::EncoderSamplerClass EncoderSampler;
+
+} // namespace hidpg
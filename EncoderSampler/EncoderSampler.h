@@ -0,0 +1,99 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Arduino.h"
+#include "FreeRTOS.h"
+#include "QuadratureTable.h"
+#include "EncoderSampler_config.h"
+#include "task.h"
+#include "timers.h"
+
+namespace hidpg
+{
+  namespace Internal
+  {
+    // 複数のロータリーエンコーダーを1つのタイマーでまとめて読む
+    // RotaryEncoderはエンコーダー毎に割り込み2つとタスク1つを使うが、
+    // こちらはタイマー割り込みでポート毎にまとめてピンを読み、状態遷移表でデコードして、
+    // 全てのエンコーダーで1つのタスクからコールバックを呼ぶ
+    // HidEngineとは2行でつなげる
+    //   EncoderSampler.setCallback([](uint8_t index) { HidEngine.rotateEncoder(EncoderId{index}); });
+    //   HidEngine.setReadEncoderStepCallback([](EncoderId id, int16_t &step) { step = EncoderSampler.readStep(id.value); });
+    class EncoderSamplerClass
+    {
+    public:
+      using callback_t = void (*)(uint8_t index);
+
+      // 登録したエンコーダーの番号(0から順番)を返す、一杯なら-1を返す
+      // start()の前に呼ぶこと
+      static int8_t addEncoder(uint8_t pin_a, uint8_t pin_b, bool full_step = true);
+      // 前回readStep()してから動いたエンコーダーの番号で呼ばれる
+      static void setCallback(callback_t callback);
+      static void start();
+      static void stop();
+      // 前回から進んだステップ数を返して0に戻す
+      // int16_tに収まらなかった分は残して、もう一度コールバックを呼ぶ
+      static int16_t readStep(uint8_t index);
+      // 全てのエンコーダーのピンを読んでデコードする、タイマーから呼ばれる
+      static void sample();
+
+    private:
+      struct Encoder
+      {
+        uint8_t pin_a;
+        uint8_t pin_b;
+        bool full_step;
+        uint8_t state;
+#ifdef ARDUINO_ARCH_NRF52
+        uint8_t port_a;
+        uint8_t bit_a;
+        uint8_t port_b;
+        uint8_t bit_b;
+#endif
+      };
+
+      static void task(void *pvParameters);
+
+      static Encoder _encoders[];
+      static volatile int32_t _steps[];
+      static uint8_t _encoders_len;
+      // readStep()されるまで同じエンコーダーで何度もコールバックを呼ばないためのビット
+      static uint32_t _pending;
+      static callback_t _callback;
+      static TaskHandle_t _task_handle;
+      static StackType_t _task_stack[];
+      static StaticTask_t _task_tcb;
+#ifndef ARDUINO_ARCH_NRF52
+      static TimerHandle_t _timer_handle;
+      static StaticTimer_t _timer_buffer;
+#endif
+    };
+
+  } // namespace Internal
+
+  extern Internal::EncoderSamplerClass EncoderSampler;
+
+} // namespace hidpg
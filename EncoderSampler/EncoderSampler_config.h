@@ -0,0 +1,51 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+// 登録できるエンコーダーの最大数(32以下)
+#ifndef ENCODER_SAMPLER_MAX_COUNT
+#define ENCODER_SAMPLER_MAX_COUNT 8
+#endif
+
+// ピンを読む間隔(μs)
+// nRF52以外ではFreeRTOSのソフトウェアタイマーを使うので1tick単位に切り上げる
+#ifndef ENCODER_SAMPLER_INTERVAL_US
+#define ENCODER_SAMPLER_INTERVAL_US 500
+#endif
+
+// nRF52で使うタイマーの番号(TIMER1~TIMER4)
+#ifndef ENCODER_SAMPLER_TIMER_NUMBER
+#define ENCODER_SAMPLER_TIMER_NUMBER 2
+#endif
+
+// タスクのスタックサイズ
+#ifndef ENCODER_SAMPLER_TASK_STACK_SIZE
+#define ENCODER_SAMPLER_TASK_STACK_SIZE 128
+#endif
+
+// タスクのプライオリティ
+#ifndef ENCODER_SAMPLER_TASK_PRIO
+#define ENCODER_SAMPLER_TASK_PRIO 1
+#endif
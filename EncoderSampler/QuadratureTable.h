@@ -0,0 +1,106 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // ロータリーエンコーダーのA相、B相の状態遷移表
+  // 状態と (B << 1) | A から次の状態を引く、CW、CCWのビットが立っていたら1ステップ進んだ
+  // チャタリングで行ったり来たりしても1周するまでステップにならない
+  class QuadratureTable
+  {
+  public:
+    static constexpr uint8_t CW = 0x10;
+    static constexpr uint8_t CCW = 0x20;
+    static constexpr uint8_t STATE_MASK = 0x0f;
+
+    // full_stepなら1クリック(4遷移)で1ステップ、そうでなければ半クリック(2遷移)で1ステップ
+    static uint8_t next(uint8_t state, uint8_t pins, bool full_step)
+    {
+      // clang-format off
+      static const uint8_t full_step_table[7][4] = {
+        // START
+        {START,      CW_BEGIN,  CCW_BEGIN, START},
+        // CW_FINAL
+        {CW_NEXT,    START,     CW_FINAL,  START | CW},
+        // CW_BEGIN
+        {CW_NEXT,    CW_BEGIN,  START,     START},
+        // CW_NEXT
+        {CW_NEXT,    CW_BEGIN,  CW_FINAL,  START},
+        // CCW_BEGIN
+        {CCW_NEXT,   START,     CCW_BEGIN, START},
+        // CCW_FINAL
+        {CCW_NEXT,   CCW_FINAL, START,     START | CCW},
+        // CCW_NEXT
+        {CCW_NEXT,   CCW_FINAL, CCW_BEGIN, START},
+      };
+      static const uint8_t half_step_table[6][4] = {
+        // START
+        {START_M,        H_CW_BEGIN,    H_CCW_BEGIN,  START},
+        // H_CCW_BEGIN
+        {START_M | CCW,  START,         H_CCW_BEGIN,  START},
+        // H_CW_BEGIN
+        {START_M | CW,   H_CW_BEGIN,    START,        START},
+        // START_M
+        {START_M,        CCW_BEGIN_M,   CW_BEGIN_M,   START},
+        // CW_BEGIN_M
+        {START_M,        START_M,       CW_BEGIN_M,   START | CW},
+        // CCW_BEGIN_M
+        {START_M,        CCW_BEGIN_M,   START_M,      START | CCW},
+      };
+      // clang-format on
+
+      state &= STATE_MASK;
+      pins &= 0b11;
+      return full_step ? full_step_table[state][pins] : half_step_table[state][pins];
+    }
+
+    // nextの戻り値のステップ(+1, -1, 0)
+    static int8_t step(uint8_t state)
+    {
+      return (state & CW) ? 1 : (state & CCW) ? -1 : 0;
+    }
+
+  private:
+    // full step
+    static constexpr uint8_t START = 0x0;
+    static constexpr uint8_t CW_FINAL = 0x1;
+    static constexpr uint8_t CW_BEGIN = 0x2;
+    static constexpr uint8_t CW_NEXT = 0x3;
+    static constexpr uint8_t CCW_BEGIN = 0x4;
+    static constexpr uint8_t CCW_FINAL = 0x5;
+    static constexpr uint8_t CCW_NEXT = 0x6;
+    // half step
+    static constexpr uint8_t H_CCW_BEGIN = 0x1;
+    static constexpr uint8_t H_CW_BEGIN = 0x2;
+    static constexpr uint8_t START_M = 0x3;
+    static constexpr uint8_t CW_BEGIN_M = 0x4;
+    static constexpr uint8_t CCW_BEGIN_M = 0x5;
+  };
+
+} // namespace hidpg
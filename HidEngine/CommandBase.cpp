@@ -98,7 +98,7 @@ namespace hidpg
     return true;
   }
 
-  void BeforeOtherKeyPressEventListener::_notifyBeforeOtherKeyPress(uint8_t key_id)
+  void BeforeOtherKeyPressEventListener::_notifyBeforeOtherKeyPress(key_id_t key_id)
   {
     for (auto &listener : _listener_list())
     {
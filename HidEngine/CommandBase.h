@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "Set.h"
 #include "etl/intrusive_links.h"
 #include "etl/intrusive_list.h"
 #include "etl/optional.h"
@@ -91,8 +92,8 @@ namespace hidpg
     void release();
     uint8_t tap(uint8_t n_times = 1);
 
-    virtual void setKeyId(uint8_t key_id) { _key_id = key_id; }
-    etl::optional<uint8_t> getKeyId() { return _key_id; }
+    virtual void setKeyId(key_id_t key_id) { _key_id = key_id; }
+    etl::optional<key_id_t> getKeyId() { return _key_id; }
 
   protected:
     virtual void onPress(){};
@@ -105,7 +106,7 @@ namespace hidpg
     };
 
   private:
-    etl::optional<uint8_t> _key_id;
+    etl::optional<key_id_t> _key_id;
     bool _is_pressed;
   };
 
@@ -119,12 +120,12 @@ namespace hidpg
   {
   public:
     BeforeOtherKeyPressEventListener(Command *command);
-    static void _notifyBeforeOtherKeyPress(uint8_t key_id);
+    static void _notifyBeforeOtherKeyPress(key_id_t key_id);
 
   protected:
     bool startListenBeforeOtherKeyPress();
     bool stopListenBeforeOtherKeyPress();
-    virtual void onBeforeOtherKeyPress(uint8_t key_id) = 0;
+    virtual void onBeforeOtherKeyPress(key_id_t key_id) = 0;
 
   private:
     using List = etl::intrusive_list<BeforeOtherKeyPressEventListener, Internal::BeforeOtherKeyPressEventListenerLink>;
@@ -131,7 +131,7 @@ namespace hidpg::Internal
   {
   }
 
-  void Layering::setKeyId(uint8_t key_id)
+  void Layering::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
 
@@ -253,7 +253,7 @@ namespace hidpg::Internal
   {
   }
 
-  void Tap::setKeyId(uint8_t key_id)
+  void Tap::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
     _command->setKeyId(key_id);
@@ -272,7 +272,7 @@ namespace hidpg::Internal
   {
   }
 
-  void TapWhenReleased::setKeyId(uint8_t key_id)
+  void TapWhenReleased::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
     _command->setKeyId(key_id);
@@ -304,7 +304,7 @@ namespace hidpg::Internal
   {
   }
 
-  void TapDance::setKeyId(uint8_t key_id)
+  void TapDance::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
 
@@ -508,7 +508,7 @@ namespace hidpg::Internal
     processTapDance(Action::Timer, nullptr);
   }
 
-  void TapDance::onBeforeOtherKeyPress(uint8_t key_id)
+  void TapDance::onBeforeOtherKeyPress(key_id_t key_id)
   {
     BeforeOtherKeyPressArgs args{.key_id = key_id};
     processTapDance(Action::BeforeOtherKeyPress, args);
@@ -625,7 +625,7 @@ namespace hidpg::Internal
   {
   }
 
-  void ConstantSpeed::setKeyId(uint8_t key_id)
+  void ConstantSpeed::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
     _command->setKeyId(key_id);
@@ -666,7 +666,7 @@ namespace hidpg::Internal
   {
   }
 
-  void StepSpeed::setKeyId(uint8_t key_id)
+  void StepSpeed::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
     _command->setKeyId(key_id);
@@ -711,7 +711,7 @@ namespace hidpg::Internal
   {
   }
 
-  void If::setKeyId(uint8_t key_id)
+  void If::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
     _true_command->setKeyId(key_id);
@@ -743,7 +743,7 @@ namespace hidpg::Internal
   {
   }
 
-  void Multi::setKeyId(uint8_t key_id)
+  void Multi::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
 
@@ -777,7 +777,7 @@ namespace hidpg::Internal
   {
   }
 
-  void Toggle::setKeyId(uint8_t key_id)
+  void Toggle::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
     _command->setKeyId(key_id);
@@ -805,7 +805,7 @@ namespace hidpg::Internal
   {
   }
 
-  void Repeat::setKeyId(uint8_t key_id)
+  void Repeat::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
     _command->setKeyId(key_id);
@@ -836,7 +836,7 @@ namespace hidpg::Internal
   {
   }
 
-  void Cycle::setKeyId(uint8_t key_id)
+  void Cycle::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
 
@@ -875,7 +875,7 @@ namespace hidpg::Internal
   {
   }
 
-  void CyclePhaseShift::setKeyId(uint8_t key_id)
+  void CyclePhaseShift::setKeyId(key_id_t key_id)
   {
     Command::setKeyId(key_id);
 
@@ -119,7 +119,7 @@ namespace hidpg::Internal
   {
   public:
     Layering(LayerClass &layer, etl::span<CommandPtr> commands);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
@@ -190,7 +190,7 @@ namespace hidpg::Internal
   {
   public:
     Tap(NotNullCommandPtr command, uint8_t n_times, uint16_t tap_speed_ms);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
@@ -208,7 +208,7 @@ namespace hidpg::Internal
   {
   public:
     TapWhenReleased(NotNullCommandPtr command, uint8_t n_times, uint16_t tap_speed_ms);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onRelease() override;
@@ -237,20 +237,20 @@ namespace hidpg::Internal
     };
 
     TapDance(etl::span<Pair> pairs, etl::span<PointingDeviceId> pointing_device_ids, uint16_t move_threshold, uint32_t tapping_term_ms);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
     void onRelease() override;
     void onTimer() override;
-    void onBeforeOtherKeyPress(uint8_t key_id) override;
+    void onBeforeOtherKeyPress(key_id_t key_id) override;
     void onBeforeMovePointer(PointingDeviceId pointing_device_id, int16_t delta_x, int16_t delta_y) override;
     void onBeforeRotateEncoder(EncoderId encoder_id, int16_t step) override;
 
   private:
     struct BeforeOtherKeyPressArgs
     {
-      const uint8_t key_id;
+      const key_id_t key_id;
     };
 
     struct BeforeMovePointerArgs
@@ -396,7 +396,7 @@ namespace hidpg::Internal
   {
   public:
     ConstantSpeed(NotNullCommandPtr command, uint32_t ms);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
@@ -417,7 +417,7 @@ namespace hidpg::Internal
   {
   public:
     StepSpeed(NotNullCommandPtr command, uint32_t _ms);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
@@ -439,7 +439,7 @@ namespace hidpg::Internal
   {
   public:
     If(bool (*func)(), NotNullCommandPtr true_command, NotNullCommandPtr false_command);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
@@ -460,7 +460,7 @@ namespace hidpg::Internal
   {
   public:
     Multi(etl::span<NotNullCommandPtr> commands);
-    void setKeyId(uint8_t key_id) override;
+    void setKeyId(key_id_t key_id) override;
 
   protected:
     void onPress() override;
@@ -477,7 +477,7 @@ namespace hidpg::Internal
   {
   public:
     Toggle(NotNullCommandPtr command);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
@@ -494,7 +494,7 @@ namespace hidpg::Internal
   {
   public:
     Repeat(NotNullCommandPtr command, uint32_t delay_ms, uint32_t interval_ms);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
@@ -514,7 +514,7 @@ namespace hidpg::Internal
   {
   public:
     Cycle(etl::span<NotNullCommandPtr> commands);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
@@ -532,7 +532,7 @@ namespace hidpg::Internal
   {
   public:
     CyclePhaseShift(etl::span<NotNullCommandPtr> commands);
-    void setKeyId(uint8_t) override;
+    void setKeyId(key_id_t) override;
 
   protected:
     void onPress() override;
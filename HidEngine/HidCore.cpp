@@ -25,7 +25,7 @@
 #include "HidCore.h"
 #include "ArduinoMacro.h"
 #include "HidEngine_config.h"
-#include "Set.h"
+#include "etl/algorithm.h"
 #include "task.h"
 #include <string.h>
 
@@ -36,10 +36,53 @@ namespace hidpg
   namespace Internal
   {
 
+#if HID_REPORTER_ENABLE_NKRO
+    static HidReporter::Report keyboardReport(uint8_t modifiers, const uint8_t key_codes[6], const uint8_t key_bitmap[HID_REPORTER_NKRO_KEY_BITMAP_SIZE])
+    {
+      HidReporter::Report report{.type = HidReporter::Report::Type::Keyboard};
+      report.keyboard.modifiers = modifiers;
+      memcpy(report.keyboard.key_codes, key_codes, sizeof(report.keyboard.key_codes));
+      memcpy(report.keyboard.key_bitmap, key_bitmap, sizeof(report.keyboard.key_bitmap));
+      return report;
+    }
+#else
+    static HidReporter::Report keyboardReport(uint8_t modifiers, const uint8_t key_codes[6])
+    {
+      HidReporter::Report report{.type = HidReporter::Report::Type::Keyboard};
+      report.keyboard.modifiers = modifiers;
+      memcpy(report.keyboard.key_codes, key_codes, sizeof(report.keyboard.key_codes));
+      return report;
+    }
+#endif
+
+    // wheel,horizは1ノッチ = HID_REPORTER_WHEEL_UNITS_PER_DETENTの単位
+    static HidReporter::Report mouseReport(uint8_t buttons, int16_t x, int16_t y, int16_t wheel, int16_t horiz)
+    {
+      HidReporter::Report report{.type = HidReporter::Report::Type::Mouse};
+      report.mouse.buttons = buttons;
+      report.mouse.x = x;
+      report.mouse.y = y;
+      report.mouse.wheel = wheel;
+      report.mouse.horiz = horiz;
+      return report;
+    }
+
+    static HidReporter::Report radialControllerReport(bool button, int16_t dial)
+    {
+      HidReporter::Report report{.type = HidReporter::Report::Type::RadialController};
+      report.radial_controller.button = button;
+      report.radial_controller.dial = dial;
+      return report;
+    }
+
     HidReporter *HidCore::_hid_reporter = nullptr;
     uint8_t HidCore::_pressed_keys[7] = {};
     uint8_t HidCore::_prev_sent_keys[6] = {};
     uint8_t HidCore::_key_counters[256] = {};
+#if HID_REPORTER_ENABLE_NKRO
+    uint8_t HidCore::_pressed_key_bitmap[HID_REPORTER_NKRO_KEY_BITMAP_SIZE] = {};
+    uint8_t HidCore::_prev_sent_key_bitmap[HID_REPORTER_NKRO_KEY_BITMAP_SIZE] = {};
+#endif
     uint8_t HidCore::_prev_sent_modifiers = 0;
     uint8_t HidCore::_modifier_counters[8] = {};
     uint8_t HidCore::_prev_sent_mouse_buttons = 0;
@@ -47,6 +90,9 @@ namespace hidpg
     bool HidCore::_prev_sent_radial_button = false;
     uint8_t HidCore::_radial_button_counter = 0;
     portTickType HidCore::_last_send_ticks = 0;
+    etl::vector<HidReporter::Report, 5> HidCore::_pending_reports;
+    bool HidCore::_pending_throttle = false;
+    uint8_t HidCore::_batch_depth = 0;
 
     void HidCore::setReporter(HidReporter *hid_reporter)
     {
@@ -61,12 +107,95 @@ namespace hidpg
       }
     }
 
+    void HidCore::beginBatch()
+    {
+      _batch_depth++;
+    }
+
+    void HidCore::endBatch()
+    {
+      if (_batch_depth > 0 && --_batch_depth == 0)
+      {
+        flush();
+      }
+    }
+
+    void HidCore::flush()
+    {
+      if (_pending_reports.empty())
+      {
+        return;
+      }
+
+      if (_hid_reporter != nullptr)
+      {
+        if (_pending_throttle)
+        {
+          vTaskDelayUntil(&_last_send_ticks, KEY_REPORT_MIN_INTERVAL_TICKS);
+        }
+        _hid_reporter->submit(etl::span<Report>(_pending_reports.data(), _pending_reports.size()));
+        if (_pending_throttle)
+        {
+          _last_send_ticks = xTaskGetTickCount();
+        }
+      }
+
+      _pending_reports.clear();
+      _pending_throttle = false;
+    }
+
+    // throttleがtrueのレポートはHID_ENGINE_KEY_REPORT_MIN_INTERVAL_MSより早く次のレポートを送らない
+    void HidCore::sendReport(const Report &report, bool throttle)
+    {
+      if (_hid_reporter == nullptr)
+      {
+        return;
+      }
+
+      for (Report &pending : _pending_reports)
+      {
+        if (pending.type != report.type)
+        {
+          continue;
+        }
+
+        // 同じボタン状態のマウスレポートは相対値なので合算できる
+        if (report.type == Report::Type::Mouse && pending.mouse.buttons == report.mouse.buttons && throttle == false)
+        {
+          pending.mouse.x = etl::clamp<int>(pending.mouse.x + report.mouse.x, INT16_MIN, INT16_MAX);
+          pending.mouse.y = etl::clamp<int>(pending.mouse.y + report.mouse.y, INT16_MIN, INT16_MAX);
+          pending.mouse.wheel = etl::clamp<int>(pending.mouse.wheel + report.mouse.wheel, INT16_MIN, INT16_MAX);
+          pending.mouse.horiz = etl::clamp<int>(pending.mouse.horiz + report.mouse.horiz, INT16_MIN, INT16_MAX);
+          return;
+        }
+
+        // 同じ種類のレポートは途中の状態を失わないように先に送る
+        flush();
+        break;
+      }
+
+      _pending_reports.push_back(report);
+      _pending_throttle |= throttle;
+
+      if (_batch_depth == 0)
+      {
+        flush();
+      }
+    }
+
     void HidCore::setKey(CharacterKey character_key)
     {
       uint8_t code = static_cast<uint8_t>(character_key);
 
       _key_counters[code]++;
 
+#if HID_REPORTER_ENABLE_NKRO
+      if (code < HID_REPORTER_NKRO_KEY_COUNT)
+      {
+        _pressed_key_bitmap[code / 8] |= bit(code % 8);
+      }
+#endif
+
       // すでに入ってるなら追加しない
       for (int i = 0; i < 6; i++)
       {
@@ -97,6 +226,12 @@ namespace hidpg
 
       if (_key_counters[code] == 0)
       {
+#if HID_REPORTER_ENABLE_NKRO
+        if (code < HID_REPORTER_NKRO_KEY_COUNT)
+        {
+          _pressed_key_bitmap[code / 8] &= ~bit(code % 8);
+        }
+#endif
         int i = 0;
         // 探して削除
         for (; i < 6; i++)
@@ -175,12 +310,31 @@ namespace hidpg
       {
         is_changed = true;
 
-        Set prev, current;
-        prev.addAll(_prev_sent_keys, 6);
-        current.addAll(_pressed_keys, 6);
-        is_key_adding = ((current - prev).count() != 0);
+        for (int i = 0; i < 6; i++)
+        {
+          if (_pressed_keys[i] != 0 && memchr(_prev_sent_keys, _pressed_keys[i], sizeof(_prev_sent_keys)) == nullptr)
+          {
+            is_key_adding = true;
+            break;
+          }
+        }
       }
 
+#if HID_REPORTER_ENABLE_NKRO
+      // 7key目以降は6keyの配列に入らないのでビットマップでも比較する
+      for (int i = 0; i < HID_REPORTER_NKRO_KEY_BITMAP_SIZE; i++)
+      {
+        if (_pressed_key_bitmap[i] != _prev_sent_key_bitmap[i])
+        {
+          is_changed = true;
+        }
+        if ((_pressed_key_bitmap[i] & ~_prev_sent_key_bitmap[i]) != 0)
+        {
+          is_key_adding = true;
+        }
+      }
+#endif
+
       // 現在押されているmodifierを追加
       uint8_t modifiers = 0;
       for (int i = 0; i < 8; i++)
@@ -203,81 +357,76 @@ namespace hidpg
       {
         // keyとmodifierが同時に追加された場合はmodifierキーを送ってからkeyを送る
         // 全く同じタイミングで送ると一部の環境で意図しない動きになる（windowsキーを使ったショートカットなど）
-        if (_hid_reporter != nullptr)
-        {
-          vTaskDelayUntil(&_last_send_ticks, KEY_REPORT_MIN_INTERVAL_TICKS);
-          _hid_reporter->keyboardReport(modifiers, _prev_sent_keys);
-          vTaskDelay(KEY_REPORT_MIN_INTERVAL_TICKS);
-          _hid_reporter->keyboardReport(modifiers, _pressed_keys);
-          _last_send_ticks = xTaskGetTickCount();
-        }
+        // 同じ種類のレポートなのでsendReport内で1つ目が先に送られ、間隔が空けられる
+#if HID_REPORTER_ENABLE_NKRO
+        sendReport(keyboardReport(modifiers, _prev_sent_keys, _prev_sent_key_bitmap), true);
+        sendReport(keyboardReport(modifiers, _pressed_keys, _pressed_key_bitmap), true);
+#else
+        sendReport(keyboardReport(modifiers, _prev_sent_keys), true);
+        sendReport(keyboardReport(modifiers, _pressed_keys), true);
+#endif
       }
       else if (is_changed)
       {
-        if (_hid_reporter != nullptr)
-        {
-          vTaskDelayUntil(&_last_send_ticks, KEY_REPORT_MIN_INTERVAL_TICKS);
-          _hid_reporter->keyboardReport(modifiers, _pressed_keys);
-          _last_send_ticks = xTaskGetTickCount();
-        }
+#if HID_REPORTER_ENABLE_NKRO
+        sendReport(keyboardReport(modifiers, _pressed_keys, _pressed_key_bitmap), true);
+#else
+        sendReport(keyboardReport(modifiers, _pressed_keys), true);
+#endif
       }
 
       // 次回用に保存
       if (is_changed)
       {
         memcpy(_prev_sent_keys, _pressed_keys, sizeof(_prev_sent_keys));
+#if HID_REPORTER_ENABLE_NKRO
+        memcpy(_prev_sent_key_bitmap, _pressed_key_bitmap, sizeof(_prev_sent_key_bitmap));
+#endif
         _prev_sent_modifiers = modifiers;
       }
     }
 
     void HidCore::consumerControlPress(ConsumerControlCode usage_code)
     {
-      if (_hid_reporter != nullptr)
-      {
-        _hid_reporter->consumerReport(static_cast<uint16_t>(usage_code));
-      }
+      Report report{.type = Report::Type::Consumer};
+      report.consumer.usage_code = static_cast<uint16_t>(usage_code);
+      sendReport(report, false);
     }
 
     void HidCore::consumerControlRelease()
     {
-      if (_hid_reporter != nullptr)
-      {
-        _hid_reporter->consumerReport(0);
-      }
+      Report report{.type = Report::Type::Consumer};
+      report.consumer.usage_code = 0;
+      sendReport(report, false);
     }
 
     void HidCore::systemControlPress(SystemControlCode usage_code)
     {
-      if (_hid_reporter != nullptr)
-      {
-        _hid_reporter->systemControlReport(static_cast<uint8_t>(usage_code));
-      }
+      Report report{.type = Report::Type::SystemControl};
+      report.system_control.usage_code = static_cast<uint8_t>(usage_code);
+      sendReport(report, false);
     }
 
     void HidCore::systemControlRelease()
     {
-      if (_hid_reporter != nullptr)
-      {
-        _hid_reporter->systemControlReport(0);
-      }
+      Report report{.type = Report::Type::SystemControl};
+      report.system_control.usage_code = 0;
+      sendReport(report, false);
     }
 
     void HidCore::mouseMove(int16_t x, int16_t y)
     {
-      if (_hid_reporter != nullptr)
-      {
-        _hid_reporter->mouseReport(_prev_sent_mouse_buttons, x, y, 0, 0);
-      }
+      sendReport(mouseReport(_prev_sent_mouse_buttons, x, y, 0, 0), false);
     }
 
     void HidCore::mouseScroll(int8_t scroll, int8_t horiz)
     {
-      if (_hid_reporter != nullptr)
-      {
-        vTaskDelayUntil(&_last_send_ticks, KEY_REPORT_MIN_INTERVAL_TICKS);
-        _hid_reporter->mouseReport(_prev_sent_mouse_buttons, 0, 0, scroll, horiz);
-        _last_send_ticks = xTaskGetTickCount();
-      }
+      mouseScrollHighResolution(scroll * HID_REPORTER_WHEEL_UNITS_PER_DETENT, horiz * HID_REPORTER_WHEEL_UNITS_PER_DETENT);
+    }
+
+    void HidCore::mouseScrollHighResolution(int16_t scroll, int16_t horiz)
+    {
+      sendReport(mouseReport(_prev_sent_mouse_buttons, 0, 0, scroll, horiz), true);
     }
 
     void HidCore::mouseButtonsPress(MouseButtons buttons)
@@ -306,12 +455,7 @@ namespace hidpg
       if (buttons != _prev_sent_mouse_buttons)
       {
         _prev_sent_mouse_buttons = buttons;
-        if (_hid_reporter != nullptr)
-        {
-          vTaskDelayUntil(&_last_send_ticks, KEY_REPORT_MIN_INTERVAL_TICKS);
-          _hid_reporter->mouseReport(buttons, 0, 0, 0, 0);
-          _last_send_ticks = xTaskGetTickCount();
-        }
+        sendReport(mouseReport(buttons, 0, 0, 0, 0), true);
       }
     }
 
@@ -329,10 +473,7 @@ namespace hidpg
 
     void HidCore::radialControllerDialRotate(int16_t deci_degree)
     {
-      if (_hid_reporter != nullptr)
-      {
-        _hid_reporter->radialControllerReport(_prev_sent_radial_button, deci_degree);
-      }
+      sendReport(radialControllerReport(_prev_sent_radial_button, deci_degree), false);
     }
 
     void HidCore::sendRadialControllerButtonReport()
@@ -342,10 +483,7 @@ namespace hidpg
       if (button != _prev_sent_radial_button)
       {
         _prev_sent_radial_button = button;
-        if (_hid_reporter != nullptr)
-        {
-          _hid_reporter->radialControllerReport(button, 0);
-        }
+        sendReport(radialControllerReport(button, 0), false);
       }
     }
 
@@ -27,6 +27,7 @@
 #include "FreeRTOS.h"
 #include "HidReporter.h"
 #include "KeyCode.h"
+#include "etl/vector.h"
 
 namespace hidpg
 {
@@ -40,6 +41,12 @@ namespace hidpg
       static void setReporter(HidReporter *hid_reporter);
       static void waitReady();
 
+      // Batch API
+      // beginBatchからendBatchまでに作られたレポートはまとめてHidReporter::submitで送られる
+      // 同じ種類のレポートが2つ目に来た場合はそれまでのレポートを先に送る(マウスの移動量は合算する)
+      static void beginBatch();
+      static void endBatch();
+
       // Keyboard API
       // setKeyをした後でsendKeyReportを呼び出すことでキーを送る。
       // 何回キーをsetしたかを覚えてるので複数回同じキーコードでsetKeyを呼び出したら同じ回数unsetKeyを呼び出すまではそのキーコードは入力され続ける。
@@ -59,6 +66,8 @@ namespace hidpg
       // mouseButtonsPress,Releaseは複数スイッチでの同時押しに対応
       static void mouseMove(int16_t x, int16_t y);
       static void mouseScroll(int8_t scroll, int8_t horiz);
+      // 1ノッチ = HID_REPORTER_WHEEL_UNITS_PER_DETENTの単位でスクロールする
+      static void mouseScrollHighResolution(int16_t scroll, int16_t horiz);
       static void mouseButtonsPress(MouseButtons buttons);
       static void mouseButtonsRelease(MouseButtons buttons);
 
@@ -73,6 +82,10 @@ namespace hidpg
       static void systemControlRelease();
 
     private:
+      using Report = HidReporter::Report;
+
+      static void sendReport(const Report &report, bool throttle);
+      static void flush();
       static void sendMouseButtonsReport();
       static void sendRadialControllerButtonReport();
 
@@ -81,6 +94,10 @@ namespace hidpg
       static uint8_t _pressed_keys[7];
       static uint8_t _prev_sent_keys[6];
       static uint8_t _key_counters[256];
+#if HID_REPORTER_ENABLE_NKRO
+      static uint8_t _pressed_key_bitmap[HID_REPORTER_NKRO_KEY_BITMAP_SIZE];
+      static uint8_t _prev_sent_key_bitmap[HID_REPORTER_NKRO_KEY_BITMAP_SIZE];
+#endif
 
       static uint8_t _prev_sent_modifiers;
       static uint8_t _modifier_counters[8];
@@ -92,6 +109,10 @@ namespace hidpg
       static uint8_t _radial_button_counter;
 
       static portTickType _last_send_ticks;
+
+      static etl::vector<Report, 5> _pending_reports;
+      static bool _pending_throttle;
+      static uint8_t _batch_depth;
     };
 
   } // namespace Internal
@@ -109,6 +109,18 @@ namespace hidpg
       HidEngineTask.enqueEvent(evt);
     }
 
+    bool HidEngineClass::tryApplyToKeymap(const Set &key_ids)
+    {
+      EventData evt{ApplyToKeymapEventData{key_ids}};
+      return HidEngineTask.tryEnqueEvent(evt);
+    }
+
+    bool HidEngineClass::tryMovePointer(PointingDeviceId pointing_device_id)
+    {
+      EventData evt{MovePointerEventData{pointing_device_id}};
+      return HidEngineTask.tryEnqueEvent(evt);
+    }
+
     void HidEngineClass::setReadPointerDeltaCallback(read_pointer_delta_callback_t cb)
     {
       _read_pointer_delta_cb = cb;
@@ -126,36 +138,20 @@ namespace hidpg
     {
       static Set prev_ids;
 
-      {
-        Set press_ids = key_ids - prev_ids;
-
-        uint8_t arr[press_ids.count()];
-        press_ids.toArray(arr);
-
-        for (uint8_t key_id : arr)
-        {
-          processComboAndKey(Action::Press, key_id);
-        }
-      }
-
-      {
-        Set release_ids = prev_ids - key_ids;
-
-        uint8_t arr[release_ids.count()];
-        release_ids.toArray(arr);
-
-        for (uint8_t key_id : arr)
-        {
-          processComboAndKey(Action::Release, key_id);
-        }
-      }
+      // 押されたキーを全て処理してから離されたキーを処理する
+      Set::diff(
+          prev_ids, key_ids,
+          [](key_id_t key_id)
+          { processComboAndKey(Action::Press, key_id); },
+          [](key_id_t key_id)
+          { processComboAndKey(Action::Release, key_id); });
 
       prev_ids = key_ids;
     }
 
-    void HidEngineClass::processComboAndKey(Action action, etl::optional<uint8_t> key_id)
+    void HidEngineClass::processComboAndKey(Action action, etl::optional<key_id_t> key_id)
     {
-      static etl::optional<uint8_t> first_commbo_id;
+      static etl::optional<key_id_t> first_commbo_id;
       static etl::intrusive_list<Combo> success_combo_list;
 
       switch (action)
@@ -297,7 +293,7 @@ namespace hidpg
       }
     }
 
-    void HidEngineClass::performKeyPress(uint8_t key_id)
+    void HidEngineClass::performKeyPress(key_id_t key_id)
     {
       for (auto &key : _pressed_key_list)
       {
@@ -335,7 +331,7 @@ namespace hidpg
       key->command->press();
     }
 
-    void HidEngineClass::performKeyRelease(uint8_t key_id)
+    void HidEngineClass::performKeyRelease(key_id_t key_id)
     {
       for (auto &key : _pressed_key_list)
       {
@@ -349,7 +345,7 @@ namespace hidpg
       }
     }
 
-    std::tuple<KeyShift *, Key *> HidEngineClass::getCurrentKey(uint8_t key_id)
+    std::tuple<KeyShift *, Key *> HidEngineClass::getCurrentKey(key_id_t key_id)
     {
       for (auto &started_key_shift_id : _started_key_shift_id_list)
       {
@@ -64,13 +64,13 @@ namespace hidpg
 
   struct Key : public etl::bidirectional_link<0>
   {
-    Key(uint8_t key_id, NotNullCommandPtr command)
+    Key(key_id_t key_id, NotNullCommandPtr command)
         : etl::bidirectional_link<0>(), key_id(key_id), command(command)
     {
       command->setKeyId(key_id);
     }
 
-    const uint8_t key_id;
+    const key_id_t key_id;
     const NotNullCommandPtr command;
   };
 
@@ -117,8 +117,8 @@ namespace hidpg
 
   struct Combo : public etl::bidirectional_link<0>
   {
-    Combo(uint8_t first_key_id,
-          uint8_t second_key_id,
+    Combo(key_id_t first_key_id,
+          key_id_t second_key_id,
           NotNullCommandPtr command,
           uint32_t combo_term_ms,
           ComboBehavior combo_behavior)
@@ -130,8 +130,8 @@ namespace hidpg
     {
     }
 
-    const uint8_t first_id;
-    const uint8_t second_id;
+    const key_id_t first_id;
+    const key_id_t second_id;
     const NotNullCommandPtr command;
     const uint32_t combo_term_ms;
     const ComboBehavior behavior;
@@ -144,7 +144,7 @@ namespace hidpg
     bool isFastRelease() { return static_cast<uint8_t>(behavior) & 0b01; }
     bool isSlowRelease() { return !isFastRelease(); }
 
-    bool isMatchFirstId(uint8_t id)
+    bool isMatchFirstId(key_id_t id)
     {
       if (isSpecifiedOrder())
       {
@@ -153,7 +153,7 @@ namespace hidpg
       return first_id == id || second_id == id;
     }
 
-    bool isMatchIds(uint8_t fst, uint8_t snd)
+    bool isMatchIds(key_id_t fst, key_id_t snd)
     {
       if (isSpecifiedOrder())
       {
@@ -298,6 +298,9 @@ namespace hidpg
       static void applyToKeymap(const Set &key_ids);
       static void movePointer(PointingDeviceId pointing_device_id);
       static void rotateEncoder(EncoderId encoder_id);
+      // ブロックできないコンテキスト(BLEのコールバック等)用、イベントキューが一杯ならfalseを返す
+      static bool tryApplyToKeymap(const Set &key_ids);
+      static bool tryMovePointer(PointingDeviceId pointing_device_id);
       static void setReadPointerDeltaCallback(read_pointer_delta_callback_t cb);
       static void setReadEncoderStepCallback(read_encoder_step_callback_t cb);
 
@@ -317,10 +320,10 @@ namespace hidpg
       };
 
       static void applyToKeymap_impl(Set &key_ids);
-      static void processComboAndKey(Action action, etl::optional<uint8_t> key_id);
-      static void performKeyPress(uint8_t key_id);
-      static void performKeyRelease(uint8_t key_id);
-      static std::tuple<KeyShift *, Key *> getCurrentKey(uint8_t key_id);
+      static void processComboAndKey(Action action, etl::optional<key_id_t> key_id);
+      static void performKeyPress(key_id_t key_id);
+      static void performKeyRelease(key_id_t key_id);
+      static std::tuple<KeyShift *, Key *> getCurrentKey(key_id_t key_id);
 
       static void movePointer_impl(PointingDeviceId pointing_device_id);
       static Gesture *getCurrentGesture(PointingDeviceId pointing_device_id);
@@ -24,6 +24,7 @@
 
 #include "HidEngineTask.h"
 #include "CommandTapper.h"
+#include "HidCore.h"
 #include "HidEngine.h"
 
 namespace hidpg
@@ -52,6 +53,12 @@ namespace hidpg
       xQueueSend(_event_queue, &evt, portMAX_DELAY);
     }
 
+    // キューが一杯なら待たずにfalseを返す
+    bool HidEngineTaskClass::tryEnqueEvent(const EventData &evt)
+    {
+      return xQueueSend(_event_queue, &evt, 0) == pdTRUE;
+    }
+
     void HidEngineTaskClass::task(void *pvParameters)
     {
       while (true)
@@ -59,6 +66,9 @@ namespace hidpg
         EventData evt;
         xQueueReceive(_event_queue, &evt, portMAX_DELAY);
 
+        // 1つのイベントで変化したレポートはまとめて送る
+        Hid.beginBatch();
+
         if (auto *e = etl::get_if<ApplyToKeymapEventData>(&evt))
         {
           HidEngine.applyToKeymap_impl(e->key_ids);
@@ -79,6 +89,8 @@ namespace hidpg
         {
           CommandTapper.onTimer();
         }
+
+        Hid.endBatch();
       }
     }
 
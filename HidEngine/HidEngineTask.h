@@ -73,6 +73,7 @@ namespace hidpg
     public:
       static void start();
       static void enqueEvent(const EventData &evt);
+      static bool tryEnqueEvent(const EventData &evt);
 
     private:
       static void task(void *pvParameters);
@@ -28,14 +28,27 @@ namespace hidpg
 {
 
   // clang-format off
-  uint8_t const hid_report_descriptor[260] =
+  // HidReporter_config.hで有効にしたレポートだけを含める
+  uint8_t const hid_report_descriptor[] =
   {
+#if HID_REPORTER_ENABLE_NKRO
+    TUD_HID_REPORT_DESC_KEYBOARD_NKRO( HID_REPORT_ID(REPORT_ID_KEYBOARD) ),
+#else
     TUD_HID_REPORT_DESC_KEYBOARD( HID_REPORT_ID(REPORT_ID_KEYBOARD) ),
+#endif
+#if HID_REPORTER_ENABLE_CONSUMER_CONTROL
     TUD_HID_REPORT_DESC_CONSUMER( HID_REPORT_ID(REPORT_ID_CONSUMER_CONTROL) ),
+#endif
     TUD_HID_REPORT_DESC_MOUSE_EX( HID_REPORT_ID(REPORT_ID_MOUSE) ),
+#if HID_REPORTER_ENABLE_RADIAL_CONTROLLER
     TUD_HID_REPORT_DESC_RADIAL_CONTROLLER( HID_REPORT_ID(REPORT_ID_RADIAL_CONTROLLER) ),
+#endif
+#if HID_REPORTER_ENABLE_SYSTEM_CONTROL
     TUD_HID_REPORT_DESC_SYSTEM_CONTROL( HID_REPORT_ID(REPORT_ID_SYSTEM_CONTROL) ),
+#endif
   };
   // clang-format on
 
+  uint16_t const hid_report_descriptor_len = sizeof(hid_report_descriptor);
+
 } // namespace hidpg
@@ -24,6 +24,8 @@
 
 #pragma once
 
+#include "HidReporter.h"
+#include "HidReporter_config.h"
 #include "class/hid/hid_device.h"
 
 namespace hidpg
@@ -31,6 +33,113 @@ namespace hidpg
 
   // clang-format off
 
+  // NKRO Keyboard Report Descriptor
+  // modifier 8bit + キーコード0 ~ HID_REPORTER_NKRO_KEY_COUNT - 1のビットマップ
+  #define TUD_HID_REPORT_DESC_KEYBOARD_NKRO(...) \
+    HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP                    )     ,\
+    HID_USAGE      ( HID_USAGE_DESKTOP_KEYBOARD                )     ,\
+    HID_COLLECTION ( HID_COLLECTION_APPLICATION                )     ,\
+      /* Report ID if any */\
+      __VA_ARGS__ \
+      /* 8 bits Modifier Keys (Shfit, Control, Alt) */ \
+      HID_USAGE_PAGE ( HID_USAGE_PAGE_KEYBOARD )                     ,\
+        HID_USAGE_MIN    ( 224                                    )  ,\
+        HID_USAGE_MAX    ( 231                                    )  ,\
+        HID_LOGICAL_MIN  ( 0                                      )  ,\
+        HID_LOGICAL_MAX  ( 1                                      )  ,\
+        HID_REPORT_COUNT ( 8                                      )  ,\
+        HID_REPORT_SIZE  ( 1                                      )  ,\
+        HID_INPUT        ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE )  ,\
+        /* Key bitmap */ \
+        HID_USAGE_MIN    ( 0                                      )  ,\
+        HID_USAGE_MAX    ( HID_REPORTER_NKRO_KEY_COUNT - 1        )  ,\
+        HID_REPORT_COUNT ( HID_REPORTER_NKRO_KEY_COUNT            )  ,\
+        HID_REPORT_SIZE  ( 1                                      )  ,\
+        HID_INPUT        ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE )  ,\
+      /* 5-bit LED Indicator Kana | Compose | ScrollLock | CapsLock | NumLock */ \
+      HID_USAGE_PAGE  ( HID_USAGE_PAGE_LED                   )       ,\
+        HID_USAGE_MIN    ( 1                                      )  ,\
+        HID_USAGE_MAX    ( 5                                      )  ,\
+        HID_REPORT_COUNT ( 5                                      )  ,\
+        HID_REPORT_SIZE  ( 1                                      )  ,\
+        HID_OUTPUT       ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE )  ,\
+        /* led padding */ \
+        HID_REPORT_COUNT ( 1                                      )  ,\
+        HID_REPORT_SIZE  ( 3                                      )  ,\
+        HID_OUTPUT       ( HID_CONSTANT                           )  ,\
+    HID_COLLECTION_END \
+
+  #define HID_USAGE_DESKTOP_RESOLUTION_MULTIPLIER_EX 0x48
+
+#if HID_REPORTER_ENABLE_HIGH_RESOLUTION_WHEEL
+  // 高解像度ホイール
+  // ホイール毎にResolution Multiplier(2bit)のFeatureを持つLogical Collectionに入れる
+  // Featureレポートは vertical 2bit | horizontal 2bit | padding 4bit の1byte
+  #define HID_MOUSE_WHEEL_DESC \
+        HID_COLLECTION ( HID_COLLECTION_LOGICAL                 )  ,\
+          HID_USAGE       ( HID_USAGE_DESKTOP_RESOLUTION_MULTIPLIER_EX ) ,\
+          HID_LOGICAL_MIN ( 0                                      )  ,\
+          HID_LOGICAL_MAX ( 1                                      )  ,\
+          HID_PHYSICAL_MIN( 1                                      )  ,\
+          HID_PHYSICAL_MAX( HID_REPORTER_WHEEL_RESOLUTION_MULTIPLIER ),\
+          HID_REPORT_COUNT( 1                                      )  ,\
+          HID_REPORT_SIZE ( 2                                      )  ,\
+          HID_FEATURE     ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE )  ,\
+          /* Verital wheel scroll [-127, 127] */ \
+          HID_USAGE       ( HID_USAGE_DESKTOP_WHEEL                )  ,\
+          HID_LOGICAL_MIN ( 0x81                                   )  ,\
+          HID_LOGICAL_MAX ( 0x7f                                   )  ,\
+          HID_PHYSICAL_MIN( 0                                      )  ,\
+          HID_PHYSICAL_MAX( 0                                      )  ,\
+          HID_REPORT_COUNT( 1                                      )  ,\
+          HID_REPORT_SIZE ( 8                                      )  ,\
+          HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE )  ,\
+        HID_COLLECTION_END                                            ,\
+        HID_COLLECTION ( HID_COLLECTION_LOGICAL                 )  ,\
+          HID_USAGE       ( HID_USAGE_DESKTOP_RESOLUTION_MULTIPLIER_EX ) ,\
+          HID_LOGICAL_MIN ( 0                                      )  ,\
+          HID_LOGICAL_MAX ( 1                                      )  ,\
+          HID_PHYSICAL_MIN( 1                                      )  ,\
+          HID_PHYSICAL_MAX( HID_REPORTER_WHEEL_RESOLUTION_MULTIPLIER ),\
+          HID_REPORT_COUNT( 1                                      )  ,\
+          HID_REPORT_SIZE ( 2                                      )  ,\
+          HID_FEATURE     ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE )  ,\
+          /* Horizontal wheel scroll [-127, 127] */ \
+          HID_PHYSICAL_MIN( 0                                      )  ,\
+          HID_PHYSICAL_MAX( 0                                      )  ,\
+          HID_USAGE_PAGE  ( HID_USAGE_PAGE_CONSUMER                )  ,\
+          HID_USAGE_N     ( HID_USAGE_CONSUMER_AC_PAN, 2           )  ,\
+          HID_LOGICAL_MIN ( 0x81                                   )  ,\
+          HID_LOGICAL_MAX ( 0x7f                                   )  ,\
+          HID_REPORT_COUNT( 1                                      )  ,\
+          HID_REPORT_SIZE ( 8                                      )  ,\
+          HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE )  ,\
+        HID_COLLECTION_END                                            ,\
+        /* Feature padding */ \
+        HID_REPORT_COUNT( 1                                        )  ,\
+        HID_REPORT_SIZE ( 4                                        )  ,\
+        HID_FEATURE     ( HID_CONSTANT                             )  ,\
+
+#else
+  #define HID_MOUSE_WHEEL_DESC \
+          /* Verital wheel scroll [-127, 127] */ \
+          HID_USAGE       ( HID_USAGE_DESKTOP_WHEEL                )  ,\
+          HID_LOGICAL_MIN ( 0x81                                   )  ,\
+          HID_LOGICAL_MAX ( 0x7f                                   )  ,\
+          HID_REPORT_COUNT( 1                                      )  ,\
+          HID_REPORT_SIZE ( 8                                      )  ,\
+          HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE )  ,\
+        HID_USAGE_PAGE  ( HID_USAGE_PAGE_CONSUMER ), \
+        /* Horizontal wheel scroll [-127, 127] */ \
+          HID_USAGE_N     ( HID_USAGE_CONSUMER_AC_PAN, 2           ), \
+          HID_LOGICAL_MIN ( 0x81                                   ), \
+          HID_LOGICAL_MAX ( 0x7f                                   ), \
+          HID_REPORT_COUNT( 1                                      ), \
+          HID_REPORT_SIZE ( 8                                      ), \
+          HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE ), \
+
+#endif
+
   // Mouse Report Descriptor
   #define TUD_HID_REPORT_DESC_MOUSE_EX(...) \
     HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP      )                   ,\
@@ -54,29 +163,15 @@ namespace hidpg
           HID_REPORT_SIZE ( 3                                      ) ,\
           HID_INPUT       ( HID_CONSTANT                           ) ,\
         HID_USAGE_PAGE  ( HID_USAGE_PAGE_DESKTOP )                   ,\
-          /* X, Y position [-32768, 32767] */ \
+          /* X, Y position [HID_MOUSE_XY_MIN, HID_MOUSE_XY_MAX] */ \
           HID_USAGE       ( HID_USAGE_DESKTOP_X                    ) ,\
           HID_USAGE       ( HID_USAGE_DESKTOP_Y                    ) ,\
-          HID_LOGICAL_MIN_N ( 0x8000, 2                            ) ,\
-          HID_LOGICAL_MAX_N ( 0x7fff, 2                            ) ,\
+          HID_LOGICAL_MIN_N ( HID_MOUSE_XY_MIN, 2                  ) ,\
+          HID_LOGICAL_MAX_N ( HID_MOUSE_XY_MAX, 2                  ) ,\
           HID_REPORT_COUNT( 2                                      ) ,\
-          HID_REPORT_SIZE ( 16                                     ) ,\
+          HID_REPORT_SIZE ( HID_REPORTER_MOUSE_XY_BITS             ) ,\
           HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE ) ,\
-          /* Verital wheel scroll [-127, 127] */ \
-          HID_USAGE       ( HID_USAGE_DESKTOP_WHEEL                )  ,\
-          HID_LOGICAL_MIN ( 0x81                                   )  ,\
-          HID_LOGICAL_MAX ( 0x7f                                   )  ,\
-          HID_REPORT_COUNT( 1                                      )  ,\
-          HID_REPORT_SIZE ( 8                                      )  ,\
-          HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE )  ,\
-        HID_USAGE_PAGE  ( HID_USAGE_PAGE_CONSUMER ), \
-        /* Horizontal wheel scroll [-127, 127] */ \
-          HID_USAGE_N     ( HID_USAGE_CONSUMER_AC_PAN, 2           ), \
-          HID_LOGICAL_MIN ( 0x81                                   ), \
-          HID_LOGICAL_MAX ( 0x7f                                   ), \
-          HID_REPORT_COUNT( 1                                      ), \
-          HID_REPORT_SIZE ( 8                                      ), \
-          HID_INPUT       ( HID_DATA | HID_VARIABLE | HID_RELATIVE ), \
+        HID_MOUSE_WHEEL_DESC \
       HID_COLLECTION_END                                            , \
     HID_COLLECTION_END \
 
@@ -132,16 +227,49 @@ namespace hidpg
     0xc0,                            /*   END_COLLECTION                      */ \
     0xc0                             /* END_COLLECTION                        */ \
 
+  // 有効なレポートにだけ1から連番でReport IDを割り当てる、無効なレポートは0
   enum
   {
     REPORT_ID_KEYBOARD = 1,
-    REPORT_ID_CONSUMER_CONTROL,
-    REPORT_ID_MOUSE,
-    REPORT_ID_RADIAL_CONTROLLER,
-    REPORT_ID_SYSTEM_CONTROL,
+    REPORT_ID_CONSUMER_CONTROL = HID_REPORTER_ENABLE_CONSUMER_CONTROL ? REPORT_ID_KEYBOARD + 1 : 0,
+    REPORT_ID_MOUSE = REPORT_ID_KEYBOARD + HID_REPORTER_ENABLE_CONSUMER_CONTROL + 1,
+    REPORT_ID_RADIAL_CONTROLLER = HID_REPORTER_ENABLE_RADIAL_CONTROLLER ? REPORT_ID_MOUSE + 1 : 0,
+    REPORT_ID_SYSTEM_CONTROL = HID_REPORTER_ENABLE_SYSTEM_CONTROL ? REPORT_ID_MOUSE + HID_REPORTER_ENABLE_RADIAL_CONTROLLER + 1 : 0,
+    REPORT_ID_COUNT = REPORT_ID_MOUSE + HID_REPORTER_ENABLE_RADIAL_CONTROLLER + HID_REPORTER_ENABLE_SYSTEM_CONTROL,
   };
 
+  #define HID_MOUSE_XY_MIN (-(1 << (HID_REPORTER_MOUSE_XY_BITS - 1)) + 1)
+  #define HID_MOUSE_XY_MAX ((1 << (HID_REPORTER_MOUSE_XY_BITS - 1)) - 1)
+
 #pragma pack(1)
+#if HID_REPORTER_ENABLE_NKRO
+  struct hid_keyboard_report_ex_t
+  {
+    uint8_t modifier;
+    uint8_t key_bitmap[HID_REPORTER_NKRO_KEY_BITMAP_SIZE];
+  };
+#else
+  using hid_keyboard_report_ex_t = hid_keyboard_report_t;
+#endif
+
+#if HID_REPORTER_MOUSE_XY_BITS == 8
+  struct hid_mouse_report_ex_t
+  {
+    uint8_t buttons;
+    int8_t x;
+    int8_t y;
+    int8_t wheel;
+    int8_t pan;
+  };
+#elif HID_REPORTER_MOUSE_XY_BITS == 12
+  struct hid_mouse_report_ex_t
+  {
+    uint8_t buttons;
+    uint8_t xy[3]; // x: bit 0-11, y: bit 12-23
+    int8_t wheel;
+    int8_t pan;
+  };
+#elif HID_REPORTER_MOUSE_XY_BITS == 16
   struct hid_mouse_report_ex_t
   {
     uint8_t buttons;
@@ -150,6 +278,9 @@ namespace hidpg
     int8_t wheel;
     int8_t pan;
   };
+#else
+#error "HID_REPORTER_MOUSE_XY_BITS must be 8, 12 or 16"
+#endif
 
   struct hid_radial_controller_report_t
   {
@@ -158,8 +289,62 @@ namespace hidpg
   };
 #pragma pack()
 
+  // キーボードのレポートを書き込む、NKROではビットマップ、それ以外は6キーの配列
+  static inline void serializeKeyboardReport(hid_keyboard_report_ex_t &buf, const HidReporter::Report &report)
+  {
+    buf.modifier = report.keyboard.modifiers;
+#if HID_REPORTER_ENABLE_NKRO
+    memcpy(buf.key_bitmap, report.keyboard.key_bitmap, sizeof(buf.key_bitmap));
+#else
+    buf.reserved = 0;
+    memcpy(buf.keycode, report.keyboard.key_codes, sizeof(buf.keycode));
+#endif
+  }
+
+  // 高解像度ホイールの単位からレポートに書く値に変換する
+  // ホストがResolution Multiplierを有効にしていなければノッチ単位にし、端数はremainderに持ち越す
+  static inline int16_t scaleWheel(int16_t units, bool multiplier_enabled, int16_t &remainder)
+  {
+    if (HID_REPORTER_WHEEL_UNITS_PER_DETENT == 1 || multiplier_enabled)
+    {
+      return units;
+    }
+    int32_t total = remainder + units;
+    int16_t detents = total / HID_REPORTER_WHEEL_UNITS_PER_DETENT;
+    remainder = total - detents * HID_REPORTER_WHEEL_UNITS_PER_DETENT;
+    return detents;
+  }
+
+  // x,y,wheel,panをレポートに書き込む
+  // 範囲に収まらない分は引数に残るので、全て0になるまで繰り返し呼び出してレポートを送る
+  static inline void serializeMouseReport(hid_mouse_report_ex_t &report, uint8_t buttons, int16_t &x, int16_t &y, int16_t &wheel, int16_t &pan)
+  {
+    int16_t sx = (x < HID_MOUSE_XY_MIN) ? HID_MOUSE_XY_MIN : (x > HID_MOUSE_XY_MAX) ? HID_MOUSE_XY_MAX : x;
+    int16_t sy = (y < HID_MOUSE_XY_MIN) ? HID_MOUSE_XY_MIN : (y > HID_MOUSE_XY_MAX) ? HID_MOUSE_XY_MAX : y;
+    int8_t swheel = (wheel < -127) ? -127 : (wheel > 127) ? 127 : wheel;
+    int8_t span = (pan < -127) ? -127 : (pan > 127) ? 127 : pan;
+
+    report.buttons = buttons;
+#if HID_REPORTER_MOUSE_XY_BITS == 12
+    report.xy[0] = sx & 0xff;
+    report.xy[1] = ((sx >> 8) & 0x0f) | ((sy & 0x0f) << 4);
+    report.xy[2] = (sy >> 4) & 0xff;
+#else
+    report.x = sx;
+    report.y = sy;
+#endif
+    report.wheel = swheel;
+    report.pan = span;
+
+    x -= sx;
+    y -= sy;
+    wheel -= swheel;
+    pan -= span;
+  }
+
   // clang-format on
 
-  extern uint8_t const hid_report_descriptor[260];
+  extern uint8_t const hid_report_descriptor[];
+  extern uint16_t const hid_report_descriptor_len;
 
 } // namespace hidpg
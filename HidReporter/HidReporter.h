@@ -24,23 +24,148 @@
 
 #pragma once
 
+#include "HidReporter_config.h"
+#include "etl/span.h"
 #include <stdint.h>
+#include <string.h>
+
+#define HID_REPORTER_NKRO_KEY_BITMAP_SIZE (HID_REPORTER_NKRO_KEY_COUNT / 8)
+
+#if HID_REPORTER_ENABLE_HIGH_RESOLUTION_WHEEL
+#define HID_REPORTER_WHEEL_UNITS_PER_DETENT HID_REPORTER_WHEEL_RESOLUTION_MULTIPLIER
+#else
+#define HID_REPORTER_WHEEL_UNITS_PER_DETENT 1
+#endif
 
 namespace hidpg
 {
+  static_assert(HID_REPORTER_NKRO_KEY_COUNT % 8 == 0 && HID_REPORTER_NKRO_KEY_COUNT <= 232, "HID_REPORTER_NKRO_KEY_COUNT must be a multiple of 8 and at most 232");
+  static_assert(HID_REPORTER_WHEEL_RESOLUTION_MULTIPLIER >= 2 && HID_REPORTER_WHEEL_RESOLUTION_MULTIPLIER <= 15, "HID_REPORTER_WHEEL_RESOLUTION_MULTIPLIER must be between 2 and 15");
 
   class HidReporter
   {
   public:
     using kbd_led_cb_t = void (*)(uint8_t leds_bitmap);
 
+    // submitでまとめて送るためのレポート
+    struct Report
+    {
+      enum class Type : uint8_t
+      {
+        Keyboard,
+        Consumer,
+        Mouse,
+        RadialController,
+        SystemControl,
+      };
+
+      Type type;
+      union
+      {
+        struct
+        {
+          uint8_t modifiers;
+          uint8_t key_codes[6]; // 6KROとBoot Mode用
+#if HID_REPORTER_ENABLE_NKRO
+          uint8_t key_bitmap[HID_REPORTER_NKRO_KEY_BITMAP_SIZE]; // NKRO用、キーコードのビットが1
+#endif
+        } keyboard;
+        struct
+        {
+          uint16_t usage_code;
+        } consumer;
+        struct
+        {
+          uint8_t buttons;
+          int16_t x;
+          int16_t y;
+          // 1ノッチ = HID_REPORTER_WHEEL_UNITS_PER_DETENTの単位
+          int16_t wheel;
+          int16_t horiz;
+        } mouse;
+        struct
+        {
+          bool button;
+          int16_t dial;
+        } radial_controller;
+        struct
+        {
+          uint8_t usage_code;
+        } system_control;
+      };
+    };
+
     virtual bool keyboardReport(uint8_t modifiers, uint8_t key_codes[6]) = 0;
     virtual bool consumerReport(uint16_t usage_code) = 0;
+    // wheel,horizはノッチ単位
     virtual bool mouseReport(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t horiz) = 0;
     virtual bool radialControllerReport(bool button, int16_t dial) = 0;
     virtual bool systemControlReport(uint8_t usage_code) = 0;
     virtual bool waitReady() = 0;
     virtual void setKeyboardLedCallback(kbd_led_cb_t cb) = 0;
+
+    // 複数のレポートを順番に送る
+    // 送信可能かどうかのチェックを1回で済ませたい場合はオーバーライドする
+    virtual bool submit(etl::span<Report> reports)
+    {
+      bool result = true;
+      for (Report &report : reports)
+      {
+        result &= submitOne(report);
+      }
+      return result;
+    }
+
+    // キーボードのレポートを作る、NKROではkey_codesからビットマップも作る
+    static Report makeKeyboardReport(uint8_t modifiers, const uint8_t key_codes[6])
+    {
+      Report report{.type = Report::Type::Keyboard};
+      report.keyboard.modifiers = modifiers;
+      memcpy(report.keyboard.key_codes, key_codes, sizeof(report.keyboard.key_codes));
+#if HID_REPORTER_ENABLE_NKRO
+      memset(report.keyboard.key_bitmap, 0, sizeof(report.keyboard.key_bitmap));
+      for (int i = 0; i < 6; i++)
+      {
+        if (key_codes[i] != 0 && key_codes[i] < HID_REPORTER_NKRO_KEY_COUNT)
+        {
+          report.keyboard.key_bitmap[key_codes[i] / 8] |= 1 << (key_codes[i] % 8);
+        }
+      }
+#endif
+      return report;
+    }
+
+    // マウスのレポートを作る、wheel,horizはノッチ単位
+    static Report makeMouseReport(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t horiz)
+    {
+      Report report{.type = Report::Type::Mouse};
+      report.mouse.buttons = buttons;
+      report.mouse.x = x;
+      report.mouse.y = y;
+      report.mouse.wheel = wheel * HID_REPORTER_WHEEL_UNITS_PER_DETENT;
+      report.mouse.horiz = horiz * HID_REPORTER_WHEEL_UNITS_PER_DETENT;
+      return report;
+    }
+
+  protected:
+    bool submitOne(Report &report)
+    {
+      switch (report.type)
+      {
+      case Report::Type::Keyboard:
+        return keyboardReport(report.keyboard.modifiers, report.keyboard.key_codes);
+      case Report::Type::Consumer:
+        return consumerReport(report.consumer.usage_code);
+      case Report::Type::Mouse:
+        return mouseReport(report.mouse.buttons, report.mouse.x, report.mouse.y,
+                           report.mouse.wheel / HID_REPORTER_WHEEL_UNITS_PER_DETENT, report.mouse.horiz / HID_REPORTER_WHEEL_UNITS_PER_DETENT);
+      case Report::Type::RadialController:
+        return radialControllerReport(report.radial_controller.button, report.radial_controller.dial);
+      case Report::Type::SystemControl:
+        return systemControlReport(report.system_control.usage_code);
+      }
+      return false;
+    }
   };
 
 } // namespace hidpg
@@ -0,0 +1,73 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+// マウスレポートのX,Yのビット数 (8, 12, 16)
+// 低CPIのデバイスなら小さくすることでレポートのサイズを減らせる
+// 範囲外の移動量は複数のレポートに分割して送られる
+#ifndef HID_REPORTER_MOUSE_XY_BITS
+#define HID_REPORTER_MOUSE_XY_BITS 16
+#endif
+
+// Report Descriptorに含めるレポート
+// Keyboard,Mouseは常に含まれる
+#ifndef HID_REPORTER_ENABLE_CONSUMER_CONTROL
+#define HID_REPORTER_ENABLE_CONSUMER_CONTROL true
+#endif
+
+#ifndef HID_REPORTER_ENABLE_RADIAL_CONTROLLER
+#define HID_REPORTER_ENABLE_RADIAL_CONTROLLER true
+#endif
+
+#ifndef HID_REPORTER_ENABLE_SYSTEM_CONTROL
+#define HID_REPORTER_ENABLE_SYSTEM_CONTROL true
+#endif
+
+// キーボードをNKRO(キー毎に1bitのビットマップ)にする
+// 6キーの配列の代わりにHID_REPORTER_NKRO_KEY_COUNT個のキーを同時に送れる
+// BLEのBoot Modeでは従来通り6キーの配列で送られる
+#ifndef HID_REPORTER_ENABLE_NKRO
+#define HID_REPORTER_ENABLE_NKRO false
+#endif
+
+// NKROのビットマップに含めるキーコード(0 ~ HID_REPORTER_NKRO_KEY_COUNT - 1)、8の倍数
+// デフォルトはLANG8(0x97)まで、modifierと合わせてBLEのデフォルトのMTUに収まる20byteになる
+// これ以上のキーコードはNKROのレポートでは送られない
+#ifndef HID_REPORTER_NKRO_KEY_COUNT
+#define HID_REPORTER_NKRO_KEY_COUNT 152
+#endif
+
+// 高解像度ホイール(Resolution Multiplier)を有効にする
+// ホストがFeatureレポートで有効にすると、1ノッチをHID_REPORTER_WHEEL_RESOLUTION_MULTIPLIERに分割して送る
+// 有効にされていなければ端数を持ち越してノッチ単位で送る
+// BLEHidGenericはFeatureレポートに対応していないので、BLEでは常にノッチ単位になる
+#ifndef HID_REPORTER_ENABLE_HIGH_RESOLUTION_WHEEL
+#define HID_REPORTER_ENABLE_HIGH_RESOLUTION_WHEEL false
+#endif
+
+// 1ノッチあたりの高解像度ホイールの単位数 (2 ~ 15)
+#ifndef HID_REPORTER_WHEEL_RESOLUTION_MULTIPLIER
+#define HID_REPORTER_WHEEL_RESOLUTION_MULTIPLIER 8
+#endif
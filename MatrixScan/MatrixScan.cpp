@@ -25,6 +25,10 @@
 #include "MatrixScan.h"
 #include "SenseInterrupt.h"
 
+#ifdef ARDUINO_ARCH_NRF52
+#include "nrf_gpio.h"
+#endif
+
 #define pdMS_TO_TICKS_DOUBLE(xTimeInMs) ((double)(((double)(xTimeInMs) * (double)configTICK_RATE_HZ) / (double)1000))
 
 namespace hidpg
@@ -33,13 +37,30 @@ namespace hidpg
   {
 
     MatrixScanClass::callback_t MatrixScanClass::_callback = nullptr;
-    uint16_t MatrixScanClass::_polling_interval_ms = 0;
-    uint16_t MatrixScanClass::_max_polling_count = 0;
-    Switch **MatrixScanClass::_matrix = nullptr;
+    TickType_t MatrixScanClass::_polling_interval_ticks = 1;
+    ScanRateProfile MatrixScanClass::_profile = {MATRIX_SCAN_DECAY_POLLING_INTERVAL_MS, MATRIX_SCAN_DECAY_DURATION_MS};
+    uint16_t MatrixScanClass::_max_debounce_delay_ms = 0;
+    const Switch *MatrixScanClass::_switches = nullptr;
     const uint8_t *MatrixScanClass::_in_pins = nullptr;
     const uint8_t *MatrixScanClass::_out_pins = nullptr;
     uint8_t MatrixScanClass::_in_pins_len = 0;
     uint8_t MatrixScanClass::_out_pins_len = 0;
+    VerticalCounter *MatrixScanClass::_rows = nullptr;
+    uint32_t *MatrixScanClass::_row_masks = nullptr;
+    MatrixScanClass::PinInfo *MatrixScanClass::_in_pin_info = nullptr;
+    MatrixScanClass::PinInfo *MatrixScanClass::_out_pin_info = nullptr;
+#ifdef ARDUINO_ARCH_NRF52
+    NRF_GPIO_Type *MatrixScanClass::_in_ports[MAX_PORT_COUNT] = {};
+    uint32_t MatrixScanClass::_in_port_masks[MAX_PORT_COUNT] = {};
+    uint8_t MatrixScanClass::_in_ports_len = 0;
+#endif
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+    ScanStats MatrixScanClass::_stats;
+    volatile uint32_t MatrixScanClass::_interrupt_time_us = 0;
+    volatile bool MatrixScanClass::_has_interrupt_time = false;
+    uint32_t MatrixScanClass::_stats_window_start_ms = 0;
+    uint32_t MatrixScanClass::_stats_window_wakeups = 0;
+#endif
 
     TaskHandle_t MatrixScanClass::_task_handle = nullptr;
     StackType_t MatrixScanClass::_task_stack[MATRIX_SCAN_TASK_STACK_SIZE];
@@ -50,6 +71,28 @@ namespace hidpg
       _callback = callback;
     }
 
+    void MatrixScanClass::setScanRateProfile(const ScanRateProfile &profile)
+    {
+      _profile = profile;
+    }
+
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+    // 計測中のタスクに書き換えられないようにスケジューラを止めてコピーする
+    void MatrixScanClass::getScanStats(ScanStats &stats)
+    {
+      vTaskSuspendAll();
+      stats = _stats;
+      xTaskResumeAll();
+    }
+
+    void MatrixScanClass::resetScanStats()
+    {
+      vTaskSuspendAll();
+      _stats = ScanStats();
+      xTaskResumeAll();
+    }
+#endif
+
 #ifdef ARDUINO_ARCH_NRF52
     void MatrixScanClass::stop_and_setWakeUpInterrupt()
     {
@@ -107,42 +150,103 @@ namespace hidpg
       attachSenseInterrupt(interrupt_callback);
 #endif
 
-      uint16_t max_debounce_delay_ms = 0;
-      uint16_t min_debounce_delay_ms = UINT16_MAX;
+      // ピンのレジスタを求めておく
+#ifdef ARDUINO_ARCH_NRF52
+      _in_ports_len = 0;
+      for (int i = 0; i < _in_pins_len; i++)
+      {
+        uint32_t pin = g_ADigitalPinMap[_in_pins[i]];
+        NRF_GPIO_Type *port = nrf_gpio_pin_port_decode(&pin);
+
+        uint8_t port_index = 0;
+        while (port_index < _in_ports_len && _in_ports[port_index] != port)
+        {
+          port_index++;
+        }
+        if (port_index == _in_ports_len)
+        {
+          _in_ports[_in_ports_len] = port;
+          _in_port_masks[_in_ports_len] = 0;
+          _in_ports_len++;
+        }
+        _in_port_masks[port_index] |= 1UL << pin;
+
+        _in_pin_info[i] = {port, 1u << pin, port_index, static_cast<uint8_t>(pin)};
+      }
+      for (int i = 0; i < _out_pins_len; i++)
+      {
+        uint32_t pin = g_ADigitalPinMap[_out_pins[i]];
+        NRF_GPIO_Type *port = nrf_gpio_pin_port_decode(&pin);
+        _out_pin_info[i] = {port, 1u << pin, 0, static_cast<uint8_t>(pin)};
+      }
+#else
+      for (int i = 0; i < _in_pins_len; i++)
+      {
+        _in_pin_info[i].pin = _in_pins[i];
+      }
+      for (int i = 0; i < _out_pins_len; i++)
+      {
+        _out_pin_info[i].pin = _out_pins[i];
+      }
+#endif
+
+      _max_debounce_delay_ms = 0;
+      for (int i = 0; i < _out_pins_len * _in_pins_len; i++)
+      {
+        const Switch &sw = _switches[i];
+        if (sw.isValid())
+        {
+          _max_debounce_delay_ms = max(_max_debounce_delay_ms, max(sw.getPressDebounceDelay(), sw.getReleaseDebounceDelay()));
+        }
+      }
+
+      // デバウンスはポーリング毎のサンプルを数えて行うので、debounce_delayの最大値がサンプル数の上限に収まる間隔にする
+      _polling_interval_ticks = max(pdMS_TO_TICKS(MATRIX_SCAN_POLLING_INTERVAL_MS), (TickType_t)1);
+      _polling_interval_ticks = max(_polling_interval_ticks, (TickType_t)ceil(pdMS_TO_TICKS_DOUBLE(_max_debounce_delay_ms) / VerticalCounter::MAX_THRESHOLD));
 
-      // スイッチオブジェクトの初期化
+      // スイッチが存在するセルのマスクを作り、スイッチ毎の閾値を設定する
       for (int oi = 0; oi < _out_pins_len; oi++)
       {
+        _row_masks[oi] = 0;
         for (int ii = 0; ii < _in_pins_len; ii++)
         {
-          int idx = oi * _in_pins_len + ii;
-          if (_matrix[idx] == nullptr)
+          const Switch &sw = _switches[oi * _in_pins_len + ii];
+          if (sw.isValid() == false)
           {
             continue;
           }
-          _matrix[idx]->attach(_in_pins[ii]);
-          uint16_t d = _matrix[idx]->getDebounceDelay();
-          max_debounce_delay_ms = max(d, max_debounce_delay_ms);
-          min_debounce_delay_ms = min(d, min_debounce_delay_ms);
+          _row_masks[oi] |= 1UL << ii;
+          _rows[oi].configure(ii,
+                              debounceDelayToSamples(sw.getPressDebounceDelay()),
+                              debounceDelayToSamples(sw.getReleaseDebounceDelay()),
+                              sw.getDebounceMode() == DebounceMode::Eager);
         }
       }
-      // debounce_delayの最小値の間隔でポーリングする
-      _polling_interval_ms = min_debounce_delay_ms;
-
-      // _polling_interval_ms * _max_polling_countは最低でもdebounce_delayの最大値を超える値に設定
-      // delay関数で切り捨てられるtick回数も考慮して計算
-      _max_polling_count = ceil(pdMS_TO_TICKS_DOUBLE(max_debounce_delay_ms) / pdMS_TO_TICKS(_polling_interval_ms)) + 3;
 
       _task_handle = xTaskCreateStatic(task, "MatrixScan", MATRIX_SCAN_TASK_STACK_SIZE, nullptr, MATRIX_SCAN_TASK_PRIO, _task_stack, &_task_tcb);
     }
 
+    // debounce_delayをポーリングのサンプル数に変換する
+    uint8_t MatrixScanClass::debounceDelayToSamples(uint16_t debounce_delay_ms)
+    {
+      uint32_t samples = ceil(pdMS_TO_TICKS_DOUBLE(debounce_delay_ms) / _polling_interval_ticks);
+      return constrain(samples, 1, VerticalCounter::MAX_THRESHOLD);
+    }
+
     // 起きる
     void MatrixScanClass::interrupt_callback()
     {
       if (_task_handle != nullptr)
       {
-        // 通知値を_max_polling_countに設定して通知
-        xTaskNotifyFromISR(_task_handle, _max_polling_count, eSetValueWithOverwrite, nullptr);
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+        // 寝ている間の最初の割り込みの時刻
+        if (_has_interrupt_time == false)
+        {
+          _interrupt_time_us = micros();
+          _has_interrupt_time = true;
+        }
+#endif
+        vTaskNotifyGiveFromISR(_task_handle, nullptr);
       }
     }
 
@@ -151,22 +255,198 @@ namespace hidpg
     {
       for (int i = 0; i < _out_pins_len; i++)
       {
-        digitalWrite(_out_pins[i], val);
+        outPinWrite(_out_pin_info[i], val);
+      }
+    }
+
+    void MatrixScanClass::outPinWrite(const PinInfo &pin_info, int val)
+    {
+#ifdef ARDUINO_ARCH_NRF52
+      if (val)
+      {
+        pin_info.port->OUTSET = pin_info.mask;
+      }
+      else
+      {
+        pin_info.port->OUTCLR = pin_info.mask;
+      }
+#else
+      digitalWrite(pin_info.pin, val);
+#endif
+    }
+
+    // 現在アクティブな行の入力を読んで、押されているスイッチのビットを1にして返す
+    uint32_t MatrixScanClass::readRow()
+    {
+      uint32_t row = 0;
+
+#ifdef ARDUINO_ARCH_NRF52
+      // ポート毎にINレジスタを1回だけ読む
+      uint32_t port_values[MAX_PORT_COUNT];
+      for (int i = 0; i < _in_ports_len; i++)
+      {
+        port_values[i] = _in_ports[i]->IN;
+      }
+      for (int i = 0; i < _in_pins_len; i++)
+      {
+        const PinInfo &info = _in_pin_info[i];
+        row |= ((port_values[info.port_index] >> info.bit) & 1UL) << i;
+      }
+#else
+      for (int i = 0; i < _in_pins_len; i++)
+      {
+        row |= static_cast<uint32_t>(digitalRead(_in_pin_info[i].pin) == HIGH) << i;
+      }
+#endif
+
+#if (MATRIX_SCAN_ACTIVE_STATE == LOW)
+      row = ~row;
+#endif
+      return row;
+    }
+
+    // 1行分スキャンしてデバウンスし、確定状態が変化したスイッチだけIDを更新する
+    void MatrixScanClass::scanRow(int oi, Set &ids)
+    {
+      outPinWrite(_out_pin_info[oi], MATRIX_SCAN_ACTIVE_STATE);
+#if (MATRIX_SCAN_SELECT_DELAY_US > 0)
+      delayMicroseconds(MATRIX_SCAN_SELECT_DELAY_US);
+#endif
+      uint32_t row = readRow() & _row_masks[oi];
+      outPinWrite(_out_pin_info[oi], !MATRIX_SCAN_ACTIVE_STATE);
+
+      uint32_t changed = _rows[oi].update(row);
+      while (changed != 0)
+      {
+        int ii = __builtin_ctz(changed);
+        changed &= changed - 1;
+
+        key_id_t id = _switches[oi * _in_pins_len + ii].getId();
+        if (bitRead(_rows[oi].state(), ii))
+        {
+          ids.add(id);
+        }
+        else
+        {
+          ids.remove(id);
+        }
+      }
+    }
+
+    // 押されている、またはデバウンス中のスイッチがある行か
+    bool MatrixScanClass::isRowBusy(int oi)
+    {
+      return (_rows[oi].state() | _rows[oi].pending()) != 0;
+    }
+
+#if (MATRIX_SCAN_USE_SENSE_INTERRUPT == true)
+    uint32_t MatrixScanClass::readInLatch()
+    {
+      uint32_t latch = 0;
+      for (int i = 0; i < _in_ports_len; i++)
+      {
+        latch |= readLatch(_in_ports[i]) & _in_port_masks[i];
       }
+      return latch;
     }
 
-    bool MatrixScanClass::needsKeyScan()
+    void MatrixScanClass::clearInLatch()
     {
-      // - 消費電流を減らすため常にスキャンをせずに割り込みが発生したら起きて一定時間スキャン（ポーリング）をする
-      // - FreeRTOSのtask通知を利用して残りのポーリング回数を設定する
-      // - キー押し時はスキャン中に入力ピンの電圧が変わるので押されてる限り割り込みが発生し続ける
-      // - 割り込みが発生し続けてる間（キーが押され続けている間）はtaskの通知値は_max_polling_countに設定され続ける
-      // - キーが離されたら割り込みが発生しなくなりそこから_max_polling_count回ポーリングされ0になったらスキャンを終了
-      if (ulTaskNotifyTake(pdFALSE, 0) > 0)
+      for (int i = 0; i < _in_ports_len; i++)
+      {
+        clearLatch(_in_ports[i], _in_port_masks[i]);
+      }
+    }
+#endif
+
+    // スキャン間隔が変わっても、スイッチが全て離されてから止めるまでの時間は変わらない
+    TickType_t MatrixScanClass::decayDurationTicks()
+    {
+      if (_profile.decay_duration_ms == 0)
+      {
+        return ceil(pdMS_TO_TICKS_DOUBLE(_max_debounce_delay_ms)) + _polling_interval_ticks * 3;
+      }
+      return pdMS_TO_TICKS(_profile.decay_duration_ms);
+    }
+
+    void MatrixScanClass::countWakeup()
+    {
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+      _stats.wakeups++;
+
+      uint32_t now_ms = millis();
+      if (now_ms - _stats_window_start_ms >= 1000)
+      {
+        if (_stats_window_wakeups > 0)
+        {
+          _stats.wakeups_per_second.add(_stats_window_wakeups);
+        }
+        _stats_window_start_ms = now_ms;
+        _stats_window_wakeups = 0;
+      }
+      _stats_window_wakeups++;
+#endif
+    }
+
+    // 全行(またはbusyな行)をスキャンする
+    // 戻り値は押されている、またはデバウンス中のスイッチがあるか
+    bool MatrixScanClass::scan(Set &ids)
+    {
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+      uint32_t start_us = micros();
+      if (_has_interrupt_time)
+      {
+        _stats.wakeup_latency_us.add(start_us - _interrupt_time_us);
+        _has_interrupt_time = false;
+      }
+#endif
+
+      // これから読むので、ここまでに発生した割り込みの通知は捨てる
+      ulTaskNotifyTake(pdTRUE, 0);
+
+#if (MATRIX_SCAN_USE_SENSE_INTERRUPT == true)
+      // - スキャンしていない間、busyな行は非アクティブ、それ以外の行はアクティブにしておく
+      // - 入力ピンのラッチがセットされていたらbusyでない行で新しくスイッチが押されたので全行スキャンする
+      // - セットされていなければbusyな行だけスキャンする
+      // - スイッチの数が多くても押されている行の分のコストしかかからない
+      bool scan_all_rows = (readInLatch() != 0);
+#else
+      bool scan_all_rows = true;
+#endif
+
+      outPinsSet(!MATRIX_SCAN_ACTIVE_STATE);
+      bool is_busy = false;
+      for (int oi = 0; oi < _out_pins_len; oi++)
+      {
+        if (scan_all_rows || isRowBusy(oi))
+        {
+          scanRow(oi, ids);
+        }
+        is_busy |= isRowBusy(oi);
+      }
+
+#if (MATRIX_SCAN_USE_SENSE_INTERRUPT == true)
+      // 割り込みのためにスキャンが終わったらbusyでない行の出力をアクティブ側に設定
+      for (int oi = 0; oi < _out_pins_len; oi++)
       {
-        return true;
+        outPinWrite(_out_pin_info[oi], isRowBusy(oi) ? !MATRIX_SCAN_ACTIVE_STATE : MATRIX_SCAN_ACTIVE_STATE);
       }
-      return false;
+#if (MATRIX_SCAN_SELECT_DELAY_US > 0)
+      delayMicroseconds(MATRIX_SCAN_SELECT_DELAY_US);
+#endif
+      // スキャン中にセットされたラッチをクリア
+      clearInLatch();
+#else
+      // 割り込みのためにスキャンが終わったら出力をアクティブ側に設定
+      outPinsSet(MATRIX_SCAN_ACTIVE_STATE);
+#endif
+
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+      _stats.scan_duration_us.add(micros() - start_us);
+      _stats.scans++;
+#endif
+
+      return is_busy;
     }
 
     void MatrixScanClass::task(void *pvParameters)
@@ -175,26 +455,22 @@ namespace hidpg
 
       while (true)
       {
-        if (needsKeyScan())
+        // 割り込みが発生するまで寝る
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+        _has_interrupt_time = false;
+#endif
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        countWakeup();
+
+        TickType_t last_wake_time = xTaskGetTickCount();
+        TickType_t last_active_time = last_wake_time;
+
+        // - 消費電流を減らすため常にスキャンをせずに割り込みが発生したら起きてスキャンする
+        // - 押されている、またはデバウンス中のスイッチがある間は割り込みに関係なく速い間隔でスキャンを続ける
+        // - 全て離されてからdecayの間は遅い間隔でスキャンする、この間も割り込みが発生したらすぐに起きる
+        while (true)
         {
-          // スキャン
-          outPinsSet(!MATRIX_SCAN_ACTIVE_STATE);
-          for (int oi = 0; oi < _out_pins_len; oi++)
-          {
-            digitalWrite(_out_pins[oi], MATRIX_SCAN_ACTIVE_STATE);
-            for (int ii = 0; ii < _in_pins_len; ii++)
-            {
-              int idx = oi * _in_pins_len + ii;
-              if (_matrix[idx] == nullptr)
-              {
-                continue;
-              }
-              _matrix[idx]->updateState(ids);
-            }
-            digitalWrite(_out_pins[oi], !MATRIX_SCAN_ACTIVE_STATE);
-          }
-          // 割り込みのためにスキャンが終わったら出力をアクティブ側に設定
-          outPinsSet(MATRIX_SCAN_ACTIVE_STATE);
+          bool is_busy = scan(ids);
 
           // 更新してたらコールバック関数を発火
           if (ids != prev_ids)
@@ -205,12 +481,28 @@ namespace hidpg
             }
             prev_ids = ids;
           }
-          delay(_polling_interval_ms);
-        }
-        else
-        {
-          // 割り込みが発生するまで寝る
-          ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+          TickType_t now = xTaskGetTickCount();
+          if (is_busy)
+          {
+            last_active_time = now;
+            // スキャンにかかった時間に関係なく一定間隔でサンプリングする
+            vTaskDelayUntil(&last_wake_time, _polling_interval_ticks);
+          }
+          else if (now - last_active_time < decayDurationTicks())
+          {
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+            _has_interrupt_time = false;
+#endif
+            TickType_t decay_polling_interval_ticks = max(pdMS_TO_TICKS(_profile.decay_polling_interval_ms), _polling_interval_ticks);
+            ulTaskNotifyTake(pdTRUE, decay_polling_interval_ticks);
+            last_wake_time = xTaskGetTickCount();
+          }
+          else
+          {
+            break;
+          }
+          countWakeup();
         }
       }
     }
@@ -24,13 +24,25 @@
 
 #pragma once
 
+#include "Arduino.h"
 #include "FreeRTOS.h"
+#include "ScanHistogram.h"
 #include "Set.h"
 #include "Switch.h"
+#include "VerticalCounter.h"
 #include "task.h"
 
 namespace hidpg
 {
+
+  // スイッチが全て離されてからスキャンを止めるまでのスキャンの間隔と時間
+  struct ScanRateProfile
+  {
+    uint16_t decay_polling_interval_ms;
+    // 0の場合はデバウンス時間の最大値にMATRIX_SCAN_POLLING_INTERVAL_MSの3回分を足した時間
+    uint16_t decay_duration_ms;
+  };
+
   namespace Internal
   {
 
@@ -39,36 +51,118 @@ namespace hidpg
     public:
       using callback_t = void (*)(const Set &switch_ids);
 
+      // 連続したSwitchのテーブルをそのまま使う、constexprで定義すればフラッシュに置かれる
+      // IDの重複をコンパイル時にチェックする場合はMATRIX_SCAN_SET_MATRIXを使う
       template <uint8_t out_pins_len, uint8_t in_pins_len>
-      static void setMatrix(Switch *matrix[out_pins_len][in_pins_len], const uint8_t (&out_pins)[out_pins_len], const uint8_t (&in_pins)[in_pins_len])
+      static void setMatrix(const Switch (&matrix)[out_pins_len][in_pins_len], const uint8_t (&out_pins)[out_pins_len], const uint8_t (&in_pins)[in_pins_len])
       {
+        // 1行分の入力を32bitのワードで扱う
+        static_assert(in_pins_len <= 32, "in_pins_len must be 32 or less");
+
+        static VerticalCounter rows[out_pins_len];
+        static uint32_t row_masks[out_pins_len];
+        static PinInfo in_pin_info[in_pins_len];
+        static PinInfo out_pin_info[out_pins_len];
+
         _in_pins_len = in_pins_len;
         _out_pins_len = out_pins_len;
         _in_pins = in_pins;
         _out_pins = out_pins;
-        _matrix = reinterpret_cast<Switch **>(matrix);
+        _switches = &matrix[0][0];
+        _rows = rows;
+        _row_masks = row_masks;
+        _in_pin_info = in_pin_info;
+        _out_pin_info = out_pin_info;
+      }
+
+      // SW()で作ったスイッチのポインタの行列、nullptrはスイッチが無い場所
+      // 連続したテーブルにコピーして使う
+      template <uint8_t out_pins_len, uint8_t in_pins_len>
+      static void setMatrix(Switch *matrix[out_pins_len][in_pins_len], const uint8_t (&out_pins)[out_pins_len], const uint8_t (&in_pins)[in_pins_len])
+      {
+        static Switch table[out_pins_len][in_pins_len];
+
+        for (int oi = 0; oi < out_pins_len; oi++)
+        {
+          for (int ii = 0; ii < in_pins_len; ii++)
+          {
+            table[oi][ii] = (matrix[oi][ii] != nullptr) ? *matrix[oi][ii] : NO_SW;
+          }
+        }
+        setMatrix(table, out_pins, in_pins);
       }
+
       static void start();
       static void setCallback(callback_t callback);
+      static void setScanRateProfile(const ScanRateProfile &profile);
+
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+      static void getScanStats(ScanStats &stats);
+      static void resetScanStats();
+#endif
 
 #ifdef ARDUINO_ARCH_NRF52
       static void stop_and_setWakeUpInterrupt();
 #endif
 
     private:
+#ifdef ARDUINO_ARCH_NRF52
+      // ピンのポートとビット位置、digitalRead/digitalWriteを使わずにレジスタを直接読み書きする
+      struct PinInfo
+      {
+        NRF_GPIO_Type *port;
+        uint32_t mask;
+        uint8_t port_index;
+        uint8_t bit;
+      };
+      static constexpr uint8_t MAX_PORT_COUNT = 2;
+      static NRF_GPIO_Type *_in_ports[MAX_PORT_COUNT];
+      static uint32_t _in_port_masks[MAX_PORT_COUNT];
+      static uint8_t _in_ports_len;
+#else
+      struct PinInfo
+      {
+        uint8_t pin;
+      };
+#endif
+
       static void interrupt_callback();
       static void outPinsSet(int val);
-      static bool needsKeyScan();
+      static void outPinWrite(const PinInfo &pin_info, int val);
+      static uint32_t readRow();
+      static uint8_t debounceDelayToSamples(uint16_t debounce_delay_ms);
+      static void scanRow(int oi, Set &ids);
+      static bool isRowBusy(int oi);
+#if (MATRIX_SCAN_USE_SENSE_INTERRUPT == true)
+      static uint32_t readInLatch();
+      static void clearInLatch();
+#endif
+      static bool scan(Set &ids);
+      static TickType_t decayDurationTicks();
+      static void countWakeup();
       static void task(void *pvParameters);
 
       static callback_t _callback;
-      static uint16_t _polling_interval_ms;
-      static uint16_t _max_polling_count;
-      static Switch **_matrix;
+      static TickType_t _polling_interval_ticks;
+      static ScanRateProfile _profile;
+      static uint16_t _max_debounce_delay_ms;
+      static const Switch *_switches;
       static const uint8_t *_in_pins;
       static const uint8_t *_out_pins;
       static uint8_t _in_pins_len;
       static uint8_t _out_pins_len;
+      static VerticalCounter *_rows;
+      static uint32_t *_row_masks;
+      static PinInfo *_in_pin_info;
+      static PinInfo *_out_pin_info;
+
+#if (MATRIX_SCAN_ENABLE_STATS == true)
+      static ScanStats _stats;
+      static volatile uint32_t _interrupt_time_us;
+      static volatile bool _has_interrupt_time;
+      static uint32_t _stats_window_start_ms;
+      static uint32_t _stats_window_wakeups;
+#endif
 
       static TaskHandle_t _task_handle;
       static StackType_t _task_stack[];
@@ -79,4 +173,19 @@ namespace hidpg
 
   extern Internal::MatrixScanClass MatrixScan;
 
+// constexprな行列をIDの重複をコンパイル時にチェックしてからセットする
+//
+// 使用例
+//   constexpr Switch matrix[2][3] = {
+//       {Switch(0), Switch(1), NO_SW},
+//       {Switch(2), Switch(3, 2, 8, DebounceMode::Eager), Switch(4)},
+//   };
+//   MATRIX_SCAN_SET_MATRIX(matrix, out_pins, in_pins);
+#define MATRIX_SCAN_SET_MATRIX(matrix, out_pins, in_pins)                                                  \
+  do                                                                                                      \
+  {                                                                                                       \
+    static_assert(hidpg::Internal::hasUniqueSwitchIds(matrix), "Switch ids in the matrix must be unique"); \
+    hidpg::MatrixScan.setMatrix(matrix, out_pins, in_pins);                                                \
+  } while (0)
+
 } // namespace hidpg
@@ -29,6 +29,44 @@
 #define MATRIX_SCAN_DEBOUNCE_DELAY_MS 6
 #endif
 
+// SWでモードを指定しなかった場合のデバウンス方式
+// DebounceMode::Eagerにすると押下が即座に報告されるのでレイテンシが減る
+#ifndef MATRIX_SCAN_DEBOUNCE_MODE
+#define MATRIX_SCAN_DEBOUNCE_MODE DebounceMode::Defer
+#endif
+
+// スキャンの間隔、デバウンス時間とは独立している
+// デバウンスはこの間隔で取ったサンプルを数えて行う(最大15サンプル)
+// debounce_delayがこの15倍を超える場合は間隔を広げる
+// RTOSのtick単位に切り上げられるので、1kHzより速くスキャンするにはconfigTICK_RATE_HZも上げる必要がある
+#ifndef MATRIX_SCAN_POLLING_INTERVAL_MS
+#define MATRIX_SCAN_POLLING_INTERVAL_MS 1
+#endif
+
+// スイッチが全て離されてから、スキャンを止めるまでのスキャンの間隔
+// この間は割り込みでも起きるので、長くしても押下の検出は遅れない
+// setScanRateProfileで実行中に変更できる
+#ifndef MATRIX_SCAN_DECAY_POLLING_INTERVAL_MS
+#define MATRIX_SCAN_DECAY_POLLING_INTERVAL_MS MATRIX_SCAN_POLLING_INTERVAL_MS
+#endif
+
+// スイッチが全て離されてから、スキャンを止めるまでの時間
+// 0の場合はデバウンス時間の最大値にMATRIX_SCAN_POLLING_INTERVAL_MSの3回分を足した時間
+// setScanRateProfileで実行中に変更できる
+#ifndef MATRIX_SCAN_DECAY_DURATION_MS
+#define MATRIX_SCAN_DECAY_DURATION_MS 0
+#endif
+
+// スキャンにかかる時間などを計測するか、getScanStatsで取得できる
+#ifndef MATRIX_SCAN_ENABLE_STATS
+#define MATRIX_SCAN_ENABLE_STATS false
+#endif
+
+// 出力ピンをアクティブにしてから入力ピンを読むまでの待ち時間
+#ifndef MATRIX_SCAN_SELECT_DELAY_US
+#define MATRIX_SCAN_SELECT_DELAY_US 1
+#endif
+
 // スイッチがHIGHとLOWどちらでONになるか
 #ifndef MATRIX_SCAN_ACTIVE_STATE
 #define MATRIX_SCAN_ACTIVE_STATE LOW
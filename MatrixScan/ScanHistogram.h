@@ -0,0 +1,75 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // 2のべき乗の幅のビンで値の分布を数えるヒストグラム
+  // ビン0は0、ビンi(i >= 1)は 2^(i-1) <= 値 < 2^i、最後のビンはそれ以上の全ての値
+  class ScanHistogram
+  {
+  public:
+    static constexpr uint8_t BINS = 16;
+
+    ScanHistogram() : bins(), count(0), sum(0), min(UINT32_MAX), max(0) {}
+
+    void add(uint32_t value)
+    {
+      uint8_t bin = (value == 0) ? 0 : 32 - __builtin_clz(value);
+      if (bin >= BINS)
+      {
+        bin = BINS - 1;
+      }
+      bins[bin]++;
+      count++;
+      sum += value;
+      min = (value < min) ? value : min;
+      max = (value > max) ? value : max;
+    }
+
+    uint32_t bins[BINS];
+    uint32_t count;
+    uint64_t sum;
+    uint32_t min;
+    uint32_t max;
+  };
+
+  // MatrixScanの計測値
+  struct ScanStats
+  {
+    // 1回のスキャンにかかった時間(μs)
+    ScanHistogram scan_duration_us;
+    // 割り込みが発生してから最初のスキャンを始めるまでの時間(μs)
+    ScanHistogram wakeup_latency_us;
+    // 1秒毎のタスクが起きた回数、1回も起きなかった秒は数えない
+    ScanHistogram wakeups_per_second;
+    uint32_t wakeups;
+    uint32_t scans;
+  };
+
+} // namespace hidpg
@@ -85,6 +85,31 @@ namespace hidpg::Internal
     senseCallback = NULL;
   }
 
+  void clearLatch(uint32_t pin)
+  {
+    pin = g_ADigitalPinMap[pin];
+
+    nrf_gpio_pin_latch_clear(pin);
+  }
+
+  bool readLatch(uint32_t pin)
+  {
+    pin = g_ADigitalPinMap[pin];
+
+    return nrf_gpio_pin_latch_get(pin);
+  }
+
+  void clearLatch(NRF_GPIO_Type *port, uint32_t mask)
+  {
+    // 1を書き込んだビットがクリアされる
+    port->LATCH = mask;
+  }
+
+  uint32_t readLatch(NRF_GPIO_Type *port)
+  {
+    return port->LATCH;
+  }
+
   extern "C"
   {
     void SWI3_EGU3_IRQHandler()
@@ -24,42 +24,136 @@
 
 #pragma once
 
-#include "Bounce2.h"
 #include "MatrixScan_config.h"
 #include "Set.h"
 #include "consthash/cityhash64.hxx"
 #include "consthash/crc64.hxx"
 #include <new>
+#include <stddef.h>
+#include <stdint.h>
 
 namespace hidpg
 {
 
+  // デバウンスの方式
+  // Defer: 入力が debounce_delay の間安定してから押下/解放を確定する
+  // Eager: 最初のエッジで即座に押下/解放を確定し、その後 debounce_delay の間は変化を無視する
+  enum class DebounceMode : uint8_t
+  {
+    Defer,
+    Eager,
+  };
+
   // 物理的なスイッチ1個に対応するクラス
-  class Switch : Bounce
+  // デバウンスの状態はMatrixScanが行単位でまとめて持つので、ここではIDと設定だけを持つ
+  // constexprで作れるので、行列全体をconstexprな配列として定義すればフラッシュ上の連続したテーブルになる
+  class Switch
   {
   public:
-    using Bounce::attach;
+    // スイッチが無い場所
+    constexpr Switch()
+        : _id(0), _mode(DebounceMode::Defer), _is_valid(false), _press_debounce_delay_ms(0), _release_debounce_delay_ms(0)
+    {
+    }
 
-  public:
     // 論理的なIDをセットする
-    Switch(uint8_t id, uint16_t debounce_delay_ms);
-    // スキャン時に呼ばれる、押されてるかを自分でチェックして自分のIDをセットする
-    void updateState(Set &switch_ids);
+    constexpr Switch(key_id_t id,
+                     uint16_t debounce_delay_ms = MATRIX_SCAN_DEBOUNCE_DELAY_MS,
+                     DebounceMode mode = MATRIX_SCAN_DEBOUNCE_MODE)
+        : Switch(id, debounce_delay_ms, debounce_delay_ms, mode)
+    {
+    }
+
+    // 押下時と解放時で別々の時間を使う
+    constexpr Switch(key_id_t id, uint16_t press_debounce_delay_ms, uint16_t release_debounce_delay_ms, DebounceMode mode)
+        : _id(id), _mode(mode), _is_valid(true), _press_debounce_delay_ms(press_debounce_delay_ms), _release_debounce_delay_ms(release_debounce_delay_ms)
+    {
+    }
 
-    uint16_t getDebounceDelay() const;
+    constexpr key_id_t getId() const { return _id; }
+    constexpr uint16_t getPressDebounceDelay() const { return _press_debounce_delay_ms; }
+    constexpr uint16_t getReleaseDebounceDelay() const { return _release_debounce_delay_ms; }
+    constexpr DebounceMode getDebounceMode() const { return _mode; }
+    constexpr bool isValid() const { return _is_valid; }
 
   private:
-    const uint8_t _id;
+    key_id_t _id;
+    DebounceMode _mode;
+    bool _is_valid;
+    uint16_t _press_debounce_delay_ms;
+    uint16_t _release_debounce_delay_ms;
   };
 
+  // 行列のスイッチが無い場所
+  constexpr Switch NO_SW = Switch();
+
   namespace Internal
   {
 
-    template <uint64_t ID1, uint64_t ID2, uint64_t ID3>
-    Switch *new_Switch(uint8_t id, uint16_t debounce_delay_ms = MATRIX_SCAN_DEBOUNCE_DELAY_MS)
+    template <uint64_t ID1, uint64_t ID2, uint64_t ID3, typename... Args>
+    Switch *new_Switch(Args... args)
     {
       static uint8_t buf[sizeof(Switch)];
-      return new (buf) Switch(id, debounce_delay_ms);
+      return new (buf) Switch(args...);
+    }
+
+    // 行列内のIDの重複チェック、static_assertで使う
+    // gnu++11のconstexpr関数はreturn文1つだけなので再帰で書く
+    // IDを64個ずつの範囲(ワード)に分け、ワード毎に全スイッチのIDのビットを範囲を半分に分けながら重ねる
+    // 重ねる時に同じビットがあれば重複、再帰の深さはlog2(スイッチ数)なので64 x 32でも浅く、計算量はスイッチ数 x ワード数
+
+    struct SwitchIdWord
+    {
+      bool is_unique;
+      uint64_t bits;
+    };
+
+    constexpr uint64_t switchIdBit(const Switch &sw, size_t word)
+    {
+      return (sw.isValid() && sw.getId() / 64 == word) ? (1ULL << (sw.getId() % 64)) : 0;
+    }
+
+    constexpr SwitchIdWord uniteSwitchIdWords(const SwitchIdWord &a, const SwitchIdWord &b)
+    {
+      return SwitchIdWord{a.is_unique && b.is_unique && (a.bits & b.bits) == 0, a.bits | b.bits};
+    }
+
+    // [begin, end)のスイッチのIDのうちword番目の範囲のもの
+    template <size_t out_pins_len, size_t in_pins_len>
+    constexpr SwitchIdWord switchIdWord(const Switch (&matrix)[out_pins_len][in_pins_len], size_t begin, size_t end, size_t word)
+    {
+      return (end - begin == 1)
+                 ? SwitchIdWord{true, switchIdBit(matrix[begin / in_pins_len][begin % in_pins_len], word)}
+                 : uniteSwitchIdWords(switchIdWord(matrix, begin, begin + (end - begin) / 2, word),
+                                      switchIdWord(matrix, begin + (end - begin) / 2, end, word));
+    }
+
+    constexpr size_t maxOf(size_t a, size_t b)
+    {
+      return (a > b) ? a : b;
+    }
+
+    template <size_t out_pins_len, size_t in_pins_len>
+    constexpr size_t maxSwitchId(const Switch (&matrix)[out_pins_len][in_pins_len], size_t begin, size_t end)
+    {
+      return (end - begin == 1)
+                 ? (matrix[begin / in_pins_len][begin % in_pins_len].isValid() ? matrix[begin / in_pins_len][begin % in_pins_len].getId() : 0)
+                 : maxOf(maxSwitchId(matrix, begin, begin + (end - begin) / 2), maxSwitchId(matrix, begin + (end - begin) / 2, end));
+    }
+
+    template <size_t out_pins_len, size_t in_pins_len>
+    constexpr bool hasUniqueSwitchIds(const Switch (&matrix)[out_pins_len][in_pins_len], size_t word_begin, size_t word_end)
+    {
+      return (word_end - word_begin == 1)
+                 ? switchIdWord(matrix, 0, out_pins_len * in_pins_len, word_begin).is_unique
+                 : (hasUniqueSwitchIds(matrix, word_begin, word_begin + (word_end - word_begin) / 2) &&
+                    hasUniqueSwitchIds(matrix, word_begin + (word_end - word_begin) / 2, word_end));
+    }
+
+    template <size_t out_pins_len, size_t in_pins_len>
+    constexpr bool hasUniqueSwitchIds(const Switch (&matrix)[out_pins_len][in_pins_len])
+    {
+      return hasUniqueSwitchIds(matrix, 0, maxSwitchId(matrix, 0, out_pins_len * in_pins_len) / 64 + 1);
     }
 
   } // namespace Internal
@@ -46,27 +46,33 @@ namespace hidpg
   constexpr uint8_t Image_Threshold = 0x0D;
   constexpr uint8_t Image_Recognition = 0x0E;
 
+  // Motion_Statusのビット
+  constexpr uint8_t Motion = 0b10000000;
+  constexpr uint8_t DYOVF = 0b00010000;
+  constexpr uint8_t DXOVF = 0b00001000;
+
+  // Operation_Modeの初期値、Slp_enhとSlp2auが立っていてセンサーが自分でSleep1、Sleep2に入る
+  constexpr uint8_t Operation_Mode_Auto = 0b10111000;
+
+  // タスク通知のビット(MOTION_BITはPointingSensor)
+  constexpr uint32_t WAKE_UP_BIT = 0b10;
+
   //------------------------------------------------------------------+
   // static member
   //------------------------------------------------------------------+
-  TaskHandle_t PAW3204DB::_task_handles[2] = {nullptr, nullptr};
-  PAW3204DB *PAW3204DB::instances[2] = {nullptr, nullptr};
-
-  void PAW3204DB::interrupt_callback_0()
+#ifdef ARDUINO_ARCH_NRF52
+  NRF_SPI_Type *PAW3204DB::allocateSpi()
   {
-    if (_task_handles[0] != nullptr)
-    {
-      xTaskNotifyFromISR(_task_handles[0], 1, eSetValueWithOverwrite, nullptr);
-    }
-  }
+    static NRF_SPI_Type *const spis[] = {NRF_SPI2, NRF_SPI1};
+    static uint8_t allocated = 0;
 
-  void PAW3204DB::interrupt_callback_1()
-  {
-    if (_task_handles[1] != nullptr)
+    if (allocated < sizeof(spis) / sizeof(spis[0]))
     {
-      xTaskNotifyFromISR(_task_handles[1], 1, eSetValueWithOverwrite, nullptr);
+      return spis[allocated++];
     }
+    return nullptr;
   }
+#endif
 
   void PAW3204DB::task(void *pvParameters)
   {
@@ -78,10 +84,35 @@ namespace hidpg
 
     while (true)
     {
-      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-      if (that->_callback != nullptr)
+      xSemaphoreTake(that->_mutex, portMAX_DELAY);
+      uint32_t wait_ms = that->_auto_power ? that->_power.timeUntilRest(millis()) : UINT32_MAX;
+      xSemaphoreGive(that->_mutex);
+
+      uint32_t bits = 0;
+      xTaskNotifyWait(0, UINT32_MAX, &bits, (wait_ms == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms));
+
+      xSemaphoreTake(that->_mutex, portMAX_DELAY);
+      if (bits & WAKE_UP_BIT)
+      {
+        that->applyPowerAction(that->_power.onWakeUp(millis(), micros()));
+      }
+      if (bits & MOTION_BIT)
+      {
+        that->applyPowerAction(that->_power.onMotion(millis(), micros()));
+      }
+      if (bits == 0)
       {
-        that->_callback();
+        that->applyPowerAction(that->_power.onTimeout(millis()));
+      }
+      xSemaphoreGive(that->_mutex);
+
+      if (bits & MOTION_BIT)
+      {
+        if (that->_callback != nullptr)
+        {
+          that->_callback();
+        }
+        that->notifyMotion();
       }
     }
   }
@@ -90,7 +121,12 @@ namespace hidpg
   // instance member
   //------------------------------------------------------------------+
   PAW3204DB::PAW3204DB(PAW3204DB_RegOperator *reg, uint8_t motswk_pin, uint8_t id)
-      : _reg(reg), _motswk_pin(motswk_pin), _id(id), _callback(nullptr)
+      : PointingSensor(id), _reg(reg), _motswk_pin(motswk_pin), _callback(nullptr),
+        _power(PAW3204DB_POWER_HOLD_MS, PAW3204DB_POWER_MIN_HOLD_MS, PAW3204DB_POWER_MAX_HOLD_MS, PAW3204DB_POWER_RETURN_WINDOW_MS),
+        _auto_power(false),
+        _carry_x(0),
+        _carry_y(0),
+        _overflow_count(0)
   {
   }
 
@@ -99,22 +135,27 @@ namespace hidpg
     _callback = callback;
   }
 
-  void PAW3204DB::start()
+  bool PAW3204DB::start()
   {
-    _mutex = xSemaphoreCreateMutex();
+    if (isRegistered() == false)
+    {
+      return false;
+    }
+
+    _mutex = xSemaphoreCreateMutexStatic(&_mutex_buffer);
 
     _reg->begin();
 
     pinMode(_motswk_pin, INPUT_PULLUP);
-    void (*interrupt_callback)() = (_id == 0) ? interrupt_callback_0 : interrupt_callback_1;
-    attachInterrupt(digitalPinToInterrupt(_motswk_pin), interrupt_callback, FALLING);
+    attachInterrupt(digitalPinToInterrupt(_motswk_pin), getInterruptCallback(), FALLING);
 
     _reg->reSyncSerial();
     initRegisters();
 
     char name[] = "3204_0";
-    name[5] += _id;
-    xTaskCreate(task, name, PAW3204DB_TASK_STACK_SIZE, this, PAW3204DB_TASK_PRIO, &_task_handles[_id]);
+    name[5] += getId();
+    setTaskHandle(xTaskCreateStatic(task, name, PAW3204DB_TASK_STACK_SIZE, this, PAW3204DB_TASK_PRIO, _task_stack, &_task_tcb));
+    return true;
   }
 
   void PAW3204DB::initRegisters()
@@ -134,21 +175,50 @@ namespace hidpg
 
   void PAW3204DB::readDelta(int16_t *delta_x, int16_t *delta_y)
   {
-    int16_t total_delta_x = 0;
-    int16_t total_delta_y = 0;
-
     xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    // 前回int16_tに収まらなかった分から始める
+    int32_t total_delta_x = _carry_x;
+    int32_t total_delta_y = _carry_y;
+
+    // Motion_Statusを読むとDelta_X、Delta_Yがラッチされる
+    // 動きが無ければDeltaは読まない、MOTSWKがLOWの間は続けて読む
     do
     {
-      _reg->read(Motion_Status);
+      uint8_t status = _reg->read(Motion_Status);
+      if ((status & Motion) == 0)
+      {
+        break;
+      }
+      if (status & (DXOVF | DYOVF))
+      {
+        _overflow_count++;
+      }
       total_delta_x += static_cast<int8_t>(_reg->read(Delta_X));
       total_delta_y += static_cast<int8_t>(_reg->read(Delta_Y));
-
     } while (digitalRead(_motswk_pin) == LOW);
+
+    int32_t clamped_x = constrain(total_delta_x, INT16_MIN, INT16_MAX);
+    int32_t clamped_y = constrain(total_delta_y, INT16_MIN, INT16_MAX);
+    _carry_x = total_delta_x - clamped_x;
+    _carry_y = total_delta_y - clamped_y;
+
+    if (clamped_x != 0 || clamped_y != 0)
+    {
+      _power.onDelta(micros());
+    }
     xSemaphoreGive(_mutex);
 
-    *delta_x = total_delta_x;
-    *delta_y = total_delta_y;
+    *delta_x = clamped_x;
+    *delta_y = clamped_y;
+  }
+
+  uint32_t PAW3204DB::getOverflowCount()
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    uint32_t count = _overflow_count;
+    xSemaphoreGive(_mutex);
+    return count;
   }
 
   void PAW3204DB::changeCpi(Cpi cpi)
@@ -165,10 +235,49 @@ namespace hidpg
     xSemaphoreGive(_mutex);
   }
 
+  void PAW3204DB::setAutoPower(bool enable)
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _auto_power = enable;
+    // 有効にした時はRunから始めて、無効にした時はセンサー任せに戻す
+    _reg->write(Operation_Mode, enable ? static_cast<uint8_t>(Mode::Run) : Operation_Mode_Auto);
+    xSemaphoreGive(_mutex);
+    xTaskNotify(getTaskHandle(), WAKE_UP_BIT, eSetBits);
+  }
+
+  void PAW3204DB::wakeUp()
+  {
+    xTaskNotify(getTaskHandle(), WAKE_UP_BIT, eSetBits);
+  }
+
+  PowerStats PAW3204DB::getPowerStats()
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    PowerStats stats = _power.stats();
+    xSemaphoreGive(_mutex);
+    return stats;
+  }
+
+  void PAW3204DB::applyPowerAction(PowerStateMachine::Action action)
+  {
+    if (_auto_power == false)
+    {
+      return;
+    }
+    if (action == PowerStateMachine::Action::EnterRun)
+    {
+      _reg->write(Operation_Mode, static_cast<uint8_t>(Mode::Run));
+    }
+    else if (action == PowerStateMachine::Action::EnterRest)
+    {
+      _reg->write(Operation_Mode, Operation_Mode_Auto);
+    }
+  }
+
 #ifdef ARDUINO_ARCH_NRF52
   void PAW3204DB::stop_and_setWakeUpInterrupt()
   {
-    vTaskSuspend(_task_handles[_id]);
+    vTaskSuspend(getTaskHandle());
 
     NRF_GPIO->PIN_CNF[_motswk_pin] |= ((uint32_t)(GPIO_PIN_CNF_SENSE_Low) << GPIO_PIN_CNF_SENSE_Pos);
   }
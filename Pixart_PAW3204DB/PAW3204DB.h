@@ -25,17 +25,20 @@
 #pragma once
 
 #include "FreeRTOS.h"
+#include "PAW3204DB_config.h"
+#include "PowerStateMachine.h"
+
+#include "PAW3204DB_RegOperator_GPIO.h"
+#include "PointingSensor.h"
 
 #ifdef ARDUINO_ARCH_NRF52
 #include "PAW3204DB_RegOperator_nRF52.h"
-#else
-#include "PAW3204DB_RegOperator_GPIO.h"
 #endif
 
 namespace hidpg
 {
 
-  class PAW3204DB
+  class PAW3204DB : public PointingSensor
   {
   public:
     enum class Mode : uint8_t
@@ -58,38 +61,40 @@ namespace hidpg
 
     using callback_t = void (*)(void);
 
+    // IDはPointingSensorsに登録するIDで、他の種類のセンサーとも重ならないようにする
+    // nRF52ではSPI2、SPI1の順にハードウェアのSPIを割り当てて、足りなくなったらGPIOで読み書きする
     template <uint8_t ID>
     static PAW3204DB &create(uint8_t sclk_pin, uint8_t sdio_pin, uint8_t motswk_pin)
     {
-      static_assert(ID < 2, "Two or more PAW3204DB can not be created.");
-      if (instances[ID] == nullptr)
-      {
-        PAW3204DB_RegOperator *reg;
-#ifdef ARDUINO_ARCH_NRF52
-        if (ID == 0)
-          reg = new PAW3204DB_RegOperator_nRF52(NRF_SPI2, sclk_pin, sdio_pin);
-        else
-          reg = new PAW3204DB_RegOperator_nRF52(NRF_SPI1, sclk_pin, sdio_pin);
-#else
-        reg = new PAW3204DB_RegOperator_GPIO(sclk_pin, sdio_pin);
-#endif
-        instances[ID] = new PAW3204DB(reg, motswk_pin, ID);
-      }
-      return *instances[ID];
+      static_assert(ID < POINTING_SENSOR_MAX_COUNT, "ID must be less than POINTING_SENSOR_MAX_COUNT.");
+      static PAW3204DB instance(createRegOperator<ID>(sclk_pin, sdio_pin), motswk_pin, ID);
+      instanceOf<ID>() = &instance;
+      return instance;
     }
 
     template <uint8_t ID>
     static PAW3204DB *getInstance()
     {
-      static_assert(ID < 2, "Two or more PAW3204DB can not be created.");
-      return instances[ID];
+      static_assert(ID < POINTING_SENSOR_MAX_COUNT, "ID must be less than POINTING_SENSOR_MAX_COUNT.");
+      return instanceOf<ID>();
     }
 
     void setCallback(callback_t callback);
-    void start();
-    void readDelta(int16_t *delta_x, int16_t *delta_y);
+    // IDが他のセンサーと重なっていたら何もせずにfalseを返す、その時は他のメソッドを呼ばないこと
+    bool start();
+    // Motion_Statusで動きがある時だけDelta_X、Delta_Yを読んで合計する
+    // int16_tに収まらない分は次回に持ち越す
+    void readDelta(int16_t *delta_x, int16_t *delta_y) override;
+    // センサーの8bitのDelta_X、Delta_Yがオーバーフローした(移動量を取りこぼした)回数
+    uint32_t getOverflowCount();
     void changeCpi(Cpi cpi);
     void changeMode(Mode mode);
+    // 動きの履歴に合わせてRunと自動スリープを切り替える
+    // 有効な間はchangeMode()を呼ばないこと
+    void setAutoPower(bool enable);
+    // マウスボタン等が押された時に呼んでSleepから先に起こしておく、割り込みからは呼べない
+    void wakeUp();
+    PowerStats getPowerStats();
 
 #ifdef ARDUINO_ARCH_NRF52
     void stop_and_setWakeUpInterrupt();
@@ -100,18 +105,48 @@ namespace hidpg
 
     static void task(void *pvParameters);
     static void timer_callback(TimerHandle_t timer_handle);
-    static void interrupt_callback_0();
-    static void interrupt_callback_1();
-    static TaskHandle_t _task_handles[2];
-    static PAW3204DB *instances[2];
+
+    template <uint8_t ID>
+    static PAW3204DB_RegOperator *createRegOperator(uint8_t sclk_pin, uint8_t sdio_pin)
+    {
+#ifdef ARDUINO_ARCH_NRF52
+      NRF_SPI_Type *spi = allocateSpi();
+      if (spi != nullptr)
+      {
+        static PAW3204DB_RegOperator_nRF52 reg(spi, sclk_pin, sdio_pin);
+        return &reg;
+      }
+#endif
+      static PAW3204DB_RegOperator_GPIO reg(sclk_pin, sdio_pin);
+      return &reg;
+    }
+
+    template <uint8_t ID>
+    static PAW3204DB *&instanceOf()
+    {
+      static PAW3204DB *instance = nullptr;
+      return instance;
+    }
+
+#ifdef ARDUINO_ARCH_NRF52
+    static NRF_SPI_Type *allocateSpi();
+#endif
 
     void initRegisters();
+    void applyPowerAction(PowerStateMachine::Action action);
 
+    StackType_t _task_stack[PAW3204DB_TASK_STACK_SIZE];
+    StaticTask_t _task_tcb;
     SemaphoreHandle_t _mutex;
+    StaticSemaphore_t _mutex_buffer;
     PAW3204DB_RegOperator *_reg;
     const uint8_t _motswk_pin;
-    const uint8_t _id;
     callback_t _callback;
+    PowerStateMachine _power;
+    bool _auto_power;
+    int32_t _carry_x;
+    int32_t _carry_y;
+    uint32_t _overflow_count;
   };
 
 } // namespace hidpg
@@ -44,6 +44,24 @@
 #define PAW3204DB_Image_Recognition 0xE5
 #endif
 
+// setAutoPower(true)の時、最後の動きからRunを保つ時間(ms)の初期値、最小値、最大値
+// Sleepに入ってからPAW3204DB_POWER_RETURN_WINDOW_MS以内に動いたら延ばし、そうでなければ縮める
+#ifndef PAW3204DB_POWER_HOLD_MS
+#define PAW3204DB_POWER_HOLD_MS 500
+#endif
+
+#ifndef PAW3204DB_POWER_MIN_HOLD_MS
+#define PAW3204DB_POWER_MIN_HOLD_MS 100
+#endif
+
+#ifndef PAW3204DB_POWER_MAX_HOLD_MS
+#define PAW3204DB_POWER_MAX_HOLD_MS 10000
+#endif
+
+#ifndef PAW3204DB_POWER_RETURN_WINDOW_MS
+#define PAW3204DB_POWER_RETURN_WINDOW_MS 2000
+#endif
+
 // PAW3204DBタスクのスタックサイズ
 #ifndef PAW3204DB_TASK_STACK_SIZE
 #define PAW3204DB_TASK_STACK_SIZE 128
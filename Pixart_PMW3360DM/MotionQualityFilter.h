@@ -0,0 +1,127 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // Motion burstのSQUAL、Shutter、Lift_Statの統計
+  struct SurfaceStats
+  {
+    // SQUALとShutterの指数移動平均(直近およそ2^MotionQualityFilter::AVERAGE_SHIFT回分)
+    uint8_t squal_average;
+    uint16_t shutter_average;
+    // リセットしてからのSQUALの最小値と最大値
+    uint8_t squal_min;
+    uint8_t squal_max;
+    // リセットしてから読んだ回数、その内で移動量を捨てた回数
+    uint32_t reads;
+    uint32_t suppressed;
+    // 持ち上げられた回数(Lift_Statが0から1に変わった回数)
+    uint32_t lifts;
+  };
+
+  // 持ち上げ中や表面の品質が低い時の移動量(ジッター)を捨てるフィルター
+  // 条件が解消してもhold_count回は捨て続けて、着地直後のジッターも取り除く
+  class MotionQualityFilter
+  {
+  public:
+    static constexpr uint8_t AVERAGE_SHIFT = 4;
+
+    MotionQualityFilter(uint8_t min_squal, uint8_t hold_count)
+        : _min_squal(min_squal), _hold_count(hold_count), _remaining(0), _lifted(false),
+          _squal_average(0), _shutter_average(0), _stats()
+    {
+      reset();
+    }
+
+    // 移動量を使って良いならtrueを返す
+    bool update(bool lifted, uint8_t squal, uint16_t shutter)
+    {
+      if (_stats.reads == 0)
+      {
+        _squal_average = static_cast<uint32_t>(squal) << AVERAGE_SHIFT;
+        _shutter_average = static_cast<uint32_t>(shutter) << AVERAGE_SHIFT;
+      }
+      else
+      {
+        _squal_average += squal - static_cast<int32_t>(_squal_average >> AVERAGE_SHIFT);
+        _shutter_average += shutter - static_cast<int32_t>(_shutter_average >> AVERAGE_SHIFT);
+      }
+      _stats.squal_min = (squal < _stats.squal_min) ? squal : _stats.squal_min;
+      _stats.squal_max = (squal > _stats.squal_max) ? squal : _stats.squal_max;
+      _stats.reads++;
+
+      if (lifted && _lifted == false)
+      {
+        _stats.lifts++;
+      }
+      _lifted = lifted;
+
+      if (lifted || squal < _min_squal)
+      {
+        _remaining = _hold_count;
+        _stats.suppressed++;
+        return false;
+      }
+      if (_remaining > 0)
+      {
+        _remaining--;
+        _stats.suppressed++;
+        return false;
+      }
+      return true;
+    }
+
+    SurfaceStats stats() const
+    {
+      SurfaceStats stats = _stats;
+      stats.squal_average = _squal_average >> AVERAGE_SHIFT;
+      stats.shutter_average = _shutter_average >> AVERAGE_SHIFT;
+      return stats;
+    }
+
+    // 統計だけをリセットする、フィルターの状態はそのまま
+    void reset()
+    {
+      _stats = SurfaceStats();
+      _stats.squal_min = UINT8_MAX;
+      _squal_average = 0;
+      _shutter_average = 0;
+    }
+
+  private:
+    const uint8_t _min_squal;
+    const uint8_t _hold_count;
+    uint8_t _remaining;
+    bool _lifted;
+    uint32_t _squal_average;
+    uint32_t _shutter_average;
+    SurfaceStats _stats;
+  };
+
+} // namespace hidpg
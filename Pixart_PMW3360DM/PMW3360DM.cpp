@@ -78,20 +78,103 @@ namespace hidpg
   constexpr uint8_t Raw_Data_Burst = 0x64;
   constexpr uint8_t LiftCutoff_Tune2 = 0x65;
 
-  // spi parameter
-  static SPISettings SpiSettings(2000000, MSBFIRST, SPI_MODE3);
-
-  PMW3360DM::PMW3360DM(ThreadSafeSPIClass &spi,
-                       uint8_t ncs_pin,
-                       uint8_t interrupt_pin,
-                       TaskHandle_t &task_handle,
-                       voidFuncPtr interrupt_callback)
-      : _spi(spi),
+  // タスク通知のビット(MOTION_BITはPointingSensor)
+  constexpr uint32_t WAKE_UP_BIT = 0b10;
+
+  // Motion burstで送るダミーデータ、EasyDMAはRAM上のバッファしか読めないのでconstにしない
+  static uint8_t BurstTxBuffer[12];
+
+#if defined(ARDUINO_ARCH_NRF52) && PMW3360DM_USE_BURST_TIMER
+
+#define PMW3360DM_CONCAT_(a, b, c) a##b##c
+#define PMW3360DM_CONCAT(a, b, c) PMW3360DM_CONCAT_(a, b, c)
+#define BURST_TIMER PMW3360DM_CONCAT(NRF_TIMER, PMW3360DM_BURST_TIMER_NUMBER, )
+#define BURST_TIMER_IRQn PMW3360DM_CONCAT(TIMER, PMW3360DM_BURST_TIMER_NUMBER, _IRQn)
+#define BURST_TIMER_IRQHandler PMW3360DM_CONCAT(TIMER, PMW3360DM_BURST_TIMER_NUMBER, _IRQHandler)
+
+  // tSRAD_MOTBRやSROMダウンロードのバイト間隔を待つワンショットタイマー、複数のインスタンスで共有する
+  // タスク通知はモーション割り込みで使っているのでセマフォで待つ
+  static SemaphoreHandle_t BurstTimerMutex = nullptr;
+  static StaticSemaphore_t BurstTimerMutexBuffer;
+  static SemaphoreHandle_t BurstTimerDone = nullptr;
+  static StaticSemaphore_t BurstTimerDoneBuffer;
+
+  static void initBurstTimer()
+  {
+    if (BurstTimerMutex != nullptr)
+    {
+      return;
+    }
+    BurstTimerMutex = xSemaphoreCreateMutexStatic(&BurstTimerMutexBuffer);
+    BurstTimerDone = xSemaphoreCreateBinaryStatic(&BurstTimerDoneBuffer);
+
+    BURST_TIMER->TASKS_STOP = 1;
+    BURST_TIMER->MODE = TIMER_MODE_MODE_Timer;
+    BURST_TIMER->BITMODE = TIMER_BITMODE_BITMODE_16Bit;
+    BURST_TIMER->PRESCALER = 4; // 16MHz / 2^4 = 1MHz
+    BURST_TIMER->SHORTS = TIMER_SHORTS_COMPARE0_STOP_Msk | TIMER_SHORTS_COMPARE0_CLEAR_Msk;
+    BURST_TIMER->INTENSET = TIMER_INTENSET_COMPARE0_Msk;
+
+    NVIC_DisableIRQ(BURST_TIMER_IRQn);
+    NVIC_ClearPendingIRQ(BURST_TIMER_IRQn);
+    NVIC_SetPriority(BURST_TIMER_IRQn, 3);
+    NVIC_EnableIRQ(BURST_TIMER_IRQn);
+  }
+
+  extern "C"
+  {
+    void BURST_TIMER_IRQHandler()
+    {
+      BURST_TIMER->EVENTS_COMPARE[0] = 0;
+      // 書き込みがペリフェラルに届く前に割り込みから抜けると再度割り込みが入るので読み戻す
+      (void)BURST_TIMER->EVENTS_COMPARE[0];
+
+      BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+      xSemaphoreGiveFromISR(BurstTimerDone, &xHigherPriorityTaskWoken);
+      portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
+  }
+
+#endif
+
+  // CPUを他のタスクに渡しながらusマイクロ秒待つ
+  // タイマーを使わない場合はdelayMicroseconds()と同じ
+  static void waitMicroseconds(uint16_t us)
+  {
+#if defined(ARDUINO_ARCH_NRF52) && PMW3360DM_USE_BURST_TIMER
+    xSemaphoreTake(BurstTimerMutex, portMAX_DELAY);
+
+    // 前回タイムアウトした後に遅れて来た分を捨てる
+    xSemaphoreTake(BurstTimerDone, 0);
+    BURST_TIMER->CC[0] = us;
+    BURST_TIMER->TASKS_CLEAR = 1;
+    BURST_TIMER->TASKS_START = 1;
+    // 割り込みが来なかった場合に備えて2tick(1tick以上)で抜ける
+    if (xSemaphoreTake(BurstTimerDone, 2) == pdFALSE)
+    {
+      BURST_TIMER->TASKS_STOP = 1;
+    }
+
+    xSemaphoreGive(BurstTimerMutex);
+#else
+    delayMicroseconds(us);
+#endif
+  }
+
+  PMW3360DM::PMW3360DM(ThreadSafeSPIClass &spi, uint8_t ncs_pin, uint8_t interrupt_pin, uint8_t id)
+      : PointingSensor(id),
+        _spi(spi),
+        _spi_device(SPISettings(2000000, MSBFIRST, SPI_MODE3), SPIDevice::Priority::Motion),
         _ncs_pin(ncs_pin),
         _interrupt_pin(interrupt_pin),
-        _task_handle(task_handle),
-        _interrupt_callback(interrupt_callback),
-        _callback(nullptr)
+        _callback(nullptr),
+        _in_burst_mode(false),
+        _burst_buffer(),
+        _front(0),
+        _init_report(),
+        _quality_filter(PMW3360DM_MIN_SQUAL, PMW3360DM_SUPPRESS_HOLD_COUNT),
+        _power(PMW3360DM_POWER_HOLD_MS, PMW3360DM_POWER_MIN_HOLD_MS, PMW3360DM_POWER_MAX_HOLD_MS, PMW3360DM_POWER_RETURN_WINDOW_MS),
+        _auto_power(false)
   {
   }
 
@@ -100,20 +183,29 @@ namespace hidpg
     _callback = callback;
   }
 
-  void PMW3360DM::start()
+  bool PMW3360DM::start()
   {
+    if (isRegistered() == false)
+    {
+      return false;
+    }
+
     _spi.begin();
     _spi.usingInterrupt(_interrupt_pin);
 
     pinMode(_ncs_pin, OUTPUT);
     pinMode(_interrupt_pin, INPUT_PULLUP);
 
-    attachInterrupt(digitalPinToInterrupt(_interrupt_pin), _interrupt_callback, FALLING);
+    attachInterrupt(digitalPinToInterrupt(_interrupt_pin), getInterruptCallback(), FALLING);
 
     _mutex = xSemaphoreCreateMutexStatic(&_mutex_buffer);
-    _task_handle = xTaskCreateStatic(task, "3360", PMW3360DM_TASK_STACK_SIZE, this, PMW3360DM_TASK_PRIO, _task_stack, &_task_tcb);
+#if defined(ARDUINO_ARCH_NRF52) && PMW3360DM_USE_BURST_TIMER
+    initBurstTimer();
+#endif
+    setTaskHandle(xTaskCreateStatic(task, "3360", PMW3360DM_TASK_STACK_SIZE, this, PMW3360DM_TASK_PRIO, _task_stack, &_task_tcb));
 
     powerUp();
+    return true;
   }
 
   void PMW3360DM::task(void *pvParameters)
@@ -122,17 +214,44 @@ namespace hidpg
 
     while (true)
     {
-      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-      if (that->_callback != nullptr)
+      xSemaphoreTake(that->_mutex, portMAX_DELAY);
+      uint32_t wait_ms = that->_auto_power ? that->_power.timeUntilRest(millis()) : UINT32_MAX;
+      xSemaphoreGive(that->_mutex);
+
+      uint32_t bits = 0;
+      xTaskNotifyWait(0, UINT32_MAX, &bits, (wait_ms == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms));
+
+      xSemaphoreTake(that->_mutex, portMAX_DELAY);
+      if (bits & WAKE_UP_BIT)
+      {
+        that->applyPowerAction(that->_power.onWakeUp(millis(), micros()));
+      }
+      if (bits & MOTION_BIT)
+      {
+        that->applyPowerAction(that->_power.onMotion(millis(), micros()));
+      }
+      if (bits == 0)
       {
-        that->_callback();
+        that->applyPowerAction(that->_power.onTimeout(millis()));
+      }
+      xSemaphoreGive(that->_mutex);
+
+      if (bits & MOTION_BIT)
+      {
+        if (that->_callback != nullptr)
+        {
+          that->_callback();
+        }
+        that->notifyMotion();
       }
     }
   }
 
   void PMW3360DM::writeRegister(uint8_t addr, uint8_t data)
   {
-    _spi.beginTransaction(SpiSettings);
+    _in_burst_mode = false;
+
+    _spi.beginTransaction(_spi_device);
     digitalWrite(_ncs_pin, LOW);
 
     delayMicroseconds(1); // tNCS-SCLK: 120ns
@@ -151,7 +270,9 @@ namespace hidpg
 
   uint8_t PMW3360DM::readRegister(uint8_t addr)
   {
-    _spi.beginTransaction(SpiSettings);
+    _in_burst_mode = false;
+
+    _spi.beginTransaction(_spi_device);
     digitalWrite(_ncs_pin, LOW);
 
     delayMicroseconds(1); // tNCS-SCLK (120ns)
@@ -172,33 +293,44 @@ namespace hidpg
     return data;
   }
 
-  void PMW3360DM::readMotionBurst(MotionBurstData *data, uint8_t length)
+  const PMW3360DM::MotionBurstData &PMW3360DM::readMotionBurst(uint8_t length)
   {
     length = min(static_cast<uint8_t>(12), length);
 
     // 1.Write any value to Motion_Burst register.
-    writeRegister(Motion_Burst, 0);
+    // burstモードのままなら不要なのでスキップする
+    if (_in_burst_mode == false)
+    {
+      writeRegister(Motion_Burst, 0);
+      _in_burst_mode = true;
+    }
 
     // 2.Lower NCS
-    _spi.beginTransaction(SpiSettings);
+    _spi.beginTransaction(_spi_device);
     digitalWrite(_ncs_pin, LOW);
 
     // 3.Send Motion_Burst address (0x50).
-    _spi.transfer(0x50);
+    _spi.transfer(Motion_Burst);
 
     // 4.Wait for tSRAD_MOTBR: 35us
-    delayMicroseconds(35);
+    // NCSがLOWの間に他のデバイスがSCLKを動かすとセンサーが応答してしまうのでバスは離さない
+    waitMicroseconds(35);
 
     // 5.Start reading SPI Data continuously up to 12 bytes. Motion burst may be terminated by pulling NCS high for at least tBEXIT.
-    _spi.transfer(data->raw, length);
+    // 裏側のバッファに受信してから表側と入れ替える
+    uint8_t back = _front ^ 1;
+    _spi.transfer(BurstTxBuffer, _burst_buffer[back].raw, length);
 
     digitalWrite(_ncs_pin, HIGH);
     _spi.endTransaction();
 
+    _front = back;
+
     delayMicroseconds(1); // tBEXIT: 500ns
 
     // 6.To read new motion burst data, repeat from step 2.
     // 7.If a non‐burst register read operation was executed; then, to read new burst data, start from step 1 instead.
+    return _burst_buffer[_front];
   }
 
   void PMW3360DM::SROM_Download()
@@ -219,17 +351,18 @@ namespace hidpg
 
     // 6.Write SROM file into SROM_Load_Burst register, 1st data must start with SROM_Load_Burst address.
     // All the SROM data must be downloaded before SROM starts running.
-    _spi.beginTransaction(SpiSettings);
+    _spi.beginTransaction(_spi_device);
     digitalWrite(_ncs_pin, LOW);
 
     _spi.transfer(SROM_Load_Burst | 0b10000000);
-    delayMicroseconds(15);
+    waitMicroseconds(15);
 
     // send all bytes of the firmware
+    // バイト間の15usはタイマーで待つので、その間は他のタスクが動ける
     for (size_t i = 0; i < sizeof(PMW3360DM_Firmware); i++)
     {
       _spi.transfer(PMW3360DM_Firmware[i]);
-      delayMicroseconds(15);
+      waitMicroseconds(15);
     }
 
     _spi.endTransaction();
@@ -237,19 +370,50 @@ namespace hidpg
     delayMicroseconds(185);       // 200us-15us
 
     // 7.Read the SROM_ID register to verify the ID before any other register reads or writes.
-    readRegister(SROM_ID);
+    _init_report.srom_id = readRegister(SROM_ID);
 
     // 8.Write 0x00 to Config2 register for wired mouse or 0x20 for wireless mouse design.
     writeRegister(Config2, 0x20);
   }
 
-  void PMW3360DM::powerUp()
+  bool PMW3360DM::isSROM_Loaded()
+  {
+    // マイコンだけがリセットされた場合はセンサーの電源が入ったままでSROMも残っている
+    // 別のセンサーやSPIの配線不良でたまたま一致しないようにProduct_IDも確認する
+    if (readRegister(Product_ID) != 0x42 || readRegister(Inverse_Product_ID) != 0xBD)
+    {
+      return false;
+    }
+    _init_report.srom_id = readRegister(SROM_ID);
+    return _init_report.srom_id == PMW3360DM_Firmware_SROM_ID;
+  }
+
+  void PMW3360DM::powerUp(bool force_srom_download)
   {
     // 1.Apply power to VDD and VDDIO in any order, with a delay of no more than 100ms in between each supply. Ensure all supplies are stable.
 
+    uint32_t start_time = micros();
+
     // 2.Drive NCS high, and then low to reset the SPI port.
     digitalWrite(_ncs_pin, HIGH);
     digitalWrite(_ncs_pin, LOW);
+
+    // SROMがロード済みならリセットとダウンロードを飛ばして設定だけやり直す
+    if (force_srom_download == false && isSROM_Loaded())
+    {
+      readRegister(Motion);
+      readRegister(Delta_X_L);
+      readRegister(Delta_X_H);
+      readRegister(Delta_Y_L);
+      readRegister(Delta_Y_H);
+      writeRegister(Config2, 0x20);
+      initRegisters();
+
+      _init_report.srom_downloaded = false;
+      _init_report.duration_us = micros() - start_time;
+      return;
+    }
+
     // 3.Write 0x5A to Power_Up_Reset register (or, alternatively toggle the NRESET pin).
     writeRegister(Power_Up_Reset, 0x5a);
     // 4.Wait for at least 50ms.
@@ -265,6 +429,9 @@ namespace hidpg
 
     // 7.Load configuration for other registers.
     initRegisters();
+
+    _init_report.srom_downloaded = true;
+    _init_report.duration_us = micros() - start_time;
   }
 
   void PMW3360DM::initRegisters()
@@ -287,14 +454,64 @@ namespace hidpg
     writeRegister(Lift_Config, PMW3360DM_Lift_Config);
   }
 
+  // Motion registerのLift_Statビット
+  constexpr uint8_t Lift_Stat = 0b00001000;
+
   void PMW3360DM::readDelta(int16_t *delta_x, int16_t *delta_y)
   {
-    MotionBurstData mb_data;
     xSemaphoreTake(_mutex, portMAX_DELAY);
-    readMotionBurst(&mb_data, 6);
+    // SQUALとShutterも同じburstで読む(6バイト増えるだけでトランザクションは増えない)
+    const MotionBurstData &mb_data = readMotionBurst(12);
+    bool lifted = (mb_data.motion & Lift_Stat) != 0;
+    uint16_t shutter = (mb_data.shutter_upper << 8) | mb_data.shutter_lower;
+    if (_quality_filter.update(lifted, mb_data.squal, shutter))
+    {
+      *delta_x = mb_data.delta_x;
+      *delta_y = mb_data.delta_y;
+      if (mb_data.delta_x != 0 || mb_data.delta_y != 0)
+      {
+        _power.onDelta(micros());
+      }
+    }
+    else
+    {
+      *delta_x = 0;
+      *delta_y = 0;
+    }
+    xSemaphoreGive(_mutex);
+  }
+
+  void PMW3360DM::readMotion(MotionBurst *data)
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    const MotionBurstData &mb_data = readMotionBurst(12);
+    data->motion = mb_data.motion;
+    data->observation = mb_data.observation;
+    data->delta_x = mb_data.delta_x;
+    data->delta_y = mb_data.delta_y;
+    data->squal = mb_data.squal;
+    data->raw_data_sum = mb_data.raw_data_sum;
+    data->maximum_raw_data = mb_data.maximum_raw_data;
+    data->minimum_raw_data = mb_data.minimum_raw_data;
+    data->shutter = (mb_data.shutter_upper << 8) | mb_data.shutter_lower;
+    data->lifted = (mb_data.motion & Lift_Stat) != 0;
+    _quality_filter.update(data->lifted, data->squal, data->shutter);
+    xSemaphoreGive(_mutex);
+  }
+
+  SurfaceStats PMW3360DM::getSurfaceStats()
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    SurfaceStats stats = _quality_filter.stats();
+    xSemaphoreGive(_mutex);
+    return stats;
+  }
+
+  void PMW3360DM::resetSurfaceStats()
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _quality_filter.reset();
     xSemaphoreGive(_mutex);
-    *delta_x = mb_data.delta_x;
-    *delta_y = mb_data.delta_y;
   }
 
   void PMW3360DM::changeMode(Mode mode)
@@ -326,10 +543,128 @@ namespace hidpg
     xSemaphoreGive(_mutex);
   }
 
+  void PMW3360DM::captureFrame(uint8_t (&frame)[FRAME_SIZE])
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    // 再起動で消える設定を覚えておく
+    uint8_t config1 = readRegister(Config1);
+    uint8_t config2 = readRegister(Config2);
+    uint8_t angle_snap = readRegister(Angle_Snap);
+
+    // 1.Lift the mouse and place it on a surface. (測りたい面に置いておく)
+    // 2.Write 0 to Rest_En bit of Config2 register to disable Rest mode.
+    writeRegister(Config2, 0x00);
+    // 3.Write 0x83 to Frame_Capture register.
+    writeRegister(Frame_Capture, 0x83);
+    // 4.Write 0xC5 to Frame_Capture register.
+    writeRegister(Frame_Capture, 0xc5);
+    // 5.Wait for 20ms.
+    vTaskDelay(pdMS_TO_TICKS(20));
+
+    // 6.Continue burst read from Raw_data_Burst register until all 1296 raw data are transferred.
+    _spi.beginTransaction(_spi_device);
+    digitalWrite(_ncs_pin, LOW);
+
+    _spi.transfer(Raw_Data_Burst);
+    waitMicroseconds(35); // tSRAD_MOTBRと同じだけ待つ
+
+    // 0を送りながら同じバッファに受信する、EasyDMAの1回の最大長(nRF52832は255)に分ける
+    memset(frame, 0, FRAME_SIZE);
+    for (uint16_t offset = 0; offset < FRAME_SIZE; offset += 255)
+    {
+      uint16_t len = min(static_cast<uint16_t>(FRAME_SIZE - offset), static_cast<uint16_t>(255));
+      _spi.transfer(&frame[offset], len);
+    }
+
+    digitalWrite(_ncs_pin, HIGH);
+    _spi.endTransaction();
+    delayMicroseconds(1); // tBEXIT: 500ns
+
+    // Manual reset and SROM download are needed after frame capture to restore navigation for motion reading.
+    powerUp(true);
+    writeRegister(Config1, config1);
+    writeRegister(Config2, config2);
+    writeRegister(Angle_Snap, angle_snap);
+
+    xSemaphoreGive(_mutex);
+  }
+
+  bool PMW3360DM::sendFrame(const uint8_t (&frame)[FRAME_SIZE], uint16_t chunk_size, frame_chunk_callback_t send)
+  {
+    if (chunk_size == 0)
+    {
+      return false;
+    }
+
+    for (uint16_t offset = 0; offset < FRAME_SIZE; offset += chunk_size)
+    {
+      uint16_t len = min(static_cast<uint16_t>(FRAME_SIZE - offset), chunk_size);
+      if (send(offset, &frame[offset], len) == false)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  SPIDevice::Stats PMW3360DM::getBusStats()
+  {
+    return _spi_device.getStats();
+  }
+
+  PMW3360DM::InitReport PMW3360DM::getInitReport()
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    InitReport report = _init_report;
+    xSemaphoreGive(_mutex);
+    return report;
+  }
+
+  void PMW3360DM::setAutoPower(bool enable)
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _auto_power = enable;
+    // 有効にした時はRunから始めて、無効にした時はセンサー任せ(Rest)に戻す
+    writeRegister(Config2, enable ? 0x00 : 0x20);
+    xSemaphoreGive(_mutex);
+    xTaskNotify(getTaskHandle(), WAKE_UP_BIT, eSetBits);
+  }
+
+  void PMW3360DM::wakeUp()
+  {
+    xTaskNotify(getTaskHandle(), WAKE_UP_BIT, eSetBits);
+  }
+
+  PowerStats PMW3360DM::getPowerStats()
+  {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    PowerStats stats = _power.stats();
+    xSemaphoreGive(_mutex);
+    return stats;
+  }
+
+  void PMW3360DM::applyPowerAction(PowerStateMachine::Action action)
+  {
+    if (_auto_power == false)
+    {
+      return;
+    }
+    // Rest_En(Config2のbit5)を0にするとすぐにRunに戻り、1にするとRun_Downshift後にRestに入る
+    if (action == PowerStateMachine::Action::EnterRun)
+    {
+      writeRegister(Config2, 0x00);
+    }
+    else if (action == PowerStateMachine::Action::EnterRest)
+    {
+      writeRegister(Config2, 0x20);
+    }
+  }
+
 #ifdef ARDUINO_ARCH_NRF52
   void PMW3360DM::stop_and_setWakeUpInterrupt()
   {
-    vTaskSuspend(_task_handle);
+    vTaskSuspend(getTaskHandle());
 
     NRF_GPIO->PIN_CNF[_interrupt_pin] |= ((uint32_t)(GPIO_PIN_CNF_SENSE_Low) << GPIO_PIN_CNF_SENSE_Pos);
   }
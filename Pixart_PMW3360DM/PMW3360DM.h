@@ -24,35 +24,16 @@
 
 #pragma once
 
+#include "MotionQualityFilter.h"
 #include "PMW3360DM_config.h"
+#include "PointingSensor.h"
+#include "PowerStateMachine.h"
 #include "ThreadSafeSPI.h"
 
 namespace hidpg
 {
 
-  namespace Internal
-  {
-    template <uint8_t ID>
-    class PMW3360DM_InterruptCallback
-    {
-    public:
-      static void interrupt_callback()
-      {
-        if (_task_handle != nullptr)
-        {
-          xTaskNotifyFromISR(_task_handle, 1, eSetValueWithOverwrite, nullptr);
-        }
-      }
-
-      static TaskHandle_t _task_handle;
-    };
-
-    template <uint8_t ID>
-    TaskHandle_t PMW3360DM_InterruptCallback<ID>::_task_handle = nullptr;
-
-  } // namespace Internal
-
-  class PMW3360DM
+  class PMW3360DM : public PointingSensor
   {
   public:
     enum class Mode
@@ -92,26 +73,73 @@ namespace hidpg
     // clang-format on
 
     using callback_t = void (*)(void);
+    // frameのoffsetバイト目からlenバイトを送る、送れたらtrueを返す
+    using frame_chunk_callback_t = bool (*)(uint16_t offset, const uint8_t *data, uint16_t len);
+
+    // Frame captureで読める画像のサイズ
+    static constexpr uint8_t FRAME_WIDTH = 36;
+    static constexpr uint16_t FRAME_SIZE = FRAME_WIDTH * FRAME_WIDTH;
+
+    // Motion burstで読める全てのデータ
+    struct MotionBurst
+    {
+      uint8_t motion;
+      uint8_t observation;
+      int16_t delta_x;
+      int16_t delta_y;
+      uint8_t squal;
+      uint8_t raw_data_sum;
+      uint8_t maximum_raw_data;
+      uint8_t minimum_raw_data;
+      uint16_t shutter;
+      bool lifted; // motionのLift_Statビット
+    };
 
+    // 起動処理(powerUp)の結果
+    struct InitReport
+    {
+      uint32_t duration_us; // 起動処理にかかった時間
+      uint8_t srom_id;      // 起動後のSROM_IDレジスタの値
+      bool srom_downloaded; // SROMをダウンロードしたか(falseなら既にロード済みだったのでスキップした)
+    };
+
+    // IDはPointingSensorsに登録するIDで、他の種類のセンサーとも重ならないようにする
     template <uint8_t ID>
     static PMW3360DM &create(ThreadSafeSPIClass &spi, uint8_t ncs_pin, uint8_t interrupt_pin)
     {
-      static PMW3360DM instance(spi,
-                                ncs_pin,
-                                interrupt_pin,
-                                Internal::PMW3360DM_InterruptCallback<ID>::_task_handle,
-                                Internal::PMW3360DM_InterruptCallback<ID>::interrupt_callback);
-
+      static_assert(ID < POINTING_SENSOR_MAX_COUNT, "ID must be less than POINTING_SENSOR_MAX_COUNT.");
+      static PMW3360DM instance(spi, ncs_pin, interrupt_pin, ID);
       return instance;
     }
 
     void setCallback(callback_t callback);
-    void start();
-    void readDelta(int16_t *delta_x, int16_t *delta_y);
+    // IDが他のセンサーと重なっていたら何もせずにfalseを返す、その時は他のメソッドを呼ばないこと
+    bool start();
+    // 持ち上げ中やSQUALが低い時は0を返す
+    void readDelta(int16_t *delta_x, int16_t *delta_y) override;
+    // 12バイト全てを1回のburstで読む、移動量はフィルターを通さずにそのまま返す
+    void readMotion(MotionBurst *data);
+    SurfaceStats getSurfaceStats();
+    void resetSurfaceStats();
     void changeMode(Mode mode);
     void changeCpi(Cpi cpi);
     void enableAngleSnap();
     void disableAngleSnap();
+    InitReport getInitReport();
+    // このセンサーがSPIバスを使った時間
+    SPIDevice::Stats getBusStats();
+    // 動きの履歴に合わせてRun/Restを自動で切り替える
+    // 有効な間はchangeMode()を呼ばないこと
+    void setAutoPower(bool enable);
+    // マウスボタン等が押された時に呼んでRestから先に起こしておく、割り込みからは呼べない
+    void wakeUp();
+    PowerStats getPowerStats();
+    // センサーの画像(36x36)をframeに読む、読んでいる間と読んだ後の再起動の間はreadDelta()が待たされる
+    // Frame captureの後はSROMを再ダウンロードしないと動きを読めないので、CPIやAngle snapの設定ごと復元する
+    void captureFrame(uint8_t (&frame)[FRAME_SIZE]);
+    // frameをchunk_sizeバイト以下に分けてsendに渡す、途中で送れなければfalseを返す
+    // BLEのNotifyやHIDのレポートのようなメッセージ単位の経路ではoffsetも一緒に送れば受信側で組み立て直せる
+    static bool sendFrame(const uint8_t (&frame)[FRAME_SIZE], uint16_t chunk_size, frame_chunk_callback_t send);
 
 #ifdef ARDUINO_ARCH_NRF52
     void stop_and_setWakeUpInterrupt();
@@ -133,36 +161,44 @@ namespace hidpg
           uint8_t raw_data_sum;
           uint8_t maximum_raw_data;
           uint8_t minimum_raw_data;
-          uint16_t shutter;
+          uint8_t shutter_upper;
+          uint8_t shutter_lower;
         };
       };
     };
 
-    PMW3360DM(ThreadSafeSPIClass &spi,
-              uint8_t ncs_pin,
-              uint8_t interrupt_pin,
-              TaskHandle_t &task_handle,
-              voidFuncPtr interrupt_callback);
+    PMW3360DM(ThreadSafeSPIClass &spi, uint8_t ncs_pin, uint8_t interrupt_pin, uint8_t id);
 
     static void task(void *pvParameters);
 
     void writeRegister(uint8_t addr, uint8_t data);
     uint8_t readRegister(uint8_t addr);
-    void readMotionBurst(MotionBurstData *data, uint8_t length);
+    const MotionBurstData &readMotionBurst(uint8_t length);
     void SROM_Download();
-    void powerUp();
+    bool isSROM_Loaded();
+    void powerUp(bool force_srom_download = false);
     void initRegisters();
+    void applyPowerAction(PowerStateMachine::Action action);
 
     ThreadSafeSPIClass &_spi;
+    // motion burstが他のデバイスの大きな転送に待たされないようにPriority::Motionでバスを取る
+    SPIDevice _spi_device;
     const uint8_t _ncs_pin;
     const uint8_t _interrupt_pin;
-    TaskHandle_t &_task_handle;
     StackType_t _task_stack[PMW3360DM_TASK_STACK_SIZE];
     StaticTask_t _task_tcb;
     SemaphoreHandle_t _mutex;
     StaticSemaphore_t _mutex_buffer;
-    voidFuncPtr _interrupt_callback;
     callback_t _callback;
+    // Motion burstモードに入っているか、burst以外のレジスタアクセスで抜ける
+    bool _in_burst_mode;
+    // EasyDMAで受信するダブルバッファ、_front側が最後に読み終わったデータ
+    MotionBurstData _burst_buffer[2];
+    uint8_t _front;
+    InitReport _init_report;
+    MotionQualityFilter _quality_filter;
+    PowerStateMachine _power;
+    bool _auto_power;
   };
 
 } // namespace hidpg
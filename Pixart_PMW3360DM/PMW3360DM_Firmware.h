@@ -7,6 +7,9 @@ namespace hidpg
 // clang-format off
 
 // Firmware "PMW3360DM_srom_0x04"
+// ダウンロード後にSROM_IDレジスタから読める値
+constexpr uint8_t PMW3360DM_Firmware_SROM_ID = 0x04;
+
 constexpr uint8_t PMW3360DM_Firmware[] = {
     0x01, 0x04, 0x8e, 0x96, 0x6e, 0x77, 0x3e, 0xfe, 0x7e, 0x5f, 0x1d, 0xb8, 0xf2, 0x66, 0x4e,
     0xff, 0x5d, 0x19, 0xb0, 0xc2, 0x04, 0x69, 0x54, 0x2a, 0xd6, 0x2e, 0xbf, 0xdd, 0x19, 0xb0,
@@ -89,6 +89,46 @@
 #define PMW3360DM_Lift_Config 0b10
 #endif
 
+// readDelta()でSQUALがこれより小さい時は移動量を0にする(0で無効)
+#ifndef PMW3360DM_MIN_SQUAL
+#define PMW3360DM_MIN_SQUAL 16
+#endif
+
+// 持ち上げやSQUALの低下が解消した後も移動量を0にし続けるreadDelta()の回数
+#ifndef PMW3360DM_SUPPRESS_HOLD_COUNT
+#define PMW3360DM_SUPPRESS_HOLD_COUNT 2
+#endif
+
+// setAutoPower(true)の時、最後の動きからRunを保つ時間(ms)の初期値、最小値、最大値
+// Restに入ってからPMW3360DM_POWER_RETURN_WINDOW_MS以内に動いたら延ばし、そうでなければ縮める
+#ifndef PMW3360DM_POWER_HOLD_MS
+#define PMW3360DM_POWER_HOLD_MS 500
+#endif
+
+#ifndef PMW3360DM_POWER_MIN_HOLD_MS
+#define PMW3360DM_POWER_MIN_HOLD_MS 100
+#endif
+
+#ifndef PMW3360DM_POWER_MAX_HOLD_MS
+#define PMW3360DM_POWER_MAX_HOLD_MS 10000
+#endif
+
+#ifndef PMW3360DM_POWER_RETURN_WINDOW_MS
+#define PMW3360DM_POWER_RETURN_WINDOW_MS 2000
+#endif
+
+// Motion burstのtSRAD_MOTBR(35us)とSROMダウンロードのバイト間隔(15us)をタイマー割り込みで待つ(nRF52のみ)
+// 待っている間タスクはブロックされるのでCPUを他のタスクに渡せる
+// falseにするとdelayMicroseconds()で待つ
+#ifndef PMW3360DM_USE_BURST_TIMER
+#define PMW3360DM_USE_BURST_TIMER true
+#endif
+
+// 待つのに使うタイマーの番号(TIMER1~TIMER4)
+#ifndef PMW3360DM_BURST_TIMER_NUMBER
+#define PMW3360DM_BURST_TIMER_NUMBER 4
+#endif
+
 // PMW3360DMタスクのスタックサイズ
 #ifndef PMW3360DM_TASK_STACK_SIZE
 #define PMW3360DM_TASK_STACK_SIZE 128
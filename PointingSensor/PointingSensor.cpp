@@ -0,0 +1,124 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "PointingSensor.h"
+
+namespace hidpg
+{
+  namespace Internal
+  {
+    // センサー毎に別々の割り込みハンドラを使ってどのセンサーの割り込みか区別する
+    const voidFuncPtr PointingSensorsClass::_interrupt_callbacks[] = {
+        interrupt_callback<0>,
+        interrupt_callback<1>,
+        interrupt_callback<2>,
+        interrupt_callback<3>,
+        interrupt_callback<4>,
+        interrupt_callback<5>,
+        interrupt_callback<6>,
+        interrupt_callback<7>,
+    };
+
+    PointingSensor *PointingSensorsClass::_sensors[POINTING_SENSOR_MAX_COUNT] = {};
+    TaskHandle_t PointingSensorsClass::_task_handles[POINTING_SENSOR_MAX_COUNT] = {};
+    PointingSensor::motion_callback_t PointingSensorsClass::_motion_callback = nullptr;
+
+    void PointingSensorsClass::setMotionCallback(PointingSensor::motion_callback_t callback)
+    {
+      _motion_callback = callback;
+    }
+
+    PointingSensor *PointingSensorsClass::get(uint8_t id)
+    {
+      static_assert(sizeof(_interrupt_callbacks) / sizeof(_interrupt_callbacks[0]) >= POINTING_SENSOR_MAX_COUNT,
+                    "POINTING_SENSOR_MAX_COUNT must be 8 or less.");
+      return (id < POINTING_SENSOR_MAX_COUNT) ? _sensors[id] : nullptr;
+    }
+
+    void PointingSensorsClass::readDelta(uint8_t id, int16_t &delta_x, int16_t &delta_y)
+    {
+      PointingSensor *sensor = get(id);
+      if (sensor == nullptr)
+      {
+        delta_x = 0;
+        delta_y = 0;
+        return;
+      }
+      sensor->readDelta(&delta_x, &delta_y);
+    }
+
+  } // namespace Internal
+
+  PointingSensor::PointingSensor(uint8_t id) : _id(id)
+  {
+    if (id < POINTING_SENSOR_MAX_COUNT && Internal::PointingSensorsClass::_sensors[id] == nullptr)
+    {
+      Internal::PointingSensorsClass::_sensors[id] = this;
+    }
+  }
+
+  bool PointingSensor::isRegistered() const
+  {
+    return Internal::PointingSensorsClass::get(_id) == this;
+  }
+
+  voidFuncPtr PointingSensor::getInterruptCallback() const
+  {
+    // 同じIDの別のセンサーの割り込みやタスクを横取りしないようにする
+    if (isRegistered() == false)
+    {
+      return nullptr;
+    }
+    return Internal::PointingSensorsClass::_interrupt_callbacks[_id];
+  }
+
+  void PointingSensor::setTaskHandle(TaskHandle_t task_handle)
+  {
+    if (isRegistered() == false)
+    {
+      return;
+    }
+    Internal::PointingSensorsClass::_task_handles[_id] = task_handle;
+  }
+
+  TaskHandle_t PointingSensor::getTaskHandle() const
+  {
+    if (isRegistered() == false)
+    {
+      return nullptr;
+    }
+    return Internal::PointingSensorsClass::_task_handles[_id];
+  }
+
+  void PointingSensor::notifyMotion()
+  {
+    if (isRegistered() && Internal::PointingSensorsClass::_motion_callback != nullptr)
+    {
+      Internal::PointingSensorsClass::_motion_callback(_id);
+    }
+  }
+
+  Internal::PointingSensorsClass PointingSensors;
+
+} // namespace hidpg
@@ -0,0 +1,105 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Arduino.h"
+#include "FreeRTOS.h"
+#include "PointingSensor_config.h"
+#include "task.h"
+
+namespace hidpg
+{
+
+  // ポインティングセンサーのドライバの共通部分
+  // 種類の違うセンサーを同じ表(PointingSensors)にIDで登録して、割り込みと読み出しを表から引く
+  class PointingSensor
+  {
+  public:
+    using motion_callback_t = void (*)(uint8_t id);
+
+    // モーション割り込みのタスク通知のビット、他のビットはドライバが自由に使える
+    static constexpr uint32_t MOTION_BIT = 0b01;
+
+    virtual void readDelta(int16_t *delta_x, int16_t *delta_y) = 0;
+    uint8_t getId() const { return _id; }
+
+  protected:
+    // IDが範囲外か既に使われていたら表には登録されない
+    // 登録されなかったセンサーは割り込みもタスクへの通知も使えないので、ドライバのstart()で失敗させる
+    PointingSensor(uint8_t id);
+
+    bool isRegistered() const;
+
+    // attachInterrupt()に渡す割り込み関数、setTaskHandle()したタスクにMOTION_BITを通知する
+    // 以下は登録されていなければ何もしないかnullptrを返す
+    voidFuncPtr getInterruptCallback() const;
+    void setTaskHandle(TaskHandle_t task_handle);
+    TaskHandle_t getTaskHandle() const;
+    // ドライバのタスクからモーションを知らせる
+    void notifyMotion();
+
+  private:
+    const uint8_t _id;
+  };
+
+  namespace Internal
+  {
+    // IDで登録されたポインティングセンサーの表
+    // HidEngineとは2行でつなげる
+    //   PointingSensors.setMotionCallback([](uint8_t id) { HidEngine.movePointer(PointingDeviceId{id}); });
+    //   HidEngine.setReadPointerDeltaCallback([](PointingDeviceId id, int16_t &x, int16_t &y) { PointingSensors.readDelta(id.value, x, y); });
+    class PointingSensorsClass
+    {
+    public:
+      // 全てのセンサーのモーションを1つのコールバックで受け取る
+      static void setMotionCallback(PointingSensor::motion_callback_t callback);
+      // 未登録のIDならnullptr
+      static PointingSensor *get(uint8_t id);
+      // HidEngine.setReadPointerDeltaCallback()からそのまま呼べる、未登録のIDなら0を返す
+      static void readDelta(uint8_t id, int16_t &delta_x, int16_t &delta_y);
+
+    private:
+      friend class hidpg::PointingSensor;
+
+      template <uint8_t ID>
+      static void interrupt_callback()
+      {
+        if (_task_handles[ID] != nullptr)
+        {
+          xTaskNotifyFromISR(_task_handles[ID], PointingSensor::MOTION_BIT, eSetBits, nullptr);
+        }
+      }
+
+      static const voidFuncPtr _interrupt_callbacks[];
+      static PointingSensor *_sensors[];
+      static TaskHandle_t _task_handles[];
+      static PointingSensor::motion_callback_t _motion_callback;
+    };
+
+  } // namespace Internal
+
+  extern Internal::PointingSensorsClass PointingSensors;
+
+} // namespace hidpg
@@ -0,0 +1,187 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // PowerStateMachineの計測値
+  struct PowerStats
+  {
+    // Restに入った回数
+    uint32_t rest_entries;
+    // wakeUp()でRestから起こした回数
+    uint32_t prewakes;
+    // Restに入ってからreturn_window_ms以内に動いた回数(その度にRunを保つ時間を延ばす)
+    uint32_t rest_misses;
+    // Restから起きてから最初に移動量を読めるまでの時間(μs)
+    uint32_t first_motion_delay_us_last;
+    uint32_t first_motion_delay_us_max;
+    uint64_t first_motion_delay_us_sum;
+    uint32_t first_motion_count;
+    // 現在のRunを保つ時間(ms)
+    uint32_t hold_ms;
+  };
+
+  // ポインティングセンサーをRunに保つかRestに入れて良いかを動きの履歴から決める
+  //
+  // 最後の動きからhold_ms動かなければRestに入れる
+  // Restに入ってすぐ(return_window_ms以内)に動いた時はhold_msを1.5倍に、
+  // そうでなければ1/8ずつ縮めて、使い方に合わせてRunを保つ時間を調整する
+  //
+  // 時刻は呼び出し側が引数で渡す
+  class PowerStateMachine
+  {
+  public:
+    enum class State : uint8_t
+    {
+      Run,
+      Rest,
+    };
+
+    // センサーにして欲しいこと
+    enum class Action : uint8_t
+    {
+      None,
+      EnterRun,
+      EnterRest,
+    };
+
+    PowerStateMachine(uint32_t hold_ms, uint32_t min_hold_ms, uint32_t max_hold_ms, uint32_t return_window_ms)
+        : _min_hold_ms(min_hold_ms), _max_hold_ms(max_hold_ms), _return_window_ms(return_window_ms),
+          _state(State::Run), _hold_ms(hold_ms), _last_activity_ms(0), _rest_entered_ms(0),
+          _woke_us(0), _waiting_first_motion(false), _stats()
+    {
+    }
+
+    // モーション割り込みがあった
+    Action onMotion(uint32_t now_ms, uint32_t now_us)
+    {
+      _last_activity_ms = now_ms;
+      if (_state == State::Run)
+      {
+        return Action::None;
+      }
+
+      if (now_ms - _rest_entered_ms < _return_window_ms)
+      {
+        _stats.rest_misses++;
+        uint32_t hold_ms = _hold_ms + _hold_ms / 2;
+        _hold_ms = (hold_ms < _max_hold_ms) ? hold_ms : _max_hold_ms;
+      }
+      else
+      {
+        uint32_t hold_ms = _hold_ms - _hold_ms / 8;
+        _hold_ms = (hold_ms > _min_hold_ms) ? hold_ms : _min_hold_ms;
+      }
+      return wake(now_us);
+    }
+
+    // 関連する入力(マウスボタン等)があったので動く前に起こしておく
+    Action onWakeUp(uint32_t now_ms, uint32_t now_us)
+    {
+      _last_activity_ms = now_ms;
+      if (_state == State::Run)
+      {
+        return Action::None;
+      }
+      _stats.prewakes++;
+      return wake(now_us);
+    }
+
+    // 0でない移動量を読んだ
+    void onDelta(uint32_t now_us)
+    {
+      if (_waiting_first_motion)
+      {
+        _waiting_first_motion = false;
+        uint32_t delay_us = now_us - _woke_us;
+        _stats.first_motion_delay_us_last = delay_us;
+        _stats.first_motion_delay_us_max = (delay_us > _stats.first_motion_delay_us_max) ? delay_us : _stats.first_motion_delay_us_max;
+        _stats.first_motion_delay_us_sum += delay_us;
+        _stats.first_motion_count++;
+      }
+    }
+
+    // timeUntilRest()の時間が経った
+    Action onTimeout(uint32_t now_ms)
+    {
+      if (_state == State::Rest || timeUntilRest(now_ms) != 0)
+      {
+        return Action::None;
+      }
+      _state = State::Rest;
+      _rest_entered_ms = now_ms;
+      _stats.rest_entries++;
+      return Action::EnterRest;
+    }
+
+    // Restに入れるまでの時間(ms)、既にRestならUINT32_MAX
+    uint32_t timeUntilRest(uint32_t now_ms) const
+    {
+      if (_state == State::Rest)
+      {
+        return UINT32_MAX;
+      }
+      uint32_t elapsed = now_ms - _last_activity_ms;
+      return (elapsed < _hold_ms) ? _hold_ms - elapsed : 0;
+    }
+
+    State state() const { return _state; }
+
+    PowerStats stats() const
+    {
+      PowerStats stats = _stats;
+      stats.hold_ms = _hold_ms;
+      return stats;
+    }
+
+    // 計測値だけをリセットする
+    void resetStats() { _stats = PowerStats(); }
+
+  private:
+    Action wake(uint32_t now_us)
+    {
+      _state = State::Run;
+      _woke_us = now_us;
+      _waiting_first_motion = true;
+      return Action::EnterRun;
+    }
+
+    const uint32_t _min_hold_ms;
+    const uint32_t _max_hold_ms;
+    const uint32_t _return_window_ms;
+    State _state;
+    uint32_t _hold_ms;
+    uint32_t _last_activity_ms;
+    uint32_t _rest_entered_ms;
+    uint32_t _woke_us;
+    bool _waiting_first_motion;
+    PowerStats _stats;
+  };
+
+} // namespace hidpg
@@ -0,0 +1,327 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+namespace hidpg
+{
+
+  // 0からN-1までの値が入るBitSet
+  // 32bitのワード単位でデータを持つので、メモリはNに比例し、集合演算はワード単位で行う
+  // 値の型はNが256以下ならuint8_t、それより大きければuint16_t
+  template <size_t N>
+  class BitSet
+  {
+    static_assert(N > 0 && N <= 65536, "N must be between 1 and 65536");
+
+  public:
+    using value_type = typename std::conditional<(N <= 256), uint8_t, uint16_t>::type;
+
+    static constexpr size_t CAPACITY = N;
+
+    BitSet() : _data(), _count(0)
+    {
+    }
+
+    bool add(value_type val)
+    {
+      if (val >= N)
+      {
+        return false;
+      }
+      uint32_t mask = 1UL << (val % 32);
+      uint32_t &word = _data[val / 32];
+      if (word & mask)
+      {
+        return false;
+      }
+
+      word |= mask;
+      _count++;
+      return true;
+    }
+
+    void addAll(const value_type vals[], size_t len)
+    {
+      for (size_t i = 0; i < len; i++)
+      {
+        add(vals[i]);
+      }
+    }
+
+    BitSet &operator|=(const BitSet &rhs)
+    {
+      _count = 0;
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        _data[i] |= rhs._data[i];
+        _count += __builtin_popcountl(_data[i]);
+      }
+      return *this;
+    }
+
+    bool remove(value_type val)
+    {
+      if (val >= N)
+      {
+        return false;
+      }
+      uint32_t mask = 1UL << (val % 32);
+      uint32_t &word = _data[val / 32];
+      if ((word & mask) == 0)
+      {
+        return false;
+      }
+
+      word &= ~mask;
+      _count--;
+      return true;
+    }
+
+    void removeAll(const value_type vals[], size_t len)
+    {
+      for (size_t i = 0; i < len; i++)
+      {
+        remove(vals[i]);
+      }
+    }
+
+    BitSet &operator-=(const BitSet &rhs)
+    {
+      _count = 0;
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        _data[i] &= ~(rhs._data[i]);
+        _count += __builtin_popcountl(_data[i]);
+      }
+      return *this;
+    }
+
+    BitSet &operator&=(const BitSet &rhs)
+    {
+      _count = 0;
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        _data[i] &= rhs._data[i];
+        _count += __builtin_popcountl(_data[i]);
+      }
+      return *this;
+    }
+
+    BitSet &operator^=(const BitSet &rhs)
+    {
+      _count = 0;
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        _data[i] ^= rhs._data[i];
+        _count += __builtin_popcountl(_data[i]);
+      }
+      return *this;
+    }
+
+    bool update(value_type val, bool b)
+    {
+      if (b)
+      {
+        return add(val);
+      }
+      else
+      {
+        return remove(val);
+      }
+    }
+
+    void clear()
+    {
+      memset(_data, 0, sizeof(_data));
+      _count = 0;
+    }
+
+    bool contains(value_type val) const
+    {
+      if (val >= N)
+      {
+        return false;
+      }
+      return (_data[val / 32] >> (val % 32)) & 1;
+    }
+
+    bool containsAll(const value_type vals[], size_t len) const
+    {
+      for (size_t i = 0; i < len; i++)
+      {
+        if (contains(vals[i]) == false)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool containsAny(const value_type vals[], size_t len) const
+    {
+      for (size_t i = 0; i < len; i++)
+      {
+        if (contains(vals[i]))
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // 共通の値があるか
+    bool intersects(const BitSet &other) const
+    {
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        if (_data[i] & other._data[i])
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // 値を小さい順にfunc(value_type)に渡す
+    // ワード毎に立っているビットだけをctzで取り出すので、要素数に比例したコストで済む
+    template <typename Func>
+    void for_each(Func func) const
+    {
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        forEachBit(_data[i], i, func);
+      }
+    }
+
+    // prevからcurで追加された値を全てon_addedに渡してから、削除された値をon_removedに渡す
+    // 差集合を作らずにワード毎の比較で求める
+    template <typename AddedFunc, typename RemovedFunc>
+    static void diff(const BitSet &prev, const BitSet &cur, AddedFunc on_added, RemovedFunc on_removed)
+    {
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        forEachBit(cur._data[i] & ~prev._data[i], i, on_added);
+      }
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        forEachBit(prev._data[i] & ~cur._data[i], i, on_removed);
+      }
+    }
+
+    void toArray(value_type buf[]) const
+    {
+      size_t buf_cnt = 0;
+      for_each([&](value_type val)
+               { buf[buf_cnt++] = val; });
+    }
+
+    size_t count() const
+    {
+      return _count;
+    }
+
+    // 比較
+    friend bool operator==(const BitSet &a, const BitSet &b)
+    {
+      if (a._count != b._count)
+      {
+        return false;
+      }
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        if (a._data[i] != b._data[i])
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    friend bool operator!=(const BitSet &a, const BitSet &b)
+    {
+      return !(a == b);
+    }
+
+    // 和集合
+    friend BitSet operator|(const BitSet &a, const BitSet &b)
+    {
+      BitSet result = a;
+      result |= b;
+      return result;
+    }
+
+    // 差集合
+    friend BitSet operator-(const BitSet &a, const BitSet &b)
+    {
+      BitSet result = a;
+      result -= b;
+      return result;
+    }
+
+    // 積集合
+    friend BitSet operator&(const BitSet &a, const BitSet &b)
+    {
+      BitSet result = a;
+      result &= b;
+      return result;
+    }
+
+    // 対称差
+    friend BitSet operator^(const BitSet &a, const BitSet &b)
+    {
+      BitSet result = a;
+      result ^= b;
+      return result;
+    }
+
+    friend BitSet symmetric_difference(const BitSet &a, const BitSet &b)
+    {
+      return a ^ b;
+    }
+
+  private:
+    static constexpr size_t WORDS = (N + 31) / 32;
+
+    template <typename Func>
+    static void forEachBit(uint32_t word, size_t word_index, Func &func)
+    {
+      while (word != 0)
+      {
+        int bit = __builtin_ctz(word);
+        word &= word - 1;
+        func(static_cast<value_type>(word_index * 32 + bit));
+      }
+    }
+
+    uint32_t _data[WORDS];
+    size_t _count;
+  };
+
+} // namespace hidpg
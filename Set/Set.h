@@ -24,53 +24,16 @@
 
 #pragma once
 
-#include <stddef.h>
-#include <stdint.h>
+#include "BitSet.h"
+#include "Set_config.h"
 
 namespace hidpg
 {
 
-  // 0から255の値が入るBitSet
-  class Set
-  {
-    friend bool operator==(const Set &a, const Set &b);
-    friend Set operator|(const Set &a, const Set &b);
-    friend Set operator-(const Set &a, const Set &b);
+  // キーIDのBitSet
+  using Set = BitSet<SET_CAPACITY>;
 
-  public:
-    Set();
-
-    bool add(uint8_t val);
-    void addAll(const uint8_t vals[], size_t len);
-    Set &operator|=(const Set &rhs);
-
-    bool remove(uint8_t val);
-    void removeAll(const uint8_t vals[], size_t len);
-    Set &operator-=(const Set &rhs);
-
-    bool update(uint8_t val, bool b);
-
-    void clear();
-
-    bool contains(uint8_t val) const;
-    bool containsAll(const uint8_t vals[], size_t len) const;
-    bool containsAny(const uint8_t vals[], size_t len) const;
-
-    void toArray(uint8_t buf[]) const;
-    uint16_t count() const;
-
-  private:
-    // 8 * 32 = 256
-    uint8_t _data[32];
-    uint16_t _count;
-  };
-
-  // 比較
-  bool operator==(const Set &a, const Set &b);
-  bool operator!=(const Set &a, const Set &b);
-  // 和集合
-  Set operator|(const Set &a, const Set &b);
-  // 差集合
-  Set operator-(const Set &a, const Set &b);
+  // キーIDの型
+  using key_id_t = Set::value_type;
 
 } // namespace hidpg
@@ -0,0 +1,301 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "ShiftRegisterMatrixScan.h"
+
+#define pdMS_TO_TICKS_DOUBLE(xTimeInMs) ((double)(((double)(xTimeInMs) * (double)configTICK_RATE_HZ) / (double)1000))
+
+namespace hidpg
+{
+  namespace Internal
+  {
+
+    // 74HC595/74HC165はどちらもクロックの立ち上がりでシフトする
+    static SPIDevice SpiDevice(SPISettings(SHIFT_REGISTER_MATRIX_SCAN_SPI_FREQUENCY, MSBFIRST, SPI_MODE0));
+
+    // gnu++11のstd::maxはconstexprではない
+    static constexpr uint8_t MAX_TRANSFER_LEN = ((ShiftRegisterMatrixScanClass::MAX_ROWS > ShiftRegisterMatrixScanClass::MAX_COLS) ? ShiftRegisterMatrixScanClass::MAX_ROWS : ShiftRegisterMatrixScanClass::MAX_COLS) / 8;
+
+    ShiftRegisterMatrixScanClass::callback_t ShiftRegisterMatrixScanClass::_callback = nullptr;
+    TickType_t ShiftRegisterMatrixScanClass::_polling_interval_ticks = 1;
+    TickType_t ShiftRegisterMatrixScanClass::_idle_polling_interval_ticks = 1;
+    const Switch *ShiftRegisterMatrixScanClass::_switches = nullptr;
+    uint8_t ShiftRegisterMatrixScanClass::_rows_len = 0;
+    uint8_t ShiftRegisterMatrixScanClass::_cols_len = 0;
+    uint8_t ShiftRegisterMatrixScanClass::_row_bytes = 0;
+    uint8_t ShiftRegisterMatrixScanClass::_col_bytes = 0;
+    uint8_t ShiftRegisterMatrixScanClass::_transfer_len = 0;
+    VerticalCounter *ShiftRegisterMatrixScanClass::_rows = nullptr;
+    uint32_t *ShiftRegisterMatrixScanClass::_row_masks = nullptr;
+    uint8_t ShiftRegisterMatrixScanClass::_cs_pin = 0;
+    uint8_t ShiftRegisterMatrixScanClass::_latch_pin = 0;
+    uint8_t ShiftRegisterMatrixScanClass::_load_pin = 0;
+    ThreadSafeSPIClass *ShiftRegisterMatrixScanClass::_spi = nullptr;
+    uint8_t ShiftRegisterMatrixScanClass::_tx_buf[MAX_TRANSFER_LEN];
+    uint8_t ShiftRegisterMatrixScanClass::_rx_buf[MAX_TRANSFER_LEN];
+
+    TaskHandle_t ShiftRegisterMatrixScanClass::_task_handle = nullptr;
+    StackType_t ShiftRegisterMatrixScanClass::_task_stack[SHIFT_REGISTER_MATRIX_SCAN_TASK_STACK_SIZE];
+    StaticTask_t ShiftRegisterMatrixScanClass::_task_tcb;
+    volatile bool ShiftRegisterMatrixScanClass::_stop_requested = false;
+    SemaphoreHandle_t ShiftRegisterMatrixScanClass::_stopped_sem = nullptr;
+    StaticSemaphore_t ShiftRegisterMatrixScanClass::_stopped_sem_buf;
+
+    void ShiftRegisterMatrixScanClass::setCallback(callback_t callback)
+    {
+      _callback = callback;
+    }
+
+    // 動作中に呼んでも何もしない、設定を変えるならstop()してから呼ぶ
+    void ShiftRegisterMatrixScanClass::start()
+    {
+      // スキャン中に行の閾値を書き換えたり、余分な通知で次のstop()後に勝手に再開したりしないようにする
+      if (_task_handle != nullptr && _stop_requested == false)
+      {
+        return;
+      }
+
+      // 165はSH/LDがHIGHかつCLK INHがLOWの間シフト、595はRCLKの立ち上がりでラッチ
+      pinMode(_cs_pin, OUTPUT);
+      digitalWrite(_cs_pin, HIGH);
+      pinMode(_load_pin, OUTPUT);
+      digitalWrite(_load_pin, HIGH);
+      pinMode(_latch_pin, OUTPUT);
+      digitalWrite(_latch_pin, LOW);
+
+      _spi->begin();
+
+      // チェーンの長い方に合わせて転送する
+      // 595側は余分な先頭のバイトがチェーンから押し出され、165側は余分な末尾のバイトを無視する
+      _row_bytes = (_rows_len + 7) / 8;
+      _col_bytes = (_cols_len + 7) / 8;
+      _transfer_len = max(_row_bytes, _col_bytes);
+
+      uint16_t max_debounce_delay_ms = 0;
+      for (int i = 0; i < _rows_len * _cols_len; i++)
+      {
+        const Switch &sw = _switches[i];
+        if (sw.isValid())
+        {
+          max_debounce_delay_ms = max(max_debounce_delay_ms, max(sw.getPressDebounceDelay(), sw.getReleaseDebounceDelay()));
+        }
+      }
+
+      // デバウンスはポーリング毎のサンプルを数えて行うので、debounce_delayの最大値がサンプル数の上限に収まる間隔にする
+      _polling_interval_ticks = max(pdMS_TO_TICKS(MATRIX_SCAN_POLLING_INTERVAL_MS), (TickType_t)1);
+      _polling_interval_ticks = max(_polling_interval_ticks, (TickType_t)ceil(pdMS_TO_TICKS_DOUBLE(max_debounce_delay_ms) / VerticalCounter::MAX_THRESHOLD));
+      _idle_polling_interval_ticks = max(pdMS_TO_TICKS(SHIFT_REGISTER_MATRIX_SCAN_IDLE_POLLING_INTERVAL_MS), _polling_interval_ticks);
+
+      // スイッチが存在するセルのマスクを作り、スイッチ毎の閾値を設定する
+      for (int r = 0; r < _rows_len; r++)
+      {
+        _row_masks[r] = 0;
+        for (int c = 0; c < _cols_len; c++)
+        {
+          const Switch &sw = _switches[r * _cols_len + c];
+          if (sw.isValid() == false)
+          {
+            continue;
+          }
+          _row_masks[r] |= 1UL << c;
+          _rows[r].configure(c,
+                             debounceDelayToSamples(sw.getPressDebounceDelay()),
+                             debounceDelayToSamples(sw.getReleaseDebounceDelay()),
+                             sw.getDebounceMode() == DebounceMode::Eager);
+        }
+      }
+
+      _stop_requested = false;
+      if (_task_handle == nullptr)
+      {
+        _stopped_sem = xSemaphoreCreateBinaryStatic(&_stopped_sem_buf);
+        _task_handle = xTaskCreateStatic(task, "SRMatrixScan", SHIFT_REGISTER_MATRIX_SCAN_TASK_STACK_SIZE, nullptr, SHIFT_REGISTER_MATRIX_SCAN_TASK_PRIO, _task_stack, &_task_tcb);
+      }
+      else
+      {
+        // stop()が止まったのを確認したタスクだけを再開する
+        xTaskNotifyGive(_task_handle);
+      }
+    }
+
+    // スキャンを止めて全行を非アクティブにする
+    // タスクはスキャンの合間に止まるので、SPIバスを持ったまま止まることはない
+    // 止まるまで最大でアイドル時のポーリング間隔待つ、スキャンタスク(コールバック)からは呼ばないこと
+    void ShiftRegisterMatrixScanClass::stop()
+    {
+      if (_task_handle != nullptr && _stop_requested == false)
+      {
+        _stop_requested = true;
+        xSemaphoreTake(_stopped_sem, portMAX_DELAY);
+      }
+
+      setRowPattern(-1);
+      transferRowOnBus();
+    }
+
+    // debounce_delayをポーリングのサンプル数に変換する
+    uint8_t ShiftRegisterMatrixScanClass::debounceDelayToSamples(uint16_t debounce_delay_ms)
+    {
+      uint32_t samples = ceil(pdMS_TO_TICKS_DOUBLE(debounce_delay_ms) / _polling_interval_ticks);
+      return constrain(samples, 1, VerticalCounter::MAX_THRESHOLD);
+    }
+
+    // rowの行だけをアクティブにする595のパターンを送信バッファに作る、範囲外なら全行非アクティブ
+    // 最後に送ったバイトがMCUに一番近い595に入る
+    void ShiftRegisterMatrixScanClass::setRowPattern(int row)
+    {
+      memset(_tx_buf, MATRIX_SCAN_ACTIVE_STATE ? 0x00 : 0xff, _transfer_len);
+      if (0 <= row && row < _rows_len)
+      {
+        uint8_t &pattern = _tx_buf[_transfer_len - 1 - row / 8];
+        pattern ^= 1 << (row % 8);
+      }
+    }
+
+    // 送信バッファの行パターンを送りつつ165にロードされている列を受信し、595の出力を更新する
+    // バスを持っている間に呼ぶ、ラッチまでにバスを空けると他のデバイスの転送が595に入ってしまう
+    void ShiftRegisterMatrixScanClass::transferRow()
+    {
+      digitalWrite(_cs_pin, LOW);
+      _spi->transfer(_tx_buf, _rx_buf, _transfer_len);
+      digitalWrite(_cs_pin, HIGH);
+      pulse(_latch_pin, LOW);
+    }
+
+    // 165のロードからラッチまでを1回のトランザクションで行う
+    void ShiftRegisterMatrixScanClass::transferRowOnBus()
+    {
+      _spi->beginTransaction(SpiDevice);
+      pulse(_load_pin, HIGH);
+      transferRow();
+      _spi->endTransaction();
+    }
+
+    // 受信バッファから押されているスイッチのビットを1にして返す
+    // 最初に受信したバイトがMCUに一番近い165
+    uint32_t ShiftRegisterMatrixScanClass::readCols()
+    {
+      uint32_t cols = 0;
+      for (int i = 0; i < _col_bytes; i++)
+      {
+        cols |= static_cast<uint32_t>(_rx_buf[i]) << (i * 8);
+      }
+#if (MATRIX_SCAN_ACTIVE_STATE == LOW)
+      cols = ~cols;
+#endif
+      return cols;
+    }
+
+    void ShiftRegisterMatrixScanClass::pulse(uint8_t pin, int idle)
+    {
+      digitalWrite(pin, !idle);
+      digitalWrite(pin, idle);
+    }
+
+    // 1行分デバウンスし、確定状態が変化したスイッチだけIDを更新する
+    void ShiftRegisterMatrixScanClass::updateRow(int row, uint32_t cols, Set &ids)
+    {
+      uint32_t changed = _rows[row].update(cols);
+      while (changed != 0)
+      {
+        int c = __builtin_ctz(changed);
+        changed &= changed - 1;
+
+        key_id_t id = _switches[row * _cols_len + c].getId();
+        if (bitRead(_rows[row].state(), c))
+        {
+          ids.add(id);
+        }
+        else
+        {
+          ids.remove(id);
+        }
+      }
+    }
+
+    // 全行をスキャンする
+    // 戻り値は押されている、またはデバウンス中のスイッチがあるか
+    bool ShiftRegisterMatrixScanClass::scan(Set &ids)
+    {
+      bool is_busy = false;
+
+      // 最初の行を選択
+      setRowPattern(0);
+      transferRowOnBus();
+
+      // 行rの列をロードして、行r+1のパターンを送るのと同時に行rの列を受信する
+      // 最後の行の後は全行非アクティブにして終わる
+      // 選択の待ち時間とデバウンスの間はバスを空けておく
+      for (int r = 0; r < _rows_len; r++)
+      {
+#if (MATRIX_SCAN_SELECT_DELAY_US > 0)
+        delayMicroseconds(MATRIX_SCAN_SELECT_DELAY_US);
+#endif
+        setRowPattern(r + 1);
+        transferRowOnBus();
+
+        updateRow(r, readCols() & _row_masks[r], ids);
+        is_busy |= (_rows[r].state() | _rows[r].pending()) != 0;
+      }
+
+      return is_busy;
+    }
+
+    void ShiftRegisterMatrixScanClass::task(void *pvParameters)
+    {
+      Set ids, prev_ids;
+      TickType_t last_wake_time = xTaskGetTickCount();
+
+      while (true)
+      {
+        if (_stop_requested)
+        {
+          // stop()に止まったことを知らせて、start()で再開されるまで待つ
+          xSemaphoreGive(_stopped_sem);
+          ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+          last_wake_time = xTaskGetTickCount();
+        }
+
+        bool is_busy = scan(ids);
+
+        // 更新してたらコールバック関数を発火
+        if (ids != prev_ids)
+        {
+          if (_callback != nullptr)
+          {
+            _callback(ids);
+          }
+          prev_ids = ids;
+        }
+
+        // 押されている、またはデバウンス中のスイッチがある間はデバウンスのサンプリング間隔でスキャンする
+        vTaskDelayUntil(&last_wake_time, is_busy ? _polling_interval_ticks : _idle_polling_interval_ticks);
+      }
+    }
+
+  } // namespace Internal
+
+  Internal::ShiftRegisterMatrixScanClass ShiftRegisterMatrixScan;
+
+} // namespace hidpg
@@ -0,0 +1,150 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Arduino.h"
+#include "FreeRTOS.h"
+#include "Set.h"
+#include "ShiftRegisterMatrixScan_config.h"
+#include "Switch.h"
+#include "ThreadSafeSPI.h"
+#include "VerticalCounter.h"
+#include "semphr.h"
+#include "task.h"
+
+namespace hidpg
+{
+  namespace Internal
+  {
+
+    // 74HC595のチェーンで行を選択し、74HC165のチェーンで列を読むマトリックススキャン
+    // GPIOのピン数に関係なく最大64行 x 32列のスイッチを扱える
+    //
+    // 配線
+    //   SCK  -> 595のSRCLK, 165のCLK
+    //   MOSI -> 595のSER (MCUに近い595から順にQH'を次のSERへ)
+    //   MISO <- 74HC125 <- 165のQH  (MCUに近い165から順にSERを前のQHへ)
+    //   cs_pin    -> 165のCLK INH, 74HC125の/OE
+    //   latch_pin -> 595のRCLK
+    //   load_pin  -> 165のSH/LD
+    //
+    // SPIバスは他のデバイス(PMW3360DM等)と共有できる
+    // cs_pinがHIGHの間は165が他のデバイスのSCKでシフトせず、165のQHは74HC125でMISOから切り離される
+    // 595は他のデバイスの転送でもシフトするが、出力はRCLKでしか変わらず、ラッチの前に必ず全行分を送り直すので影響しない
+    //
+    // 行rはMCUに近い側から数えてr/8番目の595のQ(r%8)、列cはMCUに近い側から数えてc/8番目の165のD(c%8)
+    //
+    // 1行毎にバスを取って「165のロード、次の行のパターンの送信と現在の行の列の受信、595のラッチ」を行う
+    // 行の合間はバスを空けるので、大きな行列でもMotionプライオリティのセンサーは1行分しか待たない
+    // 送受信は1回のバースト転送(nRF52ではEasyDMA)なので1行あたりのCPUの処理はほぼ一定
+    class ShiftRegisterMatrixScanClass
+    {
+    public:
+      using callback_t = void (*)(const Set &switch_ids);
+
+      static constexpr uint8_t MAX_ROWS = 64;
+      static constexpr uint8_t MAX_COLS = 32;
+
+      // 連続したSwitchのテーブルをそのまま使う、constexprで定義すればフラッシュに置かれる
+      // IDの重複をコンパイル時にチェックする場合はSHIFT_REGISTER_MATRIX_SCAN_SET_MATRIXを使う
+      template <uint8_t rows_len, uint8_t cols_len>
+      static void setMatrix(const Switch (&matrix)[rows_len][cols_len], uint8_t cs_pin, uint8_t latch_pin, uint8_t load_pin, ThreadSafeSPIClass &spi = ThreadSafeSPI)
+      {
+        static_assert(rows_len <= MAX_ROWS, "rows_len must be 64 or less");
+        // 1行分の入力を32bitのワードで扱う
+        static_assert(cols_len <= MAX_COLS, "cols_len must be 32 or less");
+
+        static VerticalCounter rows[rows_len];
+        static uint32_t row_masks[rows_len];
+
+        _rows_len = rows_len;
+        _cols_len = cols_len;
+        _switches = &matrix[0][0];
+        _rows = rows;
+        _row_masks = row_masks;
+        _cs_pin = cs_pin;
+        _latch_pin = latch_pin;
+        _load_pin = load_pin;
+        _spi = &spi;
+      }
+
+      static void start();
+      static void stop();
+      static void setCallback(callback_t callback);
+
+    private:
+      static void setRowPattern(int row);
+      static void transferRow();
+      static void transferRowOnBus();
+      static uint32_t readCols();
+      static void pulse(uint8_t pin, int idle);
+      static uint8_t debounceDelayToSamples(uint16_t debounce_delay_ms);
+      static void updateRow(int row, uint32_t cols, Set &ids);
+      static bool scan(Set &ids);
+      static void task(void *pvParameters);
+
+      static callback_t _callback;
+      static TickType_t _polling_interval_ticks;
+      static TickType_t _idle_polling_interval_ticks;
+      static const Switch *_switches;
+      static uint8_t _rows_len;
+      static uint8_t _cols_len;
+      static uint8_t _row_bytes;
+      static uint8_t _col_bytes;
+      static uint8_t _transfer_len;
+      static VerticalCounter *_rows;
+      static uint32_t *_row_masks;
+      static uint8_t _cs_pin;
+      static uint8_t _latch_pin;
+      static uint8_t _load_pin;
+      static ThreadSafeSPIClass *_spi;
+      static uint8_t _tx_buf[];
+      static uint8_t _rx_buf[];
+
+      static TaskHandle_t _task_handle;
+      static StackType_t _task_stack[];
+      static StaticTask_t _task_tcb;
+      static volatile bool _stop_requested;
+      static SemaphoreHandle_t _stopped_sem;
+      static StaticSemaphore_t _stopped_sem_buf;
+    };
+
+  } // namespace Internal
+
+  extern Internal::ShiftRegisterMatrixScanClass ShiftRegisterMatrixScan;
+
+// constexprな行列をIDの重複をコンパイル時にチェックしてからセットする
+//
+// 使用例
+//   constexpr Switch matrix[8][16] = { ... };
+//   SHIFT_REGISTER_MATRIX_SCAN_SET_MATRIX(matrix, cs_pin, latch_pin, load_pin);
+#define SHIFT_REGISTER_MATRIX_SCAN_SET_MATRIX(matrix, cs_pin, latch_pin, load_pin)                         \
+  do                                                                                                      \
+  {                                                                                                       \
+    static_assert(hidpg::Internal::hasUniqueSwitchIds(matrix), "Switch ids in the matrix must be unique"); \
+    hidpg::ShiftRegisterMatrixScan.setMatrix(matrix, cs_pin, latch_pin, load_pin);                         \
+  } while (0)
+
+} // namespace hidpg
@@ -0,0 +1,50 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "MatrixScan_config.h"
+
+// SPIのクロック周波数
+// 74HC165/74HC595は3.3Vで数十MHzまで動くが、配線が長い場合は下げる
+#ifndef SHIFT_REGISTER_MATRIX_SCAN_SPI_FREQUENCY
+#define SHIFT_REGISTER_MATRIX_SCAN_SPI_FREQUENCY 8000000
+#endif
+
+// スイッチが1つも押されていない(デバウンス中でもない)ときのスキャンの間隔
+// シフトレジスタ経由では入力ピンの割り込みが使えないので常にポーリングする
+// 大きくすると消費電流は減るが、最初の押下の検出が最大でこの時間だけ遅れる
+#ifndef SHIFT_REGISTER_MATRIX_SCAN_IDLE_POLLING_INTERVAL_MS
+#define SHIFT_REGISTER_MATRIX_SCAN_IDLE_POLLING_INTERVAL_MS MATRIX_SCAN_POLLING_INTERVAL_MS
+#endif
+
+// ShiftRegisterMatrixScanタスクのスタックサイズ
+#ifndef SHIFT_REGISTER_MATRIX_SCAN_TASK_STACK_SIZE
+#define SHIFT_REGISTER_MATRIX_SCAN_TASK_STACK_SIZE 128
+#endif
+
+// ShiftRegisterMatrixScanタスクのプライオリティ
+#ifndef SHIFT_REGISTER_MATRIX_SCAN_TASK_PRIO
+#define SHIFT_REGISTER_MATRIX_SCAN_TASK_PRIO 1
+#endif
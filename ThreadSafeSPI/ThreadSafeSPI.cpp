@@ -27,7 +27,34 @@
 namespace hidpg
 {
 
-  ThreadSafeSPIClass::ThreadSafeSPIClass(SPIClass &spi) : _spi(spi), _initialized(false)
+  //------------------------------------------------------------------+
+  // SPIDevice
+  //------------------------------------------------------------------+
+  SPIDevice::SPIDevice(const SPISettings &settings, Priority priority)
+      : _settings(settings), _priority(priority), _stats(), _begin_us(0)
+  {
+  }
+
+  SPIDevice::Stats SPIDevice::getStats()
+  {
+    taskENTER_CRITICAL();
+    Stats stats = _stats;
+    taskEXIT_CRITICAL();
+    return stats;
+  }
+
+  void SPIDevice::resetStats()
+  {
+    taskENTER_CRITICAL();
+    _stats = Stats();
+    taskEXIT_CRITICAL();
+  }
+
+  //------------------------------------------------------------------+
+  // ThreadSafeSPIClass
+  //------------------------------------------------------------------+
+  ThreadSafeSPIClass::ThreadSafeSPIClass(SPIClass &spi)
+      : _spi(spi), _initialized(false), _waitings(), _current_device(nullptr), _task_handle(nullptr)
   {
   }
 
@@ -36,7 +63,13 @@ namespace hidpg
     if (_initialized == false)
     {
       _spi.begin();
-      _mutex = xSemaphoreCreateMutex();
+      _bus_mutex = xSemaphoreCreateMutexStatic(&_bus_mutex_buffer);
+      for (uint8_t i = 0; i < PRIORITY_COUNT; i++)
+      {
+        _grants[i] = xSemaphoreCreateBinaryStatic(&_grant_buffers[i]);
+      }
+      _queue = xQueueCreateStatic(THREAD_SAFE_SPI_ASYNC_QUEUE_SIZE, sizeof(AsyncTransfer), _queue_storage, &_queue_buffer);
+      _task_handle = xTaskCreateStatic(task, "SPI", THREAD_SAFE_SPI_TASK_STACK_SIZE, this, THREAD_SAFE_SPI_TASK_PRIO, _task_stack, &_task_tcb);
       _initialized = true;
     }
   }
@@ -45,8 +78,14 @@ namespace hidpg
   {
     if (_initialized)
     {
+      vTaskDelete(_task_handle);
       _spi.end();
-      vSemaphoreDelete(_mutex);
+      vSemaphoreDelete(_bus_mutex);
+      for (uint8_t i = 0; i < PRIORITY_COUNT; i++)
+      {
+        vSemaphoreDelete(_grants[i]);
+      }
+      vQueueDelete(_queue);
       _initialized = false;
     }
   }
@@ -56,16 +95,122 @@ namespace hidpg
     _spi.usingInterrupt(interruptNumber);
   }
 
+  // クリティカルセクションの中で呼ぶ
+  bool ThreadSafeSPIClass::isWaitingAbove(uint8_t priority)
+  {
+    for (uint8_t i = priority + 1; i < PRIORITY_COUNT; i++)
+    {
+      if (_waitings[i] > 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void ThreadSafeSPIClass::acquire(uint8_t priority)
+  {
+    taskENTER_CRITICAL();
+    _waitings[priority]++;
+    taskEXIT_CRITICAL();
+
+    while (true)
+    {
+      taskENTER_CRITICAL();
+      bool gated = isWaitingAbove(priority);
+      taskEXIT_CRITICAL();
+
+      if (gated)
+      {
+        // 高い方が全部バスを取ったらrelease()が起こしてくれる、余分に起こされても調べ直すだけ
+        xSemaphoreTake(_grants[priority], portMAX_DELAY);
+        continue;
+      }
+
+      // ここで待つ間はバスを持っているタスクがこのタスクのプライオリティを継承する
+      xSemaphoreTake(_bus_mutex, portMAX_DELAY);
+
+      taskENTER_CRITICAL();
+      gated = isWaitingAbove(priority);
+      if (gated == false)
+      {
+        _waitings[priority]--;
+      }
+      taskEXIT_CRITICAL();
+
+      if (gated == false)
+      {
+        return;
+      }
+      // _bus_mutexで待っている間に高い方が来たので譲る
+      xSemaphoreGive(_bus_mutex);
+    }
+  }
+
+  void ThreadSafeSPIClass::release()
+  {
+    xSemaphoreGive(_bus_mutex);
+
+    // 待っている中で一番高いプライオリティを起こす、_bus_mutexで待っていれば空振りになる
+    taskENTER_CRITICAL();
+    int highest = -1;
+    for (int i = PRIORITY_COUNT - 1; i >= 0; i--)
+    {
+      if (_waitings[i] > 0)
+      {
+        highest = i;
+        break;
+      }
+    }
+    taskEXIT_CRITICAL();
+
+    if (highest >= 0)
+    {
+      xSemaphoreGive(_grants[highest]);
+    }
+  }
+
   void ThreadSafeSPIClass::beginTransaction(SPISettings &settings)
   {
-    xSemaphoreTake(_mutex, portMAX_DELAY);
+    acquire(static_cast<uint8_t>(SPIDevice::Priority::Normal));
+    _current_device = nullptr;
     _spi.beginTransaction(settings);
   }
 
+  void ThreadSafeSPIClass::beginTransaction(SPIDevice &device)
+  {
+    uint32_t wait_start = micros();
+    acquire(static_cast<uint8_t>(device._priority));
+    uint32_t now = micros();
+
+    uint32_t wait_us = now - wait_start;
+    taskENTER_CRITICAL();
+    device._stats.wait_us += wait_us;
+    device._stats.max_wait_us = max(device._stats.max_wait_us, wait_us);
+    taskEXIT_CRITICAL();
+    device._begin_us = now;
+
+    _current_device = &device;
+    _spi.beginTransaction(device._settings);
+  }
+
   void ThreadSafeSPIClass::endTransaction()
   {
     _spi.endTransaction();
-    xSemaphoreGive(_mutex);
+
+    SPIDevice *device = _current_device;
+    if (device != nullptr)
+    {
+      uint32_t busy_us = micros() - device->_begin_us;
+      taskENTER_CRITICAL();
+      device->_stats.transactions++;
+      device->_stats.busy_us += busy_us;
+      device->_stats.max_busy_us = max(device->_stats.max_busy_us, busy_us);
+      taskEXIT_CRITICAL();
+      _current_device = nullptr;
+    }
+
+    release();
   }
 
   uint8_t ThreadSafeSPIClass::transfer(uint8_t data)
@@ -83,6 +228,49 @@ namespace hidpg
     _spi.transfer(buf, count);
   }
 
+  void ThreadSafeSPIClass::transfer(const void *tx_buf, void *rx_buf, size_t count)
+  {
+#ifdef ARDUINO_ARCH_NRF52
+    _spi.transfer(tx_buf, rx_buf, count);
+#else
+    memcpy(rx_buf, tx_buf, count);
+    _spi.transfer(rx_buf, count);
+#endif
+  }
+
+  bool ThreadSafeSPIClass::transferAsync(SPIDevice &device, uint8_t cs_pin, const void *tx_buf, void *rx_buf, size_t count,
+                                         async_callback_t callback, void *context)
+  {
+    if (_initialized == false)
+    {
+      return false;
+    }
+    AsyncTransfer transfer{&device, tx_buf, rx_buf, count, callback, context, cs_pin};
+    return xQueueSend(_queue, &transfer, 0) == pdTRUE;
+  }
+
+  void ThreadSafeSPIClass::task(void *pvParameters)
+  {
+    ThreadSafeSPIClass *that = static_cast<ThreadSafeSPIClass *>(pvParameters);
+
+    while (true)
+    {
+      AsyncTransfer transfer;
+      xQueueReceive(that->_queue, &transfer, portMAX_DELAY);
+
+      that->beginTransaction(*transfer.device);
+      digitalWrite(transfer.cs_pin, LOW);
+      that->transfer(transfer.tx_buf, transfer.rx_buf, transfer.count);
+      digitalWrite(transfer.cs_pin, HIGH);
+      that->endTransaction();
+
+      if (transfer.callback != nullptr)
+      {
+        transfer.callback(transfer.context);
+      }
+    }
+  }
+
   ThreadSafeSPIClass ThreadSafeSPI(SPI);
 
 } // namespace hidpg
@@ -27,28 +27,118 @@
 #include "Arduino.h"
 #include "SPI.h"
 #include "FreeRTOS.h"
+#include "queue.h"
 #include "semphr.h"
+#include "ThreadSafeSPI_config.h"
 
 namespace hidpg
 {
 
+  // バスを使うデバイス毎のSPISettingsとプライオリティ、バスの使用時間の統計
+  // ドライバ毎(センサーならインスタンス毎)に1つ作っておく
+  class SPIDevice
+  {
+  public:
+    // バスが空いた時に待っているトランザクションの中から高い方を先に始める
+    // 同じプライオリティの中ではFreeRTOSのタスクのプライオリティが高い順、同じなら待ち始めた順
+    // 始まっているトランザクションを中断することはない
+    // バスを持っているタスクは一番高いプライオリティで待っているタスクのプライオリティを継承する
+    enum class Priority : uint8_t
+    {
+      Bulk,   // ディスプレイやフラッシュ等の大きな転送
+      Normal, // その他
+      Motion, // ポインティングデバイスの移動量の読み出し等、遅れると困るもの
+    };
+
+    struct Stats
+    {
+      uint32_t transactions;
+      // beginTransaction()してからendTransaction()するまでの時間(μs)
+      uint64_t busy_us;
+      uint32_t max_busy_us;
+      // beginTransaction()でバスが空くのを待った時間(μs)
+      uint64_t wait_us;
+      uint32_t max_wait_us;
+    };
+
+    SPIDevice(const SPISettings &settings, Priority priority = Priority::Normal);
+    Stats getStats();
+    void resetStats();
+
+  private:
+    friend class ThreadSafeSPIClass;
+
+    SPISettings _settings;
+    const Priority _priority;
+    Stats _stats;
+    uint32_t _begin_us;
+  };
+
   class ThreadSafeSPIClass
   {
   public:
+    // transferAsync()の転送が終わった時にタスクから呼ばれる
+    using async_callback_t = void (*)(void *context);
+
     ThreadSafeSPIClass(SPIClass &spi);
     void begin();
     void end();
     void usingInterrupt(int interruptNumber);
+    // Priority::NormalでSPIDeviceを使わない場合と同じ、統計は取らない
     void beginTransaction(SPISettings &settings);
+    void beginTransaction(SPIDevice &device);
     void endTransaction();
     uint8_t transfer(uint8_t data);
     uint16_t transfer16(uint16_t data);
     void transfer(void *buf, size_t count);
+    // 送信と受信を別々のバッファで1回のバースト転送として行う
+    // nRF52ではSPIMのEasyDMAで転送される
+    void transfer(const void *tx_buf, void *rx_buf, size_t count);
+    // cs_pinをLOWにしてtx_bufを送りrx_bufに受信する転送をキューに入れてすぐに戻る
+    // 転送は専用のタスクがdeviceのプライオリティでバスを取って行い、終わったらcallbackを呼ぶ
+    // バッファは終わるまで触らないこと、begin()の前かキューが一杯ならfalseを返す
+    bool transferAsync(SPIDevice &device, uint8_t cs_pin, const void *tx_buf, void *rx_buf, size_t count,
+                       async_callback_t callback = nullptr, void *context = nullptr);
 
   private:
+    static constexpr uint8_t PRIORITY_COUNT = 3;
+
+    struct AsyncTransfer
+    {
+      SPIDevice *device;
+      const void *tx_buf;
+      void *rx_buf;
+      size_t count;
+      async_callback_t callback;
+      void *context;
+      uint8_t cs_pin;
+    };
+
+    static void task(void *pvParameters);
+
+    void acquire(uint8_t priority);
+    void release();
+    bool isWaitingAbove(uint8_t priority);
+
     SPIClass &_spi;
-    SemaphoreHandle_t _mutex;
     bool _initialized;
+    // バスの調停
+    // バスを持っているタスクが_bus_mutexを持つので、_bus_mutexで待っているタスクのプライオリティを継承する
+    // より高いプライオリティのトランザクションが待っている間は_bus_mutexで待たずに_grantsで待つ
+    // _waitingsはクリティカルセクションで読み書きする
+    SemaphoreHandle_t _bus_mutex;
+    StaticSemaphore_t _bus_mutex_buffer;
+    uint8_t _waitings[PRIORITY_COUNT];
+    SemaphoreHandle_t _grants[PRIORITY_COUNT];
+    StaticSemaphore_t _grant_buffers[PRIORITY_COUNT];
+    SPIDevice *_current_device;
+    // transferAsync()
+    QueueHandle_t _queue;
+    StaticQueue_t _queue_buffer;
+    uint8_t _queue_storage[THREAD_SAFE_SPI_ASYNC_QUEUE_SIZE * sizeof(AsyncTransfer)];
+    TaskHandle_t _task_handle;
+    StackType_t _task_stack[THREAD_SAFE_SPI_TASK_STACK_SIZE];
+    StaticTask_t _task_tcb;
   };
 
   extern ThreadSafeSPIClass ThreadSafeSPI;
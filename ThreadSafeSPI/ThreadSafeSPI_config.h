@@ -0,0 +1,40 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+// transferAsync()で待たせておける転送の数
+#ifndef THREAD_SAFE_SPI_ASYNC_QUEUE_SIZE
+#define THREAD_SAFE_SPI_ASYNC_QUEUE_SIZE 8
+#endif
+
+// transferAsync()の転送を行うタスクのスタックサイズ
+#ifndef THREAD_SAFE_SPI_TASK_STACK_SIZE
+#define THREAD_SAFE_SPI_TASK_STACK_SIZE 128
+#endif
+
+// transferAsync()の転送を行うタスクのプライオリティ
+#ifndef THREAD_SAFE_SPI_TASK_PRIO
+#define THREAD_SAFE_SPI_TASK_PRIO 1
+#endif
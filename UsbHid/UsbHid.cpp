@@ -69,7 +69,7 @@ namespace hidpg
     Adafruit_USBD_HID UsbHidClass::_usb_hid;
     UsbHidReporter UsbHidClass::_reporter;
 
-    UsbHidReporter::UsbHidReporter() : _usb_hid(nullptr), _kbd_led_cb(nullptr)
+    UsbHidReporter::UsbHidReporter() : _usb_hid(nullptr), _kbd_led_cb(nullptr), _resolution_multiplier(0), _wheel_remainder(0), _horiz_remainder(0)
     {
     }
 
@@ -80,83 +80,116 @@ namespace hidpg
 
     bool UsbHidReporter::keyboardReport(uint8_t modifiers, uint8_t key_codes[6])
     {
-      if (tud_ready() == false)
-      {
-        return false;
-      }
+      Report report = makeKeyboardReport(modifiers, key_codes);
+      return submit({&report, 1});
+    }
 
-      hid_keyboard_report_t report = {
-          .modifier = modifiers,
-          .reserved = 0,
-          .keycode = {
-              key_codes[0],
-              key_codes[1],
-              key_codes[2],
-              key_codes[3],
-              key_codes[4],
-              key_codes[5],
-          },
-      };
+    bool UsbHidReporter::consumerReport(uint16_t usage_code)
+    {
+      Report report{.type = Report::Type::Consumer};
+      report.consumer.usage_code = usage_code;
+      return submit({&report, 1});
+    }
 
-      wait_report_ready();
-      return _usb_hid->sendReport(REPORT_ID_KEYBOARD, &report, sizeof(hid_keyboard_report_t));
+    bool UsbHidReporter::mouseReport(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t horiz)
+    {
+      Report report = makeMouseReport(buttons, x, y, wheel, horiz);
+      return submit({&report, 1});
     }
 
-    bool UsbHidReporter::consumerReport(uint16_t usage_code)
+    bool UsbHidReporter::radialControllerReport(bool button, int16_t dial)
     {
-      if (tud_ready() == false)
-      {
-        return false;
-      }
+      Report report{.type = Report::Type::RadialController};
+      report.radial_controller.button = button;
+      report.radial_controller.dial = dial;
+      return submit({&report, 1});
+    }
 
-      wait_report_ready();
-      return _usb_hid->sendReport(REPORT_ID_CONSUMER_CONTROL, &usage_code, sizeof(usage_code));
+    bool UsbHidReporter::systemControlReport(uint8_t usage_code)
+    {
+      Report report{.type = Report::Type::SystemControl};
+      report.system_control.usage_code = usage_code;
+      return submit({&report, 1});
     }
 
-    bool UsbHidReporter::mouseReport(uint8_t buttons, int16_t x, int16_t y, int8_t wheel, int8_t horiz)
+    bool UsbHidReporter::submit(etl::span<Report> reports)
     {
+      // 接続チェックはバッチ毎に1回だけ
       if (tud_ready() == false)
       {
         return false;
       }
 
-      hid_mouse_report_ex_t report = {
-          buttons = buttons,
-          .x = x,
-          .y = y,
-          .wheel = wheel,
-          .pan = horiz,
-      };
-
-      wait_report_ready();
-      return _usb_hid->sendReport(REPORT_ID_MOUSE, &report, sizeof(hid_mouse_report_ex_t));
+      // HIDは1回のインタラプト転送で1つのレポートしか送れないのでレポート毎に転送完了を待つ
+      bool result = true;
+      for (Report &report : reports)
+      {
+        wait_report_ready();
+        result &= sendReport(report);
+      }
+      return result;
     }
 
-    bool UsbHidReporter::radialControllerReport(bool button, int16_t dial)
+    bool UsbHidReporter::sendReport(const Report &report)
     {
-      if (tud_ready() == false)
+      switch (report.type)
       {
-        return false;
+      case Report::Type::Keyboard:
+      {
+        hid_keyboard_report_ex_t buf;
+        serializeKeyboardReport(buf, report);
+        return _usb_hid->sendReport(REPORT_ID_KEYBOARD, &buf, sizeof(hid_keyboard_report_ex_t));
       }
 
-      hid_radial_controller_report_t report = {
-          .button = button,
-          .dial = dial,
-      };
+      case Report::Type::Consumer:
+        if (REPORT_ID_CONSUMER_CONTROL == 0)
+        {
+          return false;
+        }
+        return _usb_hid->sendReport(REPORT_ID_CONSUMER_CONTROL, &report.consumer.usage_code, sizeof(report.consumer.usage_code));
 
-      wait_report_ready();
-      return _usb_hid->sendReport(REPORT_ID_RADIAL_CONTROLLER, &report, sizeof(hid_radial_controller_report_t));
-    }
+      case Report::Type::Mouse:
+      {
+        int16_t x = report.mouse.x;
+        int16_t y = report.mouse.y;
+        int16_t wheel = scaleWheel(report.mouse.wheel, (_resolution_multiplier & 0x03) != 0, _wheel_remainder);
+        int16_t horiz = scaleWheel(report.mouse.horiz, (_resolution_multiplier & 0x0c) != 0, _horiz_remainder);
+        hid_mouse_report_ex_t buf;
+
+        // レポートのビット数に収まらない移動量は分割して送る
+        serializeMouseReport(buf, report.mouse.buttons, x, y, wheel, horiz);
+        bool result = _usb_hid->sendReport(REPORT_ID_MOUSE, &buf, sizeof(hid_mouse_report_ex_t));
+        while (result && (x != 0 || y != 0 || wheel != 0 || horiz != 0))
+        {
+          wait_report_ready();
+          serializeMouseReport(buf, report.mouse.buttons, x, y, wheel, horiz);
+          result = _usb_hid->sendReport(REPORT_ID_MOUSE, &buf, sizeof(hid_mouse_report_ex_t));
+        }
+        return result;
+      }
 
-    bool UsbHidReporter::systemControlReport(uint8_t usage_code)
-    {
-      if (tud_ready() == false)
+      case Report::Type::RadialController:
       {
-        return false;
+        if (REPORT_ID_RADIAL_CONTROLLER == 0)
+        {
+          return false;
+        }
+        hid_radial_controller_report_t buf = {
+            .button = report.radial_controller.button,
+            .dial = report.radial_controller.dial,
+        };
+        return _usb_hid->sendReport(REPORT_ID_RADIAL_CONTROLLER, &buf, sizeof(hid_radial_controller_report_t));
       }
 
-      wait_report_ready();
-      return _usb_hid->sendReport(REPORT_ID_SYSTEM_CONTROL, &usage_code, sizeof(usage_code));
+      case Report::Type::SystemControl:
+        if (REPORT_ID_SYSTEM_CONTROL == 0)
+        {
+          return false;
+        }
+        return _usb_hid->sendReport(REPORT_ID_SYSTEM_CONTROL, &report.system_control.usage_code, sizeof(report.system_control.usage_code));
+      }
+
+      return false;
     }
 
     bool UsbHidReporter::waitReady()
@@ -185,8 +218,8 @@ namespace hidpg
       init_report_ready_sem();
 
       _usb_hid.setPollInterval(1);
-      _usb_hid.setReportDescriptor(hid_report_descriptor, sizeof(hid_report_descriptor));
-      _usb_hid.setReportCallback(NULL, UsbHidClass::hid_report_callback);
+      _usb_hid.setReportDescriptor(hid_report_descriptor, hid_report_descriptor_len);
+      _usb_hid.setReportCallback(UsbHidClass::hid_get_report_callback, UsbHidClass::hid_report_callback);
       if (_usb_hid.begin() == false)
       {
         return false;
@@ -196,8 +229,31 @@ namespace hidpg
       return true;
     }
 
+    uint16_t UsbHidClass::hid_get_report_callback(uint8_t report_id, hid_report_type_t report_type, uint8_t *buffer, uint16_t reqlen)
+    {
+#if HID_REPORTER_ENABLE_HIGH_RESOLUTION_WHEEL
+      if (report_id == REPORT_ID_MOUSE && report_type == HID_REPORT_TYPE_FEATURE && reqlen >= 1)
+      {
+        buffer[0] = _reporter._resolution_multiplier;
+        return 1;
+      }
+#endif
+      return 0;
+    }
+
     void UsbHidClass::hid_report_callback(uint8_t report_id, hid_report_type_t report_type, uint8_t const *buffer, uint16_t bufsize)
     {
+#if HID_REPORTER_ENABLE_HIGH_RESOLUTION_WHEEL
+      // ホストがResolution Multiplierを設定する、切り替え時の端数は捨てる
+      if (report_id == REPORT_ID_MOUSE && report_type == HID_REPORT_TYPE_FEATURE && bufsize >= 1)
+      {
+        _reporter._resolution_multiplier = buffer[0] & 0x0f;
+        _reporter._wheel_remainder = 0;
+        _reporter._horiz_remainder = 0;
+        return;
+      }
+#endif
+
       if (!(report_id == REPORT_ID_KEYBOARD && report_type == HID_REPORT_TYPE_OUTPUT))
       {
         return;
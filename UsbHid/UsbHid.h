@@ -43,13 +43,20 @@ namespace hidpg
       bool systemControlReport(uint8_t usage_code) override;
       bool waitReady() override;
       void setKeyboardLedCallback(kbd_led_cb_t cb) override;
+      bool submit(etl::span<Report> reports) override;
 
     private:
       UsbHidReporter();
       void setUsbHid(Adafruit_USBD_HID *usb_hid);
+      bool sendReport(const Report &report);
 
       Adafruit_USBD_HID *_usb_hid;
       kbd_led_cb_t _kbd_led_cb;
+      // ホストが設定したResolution Multiplierのfeatureレポート (vertical 2bit | horizontal 2bit)
+      uint8_t _resolution_multiplier;
+      // Resolution Multiplierが無効な時にノッチに満たない端数を持ち越す
+      int16_t _wheel_remainder;
+      int16_t _horiz_remainder;
     };
 
     class UsbHidClass
@@ -59,6 +66,7 @@ namespace hidpg
       static HidReporter *getHidReporter();
 
     private:
+      static uint16_t hid_get_report_callback(uint8_t report_id, hid_report_type_t report_type, uint8_t *buffer, uint16_t reqlen);
       static void hid_report_callback(uint8_t report_id, hid_report_type_t report_type, uint8_t const *buffer, uint16_t bufsize);
 
       static Adafruit_USBD_HID _usb_hid;
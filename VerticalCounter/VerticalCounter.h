@@ -0,0 +1,140 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace hidpg
+{
+
+  // 最大32個のスイッチをまとめてデバウンスするカウンタ
+  // 各スイッチのカウンタの値をビットごとに別々のワードに持つ(bit-sliced vertical counter)ので、
+  // 32個分のカウンタの加算や比較が数回のワード演算で済む
+  // 閾値もビットごとに別々のワードに持つので、スイッチ毎に異なる閾値を設定できる
+  //
+  // Defer: 入力が確定状態と異なるサンプルが閾値の回数だけ連続したら確定状態を反転する
+  //        押下は押下時の閾値、離すときは離したときの閾値を使う
+  // Eager: 最初のエッジで即座に確定状態を反転し、その後閾値の回数のサンプルは変化を無視する
+  //        押下後は押下時の閾値、離した後は離したときの閾値を使う
+  class VerticalCounter
+  {
+  public:
+    static constexpr uint8_t BITS = 4;
+    static constexpr uint8_t MAX_THRESHOLD = (1 << BITS) - 1;
+
+    VerticalCounter() : _state(0), _eager(0), _locked(0), _planes(), _threshold_on(), _threshold_off() {}
+
+    // bitのスイッチの閾値(サンプル数, 1 ~ MAX_THRESHOLD)とモードを設定する
+    void configure(uint8_t bit, uint8_t press_threshold, uint8_t release_threshold, bool eager)
+    {
+      uint32_t mask = 1UL << bit;
+
+      // 確定状態がON/OFFのときに使う閾値
+      // Deferは確定状態から反転するまで、Eagerは反転した後に無視する期間なので逆になる
+      uint8_t on = eager ? press_threshold : release_threshold;
+      uint8_t off = eager ? release_threshold : press_threshold;
+
+      for (uint8_t i = 0; i < BITS; i++)
+      {
+        _threshold_on[i] = ((on >> i) & 1) ? (_threshold_on[i] | mask) : (_threshold_on[i] & ~mask);
+        _threshold_off[i] = ((off >> i) & 1) ? (_threshold_off[i] | mask) : (_threshold_off[i] & ~mask);
+      }
+      _eager = eager ? (_eager | mask) : (_eager & ~mask);
+      _locked &= _eager;
+    }
+
+    // 確定状態をstateにしてカウントを止める
+    void reset(uint32_t state)
+    {
+      _state = state;
+      _locked = 0;
+      for (uint8_t i = 0; i < BITS; i++)
+      {
+        _planes[i] = 0;
+      }
+    }
+
+    // rawは押されているスイッチのビットが1
+    // 戻り値は確定状態が変化したビット
+    uint32_t update(uint32_t raw)
+    {
+      uint32_t delta = raw ^ _state;
+      uint32_t locked = _locked;
+
+      // Deferは入力が異なる間、Eagerはロック中の間カウントアップ、それ以外は0にする
+      uint32_t counting = (delta & ~_eager) | locked;
+      uint32_t carry = counting;
+      for (uint8_t i = 0; i < BITS; i++)
+      {
+        uint32_t plane = _planes[i];
+        _planes[i] = (plane ^ carry) & counting;
+        carry &= plane;
+      }
+
+      // カウンタ == 閾値 のビットを求める
+      uint32_t reached = counting;
+      for (uint8_t i = 0; i < BITS; i++)
+      {
+        uint32_t threshold = (_state & _threshold_on[i]) | (~_state & _threshold_off[i]);
+        reached &= ~(_planes[i] ^ threshold);
+      }
+      for (uint8_t i = 0; i < BITS; i++)
+      {
+        _planes[i] &= ~reached;
+      }
+
+      // Defer: 閾値に達したら反転
+      // Eager: ロックされていなければ即座に反転してロック開始、閾値に達したらロック解除
+      // ロック開始時のカウンタは0なので、反転後ちょうど閾値の回数のサンプルを無視する
+      uint32_t changed = (reached & ~_eager) | (delta & _eager & ~locked);
+      _locked = (locked & ~reached) | (changed & _eager);
+      _state ^= changed;
+
+      return changed;
+    }
+
+    uint32_t state() const { return _state; }
+
+    // カウント中(状態が確定していない、またはロック中)のビット
+    uint32_t pending() const
+    {
+      uint32_t result = _locked;
+      for (uint8_t i = 0; i < BITS; i++)
+      {
+        result |= _planes[i];
+      }
+      return result;
+    }
+
+  private:
+    uint32_t _state;
+    uint32_t _eager;
+    uint32_t _locked;
+    uint32_t _planes[BITS];
+    uint32_t _threshold_on[BITS];
+    uint32_t _threshold_off[BITS];
+  };
+
+} // namespace hidpg
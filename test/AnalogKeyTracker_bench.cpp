@@ -0,0 +1,173 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "AnalogKeyTracker.h"
+#include "SyntheticAnalogSource.h"
+#include "bench.h"
+
+using namespace hidpg;
+
+namespace
+{
+  // 押下/解放の判定が、アクチュエーションポイントを物理的に跨いでから何サンプル遅れるか
+  // ポーリング間隔がANALOG_KEY_SCAN_POLLING_INTERVAL_MSなので、サンプル数 x 間隔がスキャンの遅延になる
+  void measureLatency(uint32_t stroke_samples, bool rapid_trigger)
+  {
+    // stroke_samplesかけて底打ちし、少し待ってから同じ速さで0.5mm戻してまた押し込み、最後に離す
+    const uint32_t t0 = 20;
+    const uint32_t t1 = t0 + stroke_samples;
+    const uint32_t t2 = t1 + 10;
+    const uint32_t t3 = t2 + stroke_samples / 8 + 1;
+    const uint32_t t4 = t3 + 10;
+    const uint32_t t5 = t4 + stroke_samples / 8 + 1;
+    const uint32_t t6 = t5 + 10;
+    const uint32_t t7 = t6 + stroke_samples;
+    const test::TravelPoint points[] = {{t0, 0}, {t1, 400}, {t2, 400}, {t3, 350}, {t4, 350}, {t5, 400}, {t6, 400}, {t7, 0}, {t7 + 20, 0}};
+    test::TravelCurve curve(points);
+    test::SyntheticAnalogSource<1> source(2000, ANALOG_KEY_SCAN_DEFAULT_RANGE);
+    source.setCurve(0, curve);
+
+    AnalogKey key(0, ANALOG_KEY_SCAN_ACTUATION_POINT, rapid_trigger ? ANALOG_KEY_SCAN_RAPID_TRIGGER_SENSITIVITY : 0);
+    AnalogKeyTracker tracker;
+    uint16_t value;
+    tracker.beginCalibration();
+    for (int n = 0; n < ANALOG_KEY_SCAN_CALIBRATION_SAMPLES; n++)
+    {
+      source.read(&value, 1);
+      tracker.addCalibrationSample(value);
+    }
+    tracker.endCalibration(ANALOG_KEY_SCAN_CALIBRATION_SAMPLES);
+
+    uint32_t press = UINT32_MAX, rt_release = UINT32_MAX, rt_press = UINT32_MAX, release = UINT32_MAX;
+    while (source.time() <= t7 + 20)
+    {
+      uint32_t t = source.time();
+      source.read(&value, 1);
+      if (tracker.update(value, key) == false)
+      {
+        continue;
+      }
+      if (t < t2)
+      {
+        press = t;
+      }
+      else if (t < t4)
+      {
+        rt_release = t;
+      }
+      else if (t < t6)
+      {
+        rt_press = t;
+      }
+      else
+      {
+        release = t;
+      }
+    }
+
+    // 物理的に判定位置を跨いだ時刻
+    uint16_t rt = ANALOG_KEY_SCAN_RAPID_TRIGGER_SENSITIVITY;
+    uint32_t press_cross = curve.firstCrossing(ANALOG_KEY_SCAN_ACTUATION_POINT, true);
+    uint32_t rt_release_cross = curve.firstCrossing(400 - rt + 1, false, t2);
+    uint32_t rt_press_cross = curve.firstCrossing(350 + rt, true, t4);
+    uint32_t release_cross = rapid_trigger ? curve.firstCrossing(400 - rt + 1, false, t6)
+                                           : curve.firstCrossing(ANALOG_KEY_SCAN_ACTUATION_POINT - ANALOG_KEY_SCAN_HYSTERESIS, false, t6);
+
+    auto lag = [](uint32_t detected, uint32_t cross)
+    { return (detected == UINT32_MAX) ? -1 : static_cast<int>(detected - cross); };
+
+    if (rapid_trigger)
+    {
+      printf("  stroke %3u samples, rapid trigger    press %2d  rt release %2d  rt press %2d  release %2d samples\n",
+             stroke_samples, lag(press, press_cross), lag(rt_release, rt_release_cross), lag(rt_press, rt_press_cross), lag(release, release_cross));
+    }
+    else
+    {
+      printf("  stroke %3u samples, no rapid trigger press %2d  release %2d samples\n",
+             stroke_samples, lag(press, press_cross), lag(release, release_cross));
+    }
+  }
+} // namespace
+
+int main()
+{
+  printf("AnalogKeyTracker\n");
+
+  // 合成したストロークでの判定遅延、速い打鍵ほどIIRフィルタの遅れが位置の誤差として大きくなる
+  uint32_t strokes[] = {4, 10, 40};
+  for (uint32_t stroke : strokes)
+  {
+    measureLatency(stroke, false);
+    measureLatency(stroke, true);
+  }
+
+  // 1スキャン分(64キー)のupdateのコスト、ADCの値は事前に合成しておく
+  constexpr uint8_t KEYS = 64;
+  constexpr uint32_t FRAMES = 256;
+  static const test::TravelPoint points[] = {{0, 0}, {64, 400}, {128, 400}, {192, 0}, {256, 0}};
+  test::SyntheticAnalogSource<KEYS> source(2000, ANALOG_KEY_SCAN_DEFAULT_RANGE, 3);
+  for (uint8_t i = 0; i < KEYS; i++)
+  {
+    source.setCurve(i, test::TravelCurve(points));
+  }
+  static uint16_t frames[FRAMES][KEYS];
+  for (uint32_t f = 0; f < FRAMES; f++)
+  {
+    source.setTime((f + 4 * (f % KEYS)) % FRAMES);
+    source.read(frames[f], KEYS);
+  }
+
+  static AnalogKeyTracker trackers[KEYS];
+  for (AnalogKeyTracker &tracker : trackers)
+  {
+    tracker.beginCalibration();
+    tracker.addCalibrationSample(2000);
+    tracker.endCalibration(1);
+  }
+  AnalogKey rt_key(0);
+  AnalogKey plain_key(0, ANALOG_KEY_SCAN_ACTUATION_POINT, 0);
+
+  test::bench("update 64 keys, rapid trigger", 1000000, [&](uint32_t i)
+              {
+                const uint16_t *values = frames[i % FRAMES];
+                uint32_t pressed = 0;
+                for (uint8_t k = 0; k < KEYS; k++)
+                {
+                  trackers[k].update(values[k], rt_key);
+                  pressed += trackers[k].isPressed();
+                }
+                test::benchSink() += pressed; });
+  test::bench("update 64 keys, no rapid trigger", 1000000, [&](uint32_t i)
+              {
+                const uint16_t *values = frames[i % FRAMES];
+                uint32_t pressed = 0;
+                for (uint8_t k = 0; k < KEYS; k++)
+                {
+                  trackers[k].update(values[k], plain_key);
+                  pressed += trackers[k].isPressed();
+                }
+                test::benchSink() += pressed; });
+
+  return 0;
+}
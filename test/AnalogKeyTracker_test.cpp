@@ -0,0 +1,188 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "AnalogKeyTracker.h"
+#include "SyntheticAnalogSource.h"
+#include "test.h"
+
+using namespace hidpg;
+
+namespace
+{
+  constexpr uint8_t CHANNELS = 1;
+
+  struct Transition
+  {
+    uint32_t time;
+    bool pressed;
+  };
+
+  // AnalogKeyScanのタスクと同じ手順でキャリブレーションしてからcurveの最後までスキャンし、押下状態の変化を記録する
+  template <uint8_t max_transitions>
+  uint8_t run(test::SyntheticAnalogSource<CHANNELS> &source, const AnalogKey &key, uint32_t end,
+              Transition (&transitions)[max_transitions], int16_t range = ANALOG_KEY_SCAN_DEFAULT_RANGE)
+  {
+    AnalogKeyTracker tracker;
+    uint16_t value;
+
+    tracker.beginCalibration();
+    for (int n = 0; n < ANALOG_KEY_SCAN_CALIBRATION_SAMPLES; n++)
+    {
+      source.read(&value, CHANNELS);
+      tracker.addCalibrationSample(value);
+    }
+    tracker.endCalibration(ANALOG_KEY_SCAN_CALIBRATION_SAMPLES, range);
+
+    uint8_t count = 0;
+    while (source.time() <= end)
+    {
+      uint32_t t = source.time();
+      source.read(&value, CHANNELS);
+      if (tracker.update(value, key) && count < max_transitions)
+      {
+        transitions[count++] = {t, tracker.isPressed()};
+      }
+    }
+    return count;
+  }
+
+  // 押して底打ちして離す、アクチュエーションポイントを物理的に跨いだ時刻から遅れて判定されることを確認する
+  void testPressReleaseLatency()
+  {
+    static const test::TravelPoint points[] = {{20, 0}, {40, 400}, {60, 400}, {80, 0}, {100, 0}};
+    test::TravelCurve curve(points);
+    test::SyntheticAnalogSource<CHANNELS> source(2000, ANALOG_KEY_SCAN_DEFAULT_RANGE);
+    source.setCurve(0, curve);
+
+    AnalogKey key(0, 200, 0);
+    Transition transitions[4];
+    uint8_t count = run(source, key, 100, transitions);
+
+    CHECK_EQ(2, count);
+    CHECK(transitions[0].pressed);
+    CHECK(transitions[1].pressed == false);
+
+    // 1次のIIRフィルタの分だけ遅れるが、数サンプル以内
+    uint32_t press_cross = curve.firstCrossing(200, true);
+    uint32_t release_cross = curve.firstCrossing(200 - ANALOG_KEY_SCAN_HYSTERESIS, false, 60);
+    CHECK(transitions[0].time >= press_cross && transitions[0].time <= press_cross + 2);
+    CHECK(transitions[1].time >= release_cross && transitions[1].time <= release_cross + 2);
+  }
+
+  // ラピッドトリガー、アクチュエーションポイントより深い位置で感度以上戻ると解放、押し込むと押下
+  void testRapidTrigger()
+  {
+    static const test::TravelPoint points[] = {{20, 0}, {30, 350}, {40, 350}, {45, 300}, {55, 300}, {60, 350}, {70, 350}, {80, 0}};
+    test::TravelCurve curve(points);
+    test::SyntheticAnalogSource<CHANNELS> source(2000, ANALOG_KEY_SCAN_DEFAULT_RANGE);
+    source.setCurve(0, curve);
+
+    AnalogKey key(0, 200, 30);
+    Transition transitions[8];
+    uint8_t count = run(source, key, 90, transitions);
+
+    CHECK_EQ(4, count);
+    CHECK(transitions[0].pressed);
+    CHECK(transitions[1].pressed == false);
+    CHECK(transitions[2].pressed);
+    CHECK(transitions[3].pressed == false);
+    // 解放はアクチュエーションポイントより深い位置で起きる
+    CHECK(transitions[1].time < curve.firstCrossing(200, false, 40));
+    CHECK(transitions[1].time >= 40 && transitions[1].time <= 45 + 2);
+    CHECK(transitions[2].time >= 55 && transitions[2].time <= 60 + 2);
+  }
+
+  // ラピッドトリガーを使わなければ途中で戻しても押下のまま
+  void testNoRapidTrigger()
+  {
+    static const test::TravelPoint points[] = {{20, 0}, {30, 350}, {40, 350}, {45, 300}, {55, 300}, {60, 350}, {70, 350}, {80, 0}};
+    test::SyntheticAnalogSource<CHANNELS> source(2000, ANALOG_KEY_SCAN_DEFAULT_RANGE);
+    source.setCurve(0, test::TravelCurve(points));
+
+    AnalogKey key(0, 200, 0);
+    Transition transitions[8];
+    CHECK_EQ(2, run(source, key, 90, transitions));
+  }
+
+  // アクチュエーションポイント付近で止めてもノイズでチャタリングしない
+  void testHysteresisWithNoise()
+  {
+    static const test::TravelPoint points[] = {{20, 0}, {30, 201}, {300, 201}};
+    test::SyntheticAnalogSource<CHANNELS> source(2000, ANALOG_KEY_SCAN_DEFAULT_RANGE, 4);
+    source.setCurve(0, test::TravelCurve(points));
+
+    AnalogKey key(0, 200, 0);
+    Transition transitions[8];
+    uint8_t count = run(source, key, 300, transitions);
+    CHECK(count <= 1);
+  }
+
+  // 実際の変化量が初期値より大きい場合、最初の底打ちでrangeが広がり、2回目からは正しい位置で判定される
+  void testRangeExpansion()
+  {
+    static const test::TravelPoint points[] = {{20, 0}, {40, 400}, {50, 400}, {70, 0}, {80, 0}, {100, 400}, {110, 400}, {130, 0}};
+    test::TravelCurve curve(points);
+    test::SyntheticAnalogSource<CHANNELS> source(2000, 2 * ANALOG_KEY_SCAN_DEFAULT_RANGE);
+    source.setCurve(0, curve);
+
+    AnalogKey key(0, 200, 0);
+    Transition transitions[8];
+    uint8_t count = run(source, key, 140, transitions);
+
+    CHECK_EQ(4, count);
+    // 1回目は実際より浅い位置で押下になる
+    CHECK(transitions[0].time < curve.firstCrossing(200, true));
+    // 2回目は広がったrangeで判定される
+    uint32_t press_cross = curve.firstCrossing(200, true, 80);
+    CHECK(transitions[2].time >= press_cross && transitions[2].time <= press_cross + 2);
+  }
+
+  // センサーの向きで値が減る場合はrangeを負にする
+  void testNegativeRange()
+  {
+    static const test::TravelPoint points[] = {{20, 0}, {40, 400}, {60, 400}, {80, 0}, {100, 0}};
+    test::TravelCurve curve(points);
+    test::SyntheticAnalogSource<CHANNELS> source(2000, -ANALOG_KEY_SCAN_DEFAULT_RANGE);
+    source.setCurve(0, curve);
+
+    AnalogKey key(0, 200, 0);
+    Transition transitions[4];
+    uint8_t count = run(source, key, 100, transitions, -ANALOG_KEY_SCAN_DEFAULT_RANGE);
+
+    CHECK_EQ(2, count);
+    uint32_t press_cross = curve.firstCrossing(200, true);
+    CHECK(transitions[0].time >= press_cross && transitions[0].time <= press_cross + 2);
+  }
+} // namespace
+
+int main()
+{
+  testPressReleaseLatency();
+  testRapidTrigger();
+  testNoRapidTrigger();
+  testHysteresisWithNoise();
+  testRangeExpansion();
+  testNegativeRange();
+  return test::testResult("AnalogKeyTracker");
+}
@@ -0,0 +1,214 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "BitSet.h"
+#include "bench.h"
+
+using namespace hidpg;
+
+namespace
+{
+  using Set = BitSet<256>;
+
+  // 以前のBitSetのtoArrayと差集合をそのまま写したもの、比較のためだけに使う
+  struct LegacySet
+  {
+    static constexpr size_t WORDS = (Set::CAPACITY + 31) / 32;
+
+    uint32_t _data[WORDS];
+    size_t _count;
+
+    LegacySet() : _data(), _count(0) {}
+
+    explicit LegacySet(const Set &set) : _data(), _count(set.count())
+    {
+      set.for_each([&](uint8_t val)
+                   { _data[val / 32] |= 1UL << (val % 32); });
+    }
+
+    bool contains(uint8_t val) const
+    {
+      return (_data[val / 32] >> (val % 32)) & 1;
+    }
+
+    size_t count() const { return _count; }
+
+    void toArray(uint8_t buf[]) const
+    {
+      if (_count == 0)
+        return;
+
+      size_t buf_cnt = 0;
+
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        if (_data[i] == 0)
+        {
+          continue;
+        }
+        for (int j = 0; j < 32; j++)
+        {
+          uint8_t val = i * 32 + j;
+          if (contains(val))
+          {
+            buf[buf_cnt++] = val;
+
+            if (buf_cnt == _count)
+            {
+              return;
+            }
+          }
+        }
+      }
+    }
+
+    friend LegacySet operator-(const LegacySet &a, const LegacySet &b)
+    {
+      LegacySet result = a;
+      result._count = 0;
+      for (size_t i = 0; i < WORDS; i++)
+      {
+        result._data[i] &= ~(b._data[i]);
+        result._count += __builtin_popcountl(result._data[i]);
+      }
+      return result;
+    }
+  };
+
+  // 以前のapplyToKeymap、差集合を2つ作ってVLAに展開してから処理する
+  uint32_t legacyDiff(const LegacySet &prev, const LegacySet &cur)
+  {
+    uint32_t sum = 0;
+    {
+      LegacySet press_ids = cur - prev;
+      uint8_t arr[press_ids.count()];
+      press_ids.toArray(arr);
+      for (uint8_t id : arr)
+      {
+        sum += id;
+      }
+    }
+    {
+      LegacySet release_ids = prev - cur;
+      uint8_t arr[release_ids.count()];
+      release_ids.toArray(arr);
+      for (uint8_t id : arr)
+      {
+        sum += id * 3;
+      }
+    }
+    return sum;
+  }
+
+  uint32_t wordDiff(const Set &prev, const Set &cur)
+  {
+    uint32_t sum = 0;
+    Set::diff(
+        prev, cur,
+        [&](uint8_t id)
+        { sum += id; },
+        [&](uint8_t id)
+        { sum += id * 3; });
+    return sum;
+  }
+
+  // 擬似乱数でキーを押したり離したりした状態の列を作る
+  // 1回のスキャンで変化するキーは0 ~ changes個、押されているキーは平均でpressed個程度
+  constexpr size_t FRAMES = 1024;
+
+  void makeFrames(Set (&frames)[FRAMES], uint8_t pressed, uint8_t changes)
+  {
+    uint32_t seed = 1;
+    auto next = [&]()
+    {
+      seed = seed * 1103515245 + 12345;
+      return seed >> 16;
+    };
+
+    Set cur;
+    for (size_t f = 0; f < FRAMES; f++)
+    {
+      uint32_t n = next() % (changes + 1);
+      for (uint32_t i = 0; i < n; i++)
+      {
+        uint8_t id = next() % 256;
+        if (cur.count() < pressed)
+        {
+          cur.add(id);
+        }
+        else
+        {
+          cur.remove(id);
+        }
+      }
+      frames[f] = cur;
+    }
+  }
+
+  void benchFrames(const char *title, uint8_t pressed, uint8_t changes)
+  {
+    static Set frames[FRAMES];
+    static LegacySet legacy_frames[FRAMES];
+    makeFrames(frames, pressed, changes);
+    for (size_t f = 0; f < FRAMES; f++)
+    {
+      legacy_frames[f] = LegacySet(frames[f]);
+    }
+
+    printf(" %s\n", title);
+    double legacy = test::bench("diff: set difference + VLA + toArray", 1000000, [&](uint32_t i)
+                                { test::benchSink() += legacyDiff(legacy_frames[i % FRAMES], legacy_frames[(i + 1) % FRAMES]); });
+    double word = test::bench("diff: Set::diff", 1000000, [&](uint32_t i)
+                              { test::benchSink() += wordDiff(frames[i % FRAMES], frames[(i + 1) % FRAMES]); });
+    printf("  %-40s %10.2fx\n", "speedup", legacy / word);
+
+    legacy = test::bench("iterate: VLA + toArray", 1000000, [&](uint32_t i)
+                         {
+                           const LegacySet &set = legacy_frames[i % FRAMES];
+                           uint8_t arr[set.count()];
+                           set.toArray(arr);
+                           uint32_t sum = 0;
+                           for (uint8_t id : arr)
+                           {
+                             sum += id;
+                           }
+                           test::benchSink() += sum; });
+    word = test::bench("iterate: for_each", 1000000, [&](uint32_t i)
+                       {
+                         uint32_t sum = 0;
+                         frames[i % FRAMES].for_each([&](uint8_t id)
+                                                     { sum += id; });
+                         test::benchSink() += sum; });
+    printf("  %-40s %10.2fx\n", "speedup", legacy / word);
+  }
+} // namespace
+
+int main()
+{
+  printf("BitSet\n");
+  benchFrames("typing (about 3 keys held, up to 1 change per scan)", 3, 1);
+  benchFrames("gaming (about 10 keys held, up to 4 changes per scan)", 10, 4);
+  benchFrames("stress (about 64 keys held, up to 16 changes per scan)", 64, 16);
+  return 0;
+}
@@ -0,0 +1,193 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "BitSet.h"
+#include "test.h"
+#include <initializer_list>
+
+using namespace hidpg;
+
+namespace
+{
+  // 範囲外の値はaddもremoveもできず、配列の外にも書き込まない
+  void testOutOfRange()
+  {
+    struct
+    {
+      BitSet<200> set;
+      uint32_t guard;
+    } s = {BitSet<200>(), 0};
+
+    CHECK(s.set.add(250) == false);
+    CHECK(s.set.add(200) == false);
+    CHECK(s.set.contains(250) == false);
+    CHECK_EQ(0, s.set.count());
+    CHECK_EQ(0, s.guard);
+
+    CHECK(s.set.add(199));
+    CHECK(s.set.remove(250) == false);
+    CHECK(s.set.update(250, true) == false);
+    CHECK(s.set.update(250, false) == false);
+    CHECK_EQ(1, s.set.count());
+    CHECK(s.set.contains(199));
+
+    const uint8_t vals[] = {1, 230, 2, 255};
+    s.set.addAll(vals, sizeof(vals));
+    CHECK_EQ(3, s.set.count());
+    s.set.removeAll(vals, sizeof(vals));
+    CHECK_EQ(1, s.set.count());
+    CHECK_EQ(0, s.guard);
+  }
+
+  template <size_t N>
+  BitSet<N> makeSet(std::initializer_list<int> vals)
+  {
+    BitSet<N> set;
+    for (int v : vals)
+    {
+      set.add(v);
+    }
+    return set;
+  }
+
+  // for_eachとtoArrayはワード境界をまたいでも小さい順に全ての値を返す
+  void testForEach()
+  {
+    BitSet<256> set = makeSet<256>({0, 31, 32, 63, 64, 200, 255});
+    int expected[] = {0, 31, 32, 63, 64, 200, 255};
+    size_t n = 0;
+    set.for_each([&](uint8_t val)
+                 {
+                   if (n < 7)
+                   {
+                     CHECK_EQ(expected[n], val);
+                   }
+                   n++; });
+    CHECK_EQ(7, n);
+
+    uint8_t arr[7];
+    set.toArray(arr);
+    for (int i = 0; i < 7; i++)
+    {
+      CHECK_EQ(expected[i], arr[i]);
+    }
+  }
+
+  // diffは追加された値を全て渡してから削除された値を渡す、どちらも小さい順
+  template <size_t N>
+  void checkDiff(const BitSet<N> &prev, const BitSet<N> &cur, std::initializer_list<int> added, std::initializer_list<int> removed)
+  {
+    int log[N];
+    size_t n = 0;
+    bool in_removed = false;
+    BitSet<N>::diff(
+        prev, cur,
+        [&](typename BitSet<N>::value_type val)
+        {
+          CHECK(in_removed == false);
+          log[n++] = val;
+        },
+        [&](typename BitSet<N>::value_type val)
+        {
+          in_removed = true;
+          log[n++] = val;
+        });
+
+    CHECK_EQ(added.size() + removed.size(), n);
+    size_t i = 0;
+    for (int v : added)
+    {
+      CHECK_EQ(v, log[i++]);
+    }
+    for (int v : removed)
+    {
+      CHECK_EQ(v, log[i++]);
+    }
+
+    // 差集合で求めた結果と一致する
+    CHECK_EQ(added.size(), (cur - prev).count());
+    CHECK_EQ(removed.size(), (prev - cur).count());
+  }
+
+  void testDiff()
+  {
+    // 31と32は別のワード
+    checkDiff(makeSet<256>({31}), makeSet<256>({32}), {32}, {31});
+    checkDiff(makeSet<256>({31, 32}), makeSet<256>({31, 32}), {}, {});
+    checkDiff(makeSet<256>({}), makeSet<256>({0, 31, 32, 255}), {0, 31, 32, 255}, {});
+    checkDiff(makeSet<256>({0, 31, 32, 255}), makeSet<256>({}), {}, {0, 31, 32, 255});
+    checkDiff(makeSet<256>({1, 63, 64, 254}), makeSet<256>({1, 64, 65, 255}), {65, 255}, {63, 254});
+    // 最後のワードが途中までしか使われないN
+    checkDiff(makeSet<200>({191, 192}), makeSet<200>({192, 199}), {199}, {191});
+    // 1ワードだけのN
+    checkDiff(makeSet<8>({0, 7}), makeSet<8>({3, 7}), {3}, {0});
+  }
+
+  void testSymmetricDifference()
+  {
+    BitSet<256> a = makeSet<256>({0, 31, 32, 100, 255});
+    BitSet<256> b = makeSet<256>({31, 33, 100, 254});
+    BitSet<256> x = symmetric_difference(a, b);
+
+    CHECK_EQ(5, x.count());
+    CHECK(x == makeSet<256>({0, 32, 33, 254, 255}));
+    CHECK(x == ((a - b) | (b - a)));
+    CHECK(symmetric_difference(a, a).count() == 0);
+
+    BitSet<200> c = makeSet<200>({31, 191, 199});
+    BitSet<200> d = makeSet<200>({32, 192, 199});
+    CHECK(symmetric_difference(c, d) == makeSet<200>({31, 32, 191, 192}));
+
+    a ^= b;
+    CHECK(a == x);
+    CHECK_EQ(5, a.count());
+  }
+
+  void testIntersects()
+  {
+    CHECK(makeSet<256>({31}).intersects(makeSet<256>({32})) == false);
+    CHECK(makeSet<256>({31}).intersects(makeSet<256>({31})));
+    CHECK(makeSet<256>({32}).intersects(makeSet<256>({0, 32})));
+    CHECK(makeSet<256>({255}).intersects(makeSet<256>({255})));
+    CHECK(makeSet<256>({254}).intersects(makeSet<256>({255})) == false);
+    CHECK(makeSet<200>({199}).intersects(makeSet<200>({199})));
+    CHECK(makeSet<200>({198}).intersects(makeSet<200>({199})) == false);
+    CHECK(BitSet<256>().intersects(BitSet<256>()) == false);
+
+    BitSet<256> a = makeSet<256>({31, 32, 255});
+    BitSet<256> b = makeSet<256>({32, 254});
+    CHECK((a & b) == makeSet<256>({32}));
+    CHECK_EQ(1, (a & b).count());
+  }
+} // namespace
+
+int main()
+{
+  testOutOfRange();
+  testForEach();
+  testDiff();
+  testSymmetricDifference();
+  testIntersects();
+  return test::testResult("BitSet");
+}
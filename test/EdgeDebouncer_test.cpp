@@ -0,0 +1,129 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "EdgeDebouncer.h"
+#include "test.h"
+
+using namespace hidpg;
+
+namespace
+{
+  constexpr uint32_t DEBOUNCE_US = 5000;
+
+  // エッジが無ければ何も確定しない
+  void testNoEdge()
+  {
+    EdgeDebouncer debouncer;
+    debouncer.reset(true);
+    CHECK(debouncer.poll(100000, DEBOUNCE_US) == false);
+    CHECK(debouncer.isPending() == false);
+    CHECK(debouncer.state());
+  }
+
+  // バウンスするエッジの列は最後のエッジからdebounce_delay後に確定し、変化の時刻は最初のエッジ
+  void testBouncingPress(uint32_t t0)
+  {
+    EdgeDebouncer debouncer;
+    debouncer.reset(false);
+
+    const uint32_t edges[] = {0, 150, 400, 700, 1300};
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    {
+      debouncer.onEdge(i % 2 == 0, t0 + edges[i]);
+      // バウンス中は確定しない
+      CHECK(debouncer.poll(t0 + edges[i] + 1, DEBOUNCE_US) == false);
+      CHECK(debouncer.isPending());
+    }
+
+    uint32_t last = t0 + 1300;
+    CHECK_EQ(DEBOUNCE_US - 1000, debouncer.remaining(last + 1000, DEBOUNCE_US));
+    CHECK(debouncer.poll(last + DEBOUNCE_US - 1, DEBOUNCE_US) == false);
+    CHECK(debouncer.state() == false);
+
+    CHECK(debouncer.poll(last + DEBOUNCE_US, DEBOUNCE_US));
+    CHECK(debouncer.state());
+    CHECK_EQ(t0, debouncer.changeTime());
+    CHECK(debouncer.isPending() == false);
+    CHECK_EQ(0, debouncer.remaining(last + DEBOUNCE_US, DEBOUNCE_US));
+
+    // 確定した後は次のエッジまで何も起きない
+    CHECK(debouncer.poll(last + DEBOUNCE_US * 3, DEBOUNCE_US) == false);
+  }
+
+  // バウンスして元のレベルに戻ったら変化にしない
+  void testGlitch()
+  {
+    EdgeDebouncer debouncer;
+    debouncer.reset(true);
+    debouncer.onEdge(false, 1000);
+    debouncer.onEdge(true, 1100);
+    CHECK(debouncer.poll(1100 + DEBOUNCE_US, DEBOUNCE_US) == false);
+    CHECK(debouncer.isPending() == false);
+    CHECK(debouncer.state());
+  }
+
+  // ポーリングが遅れても変化の時刻は最初のエッジのまま、次の変化は新しいエッジから数える
+  void testLatePollAndRelease()
+  {
+    EdgeDebouncer debouncer;
+    debouncer.reset(false);
+    debouncer.onEdge(true, 10000);
+    debouncer.onEdge(false, 10200);
+    debouncer.onEdge(true, 10300);
+    CHECK(debouncer.poll(90000, DEBOUNCE_US));
+    CHECK_EQ(10000, debouncer.changeTime());
+
+    debouncer.onEdge(false, 100000);
+    debouncer.onEdge(true, 100050);
+    debouncer.onEdge(false, 100400);
+    CHECK(debouncer.poll(100400 + DEBOUNCE_US - 1, DEBOUNCE_US) == false);
+    CHECK(debouncer.poll(100400 + DEBOUNCE_US, DEBOUNCE_US));
+    CHECK(debouncer.state() == false);
+    CHECK_EQ(100000, debouncer.changeTime());
+  }
+
+  // reset()はバウンス中の状態を捨てる
+  void testReset()
+  {
+    EdgeDebouncer debouncer;
+    debouncer.reset(false);
+    debouncer.onEdge(true, 0);
+    debouncer.reset(true);
+    CHECK(debouncer.isPending() == false);
+    CHECK(debouncer.poll(DEBOUNCE_US * 2, DEBOUNCE_US) == false);
+    CHECK(debouncer.state());
+  }
+} // namespace
+
+int main()
+{
+  testNoEdge();
+  testBouncingPress(1000);
+  // μsの時刻がバウンスの途中でオーバーフローする
+  testBouncingPress(UINT32_MAX - 700);
+  testGlitch();
+  testLatePollAndRelease();
+  testReset();
+  return test::testResult("EdgeDebouncer");
+}
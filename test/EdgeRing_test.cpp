@@ -0,0 +1,139 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "EdgeRing.h"
+#include "test.h"
+
+using namespace hidpg;
+
+namespace
+{
+  struct Edge
+  {
+    uint32_t time;
+    uint8_t pin;
+  };
+
+  void testEmpty()
+  {
+    EdgeRing<Edge, 4> ring;
+    Edge edge = {123, 7};
+    CHECK(ring.pop(edge) == false);
+    // 空の時は書き換えない
+    CHECK_EQ(123, edge.time);
+    CHECK_EQ(7, edge.pin);
+    CHECK(ring.takeOverflow() == false);
+  }
+
+  // uint8_tのhead/tailが何周しても順番通りに出てくる
+  void testWrapAround()
+  {
+    EdgeRing<Edge, 4> ring;
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+    // 1~3個ずつ入れて出すのを繰り返し、インデックスを1000以上進める
+    for (int round = 0; round < 600; round++)
+    {
+      int n = round % 3 + 1;
+      for (int i = 0; i < n; i++)
+      {
+        CHECK(ring.push(Edge{next_push, static_cast<uint8_t>(next_push)}));
+        next_push++;
+      }
+      Edge edge;
+      for (int i = 0; i < n; i++)
+      {
+        CHECK(ring.pop(edge));
+        CHECK_EQ(next_pop, edge.time);
+        CHECK_EQ(next_pop & 0xff, edge.pin);
+        next_pop++;
+      }
+      CHECK(ring.pop(edge) == false);
+    }
+    CHECK(next_pop > 1000);
+    CHECK(ring.takeOverflow() == false);
+  }
+
+  // 一杯の時の値は捨てて、オーバーフローを1回だけ報告する
+  void testOverflow()
+  {
+    EdgeRing<Edge, 4> ring;
+    for (uint32_t t = 0; t < 4; t++)
+    {
+      CHECK(ring.push(Edge{t, 0}));
+    }
+    CHECK(ring.push(Edge{100, 0}) == false);
+    CHECK(ring.push(Edge{101, 0}) == false);
+    CHECK(ring.takeOverflow());
+    CHECK(ring.takeOverflow() == false);
+
+    // 1つ空ければまた入る
+    Edge edge;
+    CHECK(ring.pop(edge));
+    CHECK_EQ(0, edge.time);
+    CHECK(ring.push(Edge{4, 0}));
+    CHECK(ring.takeOverflow() == false);
+
+    // 捨てた値は出てこない
+    for (uint32_t t = 1; t <= 4; t++)
+    {
+      CHECK(ring.pop(edge));
+      CHECK_EQ(t, edge.time);
+    }
+    CHECK(ring.pop(edge) == false);
+  }
+
+  // 最大の大きさで、head/tailが255から0に戻るところで一杯になっても正しく判定する
+  void testOverflowAcrossWrap()
+  {
+    EdgeRing<uint32_t, 128> ring;
+    uint32_t value;
+    for (uint32_t i = 0; i < 200; i++)
+    {
+      CHECK(ring.push(i));
+      CHECK(ring.pop(value));
+    }
+    for (uint32_t i = 0; i < 128; i++)
+    {
+      CHECK(ring.push(1000 + i));
+    }
+    CHECK(ring.push(9999) == false);
+    CHECK(ring.takeOverflow());
+    for (uint32_t i = 0; i < 128; i++)
+    {
+      CHECK(ring.pop(value));
+      CHECK_EQ(1000 + i, value);
+    }
+    CHECK(ring.pop(value) == false);
+  }
+} // namespace
+
+int main()
+{
+  testEmpty();
+  testWrapAround();
+  testOverflow();
+  testOverflowAcrossWrap();
+  return test::testResult("EdgeRing");
+}
@@ -0,0 +1,160 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "HostHardware.h"
+#include <stdint.h>
+#include <string.h>
+
+namespace test
+{
+  // GPIOに直接つないだダイオード付きのスイッチの行列のモデル
+  // 行の出力はLOWでアクティブ、列はプルアップされていて、押されているスイッチがアクティブな行につながる
+  // 1行だけをアクティブにして戻す(scanRowの)パルスを行毎に数える
+  class GpioMatrix : public PinDevice
+  {
+  public:
+    static constexpr int MAX_ROWS = 16;
+    static constexpr int MAX_COLS = 32;
+
+    GpioMatrix(const uint8_t *row_pins, int rows_len, const uint8_t *col_pins, int cols_len)
+        : _row_pins(row_pins), _rows_len(rows_len), _col_pins(col_pins), _cols_len(cols_len), _pulse_row(-1)
+    {
+      memset(_row_levels, 1, sizeof(_row_levels));
+      memset(_pressed, 0, sizeof(_pressed));
+      memset(row_pulses, 0, sizeof(row_pulses));
+    }
+
+    void press(int row, int col, bool pressed = true)
+    {
+      _pressed[row][col] = pressed;
+    }
+
+    void releaseAll()
+    {
+      memset(_pressed, 0, sizeof(_pressed));
+    }
+
+    bool isRowActive(int row) const
+    {
+      return _row_levels[row] == 0;
+    }
+
+    int scannedRows() const
+    {
+      int count = 0;
+      for (int r = 0; r < _rows_len; r++)
+      {
+        count += row_pulses[r];
+      }
+      return count;
+    }
+
+    void onDigitalWrite(uint8_t pin, uint8_t value) override
+    {
+      int row = rowOf(pin);
+      if (row < 0)
+      {
+        return;
+      }
+      bool was_only_active = (_pulse_row == row);
+      _pulse_row = -1;
+      if (value == 0 && _row_levels[row] != 0 && activeRows() == 0)
+      {
+        _pulse_row = row;
+      }
+      else if (value != 0 && was_only_active)
+      {
+        row_pulses[row]++;
+      }
+      _row_levels[row] = value;
+    }
+
+    bool onDigitalRead(uint8_t pin, uint8_t &value) override
+    {
+      int col = colOf(pin);
+      if (col < 0)
+      {
+        return false;
+      }
+      value = 1;
+      for (int r = 0; r < _rows_len; r++)
+      {
+        if (_pressed[r][col] && isRowActive(r))
+        {
+          value = 0;
+        }
+      }
+      return true;
+    }
+
+    // 行毎の、その行だけをアクティブにして読んだ回数
+    int row_pulses[MAX_ROWS];
+
+  private:
+    int rowOf(uint8_t pin) const
+    {
+      for (int r = 0; r < _rows_len; r++)
+      {
+        if (_row_pins[r] == pin)
+        {
+          return r;
+        }
+      }
+      return -1;
+    }
+
+    int colOf(uint8_t pin) const
+    {
+      for (int c = 0; c < _cols_len; c++)
+      {
+        if (_col_pins[c] == pin)
+        {
+          return c;
+        }
+      }
+      return -1;
+    }
+
+    int activeRows() const
+    {
+      int count = 0;
+      for (int r = 0; r < _rows_len; r++)
+      {
+        count += isRowActive(r);
+      }
+      return count;
+    }
+
+    const uint8_t *_row_pins;
+    int _rows_len;
+    const uint8_t *_col_pins;
+    int _cols_len;
+    // 他の行が全て非アクティブの時にアクティブにした行、次の書き込みで非アクティブに戻ればパルス
+    int _pulse_row;
+    uint8_t _row_levels[MAX_ROWS];
+    bool _pressed[MAX_ROWS][MAX_COLS];
+  };
+} // namespace test
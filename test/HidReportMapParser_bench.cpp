@@ -0,0 +1,77 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "HidReportMapParser.h"
+#include "ReportMaps.h"
+#include "bench.h"
+
+using namespace hidpg;
+
+// Report Mapの解析はdiscover時に1回だけ、notify毎には表を引いて切り出すだけであることを確認する
+int main()
+{
+  printf("HidReportMapParser\n");
+
+  HidReportMapParser parser;
+  test::bench("parse composite map", 100000, [&](uint32_t)
+              { test::benchSink() += parser.parse(test::Composite_Report_Map, sizeof(test::Composite_Report_Map)); });
+  test::bench("parse packed mouse map", 100000, [&](uint32_t)
+              { test::benchSink() += parser.parse(test::Packed_Mouse_Report_Map, sizeof(test::Packed_Mouse_Report_Map)); });
+
+  // 12bitに詰められたマウスのレポートからボタン、X、Y、ホイール、パンを切り出す
+  parser.parse(test::Packed_Mouse_Report_Map, sizeof(test::Packed_Mouse_Report_Map));
+  const HidReportMapParser::Field *fields[] = {
+      parser.findField(0x09, 0x01),
+      parser.findField(0x01, 0x30),
+      parser.findField(0x01, 0x31),
+      parser.findField(0x01, 0x38),
+      parser.findField(0x0C, 0x0238),
+  };
+  uint8_t report[7] = {0x00, 0x80, 0xFE, 0x8F, 0x3E, 0xFF, 0x01};
+  test::bench("extract packed mouse report", 10000000, [&](uint32_t i)
+              {
+                report[2] = i;
+                uint32_t sum = 0;
+                for (const HidReportMapParser::Field *f : fields)
+                {
+                  sum += HidReportMapParser::extract(report, sizeof(report), *f);
+                }
+                test::benchSink() += sum; });
+
+  // 6KROのキー配列をUsageに変換する
+  parser.parse(test::Composite_Report_Map, sizeof(test::Composite_Report_Map));
+  const HidReportMapParser::Field *keys = parser.findField(0x07, 0x04);
+  uint8_t kbd_report[8] = {0x02, 0x00, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
+  test::bench("extract keyboard key array", 10000000, [&](uint32_t i)
+              {
+                kbd_report[2] = i;
+                uint32_t sum = 0;
+                for (uint8_t n = 0; n < keys->count; n++)
+                {
+                  sum += HidReportMapParser::extractArrayUsage(kbd_report, sizeof(kbd_report), *keys, n);
+                }
+                test::benchSink() += sum; });
+
+  return 0;
+}
@@ -0,0 +1,293 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <string.h>
+#include <vector>
+
+#include "HidReportMapParser.h"
+#include "ReportMaps.h"
+#include "test.h"
+
+using namespace hidpg;
+using test::Composite_Report_Map;
+using test::Long_Report_Count_Report_Map;
+using test::Nkro_Keyboard_Report_Map;
+using test::Offset_Array_Report_Map;
+using test::Packed_Mouse_Report_Map;
+using test::Short_Logical_Maximum_Report_Map;
+
+namespace
+{
+  HidReportMapParser parser;
+
+  void testComposite()
+  {
+    CHECK(parser.parse(Composite_Report_Map, sizeof(Composite_Report_Map)));
+
+    // OutputのLEDレポートは含まない
+    CHECK_EQ(3, parser.reportCount());
+    CHECK_EQ(8, parser.findReport(1)->byteLength());
+    CHECK_EQ(2, parser.findReport(2)->byteLength());
+    CHECK_EQ(5, parser.findReport(3)->byteLength());
+    // modifiers + key codes + consumer + buttons + X, Y, wheel, pan
+    CHECK_EQ(8, parser.fieldCount());
+
+    const HidReportMapParser::Field *keys = parser.findField(0x07, 0x04);
+    CHECK(keys != nullptr && keys->is_array);
+    CHECK_EQ(1, keys->report_id);
+    CHECK_EQ(16, keys->bit_offset);
+    CHECK_EQ(6, keys->count);
+    CHECK_EQ(0, keys->logical_minimum);
+    CHECK_EQ(255, keys->logical_maximum);
+
+    const uint8_t kbd_report[] = {0x02, 0x00, 0x04, 0x05, 0x00, 0x00, 0x00, 0x00};
+    CHECK_EQ(0x04, HidReportMapParser::extractArrayUsage(kbd_report, sizeof(kbd_report), *keys, 0));
+    CHECK_EQ(0x05, HidReportMapParser::extractArrayUsage(kbd_report, sizeof(kbd_report), *keys, 1));
+    CHECK_EQ(0x00, HidReportMapParser::extractArrayUsage(kbd_report, sizeof(kbd_report), *keys, 2));
+
+    const HidReportMapParser::Field *consumer = parser.findField(0x0C, 0x00E9);
+    CHECK(consumer != nullptr && consumer->is_array);
+    CHECK_EQ(2, consumer->report_id);
+    CHECK_EQ(0x3FF, consumer->logical_maximum);
+    const uint8_t consumer_report[] = {0xE9, 0x00};
+    CHECK_EQ(0x00E9, HidReportMapParser::extractArrayUsage(consumer_report, sizeof(consumer_report), *consumer));
+    const uint8_t consumer_out_of_range[] = {0x00, 0x04};
+    CHECK_EQ(0, HidReportMapParser::extractArrayUsage(consumer_out_of_range, sizeof(consumer_out_of_range), *consumer));
+
+    const HidReportMapParser::Field *x = parser.findField(0x01, 0x30);
+    const HidReportMapParser::Field *y = parser.findField(0x01, 0x31);
+    const HidReportMapParser::Field *wheel = parser.findField(0x01, 0x38);
+    const HidReportMapParser::Field *pan = parser.findField(0x0C, 0x0238);
+    CHECK(x != nullptr && y != nullptr && wheel != nullptr && pan != nullptr);
+    CHECK_EQ(8, x->bit_offset);
+    CHECK_EQ(16, y->bit_offset);
+    CHECK_EQ(24, wheel->bit_offset);
+    CHECK_EQ(32, pan->bit_offset);
+    CHECK(x->is_signed && x->is_relative);
+
+    const uint8_t mouse_report[] = {0x01, 0xFF, 0x05, 0x80, 0x7F};
+    CHECK_EQ(-1, HidReportMapParser::extract(mouse_report, sizeof(mouse_report), *x));
+    CHECK_EQ(5, HidReportMapParser::extract(mouse_report, sizeof(mouse_report), *y));
+    CHECK_EQ(-128, HidReportMapParser::extract(mouse_report, sizeof(mouse_report), *wheel));
+    CHECK_EQ(127, HidReportMapParser::extract(mouse_report, sizeof(mouse_report), *pan));
+
+    // ボタン1 ~ 5は1つのフィールドにまとまる
+    uint16_t index1 = 0xFFFF;
+    uint16_t index5 = 0xFFFF;
+    const HidReportMapParser::Field *button1 = parser.findField(0x09, 0x01, &index1);
+    const HidReportMapParser::Field *button5 = parser.findField(0x09, 0x05, &index5);
+    CHECK(button1 != nullptr && button1 == button5);
+    CHECK_EQ(5, button1->count);
+    CHECK_EQ(0, index1);
+    CHECK_EQ(4, index5);
+    CHECK_EQ(4, HidReportMapParser::element(*button5, index5).bit_offset);
+    CHECK_EQ(0x05, HidReportMapParser::element(*button5, index5).usage);
+    CHECK_EQ(1, HidReportMapParser::extract(mouse_report, sizeof(mouse_report), *button1, index1));
+    CHECK_EQ(0, HidReportMapParser::extract(mouse_report, sizeof(mouse_report), *button5, index5));
+  }
+
+  void testPackedMouse()
+  {
+    CHECK(parser.parse(Packed_Mouse_Report_Map, sizeof(Packed_Mouse_Report_Map)));
+    CHECK_EQ(1, parser.reportCount());
+    CHECK_EQ(7, parser.findReport(2)->byteLength());
+    // buttons + X, Y, wheel, pan
+    CHECK_EQ(5, parser.fieldCount());
+
+    const HidReportMapParser::Field *x = parser.findField(0x01, 0x30);
+    const HidReportMapParser::Field *y = parser.findField(0x01, 0x31);
+    CHECK(x != nullptr && y != nullptr);
+    CHECK_EQ(16, x->bit_offset);
+    CHECK_EQ(28, y->bit_offset);
+    CHECK_EQ(12, x->bit_size);
+    CHECK_EQ(-2047, x->logical_minimum);
+    CHECK_EQ(2047, x->logical_maximum);
+
+    // X = -2 (0xFFE), Y = 1000 (0x3E8), バイト境界をまたいで詰められている
+    const uint8_t report[] = {0x00, 0x80, 0xFE, 0x8F, 0x3E, 0xFF, 0x01};
+    CHECK_EQ(-2, HidReportMapParser::extract(report, sizeof(report), *x));
+    CHECK_EQ(1000, HidReportMapParser::extract(report, sizeof(report), *y));
+
+    uint16_t index16;
+    const HidReportMapParser::Field *button16 = parser.findField(0x09, 0x10, &index16);
+    CHECK(button16 != nullptr);
+    CHECK_EQ(15, index16);
+    CHECK_EQ(1, HidReportMapParser::extract(report, sizeof(report), *button16, index16));
+
+    const HidReportMapParser::Field *wheel = parser.findField(0x01, 0x38);
+    const HidReportMapParser::Field *pan = parser.findField(0x0C, 0x0238);
+    CHECK(wheel != nullptr && pan != nullptr);
+    CHECK_EQ(-1, HidReportMapParser::extract(report, sizeof(report), *wheel));
+    CHECK_EQ(1, HidReportMapParser::extract(report, sizeof(report), *pan));
+
+    // レポートより短いデータは足りない部分を0として読む
+    CHECK_EQ(0, HidReportMapParser::extract(report, 4, *wheel));
+  }
+
+  void testArrayLogicalMinimum()
+  {
+    CHECK(parser.parse(Offset_Array_Report_Map, sizeof(Offset_Array_Report_Map)));
+    const HidReportMapParser::Field *keys = parser.findField(0x07, 0x04);
+    CHECK(keys != nullptr && keys->is_array);
+    CHECK_EQ(0, keys->report_id);
+    CHECK_EQ(1, keys->logical_minimum);
+    CHECK_EQ(26, keys->logical_maximum);
+
+    // Usage Minimum + (値 - Logical Minimum)、範囲外はキー無し
+    const uint8_t report[] = {1, 26};
+    CHECK_EQ(0x04, HidReportMapParser::extractArrayUsage(report, sizeof(report), *keys, 0));
+    CHECK_EQ(0x1D, HidReportMapParser::extractArrayUsage(report, sizeof(report), *keys, 1));
+    const uint8_t out_of_range[] = {0, 27};
+    CHECK_EQ(0, HidReportMapParser::extractArrayUsage(out_of_range, sizeof(out_of_range), *keys, 0));
+    CHECK_EQ(0, HidReportMapParser::extractArrayUsage(out_of_range, sizeof(out_of_range), *keys, 1));
+  }
+
+  void testShortLogicalMaximum()
+  {
+    // 0x25 0xFFは符号付きなら-1だが、Logical Minimumが0なので255とみなす
+    CHECK(parser.parse(Short_Logical_Maximum_Report_Map, sizeof(Short_Logical_Maximum_Report_Map)));
+    const HidReportMapParser::Field *keys = parser.findField(0x07, 0x00);
+    CHECK(keys != nullptr);
+    CHECK_EQ(255, keys->logical_maximum);
+    CHECK(keys->is_signed == false);
+    const uint8_t report[] = {0xE0, 0, 0, 0, 0, 0};
+    CHECK_EQ(0xE0, HidReportMapParser::extractArrayUsage(report, sizeof(report), *keys, 0));
+  }
+
+  void testZeroSizeField()
+  {
+    HidReportMapParser::Field field = {};
+    field.bit_size = 0;
+    field.is_signed = true;
+    const uint8_t data[] = {0xFF, 0xFF};
+    CHECK_EQ(0, HidReportMapParser::extract(data, sizeof(data), field));
+  }
+
+  void testWideField()
+  {
+    // 32bitを超えるフィールドは下位32bitだけを読む
+    HidReportMapParser::Field field = {};
+    field.bit_size = 40;
+    const uint8_t data[] = {0x78, 0x56, 0x34, 0x12, 0xFF};
+    CHECK_EQ(0x12345678, HidReportMapParser::extract(data, sizeof(data), field));
+    field.bit_size = 255;
+    CHECK_EQ(0x12345678, HidReportMapParser::extract(data, sizeof(data), field));
+  }
+
+  void testNkroBitmap()
+  {
+    // 152個のキーは1つのフィールドになる
+    CHECK(parser.parse(Nkro_Keyboard_Report_Map, sizeof(Nkro_Keyboard_Report_Map)));
+    CHECK_EQ(2, parser.fieldCount());
+    CHECK_EQ(20, parser.findReport(1)->byteLength());
+
+    uint16_t index;
+    const HidReportMapParser::Field *keys = parser.findField(0x07, 0x04, &index);
+    CHECK(keys != nullptr && keys->is_array == false);
+    CHECK_EQ(8, keys->bit_offset);
+    CHECK_EQ(152, keys->count);
+    CHECK_EQ(0x97, keys->usage_maximum);
+    CHECK_EQ(4, index);
+    CHECK(parser.findField(0x07, 0x98) == nullptr);
+
+    // A(0x04)とLANG9(0x97)、Left Shift
+    uint8_t report[20] = {};
+    report[0] = 0x02;
+    report[1] = 0x10;
+    report[19] = 0x80;
+    CHECK_EQ(1, HidReportMapParser::extract(report, sizeof(report), *keys, 0x04));
+    CHECK_EQ(0, HidReportMapParser::extract(report, sizeof(report), *keys, 0x05));
+    CHECK_EQ(1, HidReportMapParser::extract(report, sizeof(report), *keys, 0x97));
+    CHECK_EQ(8 + 0x97, HidReportMapParser::element(*keys, 0x97).bit_offset);
+
+    uint16_t shift_index;
+    const HidReportMapParser::Field *modifiers = parser.findField(0x07, 0xE1, &shift_index);
+    CHECK(modifiers != nullptr && modifiers != keys);
+    CHECK_EQ(1, HidReportMapParser::extract(report, sizeof(report), *modifiers, shift_index));
+  }
+
+  void testLongReportCount()
+  {
+    // Report Count 256(0x96 0x00 0x01)は切り詰めない、1つのUsageの繰り返しは1つのフィールドになる
+    CHECK(parser.parse(Long_Report_Count_Report_Map, sizeof(Long_Report_Count_Report_Map)));
+    CHECK_EQ(256, parser.findReport(2)->byteLength());
+    CHECK_EQ(1, parser.fieldCount());
+
+    const HidReportMapParser::Field *data = parser.findField(0xFF00, 0x02);
+    CHECK(data != nullptr);
+    CHECK_EQ(256, data->count);
+    uint8_t report[256];
+    for (int i = 0; i < 256; i++)
+    {
+      report[i] = i;
+    }
+    CHECK_EQ(200, HidReportMapParser::extract(report, sizeof(report), *data, 200));
+    CHECK_EQ(255, HidReportMapParser::extract(report, sizeof(report), *data, 255));
+    CHECK_EQ(0x02, HidReportMapParser::element(*data, 255).usage);
+
+    // 16bitのビット長に収まらないレポートは失敗にする
+    uint8_t too_long[sizeof(Long_Report_Count_Report_Map)];
+    memcpy(too_long, Long_Report_Count_Report_Map, sizeof(too_long));
+    too_long[19] = 0x00;
+    too_long[20] = 0x20; // 8192 * 8bit
+    CHECK(parser.parse(too_long, sizeof(too_long)) == false);
+  }
+
+  void testFieldOverflow()
+  {
+    // Usageが続かないVariableのInputをMAX_FIELDS + 1個並べると切り捨てずに解析失敗にする
+    std::vector<uint8_t> map = {0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x05, 0x07, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x01};
+    for (uint8_t i = 0; i < HidReportMapParser::MAX_FIELDS; i++)
+    {
+      map.insert(map.end(), {0x09, static_cast<uint8_t>(i * 2), 0x81, 0x02});
+    }
+    map.push_back(0xC0);
+    CHECK(parser.parse(map.data(), map.size()));
+    CHECK_EQ(HidReportMapParser::MAX_FIELDS, parser.fieldCount());
+
+    map.insert(map.end() - 1, {0x09, 0xFF, 0x81, 0x02});
+    CHECK(parser.parse(map.data(), map.size()) == false);
+  }
+
+  void testTruncatedMap()
+  {
+    // 途中で切れたアイテムは失敗する
+    CHECK(parser.parse(Composite_Report_Map, 13) == false);
+  }
+} // namespace
+
+int main()
+{
+  testComposite();
+  testPackedMouse();
+  testArrayLogicalMinimum();
+  testShortLogicalMaximum();
+  testZeroSizeField();
+  testWideField();
+  testNkroBitmap();
+  testLongReportCount();
+  testFieldOverflow();
+  testTruncatedMap();
+  return test::testResult("HidReportMapParser");
+}
@@ -0,0 +1,96 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "GpioMatrix.h"
+#include "MatrixScan.h"
+#include "bench.h"
+#include <chrono>
+
+// Sense signalを使う設定で、押されている行の数に対する1回のスキャンのホストのCPU時間
+// GPIOのポートのモデルの処理も含むので、実機の時間ではなく行数に対する伸び方を見る
+
+using namespace hidpg;
+
+namespace
+{
+  constexpr int ROWS = 16;
+  constexpr int COLS = 16;
+  constexpr uint32_t SCANS = 20000;
+
+  uint8_t row_pins[ROWS];
+  uint8_t col_pins[COLS];
+  Switch matrix[ROWS][COLS];
+  test::GpioMatrix gpio(row_pins, ROWS, col_pins, COLS);
+  void *task = nullptr;
+
+  // busy_rows行でスイッチを押したままにしてスキャンし続ける
+  void benchScan(const char *name, int busy_rows)
+  {
+    gpio.releaseAll();
+    for (int r = 0; r < busy_rows; r++)
+    {
+      gpio.press(r, r);
+    }
+    test::updateGpioSense();
+    // 最初の全行スキャンとデバウンスを済ませる
+    test::runTask(task, 10);
+
+    auto start = std::chrono::steady_clock::now();
+    test::runTask(task, SCANS);
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / SCANS;
+    printf("  %-40s %10.1f ns/op\n", name, ns);
+    test::benchSink() += gpio.scannedRows();
+  }
+} // namespace
+
+int main()
+{
+  for (int i = 0; i < ROWS; i++)
+  {
+    row_pins[i] = i;
+  }
+  for (int i = 0; i < COLS; i++)
+  {
+    col_pins[i] = 32 + i;
+  }
+  for (int r = 0; r < ROWS; r++)
+  {
+    for (int c = 0; c < COLS; c++)
+    {
+      matrix[r][c] = Switch(r * COLS + c + 1);
+    }
+  }
+
+  test::attachPinDevice(&gpio);
+  MatrixScan.setMatrix(matrix, row_pins, col_pins);
+  MatrixScan.start();
+  task = test::findTask("MatrixScan");
+
+  printf("MatrixScan\n");
+  benchScan("scan 16x16, 1 row busy", 1);
+  benchScan("scan 16x16, 4 rows busy", 4);
+  benchScan("scan 16x16, 16 rows busy", 16);
+  return 0;
+}
@@ -0,0 +1,209 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "GpioMatrix.h"
+#include "MatrixScan.h"
+#include "test.h"
+
+// nRF52のSense signalを使う設定(ARDUINO_ARCH_NRF52とMATRIX_SCAN_USE_SENSE_INTERRUPT)でビルドし、
+// stubのGPIOポートのモデルで動かす
+
+using namespace hidpg;
+
+namespace
+{
+  constexpr int ROWS = 6;
+  constexpr int COLS = 7;
+  // 行も列も一部をポート1に置く
+  const uint8_t row_pins[ROWS] = {2, 3, 4, 5, 6, 33};
+  const uint8_t col_pins[COLS] = {8, 9, 10, 11, 12, 40, 41};
+
+  constexpr int EAGER_ROW = 4;
+  constexpr int EAGER_COL = 0;
+
+  Switch matrix[ROWS][COLS];
+  test::GpioMatrix gpio(row_pins, ROWS, col_pins, COLS);
+  void *task = nullptr;
+
+  Set last_ids;
+
+  key_id_t idAt(int row, int col)
+  {
+    return row * COLS + col + 1;
+  }
+
+  void onChange(const Set &ids)
+  {
+    last_ids = ids;
+  }
+
+  // スイッチを変えたらSenseの割り込みを発生させる
+  void press(int row, int col, bool pressed = true)
+  {
+    gpio.press(row, col, pressed);
+    test::updateGpioSense();
+  }
+
+  // idが確定するまで1回ずつスキャンして、かかったスキャン回数を返す
+  int scansUntil(key_id_t id, bool pressed)
+  {
+    int scans = 0;
+    for (int i = 0; i < 50 && last_ids.contains(id) != pressed; i++)
+    {
+      scans += test::runTask(task, 1);
+    }
+    CHECK(last_ids.contains(id) == pressed);
+    return scans;
+  }
+
+  // 何も押されていなければタスクは寝ていて、全行をアクティブにしてSenseを待つ
+  void testIdle()
+  {
+    CHECK_EQ(0, test::runTask(task, 5));
+    CHECK(test::isTaskBlocked(task));
+    for (int r = 0; r < ROWS; r++)
+    {
+      CHECK(gpio.isRowActive(r));
+    }
+    CHECK_EQ(0, gpio.scannedRows());
+  }
+
+  // 押されるとSenseで起きて最初だけ全行、その後は押されている行だけをスキャンする
+  void testPartialScan()
+  {
+    press(1, 2);
+    CHECK_EQ(6, scansUntil(idAt(1, 2), true));
+    CHECK_EQ(1, last_ids.count());
+
+    for (int r = 0; r < ROWS; r++)
+    {
+      CHECK_EQ((r == 1) ? 6 : 1, gpio.row_pulses[r]);
+      // 押されている行だけ非アクティブにして、他の行の新しい押下をSenseで拾う
+      CHECK(gpio.isRowActive(r) == (r != 1));
+    }
+
+    // 押されている行の別のスイッチはSenseが無くてもその行のスキャンで拾う
+    press(1, 5);
+    CHECK_EQ(6, scansUntil(idAt(1, 5), true));
+    CHECK_EQ(12, gpio.row_pulses[1]);
+    CHECK_EQ(1, gpio.row_pulses[0]);
+    CHECK_EQ(1, gpio.row_pulses[5]);
+
+    // 他の行(ポート1の列)の押下はSenseのラッチで全行スキャンに戻る
+    press(5, 6);
+    CHECK_EQ(6, scansUntil(idAt(5, 6), true));
+    CHECK_EQ(3, last_ids.count());
+    CHECK_EQ(2, gpio.row_pulses[0]);
+    CHECK_EQ(2, gpio.row_pulses[3]);
+    CHECK_EQ(7, gpio.row_pulses[5]);
+    CHECK(gpio.isRowActive(5) == false);
+  }
+
+  // デバウンスは行毎、スイッチ毎に独立していて、バウンス中のスイッチは他の行に影響しない
+  void testBounce()
+  {
+    key_id_t id = idAt(3, 3);
+    // 1スキャン毎に押下と解放を繰り返してから押したままにする
+    for (int i = 0; i < 5; i++)
+    {
+      press(3, 3, i % 2 == 0);
+      test::runTask(task, 1);
+      CHECK(last_ids.contains(id) == false);
+      CHECK_EQ(3, last_ids.count());
+    }
+    press(3, 3);
+    // 最後の変化から6サンプル安定して確定する
+    CHECK_EQ(5, scansUntil(id, true));
+    CHECK_EQ(4, last_ids.count());
+
+    press(3, 3, false);
+    CHECK_EQ(6, scansUntil(id, false));
+    CHECK_EQ(3, last_ids.count());
+  }
+
+  // Eagerのスイッチは最初のサンプルで確定し、その後のバウンスを無視する
+  void testEager()
+  {
+    key_id_t id = idAt(EAGER_ROW, EAGER_COL);
+    press(EAGER_ROW, EAGER_COL);
+    CHECK_EQ(1, scansUntil(id, true));
+    press(EAGER_ROW, EAGER_COL, false);
+    test::runTask(task, 1);
+    press(EAGER_ROW, EAGER_COL);
+    test::runTask(task, 1);
+    CHECK(last_ids.contains(id));
+
+    press(EAGER_ROW, EAGER_COL, false);
+    int scans = scansUntil(id, false);
+    CHECK(1 <= scans && scans <= 6);
+  }
+
+  // 全て離されたらdecayの間スキャンしてから寝て、次の押下で起きる
+  void testSleepAndWake()
+  {
+    gpio.releaseAll();
+    test::updateGpioSense();
+    test::runTask(task, 50);
+    CHECK(test::isTaskBlocked(task));
+    CHECK_EQ(0, last_ids.count());
+    for (int r = 0; r < ROWS; r++)
+    {
+      CHECK(gpio.isRowActive(r));
+    }
+
+    press(0, 0);
+    CHECK_EQ(6, scansUntil(idAt(0, 0), true));
+    gpio.releaseAll();
+    test::runTask(task, 50);
+    CHECK(test::isTaskBlocked(task));
+    CHECK_EQ(0, last_ids.count());
+  }
+} // namespace
+
+int main()
+{
+  for (int r = 0; r < ROWS; r++)
+  {
+    for (int c = 0; c < COLS; c++)
+    {
+      matrix[r][c] = Switch(idAt(r, c));
+    }
+  }
+  matrix[EAGER_ROW][EAGER_COL] = Switch(idAt(EAGER_ROW, EAGER_COL), MATRIX_SCAN_DEBOUNCE_DELAY_MS, DebounceMode::Eager);
+
+  test::attachPinDevice(&gpio);
+
+  MatrixScan.setMatrix(matrix, row_pins, col_pins);
+  MatrixScan.setCallback(onChange);
+  MatrixScan.start();
+  task = test::findTask("MatrixScan");
+  CHECK(task != nullptr);
+
+  testIdle();
+  testPartialScan();
+  testBounce();
+  testEager();
+  testSleepAndWake();
+  return test::testResult("MatrixScan");
+}
@@ -0,0 +1,484 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "HostHardware.h"
+#include "PAW3204DB.h"
+#include "test.h"
+
+using namespace hidpg;
+
+namespace
+{
+  constexpr uint8_t SCLK_PIN = 20;
+  constexpr uint8_t SDIO_PIN = 21;
+  constexpr uint8_t MOTSWK_PIN = 22;
+
+  // PAW3204DBの2線式シリアルインターフェースをSCLKの立ち上がりでビット単位に真似るモデル
+  // アドレス8bitの最上位が1なら書き込み8bitが続き、0ならセンサーがSDIOを駆動してデータ8bitを返す
+  class Paw3204Model : public test::PinDevice
+  {
+  public:
+    enum Register : uint8_t
+    {
+      Motion_Status = 0x02,
+      Delta_X = 0x03,
+      Delta_Y = 0x04,
+      Operation_Mode = 0x05,
+      Configuration = 0x06,
+      Write_Protect = 0x09,
+      Sleep1_Setting = 0x0A,
+      Image_Recognition = 0x0E,
+    };
+
+    static constexpr uint8_t MOTION = 0x80;
+    static constexpr uint8_t DYOVF = 0x10;
+    static constexpr uint8_t DXOVF = 0x08;
+    static constexpr size_t QUEUE_SIZE = 512;
+
+    struct Counters
+    {
+      uint32_t status_reads;
+      uint32_t delta_reads;
+      uint32_t timing_errors;  // tHOLDを待たずにデータを読んだ
+      uint32_t protect_errors; // Write_Protectを外さずに0x0A〜0x0Eに書き込んだ
+      uint32_t latch_errors;   // Motion_Statusを読まずにDeltaを読んだ
+    };
+
+    Paw3204Model() { powerOn(); }
+
+    void powerOn()
+    {
+      memset(_regs, 0, sizeof(_regs));
+      _regs[0x00] = 0x30;
+      _regs[Operation_Mode] = 0b10111000;
+      _regs[Configuration] = 0b100;
+      _sclk = HIGH;
+      _sensor_drives_sdio = false;
+      _sdio_out = LOW;
+      _bits = 0;
+      _shift = 0;
+      _phase = Phase::Address;
+      _acc_x = _acc_y = 0;
+      _ovf = 0;
+      _latched = false;
+      _head = _tail = 0;
+      _force_motswk_low = 0;
+      counters = Counters();
+    }
+
+    // センサーが1回の読み出しの間に検出する動き、8bitを超えるとDeltaが飽和してオーバーフローする
+    void move(int dx, int dy)
+    {
+      _acc_x = saturate(_acc_x + dx, DXOVF);
+      _acc_y = saturate(_acc_y + dy, DYOVF);
+    }
+
+    // Delta_Yを読む度に1つずつセンサーに入る動き、残っている間はMOTSWKがLOWのまま
+    void queueMotion(int8_t dx, int8_t dy)
+    {
+      _queue[_tail % QUEUE_SIZE][0] = dx;
+      _queue[_tail % QUEUE_SIZE][1] = dy;
+      _tail++;
+    }
+
+    // 動きが無いのにMOTSWKがLOWになっている(ノイズ等)状態、countは何回読まれるまでLOWにするか
+    void forceMotswkLow(uint32_t count) { _force_motswk_low = count; }
+
+    // 電源投入時のノイズ等でシリアルのビット位置がずれた状態
+    void desync() { _bits = 3; }
+
+    uint8_t reg(uint8_t addr) const { return _regs[addr]; }
+    size_t pendingMotion() const { return _tail - _head; }
+
+    void onPinMode(uint8_t pin, uint8_t mode) override
+    {
+      if (pin == SDIO_PIN)
+      {
+        _host_drives_sdio = (mode == OUTPUT);
+        if (_host_drives_sdio)
+        {
+          _sensor_drives_sdio = false;
+        }
+      }
+    }
+
+    void onDigitalWrite(uint8_t pin, uint8_t value) override
+    {
+      if (pin == SDIO_PIN)
+      {
+        _sdio_out = value;
+        return;
+      }
+      if (pin != SCLK_PIN || value == _sclk)
+      {
+        return;
+      }
+      _sclk = value;
+      uint64_t now = test::nowMicros();
+      if (value == LOW)
+      {
+        // SCLKを長くHIGHにした後のLOWパルスで再同期する
+        if (now - _sclk_high_time >= 1000)
+        {
+          _phase = Phase::Address;
+          _bits = 0;
+          _shift = 0;
+        }
+        if (_phase == Phase::Read && _bits == 0 && now - _address_time < 3)
+        {
+          counters.timing_errors++;
+        }
+        return;
+      }
+
+      _sclk_high_time = now;
+      if (_phase == Phase::Read)
+      {
+        // 立ち上がりの後にホストがSDIOを読む
+        _sdio_in = (_read_data >> (7 - _bits)) & 1;
+        if (++_bits == 8)
+        {
+          _phase = Phase::Address;
+          _bits = 0;
+        }
+        return;
+      }
+
+      _shift = (_shift << 1) | (_sdio_out ? 1 : 0);
+      if (++_bits < 8)
+      {
+        return;
+      }
+      _bits = 0;
+      if (_phase == Phase::Address)
+      {
+        _addr = _shift & 0x7f;
+        if (_shift & 0x80)
+        {
+          _phase = Phase::Write;
+        }
+        else
+        {
+          _phase = Phase::Read;
+          _sensor_drives_sdio = true;
+          _address_time = now;
+          _read_data = read(_addr);
+        }
+      }
+      else
+      {
+        write(_addr, _shift);
+        _phase = Phase::Address;
+      }
+      _shift = 0;
+    }
+
+    bool onDigitalRead(uint8_t pin, uint8_t &value) override
+    {
+      // 最後のビットはホストがSDIOを出力に戻すまで駆動し続ける
+      if (pin == SDIO_PIN && _sensor_drives_sdio && _host_drives_sdio == false)
+      {
+        value = _sdio_in;
+        return true;
+      }
+      if (pin == MOTSWK_PIN && (motionPending() || _force_motswk_low > 0))
+      {
+        if (_force_motswk_low > 0)
+        {
+          _force_motswk_low--;
+        }
+        value = LOW;
+        return true;
+      }
+      return false;
+    }
+
+    Counters counters;
+
+  private:
+    enum class Phase
+    {
+      Address,
+      Write,
+      Read,
+    };
+
+    int saturate(int value, uint8_t ovf_bit)
+    {
+      if (value > INT8_MAX || value < INT8_MIN)
+      {
+        _ovf |= ovf_bit;
+        return constrain(value, INT8_MIN, INT8_MAX);
+      }
+      return value;
+    }
+
+    bool motionPending() const { return _acc_x != 0 || _acc_y != 0 || _ovf != 0 || _head != _tail; }
+
+    void nextMotion()
+    {
+      if (_head != _tail && _acc_x == 0 && _acc_y == 0)
+      {
+        move(_queue[_head % QUEUE_SIZE][0], _queue[_head % QUEUE_SIZE][1]);
+        _head++;
+      }
+    }
+
+    uint8_t read(uint8_t addr)
+    {
+      switch (addr)
+      {
+      case Motion_Status:
+      {
+        // 読んだ時点の動きをDelta_X、Delta_Yにラッチする
+        counters.status_reads++;
+        nextMotion();
+        uint8_t status = _ovf;
+        if (_acc_x != 0 || _acc_y != 0 || _ovf != 0)
+        {
+          status |= MOTION;
+        }
+        _regs[Delta_X] = static_cast<uint8_t>(_acc_x);
+        _regs[Delta_Y] = static_cast<uint8_t>(_acc_y);
+        _acc_x = _acc_y = 0;
+        _ovf = 0;
+        _latched = (status & MOTION) != 0;
+        return status;
+      }
+      case Delta_X:
+        counters.delta_reads++;
+        if (_latched == false)
+        {
+          counters.latch_errors++;
+        }
+        return _regs[Delta_X];
+      case Delta_Y:
+      {
+        counters.delta_reads++;
+        if (_latched == false)
+        {
+          counters.latch_errors++;
+        }
+        _latched = false;
+        uint8_t value = _regs[Delta_Y];
+        nextMotion();
+        return value;
+      }
+      default:
+        return _regs[addr];
+      }
+    }
+
+    void write(uint8_t addr, uint8_t data)
+    {
+      if (addr >= Sleep1_Setting && addr <= Image_Recognition && _regs[Write_Protect] != 0x5A)
+      {
+        counters.protect_errors++;
+        return;
+      }
+      _regs[addr] = data;
+    }
+
+    uint8_t _regs[128];
+    uint8_t _sclk;
+    uint64_t _sclk_high_time = 0;
+    uint8_t _sdio_out;
+    uint8_t _sdio_in = 0;
+    bool _host_drives_sdio = false;
+    bool _sensor_drives_sdio = false;
+    uint8_t _bits;
+    uint8_t _shift;
+    Phase _phase;
+    uint8_t _addr = 0;
+    uint64_t _address_time = 0;
+    uint8_t _read_data = 0;
+    int _acc_x;
+    int _acc_y;
+    uint8_t _ovf;
+    bool _latched;
+    int8_t _queue[QUEUE_SIZE][2];
+    size_t _head;
+    size_t _tail;
+    uint32_t _force_motswk_low;
+  };
+
+  Paw3204Model model;
+
+  // センサーのインスタンスはIDごとに1つなので、持ち越しが残らないように読み切ってからモデルを戻す
+  PAW3204DB &sensor()
+  {
+    static PAW3204DB *instance = nullptr;
+    if (instance == nullptr)
+    {
+      test::resetHardware();
+      test::attachPinDevice(&model);
+      instance = &PAW3204DB::create<0>(SCLK_PIN, SDIO_PIN, MOTSWK_PIN);
+      CHECK(instance->start());
+    }
+    return *instance;
+  }
+
+  void resetModel()
+  {
+    int16_t x, y;
+    do
+    {
+      sensor().readDelta(&x, &y);
+    } while (x != 0 || y != 0);
+    model.powerOn();
+    model.counters = Paw3204Model::Counters();
+  }
+
+  // 起動時に再同期してWrite_Protectを外してから設定を書き、最後に戻す
+  void testStart()
+  {
+    model.powerOn();
+    model.desync();
+    sensor();
+
+    CHECK_EQ(0, model.counters.protect_errors);
+    CHECK_EQ(PAW3204DB_Sleep1_Setting, model.reg(Paw3204Model::Sleep1_Setting));
+    CHECK_EQ(PAW3204DB_Image_Recognition, model.reg(Paw3204Model::Image_Recognition));
+    CHECK_EQ(0x00, model.reg(Paw3204Model::Write_Protect));
+
+    sensor().changeCpi(PAW3204DB::Cpi::_1200);
+    CHECK_EQ(0b101, model.reg(Paw3204Model::Configuration));
+    sensor().changeMode(PAW3204DB::Mode::Sleep1);
+    CHECK_EQ(0b10110010, model.reg(Paw3204Model::Operation_Mode));
+  }
+
+  // Motion_StatusのMotionが立っていない時はDeltaを読まない
+  void testMotionStatusGating()
+  {
+    resetModel();
+    int16_t x, y;
+
+    sensor().readDelta(&x, &y);
+    CHECK_EQ(0, x);
+    CHECK_EQ(0, y);
+    CHECK_EQ(1, model.counters.status_reads);
+    CHECK_EQ(0, model.counters.delta_reads);
+
+    // MOTSWKがLOWでも動きが無ければ1回で抜ける
+    model.forceMotswkLow(3);
+    sensor().readDelta(&x, &y);
+    model.forceMotswkLow(0);
+    CHECK_EQ(0, x);
+    CHECK_EQ(0, y);
+    CHECK_EQ(2, model.counters.status_reads);
+    CHECK_EQ(0, model.counters.delta_reads);
+
+    model.move(-5, 9);
+    sensor().readDelta(&x, &y);
+    CHECK_EQ(-5, x);
+    CHECK_EQ(9, y);
+    CHECK_EQ(3, model.counters.status_reads);
+    CHECK_EQ(2, model.counters.delta_reads);
+    CHECK_EQ(0, model.counters.latch_errors);
+    CHECK_EQ(0, model.counters.timing_errors);
+  }
+
+  // MOTSWKがLOWの間は続けて読み、読み残した動きを1回のreadDeltaで合計する
+  void testMotswkLoop()
+  {
+    resetModel();
+    for (int i = 0; i < 5; i++)
+    {
+      model.queueMotion(100, -100);
+    }
+    model.queueMotion(-3, 4);
+
+    int16_t x, y;
+    sensor().readDelta(&x, &y);
+    CHECK_EQ(497, x);
+    CHECK_EQ(-496, y);
+    CHECK_EQ(0, model.pendingMotion());
+    // 最後の組を読んだ後はMOTSWKがHIGHになるので余分にMotion_Statusを読まない
+    CHECK_EQ(6, model.counters.status_reads);
+    CHECK_EQ(12, model.counters.delta_reads);
+    CHECK_EQ(0, sensor().getOverflowCount());
+    CHECK_EQ(0, model.counters.latch_errors);
+  }
+
+  // DXOVF、DYOVFが立つ度に1回数え、飽和した値はそのまま使う
+  void testOverflowCount()
+  {
+    resetModel();
+    uint32_t base = sensor().getOverflowCount();
+    int16_t x, y;
+
+    model.move(300, 0);
+    sensor().readDelta(&x, &y);
+    CHECK_EQ(127, x);
+    CHECK_EQ(0, y);
+    CHECK_EQ(base + 1, sensor().getOverflowCount());
+
+    // 両軸同時でも1回の読み出しにつき1回
+    model.move(-200, 200);
+    sensor().readDelta(&x, &y);
+    CHECK_EQ(-128, x);
+    CHECK_EQ(127, y);
+    CHECK_EQ(base + 2, sensor().getOverflowCount());
+
+    model.move(10, 10);
+    sensor().readDelta(&x, &y);
+    CHECK_EQ(base + 2, sensor().getOverflowCount());
+  }
+
+  // int16_tに収まらない分は次回のreadDeltaに持ち越して捨てない
+  void testInt16Carry()
+  {
+    resetModel();
+    // 300 * 127 = 38100
+    for (int i = 0; i < 300; i++)
+    {
+      model.queueMotion(127, -128);
+    }
+
+    int16_t x, y;
+    sensor().readDelta(&x, &y);
+    CHECK_EQ(INT16_MAX, x);
+    CHECK_EQ(INT16_MIN, y);
+
+    sensor().readDelta(&x, &y);
+    CHECK_EQ(38100 - INT16_MAX, x);
+    CHECK_EQ(-38400 - INT16_MIN, y);
+    // 持ち越し分だけの時はDeltaを読まない
+    CHECK_EQ(301, model.counters.status_reads);
+
+    sensor().readDelta(&x, &y);
+    CHECK_EQ(0, x);
+    CHECK_EQ(0, y);
+  }
+} // namespace
+
+int main()
+{
+  testStart();
+  testMotionStatusGating();
+  testMotswkLoop();
+  testOverflowCount();
+  testInt16Carry();
+  return test::testResult("PAW3204DB");
+}
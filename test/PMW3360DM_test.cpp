@@ -0,0 +1,554 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "HostHardware.h"
+#include "PMW3360DM.h"
+#include "PMW3360DM_Firmware.h"
+#include "test.h"
+
+using namespace hidpg;
+
+namespace
+{
+  constexpr uint8_t NCS_PIN = 10;
+  constexpr uint8_t MOTION_PIN = 11;
+
+  // PMW3360DMのSPIのレジスタアクセスを真似るモデル
+  // データシートの手順から外れたアクセス(burstモードでないのにMotion_Burstを読む等)をエラーとして数える
+  class Pmw3360Model : public test::PinDevice, public test::SpiPeripheral
+  {
+  public:
+    enum Register : uint8_t
+    {
+      Product_ID = 0x00,
+      Motion = 0x02,
+      Config1 = 0x0F,
+      Config2 = 0x10,
+      Frame_Capture = 0x12,
+      SROM_Enable = 0x13,
+      SROM_ID = 0x2A,
+      Power_Up_Reset = 0x3A,
+      Inverse_Product_ID = 0x3F,
+      Angle_Snap = 0x42,
+      Motion_Burst = 0x50,
+      SROM_Load_Burst = 0x62,
+      Raw_Data_Burst = 0x64,
+    };
+
+    struct Counters
+    {
+      uint32_t motion_burst_writes; // burstモードに入った回数
+      uint32_t bursts;              // Motion burstの読み出し回数
+      uint32_t burst_errors;        // burstモードでないのにMotion_Burstを読んだ
+      uint32_t nav_errors;          // SROMが動いていないのに移動量を読んだ
+      uint32_t timing_errors;       // tSRAD、tSRAD_MOTBRを待たずに読んだ
+      uint32_t frame_errors;        // Frame captureの手順を踏まずにRaw_Data_Burstを読んだ
+      uint32_t resets;              // Power_Up_Reset
+      uint32_t srom_downloads;      // 正しくダウンロードできた回数
+      uint32_t srom_errors;         // 手順やデータが間違っていた
+    };
+
+    Pmw3360Model() { powerOn(false); }
+
+    // 電源投入直後、sromをtrueにするとマイコンだけがリセットされてSROMが残っている状態
+    void powerOn(bool srom)
+    {
+      memset(_regs, 0, sizeof(_regs));
+      _regs[Product_ID] = 0x42;
+      _regs[Inverse_Product_ID] = 0xBD;
+      _regs[Config1] = 0x31;
+      _regs[Config2] = 0x20;
+      _srom_running = srom;
+      _regs[SROM_ID] = srom ? PMW3360DM_Firmware_SROM_ID : 0;
+      _burst_mode = false;
+      _srom_step = 0;
+      _frame_step = 0;
+      _selected = false;
+      _dx = _dy = 0;
+      _squal = 80;
+      _lifted = false;
+      counters = Counters();
+    }
+
+    void addMotion(int16_t dx, int16_t dy)
+    {
+      _dx += dx;
+      _dy += dy;
+    }
+
+    uint8_t reg(uint8_t addr) const { return _regs[addr]; }
+    bool inBurstMode() const { return _burst_mode; }
+    bool isSromRunning() const { return _srom_running; }
+    static uint8_t pixel(uint16_t i) { return (i * 7 + 3) & 0x7f; }
+
+    void onDigitalWrite(uint8_t pin, uint8_t value) override
+    {
+      if (pin != NCS_PIN)
+      {
+        return;
+      }
+      if (value == LOW)
+      {
+        // 既にLOWでもSPIポートのリセットとして新しいトランザクションにする
+        _selected = true;
+        _index = 0;
+      }
+      else if (_selected)
+      {
+        endTransaction();
+        _selected = false;
+      }
+    }
+
+    uint8_t exchange(uint8_t mosi) override
+    {
+      if (_selected == false)
+      {
+        return 0xff;
+      }
+      uint8_t miso = (_index == 0) ? beginAccess(mosi) : continueAccess(mosi, _index - 1);
+      _index++;
+      return miso;
+    }
+
+    Counters counters;
+
+  private:
+    enum class Access
+    {
+      Read,
+      Write,
+      Burst,
+      SromLoad,
+      Frame,
+    };
+
+    uint8_t beginAccess(uint8_t mosi)
+    {
+      _addr = mosi & 0x7f;
+      _address_time = test::nowMicros();
+      bool write = (mosi & 0x80) != 0;
+
+      if (write && _addr == SROM_Load_Burst)
+      {
+        _access = Access::SromLoad;
+        _srom_bytes = 0;
+        _srom_ok = (_srom_step == 2);
+      }
+      else if (write)
+      {
+        _access = Access::Write;
+      }
+      else if (_addr == Motion_Burst)
+      {
+        _access = Access::Burst;
+        counters.bursts++;
+        if (_burst_mode == false)
+        {
+          counters.burst_errors++;
+        }
+        if (_srom_running == false)
+        {
+          counters.nav_errors++;
+        }
+        latchBurst();
+      }
+      else if (_addr == Raw_Data_Burst)
+      {
+        _access = Access::Frame;
+        if (_frame_step != 2)
+        {
+          counters.frame_errors++;
+        }
+      }
+      else
+      {
+        // burst以外のレジスタの読み出しでburstモードを抜ける
+        _access = Access::Read;
+        _burst_mode = false;
+      }
+      return 0;
+    }
+
+    uint8_t continueAccess(uint8_t mosi, uint16_t n)
+    {
+      switch (_access)
+      {
+      case Access::Write:
+        if (n == 0)
+        {
+          write(_addr, mosi);
+        }
+        return 0;
+
+      case Access::Read:
+        if (n == 0)
+        {
+          if (test::nowMicros() - _address_time < 160)
+          {
+            counters.timing_errors++;
+          }
+          return _regs[_addr];
+        }
+        return 0;
+
+      case Access::Burst:
+        if (n == 0 && test::nowMicros() - _address_time < 35)
+        {
+          counters.timing_errors++;
+        }
+        return (n < sizeof(_burst)) ? _burst[n] : 0;
+
+      case Access::SromLoad:
+        if (_srom_bytes >= sizeof(PMW3360DM_Firmware) || mosi != PMW3360DM_Firmware[_srom_bytes])
+        {
+          _srom_ok = false;
+        }
+        _srom_bytes++;
+        return 0;
+
+      case Access::Frame:
+        return (n < PMW3360DM::FRAME_SIZE) ? pixel(n) : 0;
+      }
+      return 0;
+    }
+
+    void endTransaction()
+    {
+      if (_index == 0)
+      {
+        return;
+      }
+      if (_access == Access::SromLoad)
+      {
+        if (_srom_ok && _srom_bytes == sizeof(PMW3360DM_Firmware))
+        {
+          _srom_running = true;
+          _regs[SROM_ID] = PMW3360DM_Firmware_SROM_ID;
+          counters.srom_downloads++;
+        }
+        else
+        {
+          counters.srom_errors++;
+        }
+        _srom_step = 0;
+      }
+      if (_access == Access::Frame)
+      {
+        _frame_step = 0;
+      }
+    }
+
+    void write(uint8_t addr, uint8_t data)
+    {
+      // Motion_Burstへの書き込みでburstモードに入り、他のレジスタへの書き込みで抜ける
+      _burst_mode = (addr == Motion_Burst);
+
+      switch (addr)
+      {
+      case Motion_Burst:
+        counters.motion_burst_writes++;
+        break;
+      case Power_Up_Reset:
+        if (data == 0x5a)
+        {
+          counters.resets++;
+          uint32_t resets = counters.resets;
+          uint32_t downloads = counters.srom_downloads;
+          Counters saved = counters;
+          powerOn(false);
+          counters = saved;
+          counters.resets = resets;
+          counters.srom_downloads = downloads;
+        }
+        break;
+      case SROM_Enable:
+        if (data == 0x1d)
+        {
+          _srom_step = 1;
+        }
+        else if (data == 0x18 && _srom_step == 1)
+        {
+          _srom_step = 2;
+        }
+        else
+        {
+          _srom_step = 0;
+        }
+        break;
+      case Frame_Capture:
+        if (data == 0x83)
+        {
+          _frame_step = 1;
+        }
+        else if (data == 0xc5 && _frame_step == 1)
+        {
+          // Frame captureを始めるとSROMが止まり、ダウンロードし直すまで移動量を読めない
+          _frame_step = 2;
+          _srom_running = false;
+        }
+        break;
+      default:
+        _regs[addr] = data;
+        break;
+      }
+    }
+
+    void latchBurst()
+    {
+      memset(_burst, 0, sizeof(_burst));
+      _burst[0] = ((_dx != 0 || _dy != 0) ? 0x80 : 0) | (_lifted ? 0x08 : 0);
+      _burst[2] = _dx & 0xff;
+      _burst[3] = (_dx >> 8) & 0xff;
+      _burst[4] = _dy & 0xff;
+      _burst[5] = (_dy >> 8) & 0xff;
+      _burst[6] = _squal;
+      _burst[10] = 0x01; // Shutter_Upper
+      _burst[11] = 0x20; // Shutter_Lower
+      _dx = _dy = 0;
+    }
+
+    uint8_t _regs[128];
+    bool _srom_running;
+    bool _burst_mode;
+    uint8_t _srom_step;
+    uint8_t _frame_step;
+    bool _selected;
+    uint16_t _index;
+    uint8_t _addr;
+    uint64_t _address_time;
+    Access _access;
+    uint8_t _burst[12];
+    size_t _srom_bytes;
+    bool _srom_ok;
+    int16_t _dx;
+    int16_t _dy;
+    uint8_t _squal;
+    bool _lifted;
+  };
+
+  Pmw3360Model model;
+
+  // センサーのインスタンスはIDごとに1つなので、テスト毎にモデルの電源を入れ直してstart()し直す
+  PMW3360DM &startSensor(bool srom_loaded)
+  {
+    test::resetHardware();
+    model.powerOn(srom_loaded);
+    test::attachPinDevice(&model);
+    test::attachSpiPeripheral(&model);
+
+    PMW3360DM &sensor = PMW3360DM::create<0>(ThreadSafeSPI, NCS_PIN, MOTION_PIN);
+    CHECK(sensor.start());
+    return sensor;
+  }
+
+  // 他の種類のセンサーの代わり
+  class OtherSensor : public PointingSensor
+  {
+  public:
+    OtherSensor(uint8_t id) : PointingSensor(id) {}
+    void readDelta(int16_t *delta_x, int16_t *delta_y) override { *delta_x = *delta_y = 0; }
+  };
+
+  bool noProtocolErrors()
+  {
+    return model.counters.burst_errors == 0 && model.counters.nav_errors == 0 &&
+           model.counters.timing_errors == 0 && model.counters.frame_errors == 0 && model.counters.srom_errors == 0;
+  }
+
+  // 電源投入時はリセットしてSROMをダウンロードする
+  void testColdStart()
+  {
+    PMW3360DM &sensor = startSensor(false);
+    PMW3360DM::InitReport report = sensor.getInitReport();
+
+    CHECK(report.srom_downloaded);
+    CHECK_EQ(PMW3360DM_Firmware_SROM_ID, report.srom_id);
+    CHECK_EQ(1, model.counters.resets);
+    CHECK_EQ(1, model.counters.srom_downloads);
+    CHECK(model.isSromRunning());
+    CHECK(model.inBurstMode() == false);
+    CHECK_EQ(0x20, model.reg(Pmw3360Model::Config2));
+    CHECK(noProtocolErrors());
+  }
+
+  // SROMが残っていればリセットもダウンロードもしない
+  void testWarmStart()
+  {
+    PMW3360DM &sensor = startSensor(true);
+    PMW3360DM::InitReport report = sensor.getInitReport();
+
+    CHECK(report.srom_downloaded == false);
+    CHECK_EQ(0, model.counters.resets);
+    CHECK_EQ(0, model.counters.srom_downloads);
+    CHECK(noProtocolErrors());
+  }
+
+  // burstモードは最初のreadDeltaで1回だけ入り、続くreadDeltaはMotion_Burstへの書き込みを省く
+  void testBurstModeIsKept()
+  {
+    PMW3360DM &sensor = startSensor(false);
+
+    int16_t x, y;
+    for (int i = 0; i < 10; i++)
+    {
+      model.addMotion(i, -i);
+      sensor.readDelta(&x, &y);
+      CHECK_EQ(i, x);
+      CHECK_EQ(-i, y);
+    }
+    CHECK_EQ(1, model.counters.motion_burst_writes);
+    CHECK_EQ(10, model.counters.bursts);
+    CHECK(model.inBurstMode());
+    CHECK(noProtocolErrors());
+  }
+
+  // readMotionもburstモードを共有し、12バイト全てとint16の移動量を読む
+  void testReadMotion()
+  {
+    PMW3360DM &sensor = startSensor(true);
+
+    int16_t x, y;
+    sensor.readDelta(&x, &y);
+
+    PMW3360DM::MotionBurst data;
+    model.addMotion(-300, 1000);
+    sensor.readMotion(&data);
+    CHECK_EQ(-300, data.delta_x);
+    CHECK_EQ(1000, data.delta_y);
+    CHECK_EQ(0x80, data.motion & 0x80);
+    CHECK(data.lifted == false);
+    CHECK_EQ(80, data.squal);
+    CHECK_EQ(0x0120, data.shutter);
+    CHECK_EQ(1, model.counters.motion_burst_writes);
+    CHECK(noProtocolErrors());
+  }
+
+  // writeRegisterでburstモードを抜けるので、次のreadDeltaはMotion_Burstに書き込んでから読む
+  void testWriteRegisterLeavesBurstMode()
+  {
+    PMW3360DM &sensor = startSensor(false);
+
+    int16_t x, y;
+    sensor.readDelta(&x, &y);
+    CHECK(model.inBurstMode());
+
+    sensor.changeCpi(PMW3360DM::Cpi::_1600);
+    CHECK(model.inBurstMode() == false);
+    CHECK_EQ(0x0f, model.reg(Pmw3360Model::Config1));
+
+    model.addMotion(5, 6);
+    sensor.readDelta(&x, &y);
+    CHECK_EQ(5, x);
+    CHECK_EQ(6, y);
+    CHECK_EQ(2, model.counters.motion_burst_writes);
+
+    sensor.enableAngleSnap();
+    sensor.changeMode(PMW3360DM::Mode::Run);
+    sensor.readDelta(&x, &y);
+    CHECK_EQ(3, model.counters.motion_burst_writes);
+    CHECK(noProtocolErrors());
+  }
+
+  // 再起動(start)ではreadRegisterでburstモードを抜けたことになる
+  void testRestartLeavesBurstMode()
+  {
+    PMW3360DM &sensor = startSensor(true);
+    int16_t x, y;
+    sensor.readDelta(&x, &y);
+    CHECK_EQ(1, model.counters.motion_burst_writes);
+
+    // センサーはburstモードのまま、マイコンだけが再起動
+    sensor.start();
+    CHECK(model.inBurstMode() == false);
+    sensor.readDelta(&x, &y);
+    CHECK_EQ(2, model.counters.motion_burst_writes);
+    CHECK(noProtocolErrors());
+  }
+
+  // Frame captureの前後でburstモードを抜け、SROMの再ダウンロードと設定の復元の後にburstモードに入り直す
+  void testCaptureFrame()
+  {
+    PMW3360DM &sensor = startSensor(false);
+    sensor.changeCpi(PMW3360DM::Cpi::_3200);
+    sensor.enableAngleSnap();
+
+    int16_t x, y;
+    sensor.readDelta(&x, &y);
+    uint32_t burst_writes = model.counters.motion_burst_writes;
+
+    static uint8_t frame[PMW3360DM::FRAME_SIZE];
+    sensor.captureFrame(frame);
+
+    bool frame_ok = true;
+    for (uint16_t i = 0; i < PMW3360DM::FRAME_SIZE; i++)
+    {
+      frame_ok &= (frame[i] == Pmw3360Model::pixel(i));
+    }
+    CHECK(frame_ok);
+    CHECK_EQ(2, model.counters.srom_downloads);
+    CHECK(model.isSromRunning());
+    CHECK(model.inBurstMode() == false);
+    CHECK_EQ(0x1f, model.reg(Pmw3360Model::Config1));
+    CHECK_EQ(0x80, model.reg(Pmw3360Model::Angle_Snap));
+    CHECK_EQ(0x20, model.reg(Pmw3360Model::Config2));
+
+    model.addMotion(7, 8);
+    sensor.readDelta(&x, &y);
+    CHECK_EQ(7, x);
+    CHECK_EQ(8, y);
+    CHECK_EQ(burst_writes + 1, model.counters.motion_burst_writes);
+    CHECK(noProtocolErrors());
+  }
+  // 既に使われているIDのセンサーは登録されず、start()はセンサーに触らずに失敗する
+  void testDuplicateId()
+  {
+    static OtherSensor other(1);
+
+    test::resetHardware();
+    model.powerOn(false);
+    test::attachPinDevice(&model);
+    test::attachSpiPeripheral(&model);
+
+    PMW3360DM &sensor = PMW3360DM::create<1>(ThreadSafeSPI, NCS_PIN, MOTION_PIN);
+    CHECK(sensor.start() == false);
+    CHECK(PointingSensors.get(1) == &other);
+    CHECK_EQ(0, model.counters.resets);
+    CHECK_EQ(0, model.counters.bursts);
+    CHECK(model.inBurstMode() == false);
+  }
+} // namespace
+
+int main()
+{
+  testColdStart();
+  testWarmStart();
+  testBurstModeIsKept();
+  testReadMotion();
+  testWriteRegisterLeavesBurstMode();
+  testRestartLeavesBurstMode();
+  testCaptureFrame();
+  testDuplicateId();
+  return test::testResult("PMW3360DM");
+}
@@ -0,0 +1,91 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// テストとベンチマークで使う代表的なReport Map
+
+namespace test
+{
+  // キーボード(ID 1) + コンシューマ(ID 2) + マウス(ID 3)の複合デバイス
+  const uint8_t Composite_Report_Map[] = {
+      // Keyboard
+      0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01,
+      0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01, 0x95, 0x08, 0x75, 0x01, 0x81, 0x02, // modifiers
+      0x95, 0x01, 0x75, 0x08, 0x81, 0x01,                                                             // reserved
+      0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x95, 0x05, 0x75, 0x01, 0x91, 0x02,                         // LED (Output)
+      0x95, 0x01, 0x75, 0x03, 0x91, 0x01,
+      0x05, 0x07, 0x19, 0x00, 0x2A, 0xFF, 0x00, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x95, 0x06, 0x75, 0x08, 0x81, 0x00, // key codes
+      0xC0,
+      // Consumer
+      0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x02,
+      0x15, 0x00, 0x26, 0xFF, 0x03, 0x19, 0x00, 0x2A, 0xFF, 0x03, 0x95, 0x01, 0x75, 0x10, 0x81, 0x00,
+      0xC0,
+      // Mouse
+      0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x03, 0x09, 0x01, 0xA1, 0x00,
+      0x05, 0x09, 0x19, 0x01, 0x29, 0x05, 0x15, 0x00, 0x25, 0x01, 0x95, 0x05, 0x75, 0x01, 0x81, 0x02, // buttons
+      0x95, 0x01, 0x75, 0x03, 0x81, 0x01,                                                             // padding
+      0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x81, 0x25, 0x7F, 0x95, 0x02, 0x75, 0x08, 0x81, 0x06, // X, Y
+      0x09, 0x38, 0x15, 0x81, 0x25, 0x7F, 0x95, 0x01, 0x75, 0x08, 0x81, 0x06,                         // wheel
+      0x05, 0x0C, 0x0A, 0x38, 0x02, 0x15, 0x81, 0x25, 0x7F, 0x95, 0x01, 0x75, 0x08, 0x81, 0x06,       // AC Pan
+      0xC0, 0xC0};
+
+  // 16ボタン、X/Yを12bitに詰めたゲーミングマウスに多い形式(ID 2)
+  const uint8_t Packed_Mouse_Report_Map[] = {
+      0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x02, 0x09, 0x01, 0xA1, 0x00,
+      0x05, 0x09, 0x19, 0x01, 0x29, 0x10, 0x15, 0x00, 0x25, 0x01, 0x95, 0x10, 0x75, 0x01, 0x81, 0x02,        // buttons
+      0x05, 0x01, 0x16, 0x01, 0xF8, 0x26, 0xFF, 0x07, 0x75, 0x0C, 0x95, 0x02, 0x09, 0x30, 0x09, 0x31, 0x81, 0x06, // X, Y
+      0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x01, 0x09, 0x38, 0x81, 0x06,                                // wheel
+      0x05, 0x0C, 0x0A, 0x38, 0x02, 0x95, 0x01, 0x81, 0x06,                                                  // AC Pan
+      0xC0, 0xC0};
+
+  // Logical Minimumが1のキー配列、0は範囲外なのでキー無し(Report IDなし)
+  const uint8_t Offset_Array_Report_Map[] = {
+      0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+      0x05, 0x07, 0x19, 0x04, 0x29, 0x1D, 0x15, 0x01, 0x25, 0x1A, 0x95, 0x02, 0x75, 0x08, 0x81, 0x00,
+      0xC0};
+
+  // Logical Maximumを1byteの0xFF(符号無しで255)で書いたキー配列
+  const uint8_t Short_Logical_Maximum_Report_Map[] = {
+      0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+      0x05, 0x07, 0x19, 0x00, 0x29, 0xFF, 0x15, 0x00, 0x25, 0xFF, 0x95, 0x06, 0x75, 0x08, 0x81, 0x00,
+      0xC0};
+
+  // NKROキーボード(ID 1)、Usage 0x00 ~ 0x97のキーを1bitずつのビットマップで送る
+  const uint8_t Nkro_Keyboard_Report_Map[] = {
+      0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01,
+      0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, // modifiers
+      0x19, 0x00, 0x29, 0x97, 0x95, 0x98, 0x81, 0x02,                                                 // key bitmap
+      0xC0};
+
+  // Report Countを2byte(256)で書いたベンダー定義のレポート(ID 2)
+  const uint8_t Long_Report_Count_Report_Map[] = {
+      0x06, 0x00, 0xFF, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x02,
+      0x09, 0x02, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x96, 0x00, 0x01, 0x81, 0x02,
+      0xC0};
+
+} // namespace test
@@ -0,0 +1,209 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "HostHardware.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace test
+{
+  // 74HC595(行)と74HC165(列)のチェーンのモデル、165のQHは74HC125を通ってMISOにつながる
+  // 行はLOWでアクティブ、列はプルアップされていて、押されているスイッチがアクティブな行につながる
+  // チップセレクト(165のCLK INHと74HC125の/OE)とバスの取得の誤りはerrorsに数える
+  class ShiftRegisterChain : public PinDevice, public SpiPeripheral
+  {
+  public:
+    static constexpr int MAX_ROWS = 64;
+    static constexpr int MAX_COLS = 32;
+
+    ShiftRegisterChain(int rows_len, int cols_len, uint8_t cs_pin, uint8_t latch_pin, uint8_t load_pin)
+        : errors(0), transactions(0),
+          _rows_len(rows_len), _cols_len(cols_len), _row_bytes((rows_len + 7) / 8), _col_bytes((cols_len + 7) / 8),
+          _cs_pin(cs_pin), _latch_pin(latch_pin), _load_pin(load_pin),
+          _cs(1), _latch(0), _load(1), _bus_held(false), _foreign_bytes(0)
+    {
+      memset(_sr595, 0xff, sizeof(_sr595));
+      memset(_out595, 0xff, sizeof(_out595));
+      memset(_sr165, 0xff, sizeof(_sr165));
+      memset(_pressed, 0, sizeof(_pressed));
+    }
+
+    void press(int row, int col, bool pressed = true)
+    {
+      _pressed[row][col] = pressed;
+    }
+
+    void releaseAll()
+    {
+      memset(_pressed, 0, sizeof(_pressed));
+    }
+
+    // バスを解放する度に、他のデバイスの転送としてチップセレクトHIGHのままbytesバイト流す
+    void setForeignTraffic(int bytes)
+    {
+      _foreign_bytes = bytes;
+    }
+
+    // 595の出力で選択されている行、無ければ-1
+    int activeRow()
+    {
+      int row = -1;
+      for (int r = 0; r < _rows_len; r++)
+      {
+        if ((_out595[r / 8] & (1 << (r % 8))) == 0)
+        {
+          if (row != -1)
+          {
+            errors++; // 複数の行が同時にアクティブ
+          }
+          row = r;
+        }
+      }
+      return row;
+    }
+
+    void onDigitalWrite(uint8_t pin, uint8_t value) override
+    {
+      if (pin == _cs_pin)
+      {
+        _cs = value;
+      }
+      else if (pin == _latch_pin)
+      {
+        if (_latch == 0 && value == 1)
+        {
+          // バスを空けた後にラッチすると他のデバイスの転送が595に入っている
+          if (_bus_held == false)
+          {
+            errors++;
+          }
+          memcpy(_out595, _sr595, sizeof(_out595));
+          latched_rows.push_back(activeRow());
+        }
+        _latch = value;
+      }
+      else if (pin == _load_pin)
+      {
+        if (_load == 1 && value == 0)
+        {
+          parallelLoad();
+        }
+        _load = value;
+      }
+    }
+
+    // 595はチップセレクトに関係なくシフトする
+    // 165はチップセレクトがLOWの間だけシフトしてMISOを駆動し、HIGHならMISOはプルアップ
+    uint8_t exchange(uint8_t mosi) override
+    {
+      for (int i = _row_bytes - 1; i > 0; i--)
+      {
+        _sr595[i] = _sr595[i - 1];
+      }
+      _sr595[0] = mosi;
+
+      if (_cs == 1)
+      {
+        // ドライバがチップセレクトを下げずに転送した
+        if (_bus_held)
+        {
+          errors++;
+        }
+        return 0xff;
+      }
+      // バスを持たずに165をMISOにつないだ
+      if (_bus_held == false)
+      {
+        errors++;
+      }
+      uint8_t miso = _sr165[0];
+      for (int i = 0; i < _col_bytes - 1; i++)
+      {
+        _sr165[i] = _sr165[i + 1];
+      }
+      _sr165[_col_bytes - 1] = 0xff; // 一番遠い165のSERはプルアップ
+      return miso;
+    }
+
+    void onBeginTransaction() override
+    {
+      transactions++;
+      _bus_held = true;
+    }
+
+    void onEndTransaction() override
+    {
+      _bus_held = false;
+      for (int i = 0; i < _foreign_bytes; i++)
+      {
+        exchange(0x5a);
+      }
+    }
+
+    int errors;
+    int transactions;
+    // ラッチ毎に選択された行、全行非アクティブは-1
+    std::vector<int> latched_rows;
+
+  private:
+    // SH/LDの立ち下がりでアクティブな行の列を165に取り込む
+    void parallelLoad()
+    {
+      int row = activeRow();
+      memset(_sr165, 0xff, sizeof(_sr165));
+      if (row < 0)
+      {
+        return;
+      }
+      for (int c = 0; c < _cols_len; c++)
+      {
+        if (_pressed[row][c])
+        {
+          _sr165[c / 8] &= ~(1 << (c % 8));
+        }
+      }
+    }
+
+    int _rows_len;
+    int _cols_len;
+    int _row_bytes;
+    int _col_bytes;
+    uint8_t _cs_pin;
+    uint8_t _latch_pin;
+    uint8_t _load_pin;
+    uint8_t _cs;
+    uint8_t _latch;
+    uint8_t _load;
+    bool _bus_held;
+    int _foreign_bytes;
+    // 添字0がMCUに一番近いシフトレジスタ
+    uint8_t _sr595[MAX_ROWS / 8];
+    uint8_t _out595[MAX_ROWS / 8];
+    uint8_t _sr165[MAX_COLS / 8];
+    bool _pressed[MAX_ROWS][MAX_COLS];
+  };
+} // namespace test
@@ -0,0 +1,85 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "ShiftRegisterChain.h"
+#include "ShiftRegisterMatrixScan.h"
+#include "bench.h"
+#include <chrono>
+
+using namespace hidpg;
+
+// 1回のスキャンにかかるホストのCPU時間、シフトレジスタのモデルの処理も含む
+// SPIの転送時間は含まないので、行数と列のバイト数に対するドライバの処理の伸び方を見る
+
+namespace
+{
+  constexpr uint8_t CS_PIN = 10;
+  constexpr uint8_t LATCH_PIN = 11;
+  constexpr uint8_t LOAD_PIN = 12;
+  constexpr uint32_t SCANS = 20000;
+
+  Switch small_matrix[8][16];
+  Switch large_matrix[64][32];
+
+  template <uint8_t rows_len, uint8_t cols_len>
+  void benchScan(const char *name, Switch (&matrix)[rows_len][cols_len])
+  {
+    for (int r = 0; r < rows_len; r++)
+    {
+      for (int c = 0; c < cols_len; c++)
+      {
+        matrix[r][c] = Switch((r * cols_len + c) % 255 + 1);
+      }
+    }
+
+    test::ShiftRegisterChain chain(rows_len, cols_len, CS_PIN, LATCH_PIN, LOAD_PIN);
+    // 押しっぱなしのキーがあるとデバウンスの間隔でスキャンし続ける
+    chain.press(rows_len - 1, cols_len - 1);
+    test::attachPinDevice(&chain);
+    test::attachSpiPeripheral(&chain);
+
+    ShiftRegisterMatrixScan.setMatrix(matrix, CS_PIN, LATCH_PIN, LOAD_PIN);
+    ShiftRegisterMatrixScan.start();
+    void *task = test::findTask("SRMatrixScan");
+
+    // タスクとの切り替えは1回だけなので、ほぼスキャンの時間になる
+    auto start = std::chrono::steady_clock::now();
+    test::runTask(task, SCANS);
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / SCANS;
+    printf("  %-40s %10.1f ns/op\n", name, ns);
+
+    ShiftRegisterMatrixScan.stop();
+    test::runTask(task, 1);
+    test::benchSink() += chain.errors;
+  }
+} // namespace
+
+int main()
+{
+  printf("ShiftRegisterMatrixScan\n");
+  benchScan("scan 8x16", small_matrix);
+  benchScan("scan 64x32", large_matrix);
+  return 0;
+}
@@ -0,0 +1,240 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "ShiftRegisterChain.h"
+#include "ShiftRegisterMatrixScan.h"
+#include "test.h"
+
+using namespace hidpg;
+
+namespace
+{
+  constexpr uint8_t CS_PIN = 10;
+  constexpr uint8_t LATCH_PIN = 11;
+  constexpr uint8_t LOAD_PIN = 12;
+
+  // 行も列も1バイトをまたぐ大きさ
+  constexpr int ROWS = 10;
+  constexpr int COLS = 12;
+  // デバウンスが確定するのに十分なスキャン回数
+  constexpr uint32_t SETTLE_SCANS = 20;
+  // 15サンプルでは1msのポーリング間隔に収まらないデバウンス時間
+  constexpr int LONG_DEBOUNCE_ROW = 6;
+  constexpr int LONG_DEBOUNCE_COL = 6;
+  constexpr uint16_t LONG_DEBOUNCE_MS = 40;
+
+  Switch matrix[ROWS][COLS];
+  test::ShiftRegisterChain chain(ROWS, COLS, CS_PIN, LATCH_PIN, LOAD_PIN);
+  void *task = nullptr;
+
+  Set last_ids;
+  int callbacks = 0;
+
+  key_id_t idAt(int row, int col)
+  {
+    return row * COLS + col + 1;
+  }
+
+  void onChange(const Set &ids)
+  {
+    last_ids = ids;
+    callbacks++;
+  }
+
+  // 1回のスキャンは行0から順にラッチして、最後に全行を非アクティブにする
+  bool isScanSequence(const std::vector<int> &rows, size_t begin)
+  {
+    for (int r = 0; r <= ROWS; r++)
+    {
+      if (rows[begin + r] != ((r < ROWS) ? r : -1))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void testRowSequence()
+  {
+    chain.latched_rows.clear();
+    chain.transactions = 0;
+
+    CHECK_EQ(3, test::runTask(task, 3));
+
+    CHECK_EQ(3 * (ROWS + 1), chain.latched_rows.size());
+    for (int i = 0; i < 3; i++)
+    {
+      CHECK(isScanSequence(chain.latched_rows, i * (ROWS + 1)));
+    }
+    // 1行毎にバスを取って解放する
+    CHECK_EQ(3 * (ROWS + 1), chain.transactions);
+    CHECK_EQ(0, chain.errors);
+  }
+
+  // 行rを選択した後に読んだ列は行rのスイッチとして扱われ、列cは165のD(c%8)から読まれる
+  void testSwitchPositions()
+  {
+    const int positions[][2] = {{0, 0}, {0, 7}, {0, 8}, {0, 11}, {7, 3}, {8, 3}, {9, 0}, {5, 10}};
+    for (auto &pos : positions)
+    {
+      chain.press(pos[0], pos[1]);
+      test::runTask(task, SETTLE_SCANS);
+      CHECK_EQ(1, last_ids.count());
+      CHECK(last_ids.contains(idAt(pos[0], pos[1])));
+
+      chain.releaseAll();
+      test::runTask(task, SETTLE_SCANS);
+      CHECK_EQ(0, last_ids.count());
+    }
+
+    // 同じ列の隣り合う行を同時に押しても混ざらない
+    chain.press(3, 5);
+    chain.press(4, 5);
+    chain.press(4, 9);
+    test::runTask(task, SETTLE_SCANS);
+    CHECK_EQ(3, last_ids.count());
+    CHECK(last_ids.contains(idAt(3, 5)));
+    CHECK(last_ids.contains(idAt(4, 5)));
+    CHECK(last_ids.contains(idAt(4, 9)));
+    chain.releaseAll();
+    test::runTask(task, SETTLE_SCANS);
+    CHECK_EQ(0, chain.errors);
+  }
+
+  // スイッチが無いセルは押されても無視する
+  void testMissingSwitch()
+  {
+    int before = callbacks;
+    chain.press(ROWS - 1, COLS - 1);
+    test::runTask(task, SETTLE_SCANS);
+    CHECK_EQ(before, callbacks);
+    CHECK_EQ(0, last_ids.count());
+    chain.releaseAll();
+  }
+
+  // 行の合間に他のデバイスが転送しても行の選択と列の読み取りは乱れない
+  void testSharedBus()
+  {
+    chain.setForeignTraffic(4);
+    chain.latched_rows.clear();
+
+    chain.press(8, 11);
+    test::runTask(task, SETTLE_SCANS);
+    CHECK_EQ(1, last_ids.count());
+    CHECK(last_ids.contains(idAt(8, 11)));
+    for (uint32_t i = 0; i < SETTLE_SCANS; i++)
+    {
+      CHECK(isScanSequence(chain.latched_rows, i * (ROWS + 1)));
+    }
+
+    chain.releaseAll();
+    test::runTask(task, SETTLE_SCANS);
+    CHECK_EQ(0, last_ids.count());
+    CHECK_EQ(0, chain.errors);
+    chain.setForeignTraffic(0);
+  }
+
+  // 押してから確定するまでの仮想時間
+  uint64_t settleTime(key_id_t id, bool pressed)
+  {
+    uint64_t start_us = test::nowMicros();
+    for (int i = 0; i < 100 && last_ids.contains(id) != pressed; i++)
+    {
+      test::runTask(task, 1);
+    }
+    CHECK(last_ids.contains(id) == pressed);
+    return test::nowMicros() - start_us;
+  }
+
+  // デバウンス時間がサンプル数の上限を超えるスイッチがあるとポーリング間隔を広げて時間を守る
+  void testLongDebounce()
+  {
+    key_id_t id = idAt(LONG_DEBOUNCE_ROW, LONG_DEBOUNCE_COL);
+
+    chain.press(LONG_DEBOUNCE_ROW, LONG_DEBOUNCE_COL);
+    uint64_t press_us = settleTime(id, true);
+    CHECK(press_us >= LONG_DEBOUNCE_MS * 1000UL);
+    CHECK(press_us <= (LONG_DEBOUNCE_MS + 6) * 1000UL);
+
+    chain.releaseAll();
+    uint64_t release_us = settleTime(id, false);
+    CHECK(release_us >= LONG_DEBOUNCE_MS * 1000UL);
+    CHECK(release_us <= (LONG_DEBOUNCE_MS + 6) * 1000UL);
+    CHECK_EQ(0, chain.errors);
+  }
+
+  // 動作中のstart()は何もせず、その後のstop()で確実に止まる
+  void testStartWhileRunning()
+  {
+    ShiftRegisterMatrixScan.start();
+    ShiftRegisterMatrixScan.stop();
+
+    // stop()は全行を非アクティブにする
+    CHECK_EQ(-1, chain.latched_rows.back());
+    size_t latches = chain.latched_rows.size();
+
+    // 余分な通知が残っているとタスクはstop()を無視してスキャンを続ける
+    CHECK_EQ(0, test::runTask(task, 5));
+    CHECK(test::isTaskBlocked(task));
+    CHECK_EQ(latches, chain.latched_rows.size());
+
+    // start()で再開する
+    chain.latched_rows.clear();
+    ShiftRegisterMatrixScan.start();
+    CHECK_EQ(2, test::runTask(task, 2));
+    CHECK(test::isTaskBlocked(task) == false);
+    CHECK_EQ(2 * (ROWS + 1), chain.latched_rows.size());
+    CHECK_EQ(0, chain.errors);
+  }
+} // namespace
+
+int main()
+{
+  for (int r = 0; r < ROWS; r++)
+  {
+    for (int c = 0; c < COLS; c++)
+    {
+      matrix[r][c] = Switch(idAt(r, c));
+    }
+  }
+  matrix[ROWS - 1][COLS - 1] = NO_SW;
+  matrix[LONG_DEBOUNCE_ROW][LONG_DEBOUNCE_COL] = Switch(idAt(LONG_DEBOUNCE_ROW, LONG_DEBOUNCE_COL), LONG_DEBOUNCE_MS);
+
+  test::attachPinDevice(&chain);
+  test::attachSpiPeripheral(&chain);
+
+  ShiftRegisterMatrixScan.setMatrix(matrix, CS_PIN, LATCH_PIN, LOAD_PIN);
+  ShiftRegisterMatrixScan.setCallback(onChange);
+  ShiftRegisterMatrixScan.start();
+  task = test::findTask("SRMatrixScan");
+  CHECK(task != nullptr);
+
+  testRowSequence();
+  testSwitchPositions();
+  testMissingSwitch();
+  testSharedBus();
+  testLongDebounce();
+  testStartWhileRunning();
+  return test::testResult("ShiftRegisterMatrixScan");
+}
@@ -0,0 +1,96 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "Switch.h"
+#include "test.h"
+
+// IDの重複チェックはstatic_assertで使うので、ここでのチェックもコンパイル時に行う
+// ShiftRegisterMatrixScanの最大の64 x 32でもconstexprの再帰の深さと計算量の制限に収まること
+
+using namespace hidpg;
+
+namespace
+{
+#define NO_SW_4 NO_SW, NO_SW, NO_SW, NO_SW
+#define NO_SW_16 NO_SW_4, NO_SW_4, NO_SW_4, NO_SW_4
+#define NO_SW_ROW {NO_SW_16, NO_SW_16}
+#define SW_4(id) Switch(id), Switch(id + 1), Switch(id + 2), Switch(id + 3)
+#define SW_16(id) SW_4(id), SW_4(id + 4), SW_4(id + 8), SW_4(id + 12)
+// 1行に16個、左右の端に8個ずつ
+#define SW_ROW(id) {SW_4(id), SW_4(id + 4), NO_SW_16, SW_4(id + 8), SW_4(id + 12)}
+#define NO_SW_ROWS_16 NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, \
+                      NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW, NO_SW_ROW
+
+  // 8bitのキーIDを全て使った64 x 32の行列、IDを持つ行と持たない行が交互に並ぶ
+#define FULL_MATRIX(last_id)                                                                                                     \
+  {                                                                                                                              \
+    SW_ROW(0), NO_SW_ROW, SW_ROW(16), NO_SW_ROW, SW_ROW(32), NO_SW_ROW, SW_ROW(48), NO_SW_ROW,                                   \
+        SW_ROW(64), NO_SW_ROW, SW_ROW(80), NO_SW_ROW, SW_ROW(96), NO_SW_ROW, SW_ROW(112), NO_SW_ROW,                             \
+        SW_ROW(128), NO_SW_ROW, SW_ROW(144), NO_SW_ROW, SW_ROW(160), NO_SW_ROW, SW_ROW(176), NO_SW_ROW,                          \
+        SW_ROW(192), NO_SW_ROW, SW_ROW(208), NO_SW_ROW, SW_ROW(224), NO_SW_ROW,                                                  \
+        {SW_4(240), SW_4(244), NO_SW_16, SW_4(248), Switch(252), Switch(253), Switch(254), Switch(last_id)}, NO_SW_ROW,          \
+        NO_SW_ROWS_16, NO_SW_ROWS_16                                                                                             \
+  }
+
+  constexpr Switch unique_matrix[64][32] = FULL_MATRIX(255);
+  static_assert(Internal::hasUniqueSwitchIds(unique_matrix), "all 256 ids are unique");
+
+  // 最初と最後のスイッチのIDが同じ
+  constexpr Switch first_last_matrix[64][32] = FULL_MATRIX(0);
+  static_assert(Internal::hasUniqueSwitchIds(first_last_matrix) == false, "first and last ids are the same");
+
+  // 同じ行の隣、別のワード(64個毎のIDの範囲)
+  constexpr Switch small_matrix[2][4] = {
+      {Switch(1), Switch(1), NO_SW, Switch(200)},
+      {Switch(63), Switch(64), Switch(128), NO_SW},
+  };
+  static_assert(Internal::hasUniqueSwitchIds(small_matrix) == false, "adjacent ids are the same");
+
+  constexpr Switch words_matrix[2][4] = {
+      {Switch(0), Switch(63), NO_SW, Switch(200)},
+      {Switch(64), Switch(127), Switch(128), Switch(255)},
+  };
+  static_assert(Internal::hasUniqueSwitchIds(words_matrix), "ids across words are unique");
+
+  constexpr Switch cross_word_matrix[2][4] = {
+      {Switch(0), Switch(63), NO_SW, Switch(200)},
+      {Switch(64), Switch(127), Switch(200), Switch(255)},
+  };
+  static_assert(Internal::hasUniqueSwitchIds(cross_word_matrix) == false, "200 is used twice");
+
+  // スイッチが無い場所はIDが0でも重複にしない
+  constexpr Switch no_sw_matrix[1][3] = {{Switch(0), NO_SW, NO_SW}};
+  static_assert(Internal::hasUniqueSwitchIds(no_sw_matrix), "NO_SW has no id");
+
+  constexpr Switch single_matrix[1][1] = {{Switch(7)}};
+  static_assert(Internal::hasUniqueSwitchIds(single_matrix), "single switch");
+} // namespace
+
+int main()
+{
+  // 実行時にも同じ結果になる
+  CHECK(Internal::hasUniqueSwitchIds(unique_matrix));
+  CHECK(Internal::hasUniqueSwitchIds(first_last_matrix) == false);
+  return test::testResult("Switch");
+}
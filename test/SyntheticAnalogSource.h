@@ -0,0 +1,142 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "AnalogSource.h"
+#include "AnalogKeyScan_config.h"
+#include <stdint.h>
+
+namespace test
+{
+
+  // キーストロークの時間変化、折れ線のキーフレームで表す
+  // 時刻はサンプル(スキャン)数、位置は0.01mm単位
+  struct TravelPoint
+  {
+    uint32_t time;
+    uint16_t travel;
+  };
+
+  class TravelCurve
+  {
+  public:
+    TravelCurve() : _points(nullptr), _len(0) {}
+
+    template <uint8_t len>
+    TravelCurve(const TravelPoint (&points)[len]) : _points(points), _len(len)
+    {
+    }
+
+    // 時刻tでの位置、キーフレームの間は線形補間、範囲外は端の値
+    uint16_t travelAt(uint32_t t) const
+    {
+      if (_len == 0)
+      {
+        return 0;
+      }
+      if (t <= _points[0].time)
+      {
+        return _points[0].travel;
+      }
+      for (uint8_t i = 1; i < _len; i++)
+      {
+        const TravelPoint &a = _points[i - 1];
+        const TravelPoint &b = _points[i];
+        if (t <= b.time)
+        {
+          int32_t dt = b.time - a.time;
+          int32_t dx = static_cast<int32_t>(b.travel) - a.travel;
+          return a.travel + dx * static_cast<int32_t>(t - a.time) / dt;
+        }
+      }
+      return _points[_len - 1].travel;
+    }
+
+    // 位置が最初にthreshold以上(rising)、またはthreshold未満(falling)になる時刻、無ければUINT32_MAX
+    uint32_t firstCrossing(uint16_t threshold, bool rising, uint32_t from = 0) const
+    {
+      uint32_t end = (_len > 0) ? _points[_len - 1].time : 0;
+      for (uint32_t t = from; t <= end; t++)
+      {
+        if ((travelAt(t) >= threshold) == rising)
+        {
+          return t;
+        }
+      }
+      return UINT32_MAX;
+    }
+
+  private:
+    const TravelPoint *_points;
+    uint8_t _len;
+  };
+
+  // チャンネル毎のTravelCurveからADCの値を合成するAnalogSource
+  // read()を1回呼ぶ毎に1サンプル進む、ノイズは再現性のある擬似乱数
+  template <uint8_t channels>
+  class SyntheticAnalogSource : public hidpg::AnalogSource
+  {
+  public:
+    SyntheticAnalogSource(uint16_t rest = 2000, int16_t range = 600, uint16_t noise = 0)
+        : _rest(rest), _range(range), _noise(noise), _time(0), _seed(1)
+    {
+    }
+
+    void begin() override {}
+
+    void read(uint16_t values[], uint8_t len) override
+    {
+      for (uint8_t i = 0; i < len && i < channels; i++)
+      {
+        int32_t value = _rest + static_cast<int32_t>(_range) * _curves[i].travelAt(_time) / ANALOG_KEY_SCAN_TOTAL_TRAVEL;
+        if (_noise > 0)
+        {
+          value += static_cast<int32_t>(nextRandom() % (2 * _noise + 1)) - _noise;
+        }
+        values[i] = (value < 0) ? 0 : (value > 4095) ? 4095 : value;
+      }
+      _time++;
+    }
+
+    void setCurve(uint8_t channel, const TravelCurve &curve) { _curves[channel] = curve; }
+    uint32_t time() const { return _time; }
+    void setTime(uint32_t time) { _time = time; }
+
+  private:
+    uint32_t nextRandom()
+    {
+      _seed = _seed * 1103515245 + 12345;
+      return _seed >> 16;
+    }
+
+    TravelCurve _curves[channels];
+    uint16_t _rest;
+    int16_t _range;
+    uint16_t _noise;
+    uint32_t _time;
+    uint32_t _seed;
+  };
+
+} // namespace test
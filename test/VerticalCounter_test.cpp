@@ -0,0 +1,271 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "VerticalCounter.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+using namespace hidpg;
+
+namespace
+{
+  // 1ビット分の素直な実装、VerticalCounterの各ビットと比較する
+  struct ReferenceCounter
+  {
+    uint8_t press_threshold;
+    uint8_t release_threshold;
+    bool eager;
+    bool state;
+    bool locked;
+    uint8_t count;
+
+    bool update(bool raw)
+    {
+      if (eager)
+      {
+        if (locked)
+        {
+          // ロック中は入力を無視し、閾値の回数のサンプルでロック解除
+          count++;
+          if (count == (state ? press_threshold : release_threshold))
+          {
+            locked = false;
+            count = 0;
+          }
+          return false;
+        }
+        if (raw != state)
+        {
+          state = raw;
+          locked = true;
+          count = 0;
+          return true;
+        }
+        return false;
+      }
+
+      if (raw == state)
+      {
+        count = 0;
+        return false;
+      }
+      count++;
+      if (count == (state ? release_threshold : press_threshold))
+      {
+        state = raw;
+        count = 0;
+        return true;
+      }
+      return false;
+    }
+  };
+
+  // samplesを順に入力し、各サンプルの確定状態を'0'/'1'の文字列で返す
+  void trace(VerticalCounter &counter, const char *samples, char *out)
+  {
+    for (; *samples != '\0'; samples++, out++)
+    {
+      counter.update(*samples == '1' ? 1 : 0);
+      *out = (counter.state() & 1) ? '1' : '0';
+    }
+    *out = '\0';
+  }
+
+  void checkTrace(uint8_t press, uint8_t release, bool eager, const char *samples, const char *expected)
+  {
+    VerticalCounter counter;
+    counter.configure(0, press, release, eager);
+    char out[64];
+    trace(counter, samples, out);
+    if (strcmp(out, expected) != 0)
+    {
+      printf("press=%d release=%d eager=%d\n  in:       %s\n  expected: %s\n  actual:   %s\n", press, release, eager, samples, expected, out);
+      test::failures()++;
+    }
+  }
+
+  void testDeferTrace()
+  {
+    // 閾値の回数だけ連続したら反転する
+    checkTrace(1, 1, false, "0110100", "0110100");
+    checkTrace(2, 2, false, "0101101100", "0000111110");
+    checkTrace(3, 1, false, "011011100", "000000100");
+    checkTrace(1, 3, false, "011010001", "011111101");
+  }
+
+  void testDeferThreshold(uint8_t threshold)
+  {
+    // 押下: 閾値-1回では反転せず、閾値回目で反転する
+    VerticalCounter counter;
+    counter.configure(0, threshold, threshold, false);
+    for (uint8_t i = 0; i < threshold - 1; i++)
+    {
+      CHECK_EQ(0, counter.update(1));
+    }
+    CHECK_EQ(1, counter.update(1));
+    CHECK_EQ(1, counter.state());
+    CHECK_EQ(0, counter.pending());
+
+    // 離す: 途中で戻ったらカウントをやり直す
+    for (uint8_t i = 0; i < threshold - 1; i++)
+    {
+      CHECK_EQ(0, counter.update(0));
+    }
+    CHECK_EQ(0, counter.update(1));
+    for (uint8_t i = 0; i < threshold - 1; i++)
+    {
+      CHECK_EQ(0, counter.update(0));
+    }
+    CHECK_EQ(1, counter.update(0));
+    CHECK_EQ(0, counter.state());
+    CHECK_EQ(0, counter.pending());
+  }
+
+  void testEagerTrace()
+  {
+    // 最初のエッジで反転し、その後閾値の回数のサンプルは無視する
+    checkTrace(1, 1, true, "0101000", "0111000");
+    checkTrace(2, 2, true, "0100110000", "0111110000");
+    checkTrace(3, 1, true, "01000110", "01111110");
+  }
+
+  // Eager: 反転後ちょうど閾値の回数のサンプルだけ変化を無視する
+  void testEagerThreshold(uint8_t press, uint8_t release)
+  {
+    VerticalCounter counter;
+    counter.configure(0, press, release, true);
+
+    // 押下は最初のエッジで反転する
+    CHECK_EQ(1, counter.update(1));
+    CHECK_EQ(1, counter.state());
+
+    // 押下の閾値の回数のサンプルは離しても無視される
+    for (uint8_t i = 0; i < press; i++)
+    {
+      CHECK(counter.pending() != 0);
+      CHECK_EQ(0, counter.update(0));
+      CHECK_EQ(1, counter.state());
+    }
+    CHECK_EQ(0, counter.pending());
+
+    // ロック解除直後のサンプルで反転する
+    CHECK_EQ(1, counter.update(0));
+    CHECK_EQ(0, counter.state());
+
+    // 離した後は離したときの閾値の回数のサンプルを無視する
+    for (uint8_t i = 0; i < release; i++)
+    {
+      CHECK(counter.pending() != 0);
+      CHECK_EQ(0, counter.update(1));
+      CHECK_EQ(0, counter.state());
+    }
+    CHECK_EQ(0, counter.pending());
+    CHECK_EQ(1, counter.update(1));
+    CHECK_EQ(1, counter.state());
+  }
+
+  // 32ビットそれぞれに異なる設定をして、ランダムな入力でReferenceCounterと比較する
+  void testRandomAgainstReference(bool with_eager)
+  {
+    srand(1);
+    for (int round = 0; round < 200; round++)
+    {
+      VerticalCounter counter;
+      ReferenceCounter ref[32];
+      for (uint8_t bit = 0; bit < 32; bit++)
+      {
+        uint8_t press = 1 + rand() % VerticalCounter::MAX_THRESHOLD;
+        uint8_t release = 1 + rand() % VerticalCounter::MAX_THRESHOLD;
+        bool eager = with_eager && (rand() & 1);
+        counter.configure(bit, press, release, eager);
+        ref[bit] = ReferenceCounter{press, release, eager, false, false, 0};
+      }
+
+      // 入力が変わる確率を変えてチャタリングと安定した入力の両方を作る
+      int flip_percent = 5 + rand() % 60;
+      uint32_t raw = 0;
+      for (int sample = 0; sample < 500; sample++)
+      {
+        for (uint8_t bit = 0; bit < 32; bit++)
+        {
+          if (rand() % 100 < flip_percent)
+          {
+            raw ^= 1UL << bit;
+          }
+        }
+
+        uint32_t expected_changed = 0;
+        for (uint8_t bit = 0; bit < 32; bit++)
+        {
+          if (ref[bit].update((raw >> bit) & 1))
+          {
+            expected_changed |= 1UL << bit;
+          }
+        }
+        uint32_t changed = counter.update(raw);
+        if (changed != expected_changed)
+        {
+          printf("round %d sample %d: changed %08x != %08x\n", round, sample, changed, expected_changed);
+          test::failures()++;
+          return;
+        }
+      }
+    }
+  }
+
+  void testReset()
+  {
+    VerticalCounter counter;
+    counter.configure(0, 3, 3, false);
+    counter.update(1);
+    counter.update(1);
+    CHECK(counter.pending() != 0);
+    counter.reset(1);
+    CHECK_EQ(1, counter.state());
+    CHECK_EQ(0, counter.pending());
+    CHECK_EQ(0, counter.update(1));
+  }
+} // namespace
+
+int main()
+{
+  testDeferTrace();
+  testDeferThreshold(1);
+  testDeferThreshold(2);
+  testDeferThreshold(15);
+  testRandomAgainstReference(false);
+  testEagerTrace();
+  uint8_t thresholds[] = {1, 2, 15};
+  for (uint8_t press : thresholds)
+  {
+    for (uint8_t release : thresholds)
+    {
+      testEagerThreshold(press, release);
+    }
+  }
+  testRandomAgainstReference(true);
+  testReset();
+  return test::testResult("VerticalCounter");
+}
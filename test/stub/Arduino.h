@@ -0,0 +1,102 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+// ホストでドライバをビルドするためのArduino.hのスタブ
+// ピンと時間はHostHardwareの模擬ハードウェアにつながる
+
+#include "FreeRTOS.h"
+#include "HostHardware.h"
+#include "semphr.h"
+#include "task.h"
+#include <algorithm>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO_ARCH_NRF52
+#include "nrf.h"
+#include "nrf_gpio.h"
+#endif
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define FALLING 3
+#define CHANGE 4
+#define MSBFIRST 1
+#define INPUT_PULLUP_SENSE 5
+#define INPUT_PULLDOWN_SENSE 6
+#define INPUT_SENSE_LOW 7
+#define INPUT_SENSE_HIGH 8
+
+typedef void (*voidFuncPtr)(void);
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define bit(b) (1UL << (b))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+
+#ifdef ARDUINO_ARCH_NRF52
+// ピンの設定と出力はポートのモデルのPIN_CNFとOUTレジスタにも反映する
+extern const uint32_t g_ADigitalPinMap[];
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+  test::hostNrfPinMode(pin, mode);
+  test::hostPinMode(pin, mode);
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value)
+{
+  uint32_t bit = g_ADigitalPinMap[pin];
+  NRF_GPIO_Type *port = nrf_gpio_pin_port_decode(&bit);
+  if (value)
+  {
+    port->OUTSET = 1UL << bit;
+  }
+  else
+  {
+    port->OUTCLR = 1UL << bit;
+  }
+}
+#else
+inline void pinMode(uint8_t pin, uint8_t mode) { test::hostPinMode(pin, mode); }
+inline void digitalWrite(uint8_t pin, uint8_t value) { test::hostDigitalWrite(pin, value); }
+#endif
+
+inline int digitalRead(uint8_t pin) { return test::hostDigitalRead(pin); }
+inline void delay(uint32_t ms) { test::advanceMicros(static_cast<uint64_t>(ms) * 1000); }
+inline void delayMicroseconds(uint32_t us) { test::advanceMicros(us); }
+inline uint32_t millis() { return test::nowMicros() / 1000; }
+inline uint32_t micros() { return test::nowMicros(); }
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int, voidFuncPtr, int) {}
+inline void detachInterrupt(int) {}
@@ -0,0 +1,109 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "HostHardware.h"
+
+namespace test
+{
+  namespace
+  {
+    PinDevice *pin_device = nullptr;
+    SpiPeripheral *spi_peripheral = nullptr;
+    uint64_t now_us = 0;
+  } // namespace
+
+  void attachPinDevice(PinDevice *device)
+  {
+    pin_device = device;
+  }
+
+  void attachSpiPeripheral(SpiPeripheral *peripheral)
+  {
+    spi_peripheral = peripheral;
+  }
+
+  void resetHardware()
+  {
+    pin_device = nullptr;
+    spi_peripheral = nullptr;
+    now_us = 0;
+  }
+
+  uint64_t nowMicros()
+  {
+    return now_us;
+  }
+
+  void advanceMicros(uint64_t us)
+  {
+    now_us += us;
+  }
+
+  void hostPinMode(uint8_t pin, uint8_t mode)
+  {
+    if (pin_device != nullptr)
+    {
+      pin_device->onPinMode(pin, mode);
+    }
+  }
+
+  void hostDigitalWrite(uint8_t pin, uint8_t value)
+  {
+    if (pin_device != nullptr)
+    {
+      pin_device->onDigitalWrite(pin, value);
+    }
+  }
+
+  int hostDigitalRead(uint8_t pin)
+  {
+    uint8_t value = 1; // 何もつながっていなければプルアップ
+    if (pin_device != nullptr)
+    {
+      pin_device->onDigitalRead(pin, value);
+    }
+    return value;
+  }
+
+  uint8_t hostSpiExchange(uint8_t mosi)
+  {
+    return (spi_peripheral != nullptr) ? spi_peripheral->exchange(mosi) : 0xff;
+  }
+
+  void hostSpiBeginTransaction()
+  {
+    if (spi_peripheral != nullptr)
+    {
+      spi_peripheral->onBeginTransaction();
+    }
+  }
+
+  void hostSpiEndTransaction()
+  {
+    if (spi_peripheral != nullptr)
+    {
+      spi_peripheral->onEndTransaction();
+    }
+  }
+} // namespace test
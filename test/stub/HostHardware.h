@@ -0,0 +1,70 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// ホストでドライバを動かすための模擬ハードウェア
+// スタブのArduino.hやThreadSafeSPIからここに届くので、テスト側でセンサー等のモデルをつないで応答させる
+// 時間はdelay()等で進むだけの仮想時間
+
+namespace test
+{
+  // GPIOにつながるデバイスのモデル
+  class PinDevice
+  {
+  public:
+    virtual void onPinMode(uint8_t pin, uint8_t mode) {}
+    virtual void onDigitalWrite(uint8_t pin, uint8_t value) {}
+    // このデバイスがpinを駆動していればvalueに入れてtrueを返す
+    virtual bool onDigitalRead(uint8_t pin, uint8_t &value) { return false; }
+  };
+
+  // SPIバスにつながるデバイスのモデル、チップセレクトはPinDeviceとして自分で見る
+  class SpiPeripheral
+  {
+  public:
+    virtual uint8_t exchange(uint8_t mosi) = 0;
+    // ThreadSafeSPIのトランザクションの始まりと終わり(バスの取得と解放)
+    virtual void onBeginTransaction() {}
+    virtual void onEndTransaction() {}
+  };
+
+  void attachPinDevice(PinDevice *device);
+  void attachSpiPeripheral(SpiPeripheral *peripheral);
+  // つないだデバイスを外して時間を0に戻す
+  void resetHardware();
+
+  uint64_t nowMicros();
+  void advanceMicros(uint64_t us);
+
+  // スタブから呼ばれる
+  void hostPinMode(uint8_t pin, uint8_t mode);
+  void hostDigitalWrite(uint8_t pin, uint8_t value);
+  int hostDigitalRead(uint8_t pin);
+  uint8_t hostSpiExchange(uint8_t mosi);
+  void hostSpiBeginTransaction();
+  void hostSpiEndTransaction();
+} // namespace test
@@ -0,0 +1,208 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "HostTasks.h"
+#include "FreeRTOS.h"
+#include "HostHardware.h"
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+namespace test
+{
+  namespace
+  {
+    struct HostTask
+    {
+      void *handle;
+      const char *name;
+      void (*func)(void *);
+      void *param;
+      uint32_t notify_value;
+      uint32_t delays_left;
+      uint32_t delays;
+      bool started;
+      bool blocked;
+    };
+
+    constexpr int MAX_TASKS = 8;
+    HostTask tasks[MAX_TASKS];
+    int tasks_len = 0;
+
+    // 今動いているタスク、nullptrならメイン
+    HostTask *running = nullptr;
+    thread_local HostTask *current = nullptr;
+
+    // タスクのスレッドは終わらないので、終了時に破棄されないようにする
+    std::mutex &batonMutex()
+    {
+      static std::mutex *mutex = new std::mutex();
+      return *mutex;
+    }
+
+    std::condition_variable &batonCond()
+    {
+      static std::condition_variable *cond = new std::condition_variable();
+      return *cond;
+    }
+
+    // 実行権をnextに渡して、自分(selfがnullptrならメイン)に戻ってくるまで待つ
+    void switchTo(HostTask *next, HostTask *self)
+    {
+      std::unique_lock<std::mutex> lock(batonMutex());
+      running = next;
+      batonCond().notify_all();
+      batonCond().wait(lock, [self] { return running == self; });
+    }
+
+    void taskThread(HostTask *task)
+    {
+      {
+        std::unique_lock<std::mutex> lock(batonMutex());
+        batonCond().wait(lock, [task] { return running == task; });
+      }
+      current = task;
+      task->func(task->param);
+      // FreeRTOSのタスクは戻ってはいけない
+      fprintf(stderr, "host task returned\n");
+      abort();
+    }
+
+    HostTask *taskFor(void *handle)
+    {
+      for (int i = 0; i < tasks_len; i++)
+      {
+        if (tasks[i].handle == handle)
+        {
+          return &tasks[i];
+        }
+      }
+      return nullptr;
+    }
+  } // namespace
+
+  uint32_t runTask(void *handle, uint32_t delays)
+  {
+    HostTask *task = taskFor(handle);
+    if (task == nullptr || delays == 0 || (task->blocked && task->notify_value == 0))
+    {
+      return 0;
+    }
+    task->delays_left = delays;
+    task->delays = 0;
+    if (task->started == false)
+    {
+      task->started = true;
+      std::thread(taskThread, task).detach();
+    }
+    switchTo(task, nullptr);
+    return task->delays;
+  }
+
+  void *findTask(const char *name)
+  {
+    for (int i = 0; i < tasks_len; i++)
+    {
+      if (strcmp(tasks[i].name, name) == 0)
+      {
+        return tasks[i].handle;
+      }
+    }
+    return nullptr;
+  }
+
+  bool isTaskBlocked(void *handle)
+  {
+    HostTask *task = taskFor(handle);
+    return task != nullptr && task->blocked;
+  }
+
+  void hostCreateTask(void *handle, const char *name, void (*func)(void *), void *param)
+  {
+    if (tasks_len == MAX_TASKS)
+    {
+      fprintf(stderr, "too many host tasks\n");
+      abort();
+    }
+    tasks[tasks_len++] = HostTask{handle, name, func, param, 0, 0, 0, false, false};
+  }
+
+  void hostTaskDelay(uint32_t ticks)
+  {
+    advanceMicros(static_cast<uint64_t>(ticks) * 1000);
+    if (current == nullptr)
+    {
+      return;
+    }
+    current->delays++;
+    if (--current->delays_left == 0)
+    {
+      switchTo(nullptr, current);
+    }
+  }
+
+  void hostNotifyGive(void *handle)
+  {
+    HostTask *task = taskFor(handle);
+    if (task != nullptr)
+    {
+      task->notify_value++;
+    }
+  }
+
+  uint32_t hostNotifyTake(bool clear, uint32_t ticks)
+  {
+    if (current == nullptr)
+    {
+      return 0;
+    }
+    if (current->notify_value == 0 && ticks != 0)
+    {
+      if (ticks != portMAX_DELAY)
+      {
+        // メインに戻っている間に通知されていれば、タイムアウトより前に起きたとみなす
+        hostTaskDelay(ticks);
+      }
+      else
+      {
+        while (current->notify_value == 0)
+        {
+          current->blocked = true;
+          switchTo(nullptr, current);
+        }
+      }
+    }
+    if (current->notify_value == 0)
+    {
+      return 0;
+    }
+    current->blocked = false;
+    uint32_t value = current->notify_value;
+    current->notify_value = clear ? 0 : value - 1;
+    return value;
+  }
+} // namespace test
@@ -0,0 +1,50 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// ホストでFreeRTOSのタスクを動かすための協調スケジューラ
+// タスクはテストがrunTask()で動かした時だけ、専用のスレッドでメインと交互に動く(同時には動かない)
+// 指定回数vTaskDelay()を呼ぶか、通知待ちでブロックするとメインに戻る
+// タイムアウト付きの通知待ちは、通知が無ければタイムアウトまでのvTaskDelay()として数える
+// runTask()で動かしていないタスクや、メインからの呼び出しは今まで通り何も待たない
+
+namespace test
+{
+  // xTaskCreateStatic()で作られたタスクのハンドルを名前で探す、無ければnullptr
+  void *findTask(const char *name);
+  // タスクをvTaskDelay()がdelays回呼ばれるか、通知待ちでブロックするまで動かす
+  // ブロックしていて通知が無ければ何もしない、戻り値は実際にvTaskDelay()を呼んだ回数
+  uint32_t runTask(void *handle, uint32_t delays);
+  // タスクが通知待ちでブロックしているか
+  bool isTaskBlocked(void *handle);
+
+  // スタブから呼ばれる
+  void hostCreateTask(void *handle, const char *name, void (*func)(void *), void *param);
+  void hostTaskDelay(uint32_t ticks);
+  void hostNotifyGive(void *handle);
+  uint32_t hostNotifyTake(bool clear, uint32_t ticks);
+} // namespace test
@@ -0,0 +1,153 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "Arduino.h"
+#include "nrf.h"
+
+// nRF52のGPIOポートのモデル
+// ピン番号はポート0が0~31、ポート1が32~63で、g_ADigitalPinMapはそのままの番号を返す
+// LATCHは入力が読まれる時とテストがupdateGpioSense()を呼んだ時に、その時点の入力から求める
+
+const uint32_t g_ADigitalPinMap[64] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+    32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47,
+    48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63};
+
+namespace
+{
+  NRF_GPIO_Type port0(0);
+  NRF_GPIO_Type port1(1);
+  void (*detect_callback)() = nullptr;
+
+  uint8_t pinOf(NRF_GPIO_Type *port, int bit)
+  {
+    return port->index * 32 + bit;
+  }
+
+  uint32_t readIn(NRF_GPIO_Type *port)
+  {
+    uint32_t value = 0;
+    for (int bit = 0; bit < 32; bit++)
+    {
+      value |= static_cast<uint32_t>(test::hostDigitalRead(pinOf(port, bit)) != 0) << bit;
+    }
+    return value;
+  }
+
+  // SENSEの条件に一致している入力
+  uint32_t sensed(NRF_GPIO_Type *port)
+  {
+    uint32_t in = readIn(port);
+    uint32_t value = 0;
+    for (int bit = 0; bit < 32; bit++)
+    {
+      uint32_t sense = (port->PIN_CNF[bit] & GPIO_PIN_CNF_SENSE_Msk) >> GPIO_PIN_CNF_SENSE_Pos;
+      bool level = (in >> bit) & 1;
+      if ((sense == GPIO_PIN_CNF_SENSE_Low && level == false) || (sense == GPIO_PIN_CNF_SENSE_High && level))
+      {
+        value |= 1UL << bit;
+      }
+    }
+    return value;
+  }
+
+  // maskのピンに書き込む、値が変わらなくても書き込みとしてピンのデバイスに知らせる
+  void writeBits(NRF_GPIO_Type *port, uint32_t mask, uint32_t value)
+  {
+    port->out = (port->out & ~mask) | (value & mask);
+    for (int bit = 0; bit < 32; bit++)
+    {
+      if ((mask >> bit) & 1)
+      {
+        test::hostDigitalWrite(pinOf(port, bit), (value >> bit) & 1);
+      }
+    }
+  }
+
+  uint32_t readOut(NRF_GPIO_Type *port) { return port->out; }
+  void writeOut(NRF_GPIO_Type *port, uint32_t value) { writeBits(port, port->out ^ value, value); }
+  void writeOutSet(NRF_GPIO_Type *port, uint32_t mask) { writeBits(port, mask, UINT32_MAX); }
+  void writeOutClr(NRF_GPIO_Type *port, uint32_t mask) { writeBits(port, mask, 0); }
+  void writeNothing(NRF_GPIO_Type *port, uint32_t value) {}
+
+  uint32_t readLatch(NRF_GPIO_Type *port)
+  {
+    test::updateGpioSense();
+    return port->latch;
+  }
+
+  // 条件に一致したままのビットはクリアしてもすぐにセットされる
+  void clearLatch(NRF_GPIO_Type *port, uint32_t mask)
+  {
+    port->latch &= ~mask;
+    test::updateGpioSense();
+  }
+} // namespace
+
+NRF_GPIO_Type::NRF_GPIO_Type(uint8_t index)
+    : OUT(this, readOut, writeOut), OUTSET(this, readOut, writeOutSet), OUTCLR(this, readOut, writeOutClr),
+      IN(this, readIn, writeNothing), LATCH(this, readLatch, clearLatch),
+      PIN_CNF(), index(index), out(0), latch(0)
+{
+}
+
+NRF_GPIO_Type *const NRF_P0 = &port0;
+NRF_GPIO_Type *const NRF_P1 = &port1;
+
+namespace test
+{
+  void updateGpioSense()
+  {
+    bool detected = (port0.latch | port1.latch) != 0;
+    port0.latch |= sensed(&port0);
+    port1.latch |= sensed(&port1);
+    // LDETECTモードのDETECTの立ち上がりでPORTイベントが発生する
+    if (detected == false && (port0.latch | port1.latch) != 0 && detect_callback != nullptr)
+    {
+      detect_callback();
+    }
+  }
+
+  void hostNrfPinMode(uint8_t pin, uint8_t mode)
+  {
+    NRF_GPIO_Type *port = (pin < 32) ? &port0 : &port1;
+    uint32_t &cnf = port->PIN_CNF[pin % 32];
+    uint32_t sense = GPIO_PIN_CNF_SENSE_Disabled;
+    if (mode == INPUT_PULLUP_SENSE || mode == INPUT_SENSE_LOW)
+    {
+      sense = GPIO_PIN_CNF_SENSE_Low;
+    }
+    else if (mode == INPUT_PULLDOWN_SENSE || mode == INPUT_SENSE_HIGH)
+    {
+      sense = GPIO_PIN_CNF_SENSE_High;
+    }
+    cnf = (cnf & ~GPIO_PIN_CNF_SENSE_Msk) | (sense << GPIO_PIN_CNF_SENSE_Pos);
+  }
+
+  void hostSetGpioDetectCallback(void (*callback)())
+  {
+    detect_callback = callback;
+  }
+} // namespace test
@@ -0,0 +1,67 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "SenseInterrupt.h"
+
+// SenseInterruptのホスト用の実装、PORTイベントはnrf.hのGPIOポートのモデルから届く
+
+namespace hidpg
+{
+  namespace Internal
+  {
+    void attachSenseInterrupt(voidFuncPtr callback)
+    {
+      test::hostSetGpioDetectCallback(callback);
+    }
+
+    void detachSenseInterrupt()
+    {
+      test::hostSetGpioDetectCallback(nullptr);
+    }
+
+    void clearLatch(uint32_t pin)
+    {
+      uint32_t bit = g_ADigitalPinMap[pin];
+      NRF_GPIO_Type *port = nrf_gpio_pin_port_decode(&bit);
+      port->LATCH = 1UL << bit;
+    }
+
+    bool readLatch(uint32_t pin)
+    {
+      uint32_t bit = g_ADigitalPinMap[pin];
+      NRF_GPIO_Type *port = nrf_gpio_pin_port_decode(&bit);
+      return (port->LATCH >> bit) & 1;
+    }
+
+    void clearLatch(NRF_GPIO_Type *port, uint32_t mask)
+    {
+      port->LATCH = mask;
+    }
+
+    uint32_t readLatch(NRF_GPIO_Type *port)
+    {
+      return port->LATCH;
+    }
+  } // namespace Internal
+} // namespace hidpg
@@ -0,0 +1,150 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "ThreadSafeSPI.h"
+
+// ThreadSafeSPIのホスト用の実装、転送は模擬ハードウェアのSpiPeripheralにそのまま渡す
+// バスの調停は無く、統計はトランザクション数とバスを持っていた仮想時間だけを数える
+
+SPIClass SPI;
+
+namespace hidpg
+{
+  SPIDevice::SPIDevice(const SPISettings &settings, Priority priority)
+      : _settings(settings), _priority(priority), _stats(), _begin_us(0)
+  {
+  }
+
+  SPIDevice::Stats SPIDevice::getStats()
+  {
+    return _stats;
+  }
+
+  void SPIDevice::resetStats()
+  {
+    _stats = Stats();
+  }
+
+  ThreadSafeSPIClass::ThreadSafeSPIClass(SPIClass &spi)
+      : _spi(spi), _initialized(false), _current_device(nullptr)
+  {
+  }
+
+  void ThreadSafeSPIClass::begin()
+  {
+    _initialized = true;
+  }
+
+  void ThreadSafeSPIClass::end()
+  {
+    _initialized = false;
+  }
+
+  void ThreadSafeSPIClass::usingInterrupt(int interruptNumber)
+  {
+  }
+
+  void ThreadSafeSPIClass::beginTransaction(SPISettings &settings)
+  {
+    _current_device = nullptr;
+    test::hostSpiBeginTransaction();
+  }
+
+  void ThreadSafeSPIClass::beginTransaction(SPIDevice &device)
+  {
+    _current_device = &device;
+    device._begin_us = micros();
+    test::hostSpiBeginTransaction();
+  }
+
+  void ThreadSafeSPIClass::endTransaction()
+  {
+    test::hostSpiEndTransaction();
+    if (_current_device != nullptr)
+    {
+      uint32_t busy_us = micros() - _current_device->_begin_us;
+      _current_device->_stats.transactions++;
+      _current_device->_stats.busy_us += busy_us;
+      _current_device->_stats.max_busy_us = max(_current_device->_stats.max_busy_us, busy_us);
+      _current_device = nullptr;
+    }
+  }
+
+  uint8_t ThreadSafeSPIClass::transfer(uint8_t data)
+  {
+    return test::hostSpiExchange(data);
+  }
+
+  uint16_t ThreadSafeSPIClass::transfer16(uint16_t data)
+  {
+    uint16_t high = test::hostSpiExchange(data >> 8);
+    uint16_t low = test::hostSpiExchange(data & 0xff);
+    return (high << 8) | low;
+  }
+
+  void ThreadSafeSPIClass::transfer(void *buf, size_t count)
+  {
+    uint8_t *p = static_cast<uint8_t *>(buf);
+    for (size_t i = 0; i < count; i++)
+    {
+      p[i] = test::hostSpiExchange(p[i]);
+    }
+  }
+
+  void ThreadSafeSPIClass::transfer(const void *tx_buf, void *rx_buf, size_t count)
+  {
+    const uint8_t *tx = static_cast<const uint8_t *>(tx_buf);
+    uint8_t *rx = static_cast<uint8_t *>(rx_buf);
+    for (size_t i = 0; i < count; i++)
+    {
+      uint8_t data = test::hostSpiExchange(tx != nullptr ? tx[i] : 0);
+      if (rx != nullptr)
+      {
+        rx[i] = data;
+      }
+    }
+  }
+
+  bool ThreadSafeSPIClass::transferAsync(SPIDevice &device, uint8_t cs_pin, const void *tx_buf, void *rx_buf, size_t count,
+                                         async_callback_t callback, void *context)
+  {
+    if (_initialized == false)
+    {
+      return false;
+    }
+    beginTransaction(device);
+    digitalWrite(cs_pin, LOW);
+    transfer(tx_buf, rx_buf, count);
+    digitalWrite(cs_pin, HIGH);
+    endTransaction();
+    if (callback != nullptr)
+    {
+      callback(context);
+    }
+    return true;
+  }
+
+  ThreadSafeSPIClass ThreadSafeSPI(SPI);
+
+} // namespace hidpg
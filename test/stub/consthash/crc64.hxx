@@ -0,0 +1,3 @@
+#pragma once
+
+// ホストのテストではSW()マクロを使わないので、Switch.hのインクルードを通すだけの空のスタブ
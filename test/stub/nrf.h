@@ -0,0 +1,100 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+// ホストでnRF52のGPIOのレジスタを直接読み書きするドライバをビルドするためのスタブ
+// ARDUINO_ARCH_NRF52を定義したテストだけが使う
+// OUTSET/OUTCLR/INはHostHardwareのピンにつながり、LATCHはPIN_CNFのSENSEの設定に従って入力から求める
+
+#include "HostHardware.h"
+#include <stdint.h>
+
+#define GPIO_PIN_CNF_SENSE_Pos 16
+#define GPIO_PIN_CNF_SENSE_Msk (0x3UL << GPIO_PIN_CNF_SENSE_Pos)
+#define GPIO_PIN_CNF_SENSE_Disabled 0
+#define GPIO_PIN_CNF_SENSE_High 2
+#define GPIO_PIN_CNF_SENSE_Low 3
+
+struct NRF_GPIO_Type;
+
+namespace test
+{
+  // レジスタ1つ分、読み書きをポートのモデルに渡す
+  class GpioRegister
+  {
+  public:
+    using read_t = uint32_t (*)(NRF_GPIO_Type *port);
+    using write_t = void (*)(NRF_GPIO_Type *port, uint32_t value);
+
+    GpioRegister(NRF_GPIO_Type *port, read_t read, write_t write) : _port(port), _read(read), _write(write) {}
+
+    operator uint32_t() const { return _read(_port); }
+    GpioRegister &operator=(uint32_t value)
+    {
+      _write(_port, value);
+      return *this;
+    }
+
+  private:
+    NRF_GPIO_Type *_port;
+    read_t _read;
+    write_t _write;
+  };
+} // namespace test
+
+// ドライバが使うレジスタだけを持つ
+struct NRF_GPIO_Type
+{
+  explicit NRF_GPIO_Type(uint8_t index);
+
+  test::GpioRegister OUT;
+  test::GpioRegister OUTSET;
+  test::GpioRegister OUTCLR;
+  test::GpioRegister IN;
+  // 1を書き込んだビットがクリアされる
+  test::GpioRegister LATCH;
+  uint32_t PIN_CNF[32];
+
+  // モデルの状態
+  uint8_t index;
+  uint32_t out;
+  uint32_t latch;
+};
+
+extern NRF_GPIO_Type *const NRF_P0;
+extern NRF_GPIO_Type *const NRF_P1;
+#define NRF_GPIO NRF_P0
+
+namespace test
+{
+  // ピンの入力が変わったことを知らせてLATCHを更新する
+  // テストでスイッチを押したり離したりした後に呼ぶ
+  void updateGpioSense();
+
+  // スタブから呼ばれる
+  void hostNrfPinMode(uint8_t pin, uint8_t mode);
+  // LATCHが全ポートで0から変わった時(PORTイベント)に呼ぶ関数
+  void hostSetGpioDetectCallback(void (*callback)());
+} // namespace test
@@ -0,0 +1,64 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "FreeRTOS.h"
+#include "HostHardware.h"
+#include "HostTasks.h"
+
+typedef void (*TaskFunction_t)(void *);
+
+// タスクはテストがtest::runTask()で動かすまで動かない
+inline TaskHandle_t xTaskCreateStatic(TaskFunction_t func, const char *name, uint32_t, void *param, UBaseType_t, StackType_t *, StaticTask_t *task_buffer)
+{
+  test::hostCreateTask(task_buffer, name, func, param);
+  return task_buffer;
+}
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return nullptr; }
+inline TickType_t xTaskGetTickCount() { return test::nowMicros() / 1000; }
+inline BaseType_t xTaskNotify(TaskHandle_t, uint32_t, eNotifyAction) { return pdPASS; }
+inline BaseType_t xTaskNotifyFromISR(TaskHandle_t, uint32_t, eNotifyAction, BaseType_t *) { return pdPASS; }
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+  test::hostNotifyGive(task);
+  return pdPASS;
+}
+inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *) { test::hostNotifyGive(task); }
+inline BaseType_t xTaskNotifyWait(uint32_t, uint32_t, uint32_t *value, TickType_t)
+{
+  if (value != nullptr)
+  {
+    *value = 0;
+  }
+  return pdFALSE;
+}
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) { return test::hostNotifyTake(clear == pdTRUE, ticks); }
+inline void vTaskDelay(TickType_t ticks) { test::hostTaskDelay(ticks); }
+inline void vTaskDelayUntil(TickType_t *, TickType_t ticks) { vTaskDelay(ticks); }
+inline void vTaskSuspend(TaskHandle_t) {}
+inline void vTaskResume(TaskHandle_t) {}
+inline void vTaskDelete(TaskHandle_t) {}
+inline void vTaskSuspendAll() {}
+inline BaseType_t xTaskResumeAll() { return pdFALSE; }
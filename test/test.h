@@ -0,0 +1,73 @@
+/*
+  The MIT License (MIT)
+
+  Copyright (c) 2022 ogatatsu.
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// ホストで実行するテストの最小限のアサーション
+// 失敗しても続行し、最後にtestResult()で失敗の有無を返す
+
+namespace test
+{
+  inline int &failures()
+  {
+    static int count = 0;
+    return count;
+  }
+
+  inline int testResult(const char *name)
+  {
+    if (failures() == 0)
+    {
+      printf("%s: OK\n", name);
+      return 0;
+    }
+    printf("%s: %d failure(s)\n", name, failures());
+    return 1;
+  }
+} // namespace test
+
+#define CHECK(cond)                                                \
+  do                                                               \
+  {                                                                \
+    if (!(cond))                                                   \
+    {                                                              \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      test::failures()++;                                          \
+    }                                                              \
+  } while (0)
+
+#define CHECK_EQ(expected, actual)                                                                       \
+  do                                                                                                     \
+  {                                                                                                      \
+    long long e_ = (long long)(expected);                                                                \
+    long long a_ = (long long)(actual);                                                                  \
+    if (e_ != a_)                                                                                        \
+    {                                                                                                    \
+      printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #expected, #actual, e_, a_); \
+      test::failures()++;                                                                                \
+    }                                                                                                    \
+  } while (0)